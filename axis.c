@@ -0,0 +1,231 @@
+//=============================================================================
+/*
+* modules:
+ - GPIO (AHB): "MC4_x", "EN_4", "MC5_x", "EN_5" (motor channels 4, 5, see
+   board.h; BOARD_AXIS_NUM > 1); EN_x by drive.c (DRIVE_AXIS + a - 1)
+* notes:
+ - axis_desc[] is the only place of axes: focus.c builds ADC 1 sequence
+   (SQR, SMPR) and DMA 1 buffer from it (block of samples per axis, then
+   temperature sensor and internal reference voltage); DMA 1 interrupt
+   latches mean of each block (focus_getAxis())
+ - axis 0 is focus: keys (built from its row by focus.c), controller 
+   (focus_control()) and calibration in focus.c; axis_poll() runs on/off 
+   control of other axes on same frame
+ - targets of other axes: CAN_SRV_AXIS (not stored); first good frame sets
+   target to position
+ - driver of axis is enabled only around moves (as focus: drive_start() 
+   before start of move, lead and hold time of drive.c)
+ - cost of controller per axis (DWT cycles, max): axis_costStart() before
+   and axis_cost() after each controller; first pass after each frame is
+   measured (less load of main loop), runs with interrupt handler in
+   between are not counted
+*/
+//=============================================================================
+#include "main.h"
+#include "axis.h"
+#include "focus.h"
+#include "irq.h"
+#include "board.h"
+#include "drive.h"
+//=============================================================================
+#define AXIS_TARGET_NONE  0xFFFFFFFFU  // before first good frame
+//-----------------------------------------------------------------------------
+// Focus: hysteresis of focus_control() is config.focus_band_x (calibrated),
+// value here is default
+const struct axis_desc axis_desc[AXIS_NUM] = {
+	{ BOARD_MC3_PORT, BOARD_MC3_N, BOARD_MC3_P, BOARD_POT_CH, 
+		AXIS_SMP_601, FOCUS_BAND_START, FOCUS_BAND_STOP },
+#if AXIS_NUM > 1
+	{ BOARD_MC4_PORT, BOARD_MC4_P, BOARD_MC4_N, BOARD_POT4_CH, 
+		AXIS_SMP_61, 16U, 6U },
+#endif
+#if AXIS_NUM > 2
+	{ BOARD_MC5_PORT, BOARD_MC5_P, BOARD_MC5_N, BOARD_POT5_CH, 
+		AXIS_SMP_61, 16U, 6U },
+#endif
+};
+//-----------------------------------------------------------------------------
+// Keys of axis: BSRR values of FOCUS_DIR_x (from axis_desc[] at init => 
+// one store per drive)
+static struct {
+	uint32_t mc[3];
+} axis_io[AXIS_NUM];
+static volatile uint32_t axis_target[AXIS_NUM];
+static volatile uint32_t axis_dir[AXIS_NUM];
+static uint32_t axis_cycles[AXIS_NUM];  // max cost of controller
+static uint32_t axis_frame[AXIS_NUM];   // frame of last measure
+static uint32_t axis_meas;              // measure of this controller
+static uint32_t axis_irqs;              // irq_getCount() at axis_costStart()
+//=============================================================================
+static void 
+axis_keys(uint32_t a, uint32_t dir)
+{
+	BOARD_GPIO(axis_desc[a].port)->BSRR = axis_io[a].mc[dir];
+	axis_dir[a] = dir;
+}
+//-----------------------------------------------------------------------------
+// Keys from axis_desc[]: output, high speed, pull-down (see board.c)
+void 
+axis_init(void)
+{
+	const struct axis_desc *d;
+	uint32_t a;
+	
+	for (a = 0; a < AXIS_NUM; ++a) {
+		d = &axis_desc[a];
+		axis_io[a].mc[FOCUS_DIR_STOP] =
+			BOARD_BR(d->fwd) | BOARD_BR(d->back);
+		axis_io[a].mc[FOCUS_DIR_FORWARD] =
+			BOARD_BS(d->fwd) | BOARD_BR(d->back);
+		axis_io[a].mc[FOCUS_DIR_BACK] =
+			BOARD_BR(d->fwd) | BOARD_BS(d->back);
+		axis_target[a] = AXIS_TARGET_NONE;
+		axis_dir[a] = FOCUS_DIR_STOP;
+		axis_cycles[a] = 0;
+		axis_frame[a] = 0;
+	}
+	
+	if (AXIS_NUM > 1U)
+		board_gpioInit(BOARD_GRP_AXIS);
+}
+//-----------------------------------------------------------------------------
+// Stop keys of axes 1 ... (before Stop mode, frames are not valid; 
+// drivers: drive_sleep(), drive_off())
+void 
+axis_sleep(void)
+{
+	uint32_t a;
+	
+	for (a = 1U; a < AXIS_NUM; ++a)
+		if (axis_dir[a] != FOCUS_DIR_STOP)
+			axis_keys(a, FOCUS_DIR_STOP);
+}
+//=============================================================================
+// On/off control with hysteresis of axis_desc[] (as focus_control()); 
+// move starts when driver is enabled for lead time (drive_start())
+static void 
+axis_control(uint32_t a, uint32_t pos)
+{
+	const struct axis_desc *d = &axis_desc[a];
+	int32_t err, start = d->band_start, stop = d->band_stop;
+	uint32_t dir;
+	
+	if (axis_target[a] == AXIS_TARGET_NONE)
+		axis_target[a] = pos;
+	err = (int32_t)pos - (int32_t)axis_target[a];
+	
+	if (axis_dir[a] == FOCUS_DIR_FORWARD) {
+		if (err >= -stop)
+			axis_keys(a, FOCUS_DIR_STOP);
+	} else if (axis_dir[a] == FOCUS_DIR_BACK) {
+		if (err <= stop)
+			axis_keys(a, FOCUS_DIR_STOP);
+	} else {
+		if (err > start)
+			dir = FOCUS_DIR_BACK;
+		else if (err < -start)
+			dir = FOCUS_DIR_FORWARD;
+		else
+			return;
+		if (drive_start(DRIVE_AXIS + a - 1U))
+			axis_keys(a, dir);
+	}
+}
+//-----------------------------------------------------------------------------
+// Main loop: controllers of axes 1 ... on last good frame (axis 0 - see
+// focus_control()); keys are stopped and drivers disabled while frames 
+// are not valid
+void 
+axis_poll(void)
+{
+	uint32_t a, t0;
+	
+	if (focus_getState() & (FOCUS_STATE_NOSTART | FOCUS_STATE_ERR)) {
+		axis_sleep();
+		for (a = 1U; a < AXIS_NUM; ++a)
+			drive_off(DRIVE_AXIS + a - 1U);
+		return;
+	}
+	
+	for (a = 1U; a < AXIS_NUM; ++a) {
+		t0 = axis_costStart(a);
+		axis_control(a, focus_getAxis(a) & FOCUS_MASK);
+		axis_cost(a, t0);
+	}
+}
+//-----------------------------------------------------------------------------
+// Main loop: before controller of axis a; return t0 for axis_cost()
+uint32_t 
+axis_costStart(uint32_t a)
+{
+	uint32_t n = focus_getFrames();
+	
+	axis_meas = n != axis_frame[a];
+	if (!axis_meas)
+		return 0;
+	axis_frame[a] = n;
+	axis_irqs = irq_getCount();
+	return irq_cycles();
+}
+//-----------------------------------------------------------------------------
+// Cost of controller of axis a from t0 (not counted if interrupt handler 
+// ran in between)
+void 
+axis_cost(uint32_t a, uint32_t t0)
+{
+	uint32_t c;
+	
+	if (!axis_meas)
+		return;
+	// Count after end time: handler may run before read of DWT
+	c = irq_cycles() - t0;
+	if (irq_getCount() != axis_irqs)
+		return;
+	if (c > axis_cycles[a])
+		axis_cycles[a] = c;
+}
+//=============================================================================
+// Axis 1 ... (focus: commands), ADC counts; from CAN RX interrupt
+int32_t 
+axis_setTarget(uint32_t a, uint32_t target)
+{
+	if (a == AXIS_FOCUS || a >= AXIS_NUM || target > FOCUS_MASK)
+		return -1;
+	axis_target[a] = target;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+axis_getTarget(uint32_t a)
+{
+	if (a == AXIS_FOCUS)
+		return focus_target;
+	return a < AXIS_NUM ? axis_target[a] : AXIS_TARGET_NONE;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+axis_getDir(uint32_t a)
+{
+	if (a == AXIS_FOCUS)
+		return focus_getDir();
+	return a < AXIS_NUM ? axis_dir[a] : FOCUS_DIR_STOP;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+axis_getCycles(uint32_t a)
+{
+	return a < AXIS_NUM ? axis_cycles[a] : 0;
+}
+//-----------------------------------------------------------------------------
+// Any of axes 1 ... is driven
+uint32_t 
+axis_isMoving(void)
+{
+	uint32_t a;
+	
+	for (a = 1U; a < AXIS_NUM; ++a)
+		if (axis_dir[a] != FOCUS_DIR_STOP)
+			return 1U;
+	return 0;
+}
+//=============================================================================
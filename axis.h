@@ -0,0 +1,48 @@
+//=============================================================================
+#ifndef AXIS_H
+#define AXIS_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+#include "board.h"
+//-----------------------------------------------------------------------------
+// Axes (index in axis_desc[]); axis 0 is focus (focus.c: keys, calibration,
+// commands), others are driven by axis_poll()
+#define AXIS_FOCUS  0U
+#define AXIS_ZOOM   1U
+#define AXIS_IRIS   2U
+#define AXIS_NUM    BOARD_AXIS_NUM
+//-----------------------------------------------------------------------------
+// Sampling time of ADC 1 (SMPx code): 19.5, 61.5, 601.5 ADC clock cycles
+#define AXIS_SMP_19   4U
+#define AXIS_SMP_61   5U
+#define AXIS_SMP_601  7U
+//-----------------------------------------------------------------------------
+// Axis (bytes: table in flash): bridge MCx_F / MCx_B on one port (one
+// store for direction), feedback channel of ADC 1, hysteresis of on/off 
+// control (ADC counts, as FOCUS_BAND_x); EN_x of driver is in drive.c
+struct axis_desc {
+	uint8_t port;        // bridge (BOARD_Px)
+	uint8_t fwd;         // pin high for forward (position up)
+	uint8_t back;
+	uint8_t ch;          // ADC 1 channel
+	uint8_t smp;         // AXIS_SMP_x
+	uint8_t band_start;
+	uint8_t band_stop;
+};
+//-----------------------------------------------------------------------------
+extern const struct axis_desc axis_desc[AXIS_NUM];
+//-----------------------------------------------------------------------------
+void axis_init(void);
+void axis_sleep(void);
+void axis_poll(void);
+uint32_t axis_costStart(uint32_t a);
+void axis_cost(uint32_t a, uint32_t t0);
+int32_t axis_setTarget(uint32_t a, uint32_t target);
+uint32_t axis_getTarget(uint32_t a);
+uint32_t axis_getDir(uint32_t a);
+uint32_t axis_getCycles(uint32_t a);
+uint32_t axis_isMoving(void);
+//=============================================================================
+#endif // AXIS_H
+//=============================================================================
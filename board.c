@@ -0,0 +1,107 @@
+//=============================================================================
+/*
+* modules:
+ - GPIO A, B, C (AHB): all pins of board (see board.h)
+* notes:
+ - board_pins[] is the only place of pin setup; modules call
+   board_gpioInit() with own group
+ - whole fields of pin are written (MODER, OSPEEDR, PUPDR, AFR): reset
+   state of debug pins (PA 13 ... 15, PB 3, PB 4) is not kept
+*/
+//=============================================================================
+#include "main.h"
+#include "board.h"
+//=============================================================================
+static const struct board_pin board_pins[] = {
+	// Focus motor
+	{ BOARD_GRP_FOCUS, BOARD_MC3_PORT, BOARD_MC3_N,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	{ BOARD_GRP_FOCUS, BOARD_MC3_PORT, BOARD_MC3_P,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	{ BOARD_GRP_FOCUS, BOARD_EN3_PORT, BOARD_EN3,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	// Potentiometer (ADC 1)
+	{ BOARD_GRP_POT, BOARD_POT_PORT, BOARD_POT,
+		BOARD_MODE_AN, BOARD_SPEED_LOW, BOARD_PULL_NONE, 0 },
+#if BOARD_AXIS_NUM > 1
+	{ BOARD_GRP_POT, BOARD_POT4_PORT, BOARD_POT4,
+		BOARD_MODE_AN, BOARD_SPEED_LOW, BOARD_PULL_NONE, 0 },
+	{ BOARD_GRP_POT, BOARD_POT5_PORT, BOARD_POT5,
+		BOARD_MODE_AN, BOARD_SPEED_LOW, BOARD_PULL_NONE, 0 },
+	// Zoom and iris motors
+	{ BOARD_GRP_AXIS, BOARD_MC4_PORT, BOARD_MC4_P,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	{ BOARD_GRP_AXIS, BOARD_MC4_PORT, BOARD_MC4_N,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	{ BOARD_GRP_AXIS, BOARD_EN4_PORT, BOARD_EN4,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	{ BOARD_GRP_AXIS, BOARD_MC5_PORT, BOARD_MC5_P,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	{ BOARD_GRP_AXIS, BOARD_MC5_PORT, BOARD_MC5_N,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	{ BOARD_GRP_AXIS, BOARD_EN5_PORT, BOARD_EN5,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+#endif
+	// Pole motors
+	{ BOARD_GRP_POLE, BOARD_MC1_PORT, BOARD_MC1_P,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	{ BOARD_GRP_POLE, BOARD_MC1_PORT, BOARD_MC1_N,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	{ BOARD_GRP_POLE, BOARD_EN1_PORT, BOARD_EN1,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	{ BOARD_GRP_POLE, BOARD_MC2_PORT, BOARD_MC2_P,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	{ BOARD_GRP_POLE, BOARD_MC2_PORT, BOARD_MC2_N,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	{ BOARD_GRP_POLE, BOARD_EN2_PORT, BOARD_EN2,
+		BOARD_MODE_OUT, BOARD_SPEED_HIGH, BOARD_PULL_DOWN, 0 },
+	// CAN
+	{ BOARD_GRP_CAN, BOARD_CAN_PORT, BOARD_CAN_RX,
+		BOARD_MODE_AF, BOARD_SPEED_LOW, BOARD_PULL_NONE, BOARD_CAN_AF },
+	{ BOARD_GRP_CAN, BOARD_CAN_PORT, BOARD_CAN_TX,
+		BOARD_MODE_AF, BOARD_SPEED_LOW, BOARD_PULL_NONE, BOARD_CAN_AF },
+	// USART 2
+	{ BOARD_GRP_USART, BOARD_USART_PORT, BOARD_USART_TX,
+		BOARD_MODE_AF, BOARD_SPEED_LOW, BOARD_PULL_NONE, BOARD_USART_AF },
+	{ BOARD_GRP_USART, BOARD_USART_PORT, BOARD_USART_RX,
+		BOARD_MODE_AF, BOARD_SPEED_LOW, BOARD_PULL_NONE, BOARD_USART_AF },
+};
+
+#define BOARD_PIN_NUM  (sizeof(board_pins) / sizeof(board_pins[0]))
+//=============================================================================
+// Setup of pins of group (BOARD_GRP_x mask)
+// 1. Enable clock for used ports + delay
+// 2. Mode, speed, pull and alternate function of each pin
+void
+board_gpioInit(uint32_t grp)
+{
+	// For delay
+	int32_t i;
+	const struct board_pin *p;
+	GPIO_TypeDef *g;
+	uint32_t n, s2, s4;
+
+  // 1. Enable clock for used ports + delay
+	for (n = 0; n < BOARD_PIN_NUM; ++n)
+		if (board_pins[n].grp & grp)
+			RCC->AHBENR |= RCC_AHBENR_GPIOAEN << board_pins[n].port;
+	for (i = 0; i < 15; ++i);
+
+  // 2. Mode, speed, pull and alternate function of each pin
+	for (n = 0; n < BOARD_PIN_NUM; ++n) {
+		p = &board_pins[n];
+		if (!(p->grp & grp))
+			continue;
+		g = BOARD_GPIO(p->port);
+		s2 = 2U * p->pin;
+		s4 = 4U * (p->pin & 7U);
+		// Alternate function before mode (no glitch of other function)
+		if (p->mode == BOARD_MODE_AF)
+			g->AFR[p->pin >> 3] = (g->AFR[p->pin >> 3] & ~(0xFU << s4)) |
+				p->af << s4;
+		g->OSPEEDR = (g->OSPEEDR & ~(0x3U << s2)) | p->speed << s2;
+		g->PUPDR = (g->PUPDR & ~(0x3U << s2)) | p->pull << s2;
+		g->MODER = (g->MODER & ~(0x3U << s2)) | p->mode << s2;
+	}
+}
+//=============================================================================
@@ -0,0 +1,133 @@
+//=============================================================================
+#ifndef BOARD_H
+#define BOARD_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+// Board description: pins of motor channels, potentiometer, CAN and
+// USART 2 (new board revision => change here and in board_pins[]); all
+// macros are constants => drives of keys are one store to BSRR
+//-----------------------------------------------------------------------------
+// GPIO ports (index of RCC_AHBENR_GPIOxEN from GPIOAEN)
+#define BOARD_PA  0U
+#define BOARD_PB  1U
+#define BOARD_PC  2U
+#define BOARD_PF  5U
+#define BOARD_GPIO(port)  ((port) == BOARD_PA ? GPIOA : \
+                           (port) == BOARD_PB ? GPIOB : \
+                           (port) == BOARD_PC ? GPIOC : GPIOF)
+//-----------------------------------------------------------------------------
+// Motor channel x: MCx_P and MCx_N on one port (one store for direction),
+// EN_x on any port
+// 1 - pole motor 1 ("MC1_x", "EN_1")
+// NOTE: PB 4 is NJTRST after reset (AF 0, pull-up), MC1_P takes it =>
+//       board_gpioInit() writes whole fields of pin; JTAG works without
+//       NJTRST, SWD is not affected
+#define BOARD_MC1_PORT   BOARD_PB
+#define BOARD_MC1_P      4U
+#define BOARD_MC1_N      5U
+#define BOARD_EN1_PORT   BOARD_PC
+#define BOARD_EN1        14U
+// 2 - pole motor 2 ("MC2_x", "EN_2"); PA 2, PA 3 are USART 2 in debug.c
+#define BOARD_MC2_PORT   BOARD_PA
+#define BOARD_MC2_P      2U
+#define BOARD_MC2_N      3U
+#define BOARD_EN2_PORT   BOARD_PB
+#define BOARD_EN2        10U
+// 3 - focus motor ("MC3_x", "EN_3"): MC3_N - forward, MC3_P - back
+#define BOARD_MC3_PORT   BOARD_PA
+#define BOARD_MC3_P      1U
+#define BOARD_MC3_N      0U
+#define BOARD_EN3_PORT   BOARD_PB
+#define BOARD_EN3        12U
+//-----------------------------------------------------------------------------
+// Potentiometer of focus ("VAR_RES_IR"): pin and channel of ADC 1
+#define BOARD_POT_PORT   BOARD_PB
+#define BOARD_POT        13U
+#define BOARD_POT_CH     13U
+//-----------------------------------------------------------------------------
+// Axes of lens (see axis.c): 1 - focus only (this board), 3 - focus, zoom
+// and iris (motor channels 4, 5 on expansion header)
+#ifndef BOARD_AXIS_NUM
+#define BOARD_AXIS_NUM   1U
+#endif
+// 4 - zoom motor ("MC4_x", "EN_4"): MC4_P - forward; buffered
+// potentiometer ("VAR_RES_Z")
+#define BOARD_MC4_PORT   BOARD_PB
+#define BOARD_MC4_P      6U
+#define BOARD_MC4_N      7U
+#define BOARD_EN4_PORT   BOARD_PB
+#define BOARD_EN4        14U
+#define BOARD_POT4_PORT  BOARD_PB
+#define BOARD_POT4       0U
+#define BOARD_POT4_CH    11U
+// 5 - iris motor ("MC5_x", "EN_5"): MC5_P - forward; buffered
+// potentiometer ("VAR_RES_A")
+#define BOARD_MC5_PORT   BOARD_PA
+#define BOARD_MC5_P      8U
+#define BOARD_MC5_N      9U
+#define BOARD_EN5_PORT   BOARD_PB
+#define BOARD_EN5        15U
+#define BOARD_POT5_PORT  BOARD_PB
+#define BOARD_POT5       1U
+#define BOARD_POT5_CH    12U
+//-----------------------------------------------------------------------------
+// CAN: RX is EXTI line BOARD_CAN_RX for wake-up (see power.c)
+#define BOARD_CAN_PORT   BOARD_PB
+#define BOARD_CAN_RX     8U
+#define BOARD_CAN_TX     9U
+#define BOARD_CAN_AF     9U
+//-----------------------------------------------------------------------------
+// USART 2 (debug.c, ST-LINK virtual COM port)
+#define BOARD_USART_PORT BOARD_PA
+#define BOARD_USART_TX   2U
+#define BOARD_USART_RX   3U
+#define BOARD_USART_AF   7U
+//-----------------------------------------------------------------------------
+// BSRR values: set / reset of pin
+#define BOARD_BS(pin)  (0x1U << (pin))
+#define BOARD_BR(pin)  (0x1U << ((pin) + 16U))
+// Motor channel ch (1 ... 3): port, levels of MCx_P and MCx_N (0 / 1),
+// EN_x port and BSRR value
+#define BOARD_MC_GPIO(ch)  BOARD_GPIO(BOARD_MC##ch##_PORT)
+#define BOARD_MC(ch, p, n)  \
+	(((p) ? BOARD_BS(BOARD_MC##ch##_P) : BOARD_BR(BOARD_MC##ch##_P)) | \
+	((n) ? BOARD_BS(BOARD_MC##ch##_N) : BOARD_BR(BOARD_MC##ch##_N)))
+#define BOARD_EN_GPIO(ch)  BOARD_GPIO(BOARD_EN##ch##_PORT)
+#define BOARD_EN(ch, on)  \
+	((on) ? BOARD_BS(BOARD_EN##ch) : BOARD_BR(BOARD_EN##ch))
+//-----------------------------------------------------------------------------
+// Groups of pins for board_gpioInit() (init of module)
+#define BOARD_GRP_FOCUS  0x01U  // MC3_x, EN_3
+#define BOARD_GRP_POT    0x02U
+#define BOARD_GRP_POLE   0x04U  // MC1_x, EN_1, MC2_x, EN_2
+#define BOARD_GRP_CAN    0x08U
+#define BOARD_GRP_USART  0x10U
+#define BOARD_GRP_AXIS   0x20U  // MC4_x, EN_4, MC5_x, EN_5 (axis.c)
+//-----------------------------------------------------------------------------
+// Mode (MODER), speed (OSPEEDR), pull (PUPDR)
+#define BOARD_MODE_IN    0U
+#define BOARD_MODE_OUT   1U
+#define BOARD_MODE_AF    2U
+#define BOARD_MODE_AN    3U
+#define BOARD_SPEED_LOW  0U
+#define BOARD_SPEED_HIGH 3U
+#define BOARD_PULL_NONE  0U
+#define BOARD_PULL_UP    1U
+#define BOARD_PULL_DOWN  2U
+//-----------------------------------------------------------------------------
+// Setup of pin (bytes: table in flash)
+struct board_pin {
+	uint8_t grp;    // BOARD_GRP_x
+	uint8_t port;   // BOARD_Px
+	uint8_t pin;
+	uint8_t mode;   // BOARD_MODE_x
+	uint8_t speed;  // BOARD_SPEED_x
+	uint8_t pull;   // BOARD_PULL_x
+	uint8_t af;     // alternate function (BOARD_MODE_AF)
+};
+//-----------------------------------------------------------------------------
+void board_gpioInit(uint32_t grp);
+//=============================================================================
+#endif // BOARD_H
+//=============================================================================
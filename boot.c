@@ -0,0 +1,155 @@
+//=============================================================================
+/*
+* modules:
+ - RTC backup registers BKP0R ... BKP3R (backup domain: kept over system
+   reset, over power-off with VBAT only); PWR (APB 1): DBP
+ - RCC: reset flags (CSR)
+* notes:
+ - warm boot: stored state is valid (magic, check sum) and reset is not
+   power-on (PORRSTF); last focus target is kept (not position of first
+   frame), pole is restored without re-home (see pole_start()), ADC 1
+   calibration factor without calibration (see focus.c), no calibration
+   of range at start (config.calib_boot)
+ - pole is trusted only when stopped: main loop stores BOOT_POLE_NONE
+   before each move, boot_init() up to first pass => reset during move or
+   re-home re-homes again
+ - targets are stored from reset-to-operational on, each change is state
+   and check sum (main loop, on change only); reset between stores =>
+   check sum is wrong => cold boot
+ - reset-to-operational: DWT (irq_init()) up to first pass of main loop
+   with focus and pole ready; clock_change() before DWT is not counted
+*/
+//=============================================================================
+#include "main.h"
+#include "boot.h"
+#include "irq.h"
+#include "clock.h"
+#include "focus.h"
+#include "pole.h"
+#include "can.h"
+//=============================================================================
+static uint32_t boot_warm;
+static uint32_t boot_csr;      // reset flags (RCC CSR [31:24])
+static uint32_t boot_stored;   // state at boot (focus, pole)
+static uint32_t boot_state;    // in BKP1R
+static uint32_t boot_calfact;  // in BKP2R
+static uint32_t boot_us;       // reset-to-operational (0 - not yet)
+//=============================================================================
+static void 
+boot_store(void)
+{
+	RTC->BKP1R = boot_state;
+	RTC->BKP2R = boot_calfact;
+	RTC->BKP3R = ~(BOOT_MAGIC + boot_state + boot_calfact);
+}
+//-----------------------------------------------------------------------------
+// After irq_init() (DWT), before focus_init() and pole_start()
+// 1. Enable clock for PWR, access to backup domain
+// 2. Reset flags (cleared for next reset)
+// 3. Stored state: warm boot if valid and not power-on
+// 4. Pole is not trusted up to first pass of main loop
+void 
+boot_init(void)
+{
+	// For delay
+	int32_t i;
+	uint32_t state, calfact;
+	
+  // 1. Enable clock for PWR + delay, access to backup domain
+	RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+	for (i = 0; i < 15; ++i);
+	PWR->CR |= PWR_CR_DBP;
+	
+  // 2. Reset flags (cleared for next reset)
+	boot_csr = RCC->CSR >> BOOT_CSR_POS;
+	RCC->CSR |= RCC_CSR_RMVF;
+	boot_us = 0;
+	
+  // 3. Stored state: warm boot if valid and not power-on
+	state = RTC->BKP1R;
+	calfact = RTC->BKP2R;
+	boot_warm = RTC->BKP0R == BOOT_MAGIC && 
+		RTC->BKP3R == ~(BOOT_MAGIC + state + calfact) && 
+		!(boot_csr & RCC_CSR_PORRSTF >> BOOT_CSR_POS);
+	if (!boot_warm) {
+		state = BOOT_FOCUS_NONE | BOOT_POLE_NONE << BOOT_POLE_POS;
+		calfact = BOOT_NONE;
+	}
+	boot_stored = state;
+	boot_calfact = calfact;
+	
+  // 4. Pole is not trusted up to first pass of main loop
+	boot_state = state | BOOT_POLE_NONE << BOOT_POLE_POS;
+	RTC->BKP0R = BOOT_MAGIC;
+	boot_store();
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+boot_isWarm(void)
+{
+	return boot_warm;
+}
+//-----------------------------------------------------------------------------
+// Focus target of warm boot (ADC counts) or BOOT_FOCUS_NONE
+uint32_t 
+boot_getFocus(void)
+{
+	uint32_t focus = boot_stored & BOOT_FOCUS_NONE;
+	
+	return focus <= FOCUS_MASK ? focus : BOOT_FOCUS_NONE;
+}
+//-----------------------------------------------------------------------------
+// Pole of warm boot (stopped) or BOOT_POLE_NONE
+uint32_t 
+boot_getPole(void)
+{
+	uint32_t pole = boot_stored >> BOOT_POLE_POS & BOOT_POLE_NONE;
+	
+	return pole <= POLE_2 ? pole : BOOT_POLE_NONE;
+}
+//-----------------------------------------------------------------------------
+// Calibration factor of ADC 1 of warm boot or BOOT_NONE
+uint32_t 
+boot_getCalfact(void)
+{
+	return boot_calfact;
+}
+//-----------------------------------------------------------------------------
+// After calibration of ADC 1 (cold boot)
+void 
+boot_setCalfact(uint32_t calfact)
+{
+	boot_calfact = calfact;
+	boot_store();
+}
+//=============================================================================
+// Main loop (pole is ready), before pole_setPole(): store targets on change
+// moving - pole moves or is moved by this pass (not trusted)
+void 
+boot_poll(uint32_t moving)
+{
+	uint32_t state;
+	
+	if (!boot_us) {
+		if (focus_getState() != FOCUS_STATE_OK)
+			return;
+		boot_us = irq_cycles() / (clock_getHclk() / 1000000U);
+	}
+	state = (focus_target & BOOT_FOCUS_NONE) | 
+		(moving ? BOOT_POLE_NONE : pole_getPole()) << BOOT_POLE_POS;
+	if (state == boot_state)
+		return;
+	boot_state = state;
+	boot_store();
+}
+//-----------------------------------------------------------------------------
+// Answer of CAN_SRV_BOOT (without opcode)
+void 
+boot_getStat(uint32_t *l, uint32_t *h)
+{
+	*l = boot_warm << CAN_SRV_ARG1_POS | 
+		(boot_csr & 0xFFU) << CAN_SRV_ARG2_POS | 
+		(boot_getPole() != BOOT_POLE_NONE) << CAN_SRV_ARG3_POS;
+	*h = boot_us;
+}
+//=============================================================================
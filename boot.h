@@ -0,0 +1,25 @@
+//=============================================================================
+#ifndef BOOT_H
+#define BOOT_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+// Stored state (RTC backup registers, see boot.c)
+#define BOOT_MAGIC       0x4C420001U  // "LB" + version of layout
+#define BOOT_NONE        0xFFFFFFFFU  // no calibration factor
+#define BOOT_FOCUS_NONE  0xFFFFU      // focus target of first frame
+#define BOOT_POLE_NONE   0xFFU        // pole is moving: not trusted
+#define BOOT_POLE_POS    16U
+#define BOOT_CSR_POS     24U          // reset flags in RCC CSR
+//-----------------------------------------------------------------------------
+void boot_init(void);
+uint32_t boot_isWarm(void);
+uint32_t boot_getFocus(void);
+uint32_t boot_getPole(void);
+uint32_t boot_getCalfact(void);
+void boot_setCalfact(uint32_t calfact);
+void boot_poll(uint32_t moving);
+void boot_getStat(uint32_t *l, uint32_t *h);
+//=============================================================================
+#endif // BOOT_H
+//=============================================================================
@@ -0,0 +1,259 @@
+//=============================================================================
+/*
+* modules:
+ - RAM only (focus keys by focus.c, result in flash by config.c)
+* phases (calib_tick() from DMA 1 Channel 1 interrupt, 1 KHz):
+ 1. NOISE - keys stopped: peak-to-peak of ADC
+ 2. BACK - slow move back to end stop: minimum of range
+ 3. FAST - full speed forward: maximum speed (counts per CALIB_WIN_MS)
+ 4. COAST - keys stopped: counts after stop from maximum speed
+ 5. FORWARD - slow move forward to end stop: maximum of range
+* notes:
+ - main loop does not control focus while FOCUS_STATE_CALIB is set
+ - end (DMA interrupt) keeps FOCUS_STATE_CALIB: main loop (calib_poll()) 
+   sets focus target to final position and then controls focus again 
+   (main loop is only writer of focus_target); commands are rejected 
+   (CAN_EV_CALIB) while FOCUS_STATE_CALIB is set, command received before 
+   start is held up to end (main.c)
+ - each phase is limited by CALIB_PHASE_MS => calibration is completed 
+   in 5 * CALIB_PHASE_MS in the worst case (timeout)
+ - result is sent by main loop (calib_poll()) as CAN_SRV_CALIB_READ 
+   answers (parts 0 ... 2)
+*/
+//=============================================================================
+#include "main.h"
+#include "calib.h"
+#include "focus.h"
+#include "config.h"
+#include "can.h"
+//=============================================================================
+#define CALIB_PH_NOISE    0U
+#define CALIB_PH_BACK     1U
+#define CALIB_PH_FAST     2U
+#define CALIB_PH_COAST    3U
+#define CALIB_PH_FORWARD  4U
+//-----------------------------------------------------------------------------
+#define CALIB_PARTS  3U  // answers of CAN_SRV_CALIB_READ
+//-----------------------------------------------------------------------------
+static volatile uint32_t calib_state;   // CALIB_x
+static uint32_t calib_phase;
+static uint32_t calib_ms;               // all phases
+static uint32_t calib_phase_ms;
+static uint32_t calib_lo, calib_hi;     // noise
+static uint32_t calib_win_pos, calib_win_ms;
+static uint32_t calib_stop_pos;         // position at stop (coast)
+static uint32_t calib_min, calib_noise, calib_speed, calib_coast;
+static volatile uint32_t calib_report;  // parts left to send
+static volatile uint32_t calib_pos;     // final position (to main loop)
+//=============================================================================
+void 
+calib_init(void)
+{
+	calib_state = config.focus_calib;
+	calib_report = 0;
+}
+//-----------------------------------------------------------------------------
+// Return -1 if calibration is run already (or its end is not taken by 
+// main loop)
+int32_t 
+calib_start(void)
+{
+	if (calib_state == CALIB_RUN || focus_getState() & FOCUS_STATE_CALIB)
+		return -1;
+	
+	calib_phase = CALIB_PH_NOISE;
+	calib_ms = 0;
+	calib_phase_ms = 0;
+	calib_lo = 0xFFFFFFFFU;
+	calib_hi = 0;
+	calib_speed = 0;
+	calib_coast = 0;
+	calib_report = 0;
+	
+	// Main loop stops focus control
+	focus_calibEn();
+	calib_state = CALIB_RUN;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+static void 
+calib_next(uint32_t phase, uint32_t pos)
+{
+	calib_phase = phase;
+	calib_phase_ms = 0;
+	calib_win_pos = pos;
+	calib_win_ms = 0;
+}
+//-----------------------------------------------------------------------------
+// Return 1 if position is not changed more than noise during ms
+static uint32_t 
+calib_still(uint32_t pos, uint32_t ms)
+{
+	uint32_t d;
+	
+	if (++calib_win_ms < ms)
+		return 0;
+	
+	d = pos > calib_win_pos ? pos - calib_win_pos : calib_win_pos - pos;
+	calib_win_pos = pos;
+	calib_win_ms = 0;
+	return d <= calib_noise + CALIB_STILL_BAND;
+}
+//-----------------------------------------------------------------------------
+static void 
+calib_slow(uint32_t dir)
+{
+	if (calib_phase_ms % CALIB_DUTY_PERIOD < CALIB_DUTY_ON) {
+		if (dir == FOCUS_DIR_BACK)
+			focus_keysBack();
+		else
+			focus_keysForward();
+	} else {
+		focus_keysStop();
+	}
+}
+//-----------------------------------------------------------------------------
+static void 
+calib_end(uint32_t state, uint32_t pos)
+{
+	focus_keysStop();
+	
+	if (state == CALIB_OK && pos < calib_min + CALIB_RANGE_MIN)
+		state = CALIB_RANGE;
+	
+	if (state == CALIB_OK) {
+		config.focus_min = calib_min;
+		config.focus_max = pos;
+		config.focus_speed = calib_speed;
+		config.focus_noise = calib_noise;
+		config.focus_coast = calib_coast;
+		// Stop before target by coast; do not start again inside 
+		// coast + noise
+		config.focus_band_stop = calib_coast;
+		config.focus_band_start = 
+			calib_coast + calib_noise + CALIB_MARGIN;
+	}
+	config.focus_calib = state;
+	config_request();
+	
+	// Stay here: target and focus control by main loop (calib_poll())
+	calib_pos = pos;
+	__DMB();
+	
+	calib_state = state;
+	calib_report = CALIB_PARTS;
+}
+//=============================================================================
+// DMA 1 Channel 1 interrupt (each frame); pos - ADC counts
+void 
+calib_tick(uint32_t pos)
+{
+	uint32_t d;
+	
+	if (calib_state != CALIB_RUN)
+		return;
+	
+	++calib_ms;
+	if (++calib_phase_ms > CALIB_PHASE_MS) {
+		calib_end(CALIB_TIMEOUT, pos);
+		return;
+	}
+	
+	switch (calib_phase) {
+	case CALIB_PH_NOISE:
+		focus_keysStop();
+		if (pos < calib_lo)
+			calib_lo = pos;
+		if (pos > calib_hi)
+			calib_hi = pos;
+		if (calib_phase_ms >= CALIB_NOISE_MS) {
+			calib_noise = calib_hi - calib_lo;
+			calib_next(CALIB_PH_BACK, pos);
+		}
+		break;
+	case CALIB_PH_BACK:
+		calib_slow(FOCUS_DIR_BACK);
+		if (calib_still(pos, CALIB_STILL_MS)) {
+			calib_min = pos;
+			calib_next(CALIB_PH_FAST, pos);
+		}
+		break;
+	case CALIB_PH_FAST:
+		focus_keysForward();
+		if (calib_phase_ms % CALIB_WIN_MS == 0) {
+			d = pos > calib_win_pos ? pos - calib_win_pos : 0;
+			if (d > calib_speed)
+				calib_speed = d;
+			calib_win_pos = pos;
+		}
+		if (calib_phase_ms >= CALIB_FAST_MS) {
+			focus_keysStop();
+			calib_stop_pos = pos;
+			calib_next(CALIB_PH_COAST, pos);
+		}
+		break;
+	case CALIB_PH_COAST:
+		focus_keysStop();
+		if (calib_still(pos, CALIB_SETTLE_MS)) {
+			calib_coast = pos > calib_stop_pos ? pos - calib_stop_pos : 0;
+			calib_next(CALIB_PH_FORWARD, pos);
+		}
+		break;
+	case CALIB_PH_FORWARD:
+		calib_slow(FOCUS_DIR_FORWARD);
+		if (calib_still(pos, CALIB_STILL_MS))
+			calib_end(CALIB_OK, pos);
+		break;
+	default:
+		break;
+	}
+}
+//=============================================================================
+// Answer for CAN_SRV_CALIB_READ (without opcode)
+// part 0: 1 - 0, 2 - state; 4..5 - min, 6..7 - max
+// part 1: 1 - 1, 2..3 - speed; 4..5 - noise, 6..7 - coast
+// part 2: 1 - 2, 2..3 - start band; 4..5 - stop band, 6..7 - time (10 ms)
+void 
+calib_get(uint32_t part, uint32_t *l, uint32_t *h)
+{
+	switch (part) {
+	case 0:
+		*l = calib_state << CAN_SRV_ARG2_POS;
+		*h = config.focus_min | config.focus_max << 16;
+		break;
+	case 1:
+		*l = config.focus_speed << CAN_SRV_ARG2_POS;
+		*h = config.focus_noise | config.focus_coast << 16;
+		break;
+	default:
+		part = 2;
+		*l = config.focus_band_start << CAN_SRV_ARG2_POS;
+		*h = config.focus_band_stop | (calib_ms / 10U & 0xFFFFU) << 16;
+		break;
+	}
+	*l |= part << CAN_SRV_ARG1_POS;
+}
+//-----------------------------------------------------------------------------
+// Main loop: end of calibration (focus stays at final position), then 
+// send result (one part per call, thread 1)
+void 
+calib_poll(void)
+{
+	uint32_t part, l, h;
+	
+	if (focus_getState() & FOCUS_STATE_CALIB && calib_state != CALIB_RUN) {
+		__DMB();
+		focus_target = calib_pos;
+		focus_calibDis();
+	}
+	
+	if (!calib_report)
+		return;
+	
+	part = CALIB_PARTS - calib_report;
+	calib_get(part, &l, &h);
+	if (can_send(CAN_ID_SRV, 8, 
+			CAN_SRV_CALIB_READ << CAN_SRV_OP_POS | l, h, 1) == 0)
+		--calib_report;
+}
+//=============================================================================
@@ -0,0 +1,34 @@
+//=============================================================================
+#ifndef CALIB_H
+#define CALIB_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+// Status of calibration (config.focus_calib)
+#define CALIB_NONE     0U  // never (default mapping and controller)
+#define CALIB_OK       1U
+#define CALIB_RUN      2U
+#define CALIB_TIMEOUT  3U  // phase is not completed in CALIB_PHASE_MS
+#define CALIB_RANGE    4U  // range is less than CALIB_RANGE_MIN
+//-----------------------------------------------------------------------------
+// All times in DMA frames (ms)
+#define CALIB_NOISE_MS     200U    // standstill for ADC noise
+#define CALIB_STILL_MS     200U    // window for end stop detection
+#define CALIB_STILL_BAND   8U      // counts over noise: not moving
+#define CALIB_FAST_MS      300U    // full speed (max speed)
+#define CALIB_SETTLE_MS    50U     // window for coast end detection
+#define CALIB_WIN_MS       10U     // window for speed
+#define CALIB_DUTY_ON      1U      // slow move: on 1 ms of 4 ms
+#define CALIB_DUTY_PERIOD  4U
+#define CALIB_PHASE_MS     20000U  // time limit of each phase
+#define CALIB_RANGE_MIN    500U    // counts
+#define CALIB_MARGIN       4U      // counts (start band over coast + noise)
+//-----------------------------------------------------------------------------
+void calib_init(void);
+int32_t calib_start(void);
+void calib_tick(uint32_t pos);
+void calib_get(uint32_t part, uint32_t *l, uint32_t *h);
+void calib_poll(void);
+//=============================================================================
+#endif // CALIB_H
+//=============================================================================
@@ -1,50 +1,225 @@
 //=============================================================================
 /*
 * modules:
- - GPIO B (AHB): pin 8 ("CAN_RX"), pin 9 ("CAN_TX")
+ - GPIO (AHB): "CAN_RX", "CAN_TX" (see board.h)
  - CAN (APB 1)
 * notes:
- - look for "<RCC>" for code depend on system clock frequence value
+ - bit timing for each rate (CAN_RATE_x) is computed from PCLK1 (clock.c)
+   at start: BRP x (1 + TS1 + TS2) = PCLK1 / rate exactly, sample point 
+   near CAN_SAMPLE / 16
+ - automatic rate (CAN_RATE_AUTO): silent mode at candidate rate, LEC = 7 
+   by software; LEC = 0 after frame without error (also not passed by 
+   filters) => rate is found (normal mode); error or CAN_BAUD_WAIT_MS 
+   without frame => next candidate
+ - each thread of can_send() has own TX mailbox and own counters: thread 0 
+   from CAN RX interrupt, thread 1 from main loop (no shared counter)
+ - TX queue of one frame per thread (mailbox): can_send() requests 
+   transmission without wait; result (RQCP), abort after CAN_TX_TIMEOUT 
+   and retries after backoff (CAN_RETRY_SW) by elapsed time in can_poll() 
+   => no busy wait in interrupt or main loop; thread 0 waits only for 
+   own frame on bus (up to CAN_TX_WAIT) and replaces queued retry (lost), 
+   threads 1, 2 get -1 while mailbox is busy (caller sends again)
+ - retransmission policy (config.can_retry) is applied at start and by 
+   can_poll() between frames (NART is written in initialization mode)
+ - bus-off: recovery by hardware (ABOM, 128 x 11 recessive bits); start 
+   in CAN SCE interrupt, end in can_poll() => recovery time in cycles
+ - load statistics (CAN_SRV_CAN_LOAD): filter bank 2 (mask 0) stores 
+   frames of other nodes in FIFO 1, CAN RX1 interrupt only counts them 
+   (list of bank 0, 1 has priority => own IDs stay in FIFO 0)
+ - bus load: bits of received (FIFO 0, 1) and sent frames with worst case 
+   of stuff bits (upper bound) per bit times of window (CAN_LOAD_MS, 
+   can_poll()); frames not seen by node (Stop mode, overrun) are missing
+ - counters of load have one writer (CAN RX interrupts are in one 
+   preemption group, each thread of can_send() has own counter); 
+   can_poll() takes differences at end of window
+ - TX delay: can_send() call up to TXOK seen by can_poll() or can_send() 
+   (arbitration, retries, backoff); 
+   RX-to-processing latency: commands from CAN RX interrupt up to main 
+   loop (cmd.c), other frames are processed in interrupt (irq.c)
 */
 //=============================================================================
 #include "main.h"
 #include "can.h"
+#include "irq.h"
+#include "cmd.h"
+#include "focus.h"
+#include "config.h"
+#include "clock.h"
+#include "power.h"
+#include "board.h"
 //=============================================================================
+// Transmit statistics of one thread (TX mailbox)
+struct can_tx {
+	uint32_t ok;
+	uint32_t alst;     // arbitration lost
+	uint32_t terr;     // transmission error
+	uint32_t retry;    // retries by can_poll() (CAN_RETRY_SW)
+	uint32_t timeout;  // aborted after CAN_TX_TIMEOUT
+	uint32_t lost;     // not sent (last attempt failed or bus-off)
+	uint32_t bits;     // bits of sent frames (load statistics)
+	uint32_t delay;    // max from can_send() up to TXOK (cycles)
+};
+//-----------------------------------------------------------------------------
+// TX queue of one thread: frame stays in mailbox up to result (see notes)
+#define CAN_Q_IDLE   0U  // mailbox is free
+#define CAN_Q_TX     1U  // transmit request
+#define CAN_Q_ABORT  2U  // abort request after CAN_TX_TIMEOUT
+#define CAN_Q_WAIT   3U  // backoff before retry (can_poll())
+
+struct can_q {
+	uint32_t state;    // CAN_Q_x
+	uint32_t n;        // retries done
+	uint32_t retries;  // allowed (policy at can_send())
+	uint32_t t;        // start of attempt or backoff (cycles)
+	uint32_t tq;       // can_send() call (TX delay)
+	uint32_t bits;     // bits of frame (load statistics)
+};
+//-----------------------------------------------------------------------------
 static uint32_t can_state;
+static struct can_tx can_tx[3];
+static struct can_q can_q[3];
+static volatile uint32_t can_boff;      // bus-off events
+static volatile uint32_t can_boffT;     // start of bus-off (cycles), 0 - no
+static volatile uint32_t can_epv;       // error passive events
+static volatile uint32_t can_recovLast; // bus-off recovery time (cycles)
+static volatile uint32_t can_recovMax;
+//-----------------------------------------------------------------------------
+// Load statistics (see notes)
+static volatile uint32_t can_rxN[CAN_RXID_NUM];  // received frames
+static volatile uint32_t can_rxBits;    // bits of received frames
+static volatile uint32_t can_fmpMax[2]; // max fill of FIFO 0, 1
+static volatile uint32_t can_ovrN[2];   // overruns of FIFO 0, 1
+static volatile uint32_t can_topId;     // lowest ID of other nodes
+static volatile uint32_t can_topN;      // its frames
+static uint32_t can_winT;               // start of window (cycles)
+static uint32_t can_winFrame;           // focus_getFrames() at last check
+static uint32_t can_winRx[CAN_RXID_NUM];  // counters at start of window
+static uint32_t can_winBits;
+static uint32_t can_fps[CAN_RXID_NUM];  // frames/s of last window
+static uint32_t can_topIdLast;
+static uint32_t can_topFps;
+static uint32_t can_load;               // last window (0.1 %)
+static uint32_t can_loadMax;
+//-----------------------------------------------------------------------------
+// Bit rates (CAN_RATE_x order)
+static const uint32_t can_rates[CAN_RATE_NUM] = {
+	1000000U, 800000U, 500000U, 250000U, 125000U, 100000U, 50000U, 20000U, 
+	10000U
+};
+static uint32_t can_btr[CAN_RATE_NUM];  // 0 - not supported with clock
+static uint32_t can_rate;               // CAN_RATE_x or CAN_RATE_NONE
+static uint32_t can_cand;               // candidate while search
+static uint32_t can_candT;              // start of listen (cycles)
+static uint32_t can_btrCur;             // BTR in hardware
+static uint32_t can_bitT;               // bit time (cycles of HCLK)
+static uint32_t can_hclk;
+static volatile uint32_t can_rateReq;   // new rate in configuration
 //=============================================================================
-// 1. Enable clock for GPIO B
-// 2. Alternative function 9 (CAN) for pin 8 and 9
+// Alternative function (CAN) for RX and TX pins (see board.c)
 void 
 can_gpio_init(void)
 {
-	#define CAN_ALT_FUNC 9U
-	
-	// For delay
-	int32_t i;
+	board_gpioInit(BOARD_GRP_CAN);
+}
+//-----------------------------------------------------------------------------
+// NART bit for policy from configuration
+static uint32_t 
+can_nart(void)
+{
+	return (config.can_retry >> CAN_RETRY_POS & CAN_RETRY_MSK) == 
+		CAN_RETRY_HW ? 0 : CAN_MCR_NART;
+}
+//-----------------------------------------------------------------------------
+// BTR for bit rate (bit/s) or 0 if not exact; more time quanta first
+static uint32_t 
+can_timing(uint32_t pclk, uint32_t bps)
+{
+	uint32_t tq, brp, ts1, ts2;
 	
-  // 1. Enable clock for GPIO B + delay
-	RCC->AHBENR |= RCC_AHBENR_GPIOBEN;
-	for (i = 0; i < 15; ++i);
+	for (tq = CAN_TQ_MAX; tq >= CAN_TQ_MIN; --tq) {
+		if (pclk % (bps * tq))
+			continue;
+		brp = pclk / (bps * tq);
+		if (brp > 1024U)
+			continue;
+		// Sync segment (1 tq) + TS1 up to sample point, TS2 after
+		ts2 = tq - (tq * CAN_SAMPLE + 8U) / 16U;
+		ts2 = ts2 < 2U ? 2U : ts2 > 8U ? 8U : ts2;
+		ts1 = tq - 1U - ts2;
+		if (ts1 > 16U)
+			continue;
+		return (brp - 1U) << CAN_BTR_BRP_Pos | 
+			(ts1 - 1U) << CAN_BTR_TS1_Pos | 
+			(ts2 - 1U) << CAN_BTR_TS2_Pos | 
+			(ts2 > 2U ? 1U : ts2 - 1U) << CAN_BTR_SJW_Pos;
+	}
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Next supported rate after r (cyclic), CAN_RATE_NONE if no one
+static uint32_t 
+can_nextRate(uint32_t r)
+{
+	uint32_t i;
 	
-  // 2. Alternative function 9 (CAN) for pin 8 and 9
-	GPIOB->MODER |= GPIO_MODER_MODER8_1 | GPIO_MODER_MODER9_1;
-	GPIOB->AFR[1] |= 
-		CAN_ALT_FUNC << GPIO_AFRH_AFRH0_Pos | 
-		CAN_ALT_FUNC << GPIO_AFRH_AFRH1_Pos;
-	for (i = 0; i < 15; ++i);
+	for (i = 1; i <= CAN_RATE_NUM; ++i)
+		if (can_btr[(r + i) % CAN_RATE_NUM])
+			return (r + i) % CAN_RATE_NUM;
+	return CAN_RATE_NONE;
+}
+//-----------------------------------------------------------------------------
+// BTR for active rate or for candidate (silent mode while search)
+static uint32_t 
+can_btrWant(void)
+{
+	if (can_rate == CAN_RATE_NONE)
+		return can_btr[can_cand] | CAN_BTR_SILM;
+	return can_btr[can_rate];
+}
+//-----------------------------------------------------------------------------
+// Initialization mode only; bit time for timeouts of can_send()
+static void 
+can_setBtr(void)
+{
+	can_btrCur = can_btrWant();
+	CAN->BTR = can_btrCur;
+	can_bitT = can_hclk / can_rates[can_rate == CAN_RATE_NONE ? 
+		can_cand : can_rate];
+}
+//-----------------------------------------------------------------------------
+// Active rate (or search) from configuration
+static void 
+can_selectRate(void)
+{
+	uint32_t r = config.can_rate;
 	
-	#undef CAN_ALT_FUNC
+	if (r < CAN_RATE_NUM && can_btr[r]) {
+		can_rate = r;
+	} else {
+		// CAN_RATE_AUTO (or not supported): search from highest
+		can_rate = CAN_RATE_NONE;
+		can_cand = can_nextRate(CAN_RATE_NUM - 1U);
+	}
+}
+//-----------------------------------------------------------------------------
+// Start of listen at candidate rate (normal mode)
+static void 
+can_listen(void)
+{
+	// LEC = 7: set by software (0 - by hardware after frame)
+	CAN->ESR = CAN_ESR_LEC_Msk;
+	can_candT = irq_cycles();
 }
 //-----------------------------------------------------------------------------
 // 1. Enable clock for CAN
 // 2. Sleep mode -> Initialization mode + confirm
 // 3. Transmit priority by the request order
-// 4. Non automatic retransmission mode
-// 5. Enable interrupt for reception message (FIFO 0)
+// 4. Retransmission policy (config.can_retry)
+// 5. Enable interrupt for reception message (FIFO 0, 1)
 // 6 (disable). Enable interrupt when full (FIFO 0)
-// 7. Enable interrupt for overrun (FIFO 0)
-// 8 (disable). Enable Buss-Off interrupt
-// 9 (disable). Enable error interrupt
+// 7. Enable interrupt for overrun (FIFO 0, 1)
+// 8. Enable Bus-Off and error passive interrupt
+// 9. Enable error interrupt
 // 10. Auto exit from Bus-Off state
 // 11. Bit-timeing setting
 // 12 (disable). Enable time triggered communication mode
@@ -53,9 +228,10 @@ can_gpio_init(void)
 // X+1. Identifier list mode for filter bank 0, 1
 // X+2. Single 32-bit scale configuration for filter bank 0, 1
 // X+3. Set id list for filter bank 0, 1
+// X+4. Mask mode for filter bank 2 (all IDs) to FIFO 1
 
 // Y. Exit from filter setting mode
-// Y+1. Activate filter bank 0, 1
+// Y+1. Activate filter bank 0, 1, 2
 
 // Z. Enable interrupt using NVIC
 void 
@@ -63,8 +239,33 @@ can_init(void)
 {
 	// For delay
 	int32_t i;
+	uint32_t r;
 	
 	can_state = CAN_STATE_OK;
+	can_rateReq = 0;
+	can_resetStat();
+	for (r = 0; r < 3U; ++r)
+		can_q[r].state = CAN_Q_IDLE;
+	for (r = 0; r < CAN_RXID_NUM; ++r) {
+		can_rxN[r] = 0;
+		can_winRx[r] = 0;
+		can_fps[r] = 0;
+	}
+	can_rxBits = 0;
+	can_winBits = 0;
+	can_topId = CAN_LOAD_NOID;
+	can_topIdLast = CAN_LOAD_NOID;
+	can_topN = 0;
+	can_topFps = 0;
+	can_load = 0;
+	can_winT = irq_cycles();
+	can_winFrame = 0;
+	
+	// Bit timing for all rates (from active clock)
+	can_hclk = clock_getHclk();
+	for (r = 0; r < CAN_RATE_NUM; ++r)
+		can_btr[r] = can_timing(clock_getPclk1(), can_rates[r]);
+	can_selectRate();
 	
 	// Enable alternative function for CAN
 	can_gpio_init();
@@ -79,35 +280,25 @@ can_init(void)
 	while (!(CAN->MSR & CAN_MSR_INAK) && CAN->MSR & CAN_MSR_SLAK);
 	
   // 3. Transmit priority by the request order
-  // 4. Non automatic retransmission mode
-	CAN->MCR |= CAN_MCR_TXFP | CAN_MCR_NART;
+  // 4. Retransmission policy (config.can_retry)
+	CAN->MCR |= CAN_MCR_TXFP | can_nart();
 	
-  // 5. Enable interrupt for reception message (FIFO 0)
+  // 5. Enable interrupt for reception message (FIFO 0, 1)
   // 6 (disable). Enable interrupt when full (FIFO 0)
-  // 7. Enable interrupt for overrun (FIFO 0)
+  // 7. Enable interrupt for overrun (FIFO 0, 1)
 	CAN->IER |= CAN_IER_FMPIE0 | CAN_IER_FOVIE0; // 6: | CAN_IER_FFIE0
+	CAN->IER |= CAN_IER_FMPIE1 | CAN_IER_FOVIE1;
 	
-  // 8 (disable). Enable Bus-Off interrupt
-  // 9 (disable). Enable error interrupt
-	// CAN->IER |= CAN_IER_BOFIE | CAN_IER_ERRIE;
+  // 8. Enable Bus-Off and error passive interrupt
+  // 9. Enable error interrupt
+	CAN->IER |= CAN_IER_BOFIE | CAN_IER_EPVIE | CAN_IER_ERRIE;
 	
   // 10. Auto exit from Bus-Off state
 	CAN->MCR |= CAN_MCR_ABOM;
 	
-  // 11. Bit-timing setting
-	// <RCC>
-	// 8 MHz system clock - 500 Kbit/s
-	// 16 MHz system clock - 1000 Kbit/s
-	#define TS1 11U // BS1 = 11 + 1 = 12
-	#define TS2 2U  // BS2 =  2 + 1 =  3
-	#define SJW 1U  // SJW =  1 + 1 =  2
-	CAN->BTR &= ~CAN_BTR_SJW_Msk | ~CAN_BTR_TS2_Msk | ~CAN_BTR_TS1_Msk;
-	for (i = 0; i < 2; ++i);
-	CAN->BTR |= TS1 << CAN_BTR_TS1_Pos | TS2 << CAN_BTR_TS2_Pos | 
-		SJW << CAN_BTR_SJW_Pos;
-	#undef TS1
-	#undef TS2
-	#undef SJW
+  // 11. Bit-timing setting (from table, silent mode while search)
+	// e.g. 16 MHz PCLK1, 1000 Kbit/s: BRP = 1, BS1 = 12, BS2 = 3, SJW = 2
+	can_setBtr();
 	
   // 12 (disable). Enable time triggered communication mode
 	// CAN->MCR |= CAN_MCR_TTCM;
@@ -123,20 +314,38 @@ can_init(void)
 	
   // X+3. Set id list for filter bank 0, 1
 	CAN->sFilterRegister[0].FR1 = CAN_ID_CMD << 21;
-	CAN->sFilterRegister[0].FR2 = 0; // CAN_ID_CMD << 21 | 1 << 1; // + rtr
+	CAN->sFilterRegister[0].FR2 = CAN_ID_SRV << 21;
 	
 	CAN->sFilterRegister[1].FR1 = CAN_ID_CTRL << 21;
 	CAN->sFilterRegister[1].FR2 = 0;
 	
+  // X+4. Mask mode for filter bank 2 (all IDs) to FIFO 1
+	// Load statistics: mask 0 matches any frame, bank 0, 1 have priority
+	CAN->FS1R |= CAN_FS1R_FSC2;
+	CAN->sFilterRegister[2].FR1 = 0;
+	CAN->sFilterRegister[2].FR2 = 0;
+	CAN->FFA1R |= CAN_FFA1R_FFA2;
+	
   // Y. Exit from filter setting mode
 	CAN->FMR &= ~CAN_FMR_FINIT;
 	
-  // Y+1. Activate filter bank 0, 1
-	CAN->FA1R |= CAN_FA1R_FACT0 | CAN_FA1R_FACT1;
+  // Y+1. Activate filter bank 0, 1, 2
+	CAN->FA1R |= CAN_FA1R_FACT0 | CAN_FA1R_FACT1 | CAN_FA1R_FACT2;
 	
-  // Z. Enable interrupt from CAN RX0 (filter bank 0, 1)
+  // Z. Enable interrupt from CAN RX0 (filter bank 0, 1; priority - irq.h)
+	NVIC_SetPriority(USB_LP_CAN_RX0_IRQn, 
+		IRQ_PRIO(IRQ_CAN_RX0_PRE, IRQ_CAN_RX0_SUB));
 	NVIC_EnableIRQ(USB_LP_CAN_RX0_IRQn);
 	
+	// FIFO 1: frames of other nodes (filter bank 2)
+	NVIC_SetPriority(CAN_RX1_IRQn, 
+		IRQ_PRIO(IRQ_CAN_RX1_PRE, IRQ_CAN_RX1_SUB));
+	NVIC_EnableIRQ(CAN_RX1_IRQn);
+	
+	// Status change and error (bus-off, error passive)
+	NVIC_SetPriority(CAN_SCE_IRQn, 
+		IRQ_PRIO(IRQ_CAN_SCE_PRE, IRQ_CAN_SCE_SUB));
+	NVIC_EnableIRQ(CAN_SCE_IRQn);
 }
 //=============================================================================
 void 
@@ -145,68 +354,190 @@ can_start(void)
 	// Initialization mode -> Normal mode + confirm
 	CAN->MCR &= ~CAN_MCR_INRQ;
 	while (CAN->MSR & CAN_MSR_INAK);
+	
+	if (can_rate == CAN_RATE_NONE)
+		can_listen();
 }
 //=============================================================================
+// Bits of standard data frame on bus (interframe space included) with 
+// worst case of stuff bits: one per 4 bits after first 5 of 34 + data
+static uint32_t 
+can_frameBits(uint32_t dlc)
+{
+	if (dlc > 8U)
+		dlc = 8U;
+	return 47U + 8U * dlc + (33U + 8U * dlc) / 4U;
+}
+//-----------------------------------------------------------------------------
+// Transmit request of frame in mailbox of thread (0 ... 2)
+static void 
+can_request(uint32_t thread)
+{
+	// For delay
+	int32_t i;
+	
+	CAN->sTxMailBox[thread].TIR |= CAN_TI0R_TXRQ;
+	// Delay (TXRQ clear RQCP)
+	for (i = 0; i < 2; ++i);
+	can_q[thread].state = CAN_Q_TX;
+	can_q[thread].t = irq_cycles();
+}
+//-----------------------------------------------------------------------------
+// Result of attempt (RQCP is set): failed => backoff before retry 
+// (CAN_Q_WAIT) or lost
+// Flags of mailbox x are at 8 * x in TSR (RQCPx, TXOKx, ALSTx, TERRx, ABRQx)
+static void 
+can_result(uint32_t thread)
+{
+	struct can_tx *st = &can_tx[thread];
+	struct can_q *q = &can_q[thread];
+	uint32_t tsr, t;
+	
+	// Check transmit status (ALST / TERR of last attempt; with 
+	// CAN_RETRY_HW also after successful retransmission)
+	tsr = CAN->TSR >> 8U * thread;
+	if (tsr & CAN_TSR_ALST0)
+		++st->alst;
+	if (tsr & CAN_TSR_TERR0)
+		++st->terr;
+	if (tsr & CAN_TSR_TXOK0) {
+		++st->ok;
+		st->bits += q->bits;
+		t = irq_cycles() - q->tq;
+		if (t > st->delay)
+			st->delay = t;
+		q->state = CAN_Q_IDLE;
+		return;
+	}
+	if (!(tsr & (CAN_TSR_ALST0 | CAN_TSR_TERR0)))
+		// Aborted (pending request after timeout, e.g. bus-off)
+		++st->timeout;
+	if (q->n < q->retries && !(CAN->ESR & CAN_ESR_BOFF)) {
+		++st->retry;
+		q->state = CAN_Q_WAIT;
+		q->t = irq_cycles();
+		return;
+	}
+	++st->lost;
+	q->state = CAN_Q_IDLE;
+}
+//-----------------------------------------------------------------------------
+// Queue of thread without wait: result of attempt, abort after 
+// CAN_TX_TIMEOUT (CAN_RETRY_HW: retransmission up to timeout), retry 
+// after backoff (bus to other nodes, x2 each retry)
+static void 
+can_txPoll(uint32_t thread)
+{
+	struct can_q *q = &can_q[thread];
+	uint32_t sh = 8U * thread;
+	
+	switch (q->state) {
+	case CAN_Q_TX:
+	case CAN_Q_ABORT:
+		if (CAN->TSR & CAN_TSR_RQCP0 << sh) {
+			can_result(thread);
+		} else if (q->state == CAN_Q_TX && 
+			irq_cycles() - q->t > CAN_TX_TIMEOUT * can_bitT) {
+			// Abort request: single store (other flags are w1c)
+			CAN->TSR = CAN_TSR_ABRQ0 << sh;
+			q->state = CAN_Q_ABORT;
+		}
+		break;
+	case CAN_Q_WAIT:
+		if (CAN->ESR & CAN_ESR_BOFF) {
+			++can_tx[thread].lost;
+			q->state = CAN_Q_IDLE;
+		} else if (irq_cycles() - q->t >= (CAN_BACKOFF * can_bitT) << q->n) {
+			++q->n;
+			can_request(thread);
+		}
+		break;
+	default:
+		break;
+	}
+}
+//-----------------------------------------------------------------------------
+// All mailboxes empty, no queued frame
+static uint32_t 
+can_txIdle(void)
+{
+	uint32_t tme = CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2;
+	
+	return can_q[0].state == CAN_Q_IDLE && can_q[1].state == CAN_Q_IDLE && 
+		can_q[2].state == CAN_Q_IDLE && (CAN->TSR & tme) == tme;
+}
+//-----------------------------------------------------------------------------
+// thread - TX mailbox (0 ... 2), see notes; return 0 if frame is queued 
+// (result and retries by can_poll()), -1 if not: bus-off, search of rate, 
+// busy mailbox
 int32_t 
 can_send(uint32_t id, uint8_t dlc, uint32_t l, uint32_t h, uint8_t thread)
 {
 	#define CAN_TIxR_STID_Pos  CAN_TI0R_STID_Pos
 	#define CAN_TDTxR_DLC_Pos  CAN_TDT0R_DLC_Pos
 	#define CAN_TDTxR_DLC_Msk  CAN_TDT0R_DLC_Msk
-	#define CAN_TIxR_TXRQ      CAN_TI0R_TXRQ
 	
-	// For delay
-	int32_t i;
+	CAN_TxMailBox_TypeDef *mb;
+	struct can_tx *st;
+	struct can_q *q;
+	uint32_t t0;
 	
-	// Current transmit FIFO (0, 1 or 2) and coresponding control bit for 
-	// each FIFO; depend on thread input parameter
-	uint32_t currRQCP_Pos, currALST_Pos, currTERR_Pos;
-	CAN_TxMailBox_TypeDef *currMailBox;
-	
-	if (thread == 0) {
-		currMailBox = &CAN->sTxMailBox[0];
-		currRQCP_Pos = CAN_TSR_RQCP0;
-		currALST_Pos = CAN_TSR_ALST0;
-		currTERR_Pos = CAN_TSR_TERR0;
-	} else if (thread == 1) {
-		currMailBox = &CAN->sTxMailBox[1];
-		currRQCP_Pos = CAN_TSR_RQCP1;
-		currALST_Pos = CAN_TSR_ALST1;
-		currTERR_Pos = CAN_TSR_TERR1;
-	} else if (thread == 2) {
-		currMailBox = &CAN->sTxMailBox[2];
-		currRQCP_Pos = CAN_TSR_RQCP2;
-		currALST_Pos = CAN_TSR_ALST2;
-		currTERR_Pos = CAN_TSR_TERR2;
+	if (thread > 2U)
+		return -1;
+	mb = &CAN->sTxMailBox[thread];
+	st = &can_tx[thread];
+	q = &can_q[thread];
+	
+	// Result of previous frame (no wait)
+	can_txPoll(thread);
+	if (thread == 0 && q->state != CAN_Q_IDLE) {
+		// Interrupt: own frame on bus (up to CAN_TX_WAIT, one attempt), 
+		// queued retry is replaced
+		t0 = irq_cycles();
+		while (q->state == CAN_Q_TX && 
+			irq_cycles() - t0 < CAN_TX_WAIT * can_bitT)
+			can_txPoll(thread);
+		if (q->state == CAN_Q_WAIT) {
+			++st->lost;
+			q->state = CAN_Q_IDLE;
+		}
+	}
+	if (q->state != CAN_Q_IDLE) {
+		// Busy: thread 0 loses frame, threads 1, 2 send again
+		if (thread == 0)
+			++st->lost;
+		return -1;
+	}
+	
+	// Bus-off: no transmission up to recovery; search of rate: silent
+	if (CAN->ESR & CAN_ESR_BOFF || can_rate == CAN_RATE_NONE) {
+		++st->lost;
+		return -1;
 	}
 	
 	// Clear old DLC
-	currMailBox->TDTR &= ~CAN_TDTxR_DLC_Msk;
+	mb->TDTR &= ~CAN_TDTxR_DLC_Msk;
 	// Set ID
-	currMailBox->TIR = id << CAN_TIxR_STID_Pos;
+	mb->TIR = id << CAN_TIxR_STID_Pos;
 	// Set data
-	currMailBox->TDLR = l;
-	currMailBox->TDHR = h;
+	mb->TDLR = l;
+	mb->TDHR = h;
 	// Set DLC
-	currMailBox->TDTR |= dlc << CAN_TDTxR_DLC_Pos;
-	
-	// Transmit request
-	currMailBox->TIR |= CAN_TIxR_TXRQ;
-	// Delay (TXRQ clear RQCP)
-	for (i = 0; i < 2; ++i);
-	// Wait end of transmit
-	while (!(CAN->TSR & currRQCP_Pos)); // || !(CAN->TSR & CAN_TSR_TME0)
+	mb->TDTR |= dlc << CAN_TDTxR_DLC_Pos;
 	
-	// Check transmit status
-	if (CAN->TSR & currALST_Pos || CAN->TSR & currTERR_Pos)
-		// && !(CAN->TSR & CAN_TSR_TXOK0)
-		return -1;
+	q->n = 0;
+	q->retries = 0;
+	if (CAN->MCR & CAN_MCR_NART)
+		q->retries = config.can_retry >> CAN_RETRIES_POS & CAN_RETRY_MSK;
+	q->bits = can_frameBits(dlc);
+	// Request time (TX delay)
+	q->tq = irq_cycles();
+	can_request(thread);
 	return 0;
 	
 	#undef CAN_TIxR_STID_Pos
 	#undef CAN_TDTxR_DLC_Pos
 	#undef CAN_TDTxR_DLC_Msk
-	#undef CAN_TIxR_TXRQ
 }
 //=============================================================================
 uint32_t
@@ -217,28 +548,340 @@ can_getState(void)
 	// Error if TEC or REC > 0
 	if (CAN->ESR & (CAN_ESR_REC_Msk | CAN_ESR_TEC_Msk))
 		err = CAN_STATE_ERR;
+	if (CAN->ESR & CAN_ESR_BOFF)
+		err |= CAN_STATE_BOFF;
 	ret = can_state | err;
 	// Clear OVR state
 	if (can_state & CAN_STATE_OVR)
 		can_state &= ~CAN_STATE_OVR;
 	return ret;
 }
+//-----------------------------------------------------------------------------
+// No pending or queued TX, rate is found, not bus-off (Stop mode is 
+// allowed)
+uint32_t 
+can_isIdle(void)
+{
+	return can_txIdle() && can_rate != CAN_RATE_NONE && !can_boffT && 
+		!can_rateReq;
+}
+//-----------------------------------------------------------------------------
+// End of window (t - length in cycles): rates from differences of counters
+// (one writer each, see notes), lowest ID of other nodes from interrupt
+static void 
+can_window(uint32_t t)
+{
+	uint32_t i, n, ms, bits;
+	
+	ms = t / (can_hclk / 1000U);
+	for (i = 0; i < CAN_RXID_NUM; ++i) {
+		n = can_rxN[i];
+		can_fps[i] = (n - can_winRx[i]) * 1000U / ms;
+		can_winRx[i] = n;
+	}
+	
+	n = can_rxBits + can_tx[0].bits + can_tx[1].bits + can_tx[2].bits;
+	bits = n - can_winBits;
+	can_winBits = n;
+	// Bit times of window; estimate is upper bound => limit 100 %
+	n = t / can_bitT;
+	if (bits >= n)
+		can_load = 1000U;
+	else if (bits < 0xFFFFFFFFU / 1000U)
+		can_load = bits * 1000U / n;
+	else
+		can_load = bits / (n / 1000U);
+	if (can_load > can_loadMax)
+		can_loadMax = can_load;
+	
+	__disable_irq();
+	can_topIdLast = can_topId;
+	n = can_topN;
+	can_topId = CAN_LOAD_NOID;
+	can_topN = 0;
+	__enable_irq();
+	can_topFps = n * 1000U / ms;
+	can_winT += t;
+}
+//-----------------------------------------------------------------------------
+// Main loop
+// 1. End of bus-off: recovery time
+// 2. TX queues: results, aborts, retries after backoff (interrupts are 
+//    masked: thread 0 is sent from CAN RX interrupt; no wait inside)
+// 3. Search of rate (CAN_RATE_AUTO): result of listen at candidate (or 
+//    new rate in configuration)
+// 4. End of window of load statistics (CAN_LOAD_MS), checked on each 
+//    ADC frame (window is longer by up to one frame period)
+// 5. Retransmission policy or rate changed: initialization mode between 
+//    frames (all mailboxes empty, no queued frame; RX interrupts are 
+//    masked, frame on bus at this time may be lost)
+void 
+can_poll(void)
+{
+	uint32_t nart, t, lec, i;
+	
+  // 1. End of bus-off: recovery time
+	if (can_boffT && !(CAN->ESR & CAN_ESR_BOFF)) {
+		__disable_irq();
+		t = irq_cycles() - can_boffT;
+		can_boffT = 0;
+		__enable_irq();
+		can_recovLast = t;
+		if (t > can_recovMax)
+			can_recovMax = t;
+	}
+	
+  // 2. TX queues: results, aborts, retries after backoff
+	for (i = 0; i < 3U; ++i) {
+		if (can_q[i].state == CAN_Q_IDLE)
+			continue;
+		__disable_irq();
+		can_txPoll(i);
+		__enable_irq();
+	}
+	
+  // 3. Search of rate (CAN_RATE_AUTO): result of listen at candidate
+	if (can_rateReq) {
+		can_rateReq = 0;
+		can_selectRate();
+	} else if (can_rate == CAN_RATE_NONE) {
+		lec = (CAN->ESR & CAN_ESR_LEC_Msk) >> CAN_ESR_LEC_Pos;
+		if (lec == 0) {
+			// Frame without error: normal mode at this rate
+			can_rate = can_cand;
+		} else if (lec != 7U || irq_cycles() - can_candT > 
+			CAN_BAUD_WAIT_MS * (can_hclk / 1000U)) {
+			can_cand = can_nextRate(can_cand);
+			can_listen();
+		}
+	}
+	
+  // 4. End of window of load statistics (CAN_LOAD_MS)
+	// DWT is read once per ADC frame (cost of main loop pass)
+	if (focus_getFrames() != can_winFrame) {
+		can_winFrame = focus_getFrames();
+		t = irq_cycles() - can_winT;
+		if (t >= CAN_LOAD_MS * (can_hclk / 1000U))
+			can_window(t);
+	}
+	
+  // 5. Retransmission policy or rate changed
+	nart = can_nart();
+	if ((CAN->MCR & CAN_MCR_NART) == nart && can_btrCur == can_btrWant())
+		return;
+	if (!can_txIdle())
+		return;
+	NVIC_DisableIRQ(USB_LP_CAN_RX0_IRQn);
+	NVIC_DisableIRQ(CAN_RX1_IRQn);
+	CAN->MCR |= CAN_MCR_INRQ;
+	while (!(CAN->MSR & CAN_MSR_INAK));
+	CAN->MCR = (CAN->MCR & ~CAN_MCR_NART) | nart;
+	can_setBtr();
+	CAN->MCR &= ~CAN_MCR_INRQ;
+	while (CAN->MSR & CAN_MSR_INAK);
+	if (can_rate == CAN_RATE_NONE)
+		can_listen();
+	NVIC_EnableIRQ(USB_LP_CAN_RX0_IRQn);
+	NVIC_EnableIRQ(CAN_RX1_IRQn);
+}
+//-----------------------------------------------------------------------------
+// From CAN_SRV_CAN_RETRY (saved in flash); policy - CAN_RETRY_x
+int32_t 
+can_setRetry(uint32_t policy, uint32_t retries)
+{
+	if (policy > CAN_RETRY_SW || retries > CAN_RETRIES_MAX)
+		return -1;
+	config.can_retry = policy << CAN_RETRY_POS | retries << CAN_RETRIES_POS;
+	config_request();
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// From CAN_SRV_CAN_RATE (saved in flash): applied by can_poll() after 
+// answer; rate - CAN_RATE_x or CAN_RATE_AUTO
+int32_t 
+can_setRate(uint32_t rate)
+{
+	if (rate != CAN_RATE_AUTO && (rate >= CAN_RATE_NUM || !can_btr[rate]))
+		return -1;
+	config.can_rate = rate;
+	config_request();
+	can_rateReq = 1;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Active rate (CAN_RATE_x) or CAN_RATE_NONE while search
+uint32_t 
+can_getRate(void)
+{
+	return can_rate;
+}
+//-----------------------------------------------------------------------------
+// Supported rates with active clock: bit for each CAN_RATE_x
+uint32_t 
+can_getRates(void)
+{
+	uint32_t i, m = 0;
+	
+	for (i = 0; i < CAN_RATE_NUM; ++i)
+		if (can_btr[i])
+			m |= 1U << i;
+	return m;
+}
 //=============================================================================
+static uint32_t 
+can_sat16(uint32_t v)
+{
+	return v > 0xFFFFU ? 0xFFFFU : v;
+}
+//-----------------------------------------------------------------------------
+// Answer for CAN_SRV_CAN_STAT (without opcode); sum of all threads
+// part 0: 1 - 0, 2..3 - sent; 4..5 - arbitration lost, 6..7 - errors
+// part 1: 1 - 1, 2..3 - retries; 4..5 - timeouts, 6..7 - lost
+// part 2: 1 - 2, 2 - bus-off events, 3 - error passive events; 
+//         4..7 - max bus-off recovery (cycles)
+// part 3: 1 - 3, 2 - TEC, 3 - REC; 4..7 - last bus-off recovery (cycles)
+void 
+can_getStat(uint32_t part, uint32_t *l, uint32_t *h)
+{
+	struct can_tx s = { 0 };
+	uint32_t i, esr;
+	
+	for (i = 0; i < 3U; ++i) {
+		s.ok += can_tx[i].ok;
+		s.alst += can_tx[i].alst;
+		s.terr += can_tx[i].terr;
+		s.retry += can_tx[i].retry;
+		s.timeout += can_tx[i].timeout;
+		s.lost += can_tx[i].lost;
+	}
+	
+	switch (part) {
+	case 0:
+		*l = can_sat16(s.ok) << CAN_SRV_ARG2_POS;
+		*h = can_sat16(s.alst) | can_sat16(s.terr) << 16;
+		break;
+	case 1:
+		*l = can_sat16(s.retry) << CAN_SRV_ARG2_POS;
+		*h = can_sat16(s.timeout) | can_sat16(s.lost) << 16;
+		break;
+	case 2:
+		*l = (can_boff > 0xFFU ? 0xFFU : can_boff) << CAN_SRV_ARG2_POS | 
+			(can_epv > 0xFFU ? 0xFFU : can_epv) << CAN_SRV_ARG3_POS;
+		*h = can_recovMax;
+		break;
+	default:
+		part = 3;
+		esr = CAN->ESR;
+		*l = (esr & CAN_ESR_TEC_Msk) >> CAN_ESR_TEC_Pos << CAN_SRV_ARG2_POS | 
+			(esr & CAN_ESR_REC_Msk) >> CAN_ESR_REC_Pos << CAN_SRV_ARG3_POS;
+		*h = can_recovLast;
+		break;
+	}
+	*l |= part << CAN_SRV_ARG1_POS;
+}
+//-----------------------------------------------------------------------------
+void 
+can_resetStat(void)
+{
+	uint32_t i;
+	
+	for (i = 0; i < 3U; ++i) {
+		can_tx[i].ok = 0;
+		can_tx[i].alst = 0;
+		can_tx[i].terr = 0;
+		can_tx[i].retry = 0;
+		can_tx[i].timeout = 0;
+		can_tx[i].lost = 0;
+		can_tx[i].delay = 0;
+	}
+	can_boff = 0;
+	can_epv = 0;
+	can_recovLast = 0;
+	can_recovMax = 0;
+	for (i = 0; i < 2U; ++i) {
+		can_fmpMax[i] = 0;
+		can_ovrN[i] = 0;
+	}
+	can_loadMax = 0;
+}
+//-----------------------------------------------------------------------------
+// Cycles to us (saturated to 16 bits)
+static uint32_t 
+can_us(uint32_t c)
+{
+	return can_sat16(c / (can_hclk / 1000000U));
+}
+//-----------------------------------------------------------------------------
+// Answer for CAN_SRV_CAN_LOAD (without opcode); rates of last window 
+// (CAN_LOAD_MS), max values since can_resetStat()
+// part 0: 1 - 0, 2 - max fill of FIFO 0 | FIFO 1 << 4, 3 - overruns of 
+//         FIFO 0, 1 (saturated); 4..5 - bus load, 6..7 - max (0.1 %)
+// part 1: 1 - 1, 2..3 - CMD frames/s; 4..5 - CTRL, 6..7 - SRV frames/s
+// part 2: 1 - 2, 2..3 - frames/s of other IDs (FIFO 1); 4..5 - lowest 
+//         of them (CAN_LOAD_NOID - none), 6..7 - its frames/s
+// part 3: 1 - 3, 2..3 - max command latency (CAN RX interrupt up to 
+//         main loop); 4..5 - max TX delay of thread 0, 6..7 - thread 1 
+//         (us, saturated)
+void 
+can_getLoad(uint32_t part, uint32_t *l, uint32_t *h)
+{
+	uint32_t ovr;
+	
+	switch (part) {
+	case 0:
+		ovr = can_ovrN[0] + can_ovrN[1];
+		*l = (can_fmpMax[0] | can_fmpMax[1] << 4) << CAN_SRV_ARG2_POS | 
+			(ovr > 0xFFU ? 0xFFU : ovr) << CAN_SRV_ARG3_POS;
+		*h = can_load | can_loadMax << 16;
+		break;
+	case 1:
+		*l = can_sat16(can_fps[CAN_RXID_CMD]) << CAN_SRV_ARG2_POS;
+		*h = can_sat16(can_fps[CAN_RXID_CTRL]) | 
+			can_sat16(can_fps[CAN_RXID_SRV]) << 16;
+		break;
+	case 2:
+		*l = can_sat16(can_fps[CAN_RXID_OTHER]) << CAN_SRV_ARG2_POS;
+		*h = can_topIdLast | can_sat16(can_topFps) << 16;
+		break;
+	default:
+		part = 3;
+		*l = can_us(cmd_getLatency()) << CAN_SRV_ARG2_POS;
+		*h = can_us(can_tx[0].delay) | can_us(can_tx[1].delay) << 16;
+		break;
+	}
+	*l |= part << CAN_SRV_ARG1_POS;
+}
+//=============================================================================
+// Mask for n (0 ... 4) bytes of word
+static uint32_t 
+can_bytes(uint32_t n)
+{
+	return n >= 4U ? 0xFFFFFFFFU : (1U << 8U * n) - 1U;
+}
+//-----------------------------------------------------------------------------
 // FIFO 0
 void 
 USB_LP_CAN_RX0_IRQHandler(void)
 {
-	uint32_t fovr, l, focus_target_, pole_target_;
+	uint32_t rf, fmp, fovr, l, h, dlc, focus_target_, pole_target_, err;
 	uint8_t id;
-	// uint8_t fmp, full, fmi, id, rtr;
-	// uint32_t time, h;
+	// Entry time
+	uint32_t t0 = irq_cycles();
+	// uint8_t full, fmi, id, rtr;
+	// uint32_t time;
 	
-	// fmp = (CAN->RF0R & CAN_RF0R_FMP0_Msk) >> CAN_RF0R_FMP0_Pos;
-	fovr = (CAN->RF0R & CAN_RF0R_FOVR0_Msk) >> CAN_RF0R_FOVR0_Pos;
-	// full = (CAN->RF0R & CAN_RF0R_FULL0_Msk) >> CAN_RF0R_FULL0_Pos;
+	rf = CAN->RF0R;
+	fmp = (rf & CAN_RF0R_FMP0_Msk) >> CAN_RF0R_FMP0_Pos;
+	fovr = (rf & CAN_RF0R_FOVR0_Msk) >> CAN_RF0R_FOVR0_Pos;
+	// full = (rf & CAN_RF0R_FULL0_Msk) >> CAN_RF0R_FULL0_Pos;
+	
+	// Fill of FIFO 0 at entry (high-water mark)
+	if (fmp > can_fmpMax[0])
+		can_fmpMax[0] = fmp;
 	
 	if (fovr) {
 		can_state |= CAN_STATE_OVR;
+		++can_ovrN[0];
 		// Exclude the cause of the interrupt: clear FOVR bit
 		CAN->RF0R |= CAN_RF0R_FOVR0;
 	}
@@ -251,34 +894,149 @@ USB_LP_CAN_RX0_IRQHandler(void)
 	//	>> CAN_RDT0R_FMI_Pos;
 	// time = (CAN->sFIFOMailBox[0].RDTR & CAN_RDT0R_TIME_Msk)
 	//	>> CAN_RDT0R_TIME_Pos;
+	dlc = (CAN->sFIFOMailBox[0].RDTR & CAN_RDT0R_DLC_Msk)
+		>> CAN_RDT0R_DLC_Pos;
 	l = CAN->sFIFOMailBox[0].RDLR;
-	// h = CAN->sFIFOMailBox[0].RDHR;
+	h = CAN->sFIFOMailBox[0].RDHR;
+	// Bytes after DLC are not valid => zero
+	l &= can_bytes(dlc);
+	h &= can_bytes(dlc > 4U ? dlc - 4U : 0);
 	
 	// Exclude the cause of the interrupt: release a message in FIFO 0
 	CAN->RF0R |= CAN_RF0R_RFOM0;
 	
+	// Quiet period before Stop mode starts again
+	power_activity();
+	
+	can_rxBits += can_frameBits(dlc);
 	if (id == CAN_ID_CTRL) {
+		++can_rxN[CAN_RXID_CTRL];
 		send_state();
 	} else if (id == CAN_ID_CMD) {
-		focus_target_ = (l & CAN_FOCUS_MSK) >> CAN_FOCUS_POS;
-		if (focus_target_ <= FOCUS_MAX /*- 1 && focus_target_ >= 0 + 1*/)
-			focus_target = focus_target_;
-		// else
-			// err focus val
+		++can_rxN[CAN_RXID_CMD];
+		err = 0;
+		if ((l & CAN_VER_MSK) >> CAN_VER_POS == CAN_VER_HIRES) {
+			focus_target_ = (h & CAN_FOCUS_HR_MSK) >> CAN_FOCUS_HR_POS;
+			if (focus_target_ == CAN_FOCUS_HR_KEEP)
+				focus_target_ = CMD_KEEP;
+			else if (focus_target_ > FOCUS_MASK)
+				// err focus val
+				err |= CAN_EV_FOCUS;
+			else
+				focus_target_ = focus_clamp(focus_target_);
+		} else {
+			focus_target_ = (l & CAN_FOCUS_MSK) >> CAN_FOCUS_POS;
+			if (focus_target_ == CAN_FOCUS_KEEP)
+				focus_target_ = CMD_KEEP;
+			else if (focus_target_ > FOCUS_MAX)
+				// err focus val
+				err |= CAN_EV_FOCUS;
+			else
+				focus_target_ = focus_fromStep(focus_target_);
+		}
 		pole_target_ = (l & CAN_POLE_MSK) >> CAN_POLE_POS;
 		switch (pole_target_) {
 		case POLE_0:
 		case POLE_1:
 		case POLE_2:
-			pole_target = pole_target_;
+			break;
+		case CAN_POLE_KEEP:
+			pole_target_ = CMD_KEEP;
 			break;
 		default:
 			// err pole val
+			err |= CAN_EV_POLE;
 			break;
 		}
+		// Calibration moves focus: no command up to its end (calib.c)
+		if (focus_getState() & FOCUS_STATE_CALIB)
+			err |= CAN_EV_CALIB;
+		// Both targets to main loop as one command; invalid target => 
+		// whole command is rejected (event from main loop)
+		if (err)
+			cmd_reject((l & CAN_SEQ_MSK) >> CAN_SEQ_POS, err);
+		else
+			cmd_put(focus_target_, pole_target_, 
+				(l & CAN_SEQ_MSK) >> CAN_SEQ_POS);
+	} else if (id == CAN_ID_SRV) {
+		++can_rxN[CAN_RXID_SRV];
+		service(l, h);
 	}
 	
 	// Wait release the message from FIFO 0 (see above)
 	while (CAN->RF0R & CAN_RF0R_RFOM0);
+	
+	// Frame time is unknown (without TTCM) => only duration
+	irq_add(IRQ_SRC_CAN_RX0, t0, IRQ_NOLAT);
+}
+//-----------------------------------------------------------------------------
+// FIFO 1: frames of other nodes (filter bank 2), load statistics only
+void 
+CAN_RX1_IRQHandler(void)
+{
+	uint32_t rf, fmp, rir, dlc, id;
+	// Entry time
+	uint32_t t0 = irq_cycles();
+	
+	rf = CAN->RF1R;
+	fmp = (rf & CAN_RF1R_FMP1_Msk) >> CAN_RF1R_FMP1_Pos;
+	if (fmp > can_fmpMax[1])
+		can_fmpMax[1] = fmp;
+	
+	if (rf & CAN_RF1R_FOVR1) {
+		++can_ovrN[1];
+		// Exclude the cause of the interrupt: clear FOVR bit
+		CAN->RF1R |= CAN_RF1R_FOVR1;
+	}
+	
+	rir = CAN->sFIFOMailBox[1].RIR;
+	dlc = (CAN->sFIFOMailBox[1].RDTR & CAN_RDT0R_DLC_Msk)
+		>> CAN_RDT0R_DLC_Pos;
+	
+	// Exclude the cause of the interrupt: release a message in FIFO 1
+	CAN->RF1R |= CAN_RF1R_RFOM1;
+	
+	// Extended frame: 18 bits of ID, SRR and IDE more
+	++can_rxN[CAN_RXID_OTHER];
+	can_rxBits += can_frameBits(dlc) + (rir & CAN_RI0R_IDE ? 20U : 0);
+	
+	// Lowest ID (highest priority) of window: 11 bits of standard ID or 
+	// high bits of extended ID
+	id = (rir & CAN_RI0R_STID_Msk) >> CAN_RI0R_STID_Pos;
+	if (id < can_topId) {
+		can_topId = id;
+		can_topN = 1U;
+	} else if (id == can_topId) {
+		++can_topN;
+	}
+	
+	// Wait release the message from FIFO 1 (see above)
+	while (CAN->RF1R & CAN_RF1R_RFOM1);
+	
+	irq_add(IRQ_SRC_CAN_RX1, t0, IRQ_NOLAT);
+}
+//=============================================================================
+// Status change and error: bus-off, error passive (entry only: ERRI is set 
+// on change of flag to 1)
+void 
+CAN_SCE_IRQHandler(void)
+{
+	uint32_t esr;
+	// Entry time
+	uint32_t t0 = irq_cycles();
+	
+	esr = CAN->ESR;
+	if (esr & CAN_ESR_BOFF && !can_boffT) {
+		++can_boff;
+		// 0 - no bus-off
+		can_boffT = t0 ? t0 : 1U;
+	}
+	else if (esr & CAN_ESR_EPVF)
+		++can_epv;
+	
+	// Exclude the cause of the interrupt: clear ERRI (single store, w1c)
+	CAN->MSR = CAN_MSR_ERRI;
+	
+	irq_add(IRQ_SRC_CAN_SCE, t0, IRQ_NOLAT);
 }
 //=============================================================================
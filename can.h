@@ -7,21 +7,237 @@
 #define CAN_STATE_OK   0x00U
 #define CAN_STATE_OVR  0x01U
 #define CAN_STATE_ERR  0x02U
+#define CAN_STATE_BOFF 0x04U  // bus-off (automatic recovery - ABOM)
 //-----------------------------------------------------------------------------
-#define CAN_ID_CTRL  0x93U
-#define CAN_ID_CMD   0x92U
+#define CAN_ID_CTRL   0x93U
+#define CAN_ID_CMD    0x92U
+#define CAN_ID_SRV    0x94U  // service request + answer (opcode in byte 0)
+#define CAN_ID_TRACE  0x95U  // trace records (after CAN_SRV_TRACE_READ)
+#define CAN_ID_EVENT  0x96U  // events of commands (CAN_EV_x in byte 0)
+#define CAN_ID_STREAM 0x97U  // position samples (CAN_SRV_STREAM, stream.h)
 //-----------------------------------------------------------------------------
 #define CAN_POLE_POS   0U
 #define CAN_FOCUS_POS  8U
+#define CAN_SEQ_POS    16U  // sequence ID of command (from master)
+#define CAN_VER_POS    24U  // version of command (CAN_VER_x)
 
 #define CAN_POLE_MSK   0xFFU
 #define CAN_FOCUS_MSK  0xFF00U
+#define CAN_SEQ_MSK    0xFF0000U
+#define CAN_VER_MSK    0xFF000000U
+
+#define CAN_VER_LEGACY  0U  // focus - step (0 ... FOCUS_MAX) in byte 1
+#define CAN_VER_HIRES   1U  // focus - ADC counts in bytes 4..5 (high word)
+
+#define CAN_FOCUS_HR_POS  0U  // high word (RDHR)
+#define CAN_FOCUS_HR_MSK  0xFFFFU
+
+// Target is not changed by command; other values out of range => command 
+// is rejected (CAN_EV_REJECT)
+#define CAN_POLE_KEEP      0xFFU
+#define CAN_FOCUS_KEEP     0xFFU    // legacy step
+#define CAN_FOCUS_HR_KEEP  0xFFFFU
+//-----------------------------------------------------------------------------
+// State (CAN_ID_CTRL): low word - legacy (as command), high word - focus 
+// position and target in ADC counts
+#define CAN_STATE_FOCUS_HR_POS   0U
+#define CAN_STATE_TARGET_HR_POS  16U
+//-----------------------------------------------------------------------------
+// Events (CAN_ID_EVENT, main loop): byte 1 - sequence ID of command, high 
+// word - focus position and target as in state (CAN_ID_CTRL)
+#define CAN_EV_TYPE_POS    0U
+#define CAN_EV_SEQ_POS     8U
+#define CAN_EV_ARG1_POS    16U
+#define CAN_EV_ARG2_POS    24U
+
+#define CAN_EV_ACK         0x01U  // command applied: 2 - targets (CAN_EV_
+                                  // FOCUS | CAN_EV_POLE), 3 - superseded 
+                                  // commands before it (up to 0xFF)
+#define CAN_EV_REJECT      0x02U  // command not applied: 2 - invalid 
+                                  // targets (CAN_EV_FOCUS | CAN_EV_POLE) 
+                                  // or CAN_EV_CALIB, 3 - rejected 
+                                  // commands (8 bits)
+#define CAN_EV_FOCUS_DONE  0x03U  // focus stopped on target: 2 - 0 / state
+                                  // of focus (FOCUS_STATE_x, not reached), 
+                                  // 3 - step (legacy)
+#define CAN_EV_POLE_DONE   0x04U  // end of pole pulse (TIM 6): 2 - 0 / 
+                                  // state of pole (POLE_STATE_x, not 
+                                  // moved), 3 - pole
+
+#define CAN_EV_FOCUS       0x01U
+#define CAN_EV_POLE        0x02U
+#define CAN_EV_CALIB       0x04U  // calibration of focus runs (calib.c)
+//-----------------------------------------------------------------------------
+#define CAN_SRV_OP_POS     0U
+#define CAN_SRV_ARG1_POS   8U
+#define CAN_SRV_ARG2_POS   16U
+#define CAN_SRV_ARG3_POS   24U
+
+#define CAN_SRV_OP_MSK     0xFFU
+#define CAN_SRV_ARG_MSK    0xFFU  // after shift
+
+#define CAN_SRV_TRACE_ARM   0x01U  // 1 - decimation, 2 - post, 3 - trigger
+                                   // (ignored during read out)
+#define CAN_SRV_TRACE_TRIG  0x02U
+#define CAN_SRV_TRACE_READ  0x03U  // answer: 1 - state, 2..3 - records
+#define CAN_SRV_IRQ_STAT    0x04U  // 1 - IRQ_SRC_x; answer: 2..3 - jitter,
+                                   // 4..5 - max latency, 6..7 - max 
+                                   // duration (cycles, saturated)
+#define CAN_SRV_IRQ_RESET   0x05U
+#define CAN_SRV_CMD_STAT    0x06U  // answer: 2..3 - received, 
+                                   // 4..5 - applied, 6..7 - superseded
+#define CAN_SRV_PRESET_STORE   0x07U  // 1 - slot, 2 - pole (0xFF - current
+                                      // targets), 3 - speed, 4..5 - focus
+                                      // (ADC counts);
+                                      // answer: 1 - slot, 2 - 0 / 0xFF err
+#define CAN_SRV_PRESET_RECALL  0x08U  // 1 - slot, 2 - flags, 3 - seq ID;
+                                      // answer: 1 - slot, 2 - 0 / 0xFF err;
+                                      // on arrival (PRESET_NOTIFY): 1 - 
+                                      // slot, 2 - PRESET_NOTIFY, 3 - focus
+                                      // step, 4..5 - focus (ADC counts)
+#define CAN_SRV_PRESET_READ    0x09U  // 1 - slot; answer: 4..7 - preset
+#define CAN_SRV_CALIB_START    0x0AU  // answer: 2 - 0 / 0xFF err (is run);
+                                      // result - see CAN_SRV_CALIB_READ
+#define CAN_SRV_CALIB_READ     0x0BU  // 1 - part (0 ... 2), see calib.c
+#define CAN_SRV_CALIB_BOOT     0x0CU  // 1 - 1 calibration at start / 0
+#define CAN_SRV_CAN_STAT       0x0DU  // 1 - part (0 ... 3), see can.c
+#define CAN_SRV_CAN_RESET      0x0EU
+#define CAN_SRV_CAN_RETRY      0x0FU  // 1 - policy (CAN_RETRY_x, 0xFF - 
+                                      // read only), 2 - retries;
+                                      // answer: 1 - policy, 2 - retries, 
+                                      // 3 - 0 / 0xFF err
+#define CAN_SRV_CAN_RATE       0x10U  // 1 - rate (CAN_RATE_x, CAN_RATE_AUTO,
+                                      // 0xFF - read only); answer: 1 - 
+                                      // stored, 2 - active, 3 - 0 / 0xFF 
+                                      // err, 4..5 - supported (bit for 
+                                      // each CAN_RATE_x)
+#define CAN_SRV_POWER          0x11U  // 1 - quiet period before Stop mode
+                                      // (100 ms, 0 - never, 0xFF - read 
+                                      // only); answer: 1 - quiet period, 
+                                      // 2..3 - wake-ups, 4..5 - max 
+                                      // wake-to-ready (us), 6..7 - late 
+                                      // wake-ups (see power.h); frame 
+                                      // which wakes node from Stop mode 
+                                      // is lost (CAN is not clocked): 
+                                      // master repeats command or state 
+                                      // request without answer
+#define CAN_SRV_FOCUS_RATE     0x12U  // 1 - rate of ADC frames 
+                                      // (FOCUS_RATE_x, FOCUS_RATE_AUTO, 
+                                      // 0xFF - read only; not stored); 
+                                      // answer: 1 - mode, 2 - active, 
+                                      // 3 - 0 / 0xFF err, 4..7 - frames
+#define CAN_SRV_CMD_EVENT      0x13U  // 1 - 1 events of commands 
+                                      // (CAN_ID_EVENT) / 0, 0xFF - read 
+                                      // only; answer: 1 - on, 2..3 - 
+                                      // rejected, 4..7 - events sent
+#define CAN_SRV_DSP_BENCH      0x14U  // 1 - kernel (DSP_K_x); answer: 
+                                      // 1 - kernel, 2 - DSP_SIMD, 3 - 0 / 
+                                      // 0xFF err, 4..5 - cycles per 
+                                      // sample (x 16), 6..7 - check sum
+#define CAN_SRV_AXIS           0x15U  // 1 - axis (AXIS_x), 2 - 1 new 
+                                      // target (4..5, ADC counts; not 
+                                      // focus) / 0 read only; answer: 
+                                      // 1 - axis, 2 - 0 / 0xFF err, 3 - 
+                                      // direction, 4..5 - position, 6..7 - 
+                                      // max cycles of controller
+#define CAN_SRV_CAN_LOAD       0x16U  // 1 - part (0 ... 3), see can.c;
+                                      // reset by CAN_SRV_CAN_RESET
+#define CAN_SRV_FOCUS_LASH     0x17U  // 1 - approach (FOCUS_APPROACH_BOTH,
+                                      // FOCUS_DIR_x; 0xFF - read only), 
+                                      // 2 - counts past target, 4..5 - 
+                                      // gear lash (ADC counts); answer: 
+                                      // 1 - approach, 2 - past target, 
+                                      // 3 - 0 / 0xFF err, 4..5 - lash, 
+                                      // 6..7 - lens position
+#define CAN_SRV_BOOT           0x18U  // answer: 1 - 1 warm boot / 0, 2 - 
+                                      // reset flags (RCC CSR [31:24]), 
+                                      // 3 - 1 pole restored / 0 re-home,
+                                      // 4..7 - reset-to-operational (us,
+                                      // 0 - not yet), see boot.c
+#define CAN_SRV_POLE_FOCUS     0x19U  // 1 - pole, 2 - 1 write / 0 read, 
+                                      // 4..5 - focus offset of pole (ADC
+                                      // counts, signed); answer: 1 - 
+                                      // pole, 2 - 0 / 0xFF err, 4..5 - 
+                                      // offset, 6..7 - focus target
+#define CAN_SRV_STREAM         0x1AU  // 1 - period (x 250 us, 0 - off, 
+                                      // 0xFF - read only), 2 - axis 
+                                      // (AXIS_x); answer: 1 - period, 
+                                      // 2 - axis, 3 - 0 / 0xFF err, 
+                                      // 4..5 - frames, 6..7 - lost 
+                                      // samples (see stream.c)
+#define CAN_SRV_DRIVE          0x1BU  // 1 - motor (DRIVE_x) or 
+                                      // DRIVE_CONFIG, 2 - 1 write 
+                                      // (DRIVE_CONFIG: 4..5 - lead us, 
+                                      // 6..7 - hold ms) / 0 read; answer:
+                                      // 1 - motor, 2 - 0 / 0xFF err, 3 - 
+                                      // 1 enabled / 0, 4..5 - on time, 
+                                      // 6..7 - drive time (per mille of
+                                      // run time) or lead, hold (see 
+                                      // drive.c)
+//-----------------------------------------------------------------------------
+// Retransmission policy (config.can_retry: policy | retries << 8)
+#define CAN_RETRY_HW      0U  // automatic retransmission (up to timeout)
+#define CAN_RETRY_SW      1U  // one attempt by hardware (NART), can_poll()
+                              // repeats failed frame after backoff
+#define CAN_RETRY_POS     0U
+#define CAN_RETRIES_POS   8U
+#define CAN_RETRY_MSK     0xFFU  // after shift
+
+#define CAN_RETRY_DEF     CAN_RETRY_SW
+#define CAN_RETRIES_DEF   3U
+#define CAN_RETRIES_MAX   8U
+// Bit times of active rate
+#define CAN_TX_TIMEOUT    2000U  // request up to abort (can_poll())
+#define CAN_TX_WAIT       160U   // max wait of can_send() (thread 0) for 
+                                 // own frame: one frame of 8 bytes
+#define CAN_BACKOFF       32U    // before 1st retry, x2 each next
+//-----------------------------------------------------------------------------
+// Bit rates (config.can_rate: CAN_RATE_x or CAN_RATE_AUTO); bit timing is
+// computed from PCLK1 at start (rate is not supported if not exact)
+#define CAN_RATE_1000K    0U
+#define CAN_RATE_800K     1U
+#define CAN_RATE_500K     2U
+#define CAN_RATE_250K     3U
+#define CAN_RATE_125K     4U
+#define CAN_RATE_100K     5U
+#define CAN_RATE_50K      6U
+#define CAN_RATE_20K      7U
+#define CAN_RATE_10K      8U
+#define CAN_RATE_NUM      9U
+#define CAN_RATE_AUTO     0xFEU  // search in silent mode (from highest)
+#define CAN_RATE_NONE     0xFFU  // active rate while search
+#define CAN_RATE_DEF      CAN_RATE_1000K
+
+#define CAN_TQ_MIN        8U     // time quanta per bit
+#define CAN_TQ_MAX        25U
+#define CAN_SAMPLE        13U    // sample point (of 16): 81.25 %
+#define CAN_BAUD_WAIT_MS  200U   // listen at candidate rate (without error)
+//-----------------------------------------------------------------------------
+// Load statistics (CAN_SRV_CAN_LOAD): received frames by ID, rates and bus
+// load of last window
+#define CAN_RXID_CMD      0U
+#define CAN_RXID_CTRL     1U
+#define CAN_RXID_SRV      2U
+#define CAN_RXID_OTHER    3U     // IDs of other nodes (FIFO 1)
+#define CAN_RXID_NUM      4U
+
+#define CAN_LOAD_MS       1000U  // window
+#define CAN_LOAD_NOID     0xFFFFU  // no frame of other nodes in window
 //-----------------------------------------------------------------------------
 void can_init(void);
 void can_start(void);
 uint32_t can_getState(void);
+uint32_t can_isIdle(void);
 int32_t can_send(uint32_t id, uint8_t dlc, uint32_t l, uint32_t h, 
 		uint8_t thread);
+void can_poll(void);
+int32_t can_setRetry(uint32_t policy, uint32_t retries);
+int32_t can_setRate(uint32_t rate);
+uint32_t can_getRate(void);
+uint32_t can_getRates(void);
+void can_getStat(uint32_t part, uint32_t *l, uint32_t *h);
+void can_resetStat(void);
+void can_getLoad(uint32_t part, uint32_t *l, uint32_t *h);
 //=============================================================================
 #endif // CAN_H
 //=============================================================================
@@ -2,9 +2,14 @@
 /*
 * modules:
  - RCC
+* notes:
+ - frequencies are computed from active configuration of RCC (not from 
+   constants): modules with timing (e.g. CAN bit rate) use them instead 
+   of "<RCC>" assumption
 */
 //=============================================================================
 #include "main.h"
+#include "clock.h"
 //=============================================================================
 void 
 clock_change(void)
@@ -64,3 +69,51 @@ NMI_Handler(void)
 	RCC->CIR |= RCC_CIR_CSSC;
 }
 //=============================================================================
+// System clock (SYSCLK) from source, PLL multiplier and divider
+static uint32_t 
+clock_getSysclk(void)
+{
+	uint32_t cfgr = RCC->CFGR;
+	uint32_t in, mul;
+	
+	switch (cfgr & RCC_CFGR_SWS_Msk) {
+	case RCC_CFGR_SWS_HSE:
+		return CLOCK_HSE_HZ;
+	case RCC_CFGR_SWS_PLL:
+		if (cfgr & RCC_CFGR_PLLSRC)
+			in = CLOCK_HSE_HZ / 
+				(((RCC->CFGR2 & RCC_CFGR2_PREDIV_Msk) >> 
+					RCC_CFGR2_PREDIV_Pos) + 1U);
+		else
+			in = CLOCK_HSI_HZ / 2U;
+		// x2 ... x16 (0xF - also x16)
+		mul = ((cfgr & RCC_CFGR_PLLMUL_Msk) >> RCC_CFGR_PLLMUL_Pos) + 2U;
+		return in * (mul > 16U ? 16U : mul);
+	default:
+		return CLOCK_HSI_HZ;
+	}
+}
+//-----------------------------------------------------------------------------
+// AHB clock (HCLK: core, DWT cycle counter)
+uint32_t 
+clock_getHclk(void)
+{
+	// HPRE: 0xxx - 1, 1000 ... 1011 - 2 ... 16, 1100 ... 1111 - 64 ... 512
+	uint32_t hpre = (RCC->CFGR & RCC_CFGR_HPRE_Msk) >> RCC_CFGR_HPRE_Pos;
+	uint32_t sh = 0;
+	
+	if (hpre & 0x8U)
+		sh = (hpre & 0x7U) + (hpre >= 0xCU ? 2U : 1U);
+	return clock_getSysclk() >> sh;
+}
+//-----------------------------------------------------------------------------
+// APB 1 clock (PCLK1: CAN, TIM 2/6/7 x1 or x2)
+uint32_t 
+clock_getPclk1(void)
+{
+	// PPRE1: 0xx - 1, 100 ... 111 - 2 ... 16
+	uint32_t ppre = (RCC->CFGR & RCC_CFGR_PPRE1_Msk) >> RCC_CFGR_PPRE1_Pos;
+	
+	return clock_getHclk() >> (ppre & 0x4U ? (ppre & 0x3U) + 1U : 0);
+}
+//=============================================================================
@@ -4,7 +4,12 @@
 //=============================================================================
 #include <stm32f302x8.h>
 //-----------------------------------------------------------------------------
+#define CLOCK_HSE_HZ  8000000U  // crystal
+#define CLOCK_HSI_HZ  8000000U
+//-----------------------------------------------------------------------------
 void clock_change(void);
+uint32_t clock_getHclk(void);
+uint32_t clock_getPclk1(void);
 //=============================================================================
 #endif // CLOCK_H
 //=============================================================================
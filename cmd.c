@@ -0,0 +1,293 @@
+//=============================================================================
+/*
+* modules:
+ - RAM only
+* notes:
+ - one writer (CAN RX interrupt, cmd_put()) and one reader (main loop, 
+   cmd_get()); writer preempts reader, never vice versa
+ - writer fills the slot which is not published, then publishes it by 
+   increment of cmd_seq (latest command wins)
+ - reader copies published slot and repeats if cmd_seq was changed during 
+   the copy (seqlock); copy is short, so repeat is rare
+ - events (CAN_ID_EVENT, config.cmd_event) are sent by main loop 
+   (cmd_poll(), thread 1): acknowledge of applied command, rejection of 
+   command from CAN RX interrupt (cmd_reject(), latest one wins as 
+   command), end of move of focus and pole for latest command with this 
+   target (superseded move has no end); failed frame is sent next pass
+ - command with pole and without focus gets focus of new pole (see 
+   focus_forPole()): applied, acknowledged and reported as both targets
+ - latency (CAN_SRV_CAN_LOAD): cycles from cmd_put() in CAN RX interrupt 
+   up to cmd_get() of this command in main loop (max)
+ - CMD_TEST (host/cmdtest.c): cmd_testHook() between reads of slot in 
+   cmd_get() runs cmd_put() as interrupt would (copy and repeat; RAM 
+   reads are no preemption point of simulator)
+*/
+//=============================================================================
+#include "main.h"
+#include "cmd.h"
+#include "config.h"
+#include "can.h"
+#include "focus.h"
+#include "pole.h"
+#include "irq.h"
+//=============================================================================
+#ifdef CMD_TEST
+void cmd_testHook(void);
+#define CMD_HOOK()  cmd_testHook()
+#else
+#define CMD_HOOK()
+#endif
+//-----------------------------------------------------------------------------
+static volatile uint32_t cmd_focus[2];
+static volatile uint32_t cmd_pole[2];
+static volatile uint32_t cmd_id[2];
+static volatile uint32_t cmd_t[2];      // cmd_put() (cycles)
+static volatile uint32_t cmd_seq;       // published commands (received)
+static uint32_t cmd_seq_last;           // last applied command
+static volatile uint32_t cmd_applied;
+static volatile uint32_t cmd_superseded;
+static volatile uint32_t cmd_latMax;    // cmd_put() to cmd_get() (cycles)
+// Events
+static volatile uint32_t cmd_rej;       // id | reason << 8 (latest)
+static volatile uint32_t cmd_rej_seq;   // rejected commands
+static uint32_t cmd_rej_sent;
+static uint32_t cmd_ack;                // 0 - nothing, id | mask << 8 | 
+                                        // superseded << 16 | 1 << 24
+static uint32_t cmd_wait_focus;         // 0 - nothing, id + 1
+static uint32_t cmd_wait_pole;
+static volatile uint32_t cmd_events;    // sent
+//=============================================================================
+void 
+cmd_init(void)
+{
+	cmd_seq = 0;
+	cmd_seq_last = 0;
+	cmd_applied = 0;
+	cmd_superseded = 0;
+	cmd_latMax = 0;
+	cmd_rej_seq = 0;
+	cmd_rej_sent = 0;
+	cmd_ack = 0;
+	cmd_wait_focus = 0;
+	cmd_wait_pole = 0;
+	cmd_events = 0;
+}
+//=============================================================================
+// Writer (CAN RX interrupt)
+// focus, pole - targets or CMD_KEEP
+// id - sequence ID of command from master
+void 
+cmd_put(uint32_t focus, uint32_t pole, uint32_t id)
+{
+	uint32_t i = (cmd_seq + 1U) & 1U;
+	
+	// Fill slot which is not published
+	cmd_focus[i] = focus;
+	cmd_pole[i] = pole;
+	cmd_id[i] = id;
+	cmd_t[i] = irq_cycles();
+	
+	// Publish
+	__DMB();
+	++cmd_seq;
+}
+//-----------------------------------------------------------------------------
+// Writer (CAN RX interrupt): command is not applied
+// id - sequence ID of command, reason - CAN_EV_FOCUS | CAN_EV_POLE
+void 
+cmd_reject(uint32_t id, uint32_t reason)
+{
+	cmd_rej = (id & 0xFFU) | reason << 8;
+	__DMB();
+	++cmd_rej_seq;
+}
+//-----------------------------------------------------------------------------
+// Reader (main loop); return 0 if new command was get, -1 otherwise
+int32_t 
+cmd_get(uint32_t *focus, uint32_t *pole, uint32_t *id)
+{
+	uint32_t seq, i, n, t;
+	
+	do {
+		seq = cmd_seq;
+		if (seq == cmd_seq_last)
+			return -1;
+		__DMB();
+		i = seq & 1U;
+		*focus = cmd_focus[i];
+		CMD_HOOK();
+		*pole = cmd_pole[i];
+		CMD_HOOK();
+		*id = cmd_id[i];
+		CMD_HOOK();
+		t = cmd_t[i];
+		__DMB();
+	} while (seq != cmd_seq);
+	
+	t = irq_cycles() - t;
+	if (t > cmd_latMax)
+		cmd_latMax = t;
+	
+	// Focus follows new pole (offset table) if command keeps focus: both 
+	// moves start in this pass, end of focus move is reported as well
+	if (*focus == CMD_KEEP && *pole != CMD_KEEP) {
+		t = focus_forPole(focus_target, pole_target, *pole);
+		if (t != focus_target)
+			*focus = t;
+	}
+	
+	// Commands between last applied and this one were never applied
+	n = seq - cmd_seq_last - 1U;
+	cmd_superseded += n;
+	++cmd_applied;
+	
+	// Events: acknowledge (latest), wait for end of move
+	cmd_ack = (*id & 0xFFU) | (n > 0xFFU ? 0xFFU : n) << 16 | 1U << 24;
+	if (*focus != CMD_KEEP) {
+		cmd_ack |= CAN_EV_FOCUS << 8;
+		cmd_wait_focus = (*id & 0xFFU) + 1U;
+	}
+	if (*pole != CMD_KEEP) {
+		cmd_ack |= CAN_EV_POLE << 8;
+		cmd_wait_pole = (*id & 0xFFU) + 1U;
+	}
+	
+	cmd_seq_last = seq;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+static int32_t 
+cmd_event(uint32_t type, uint32_t id, uint32_t a1, uint32_t a2)
+{
+	uint32_t pos = *focus_pos & FOCUS_MASK;
+	
+	if (can_send(CAN_ID_EVENT, 8, 
+			type << CAN_EV_TYPE_POS | 
+			id << CAN_EV_SEQ_POS | 
+			a1 << CAN_EV_ARG1_POS | 
+			a2 << CAN_EV_ARG2_POS, 
+			pos << CAN_STATE_FOCUS_HR_POS | 
+			focus_target << CAN_STATE_TARGET_HR_POS, 
+		1))
+		return -1;
+	++cmd_events;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Main loop (after targets are applied): send events, see notes
+// arrived - focus is stopped on target (focus_control())
+// 1. Rejected command
+// 2. Acknowledge of applied command
+// 3. End of focus move (or focus is not able to move: error; 
+//    calibration supersedes target); no frame yet (FOCUS_STATE_NOSTART, 
+//    boot or wake-up) => move starts later, wait
+// 4. End of pole pulse (or pole is not able to move)
+void 
+cmd_poll(uint32_t arrived)
+{
+	uint32_t seq, rej, st;
+	
+	if (!config.cmd_event) {
+		cmd_rej_sent = cmd_rej_seq;
+		cmd_ack = 0;
+		cmd_wait_focus = 0;
+		cmd_wait_pole = 0;
+		return;
+	}
+	
+  // 1. Rejected command
+	seq = cmd_rej_seq;
+	if (seq != cmd_rej_sent) {
+		__DMB();
+		rej = cmd_rej;
+		if (cmd_event(CAN_EV_REJECT, rej & 0xFFU, rej >> 8, seq & 0xFFU))
+			return;
+		cmd_rej_sent = seq;
+	}
+	
+  // 2. Acknowledge of applied command
+	if (cmd_ack) {
+		if (cmd_event(CAN_EV_ACK, cmd_ack & 0xFFU, cmd_ack >> 8 & 0xFFU, 
+			cmd_ack >> 16 & 0xFFU))
+			return;
+		cmd_ack = 0;
+	}
+	
+  // 3. End of focus move (or focus is not able to move)
+	st = focus_getState() & (FOCUS_STATE_ERR | FOCUS_STATE_CALIB);
+	if (cmd_wait_focus && (arrived || st)) {
+		if (cmd_event(CAN_EV_FOCUS_DONE, cmd_wait_focus - 1U, st, 
+			focus_toStep(*focus_pos & FOCUS_MASK)))
+			return;
+		cmd_wait_focus = 0;
+	}
+	
+  // 4. End of pole pulse (or pole is not able to move)
+	st = pole_getState();
+	if (cmd_wait_pole && (st || 
+		(!pole_isMoving() && pole_getPole() == pole_target))) {
+		if (cmd_event(CAN_EV_POLE_DONE, cmd_wait_pole - 1U, st, 
+			pole_getPole()))
+			return;
+		cmd_wait_pole = 0;
+	}
+}
+//=============================================================================
+uint32_t 
+cmd_getReceived(void)
+{
+	return cmd_seq;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+cmd_getApplied(void)
+{
+	return cmd_applied;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+cmd_getSuperseded(void)
+{
+	return cmd_superseded;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+cmd_getRejected(void)
+{
+	return cmd_rej_seq;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+cmd_getEvents(void)
+{
+	return cmd_events;
+}
+//-----------------------------------------------------------------------------
+// Max latency of command: CAN RX interrupt up to main loop (cycles)
+uint32_t 
+cmd_getLatency(void)
+{
+	return cmd_latMax;
+}
+//-----------------------------------------------------------------------------
+void 
+cmd_resetLatency(void)
+{
+	cmd_latMax = 0;
+}
+//-----------------------------------------------------------------------------
+// on - 1 events of commands / 0 (stored in flash)
+void 
+cmd_setEvent(uint32_t on)
+{
+	config.cmd_event = on ? 1U : 0;
+	config_request();
+}
+//-----------------------------------------------------------------------------
+// Sequence number (cmd_getReceived()) of last applied command
+uint32_t 
+cmd_getLast(void)
+{
+	return cmd_seq_last;
+}
+//=============================================================================
@@ -0,0 +1,25 @@
+//=============================================================================
+#ifndef CMD_H
+#define CMD_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+#define CMD_KEEP  0xFFFFFFFFU  // target is not changed by command
+//-----------------------------------------------------------------------------
+void cmd_init(void);
+void cmd_put(uint32_t focus, uint32_t pole, uint32_t id);
+void cmd_reject(uint32_t id, uint32_t reason);
+int32_t cmd_get(uint32_t *focus, uint32_t *pole, uint32_t *id);
+void cmd_poll(uint32_t arrived);
+uint32_t cmd_getReceived(void);
+uint32_t cmd_getApplied(void);
+uint32_t cmd_getSuperseded(void);
+uint32_t cmd_getLast(void);
+uint32_t cmd_getRejected(void);
+uint32_t cmd_getEvents(void);
+uint32_t cmd_getLatency(void);
+void cmd_resetLatency(void);
+void cmd_setEvent(uint32_t on);
+//=============================================================================
+#endif // CMD_H
+//=============================================================================
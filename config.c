@@ -0,0 +1,121 @@
+//=============================================================================
+/*
+* modules:
+ - FLASH (see flash.c)
+* notes:
+ - RAM copy (config) is used by modules; flash copy is read at start only
+ - saving is requested from any context (config_request()) and done by 
+   main loop (config_poll()) when motors are stopped: CPU is stalled 
+   during flash erase
+*/
+//=============================================================================
+#include "main.h"
+#include "config.h"
+#include "flash.h"
+#include "focus.h"
+#include "calib.h"
+#include "can.h"
+#include "power.h"
+#include "drive.h"
+//=============================================================================
+struct config config;
+static struct config config_copy;  // copy for flash (without interrupts)
+static volatile uint32_t config_req;
+//=============================================================================
+static uint32_t 
+config_sum(const struct config *c)
+{
+	const uint32_t *w = (const uint32_t *)c;
+	uint32_t i, sum = 0;
+	
+	for (i = 0; i < sizeof(*c) / 4U - 1U; ++i)
+		sum += w[i];
+	return ~sum;
+}
+//-----------------------------------------------------------------------------
+static void 
+config_default(void)
+{
+	uint32_t i;
+	
+	config.magic = CONFIG_MAGIC;
+	for (i = 0; i < CONFIG_PRESET_NUM; ++i)
+		config.preset[i] = CONFIG_PRESET_EMPTY;
+	
+	// Not calibrated: legacy mapping (FOCUS_DEVIDER counts per step)
+	config.calib_boot = 0;
+	config.focus_calib = CALIB_NONE;
+	config.focus_min = 0;
+	config.focus_max = (FOCUS_MAX + 1U) * FOCUS_DEVIDER;
+	config.focus_speed = 0;
+	config.focus_noise = 0;
+	config.focus_coast = 0;
+	config.focus_band_start = FOCUS_BAND_START;
+	config.focus_band_stop = FOCUS_BAND_STOP;
+	config.focus_lash = 0;
+	config.focus_approach = FOCUS_APPROACH_BOTH;
+	config.focus_over = FOCUS_OVER_DEF;
+	// Same focus for all poles (pole command does not move focus)
+	for (i = 0; i < CONFIG_POLE_NUM; ++i)
+		config.focus_pole[i] = 0;
+	
+	config.can_retry = CAN_RETRY_DEF << CAN_RETRY_POS | 
+		CAN_RETRIES_DEF << CAN_RETRIES_POS;
+	config.can_rate = CAN_RATE_DEF;
+	
+	config.power_quiet = POWER_QUIET_DEF;
+	
+	config.cmd_event = 1;
+	
+	config.drive_lead = DRIVE_LEAD_DEF;
+	config.drive_hold = DRIVE_HOLD_DEF;
+}
+//=============================================================================
+// Load configuration from flash (or default if flash copy is not valid)
+void 
+config_init(void)
+{
+	const struct config *c = (const struct config *)FLASH_CFG_ADDR;
+	
+	config_req = 0;
+	
+	if (c->magic == CONFIG_MAGIC && c->sum == config_sum(c))
+		config = *c;
+	else
+		config_default();
+}
+//-----------------------------------------------------------------------------
+void 
+config_request(void)
+{
+	config_req = 1;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+config_getRequest(void)
+{
+	return config_req;
+}
+//-----------------------------------------------------------------------------
+// Main loop (motors must be stopped); return -1 on flash error
+int32_t 
+config_poll(void)
+{
+	if (!config_req)
+		return 0;
+	
+	// Consistent copy (config is changed from interrupts)
+	__disable_irq();
+	config_req = 0;
+	config_copy = config;
+	__enable_irq();
+	
+	config_copy.magic = CONFIG_MAGIC;
+	config_copy.sum = config_sum(&config_copy);
+	
+	if (flash_erase(FLASH_CFG_ADDR) != 0)
+		return -1;
+	return flash_write(FLASH_CFG_ADDR, (const uint32_t *)&config_copy, 
+		sizeof(config_copy) / 4U);
+}
+//=============================================================================
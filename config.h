@@ -0,0 +1,47 @@
+//=============================================================================
+#ifndef CONFIG_H
+#define CONFIG_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+#define CONFIG_MAGIC  0x4C43000AU  // "LC" + version of layout
+//-----------------------------------------------------------------------------
+#define CONFIG_PRESET_NUM    8U
+#define CONFIG_PRESET_EMPTY  0xFFFFFFFFU  // as erased flash
+#define CONFIG_POLE_NUM      3U           // POLE_0 ... POLE_2
+//-----------------------------------------------------------------------------
+// Stored in flash (FLASH_CFG_ADDR); change CONFIG_MAGIC if layout changed
+struct config {
+	uint32_t magic;
+	uint32_t preset[CONFIG_PRESET_NUM];  // see preset.h
+	uint32_t calib_boot;                 // 1 - calibration at start
+	uint32_t focus_calib;                // CALIB_x (last calibration)
+	uint32_t focus_min;                  // range (ADC counts)
+	uint32_t focus_max;
+	uint32_t focus_speed;                // counts per CALIB_WIN_MS
+	uint32_t focus_noise;                // peak-to-peak at standstill
+	uint32_t focus_coast;                // counts after stop
+	uint32_t focus_band_start;           // see FOCUS_BAND_x
+	uint32_t focus_band_stop;
+	uint32_t focus_lash;                 // gear lash (ADC counts, see focus.h)
+	uint32_t focus_approach;             // FOCUS_APPROACH_BOTH, FOCUS_DIR_x
+	uint32_t focus_over;                 // past target before approach
+	int32_t focus_pole[CONFIG_POLE_NUM]; // focus offset of pole (counts)
+	uint32_t can_retry;                  // CAN_RETRY_x | retries << 8
+	uint32_t can_rate;                   // CAN_RATE_x or CAN_RATE_AUTO
+	uint32_t power_quiet;                // ms before Stop mode, 0 - never
+	uint32_t cmd_event;                  // 1 - events of commands (cmd.c)
+	uint32_t drive_lead;                 // driver enable before move (us)
+	uint32_t drive_hold;                 // driver enable after move (ms)
+	uint32_t sum;                        // must be last
+};
+//-----------------------------------------------------------------------------
+extern struct config config;
+//-----------------------------------------------------------------------------
+void config_init(void);
+void config_request(void);
+uint32_t config_getRequest(void);
+int32_t config_poll(void);
+//=============================================================================
+#endif // CONFIG_H
+//=============================================================================
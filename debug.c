@@ -1,7 +1,8 @@
 //=============================================================================
 /*
 * modules:
- - GPIO A (AHB): pin 2 ("USART_2_TX"), pin 3 ("USART_2_RX")
+ - GPIO (AHB): "USART_2_TX", "USART_2_RX" (see board.h; pins of motor 
+   channel 2)
  - USART 2 (APB 1)
 * notes:
  - USART 2 connect to ST-LINK/V2-1 for virtual COM port interface on USB
@@ -9,28 +10,15 @@
 */
 //=============================================================================
 #include "main.h"
+#include "board.h"
 //=============================================================================
 static uint32_t prb;
 static uint32_t tdr;
 //=============================================================================
 void uart2_gpio_init(void)
 {
-	#define USART_ALT_FUNC 7U
-	
-	// For delay
-	int32_t i;
-	
-  // 1. Enable clock for GPIO A + delay
-	RCC->AHBENR |= RCC_AHBENR_GPIOAEN;
-	for (i = 0; i < 15; ++i);
-	
-  // 2. Alternative function 7 (USART) for pin 2 and 3
-	GPIOA->MODER |= GPIO_MODER_MODER2_1 | GPIO_MODER_MODER3_1;
-	GPIOA->AFR[0] |= USART_ALT_FUNC << GPIO_AFRL_AFRL2_Pos |
-			USART_ALT_FUNC << GPIO_AFRL_AFRL3_Pos;
-	for (i = 0; i < 15; ++i);
-	
-	#undef USART_ALT_FUNC
+	// Alternative function (USART) for TX and RX pins (see board.c)
+	board_gpioInit(BOARD_GRP_USART);
 }
 //-----------------------------------------------------------------------------
 void usart2_init(void)
@@ -0,0 +1,261 @@
+//=============================================================================
+/*
+* modules:
+ - GPIO (AHB): "EN_3" (focus), "EN_1", "EN_2" (pole motors, see board.h),
+   "EN_4", "EN_5" (axes 1 ..., BOARD_AXIS_NUM > 1); bridge keys "MCx_x" by
+   focus.c, pole.c and axis.c
+* notes:
+ - driver is enabled only around moves: drive_start() before each drive of
+   bridge requests it (RAM only: cost of controller) and returns 1 when it
+   is enabled for config.drive_lead (us); drive_poll() enables it in same
+   pass; driver stays enabled config.drive_hold (ms) after last drive 
+   (bridge brakes, next move starts without lead), then drive_poll() 
+   disables it
+ - motor is busy (driver kept enabled) while its bridge is driven, while 
+   drive_start() is called (move waits for lead) and for focus during 
+   calibration (calib.c drives keys from DMA 1 interrupt); focus with 
+   FOCUS_STATE_ERR is not busy (driver is off after faults, focus.c)
+ - EN_x is written on change only (one store of BSRR); state per motor is
+   one word: drive_off() from interrupt (faults of focus.c) does not race 
+   with main loop
+ - drive_poll() reads DWT once per ADC frame, on change of driven bridges
+   and while a requested driver is not ready (lead time); other passes of
+   main loop cost RAM only => hold time is counted from first poll 
+   without drive (up to one frame late at FOCUS_RATE_PARK)
+ - on time (EN_x set) and drive time (bridge driven) of each motor are 
+   counted by main loop (DWT) => time in Stop mode is not counted; ratio 
+   to run time since start in per mille (CAN_SRV_DRIVE)
+*/
+//=============================================================================
+#include "main.h"
+#include "drive.h"
+#include "irq.h"
+#include "clock.h"
+#include "config.h"
+#include "focus.h"
+#include "pole.h"
+#include "board.h"
+#include "can.h"
+#include "axis.h"
+//=============================================================================
+// Port and BSRR values of EN_x: disable, enable
+static const uint8_t drive_port[DRIVE_NUM] = {
+	BOARD_EN3_PORT, BOARD_EN1_PORT, BOARD_EN2_PORT,
+#if BOARD_AXIS_NUM > 1
+	BOARD_EN4_PORT,
+#endif
+#if BOARD_AXIS_NUM > 2
+	BOARD_EN5_PORT,
+#endif
+};
+static const uint32_t drive_en[DRIVE_NUM][2] = {
+	{ BOARD_EN(3, 0), BOARD_EN(3, 1) },
+	{ BOARD_EN(1, 0), BOARD_EN(1, 1) },
+	{ BOARD_EN(2, 0), BOARD_EN(2, 1) },
+#if BOARD_AXIS_NUM > 1
+	{ BOARD_EN(4, 0), BOARD_EN(4, 1) },
+#endif
+#if BOARD_AXIS_NUM > 2
+	{ BOARD_EN(5, 0), BOARD_EN(5, 1) },
+#endif
+};
+//-----------------------------------------------------------------------------
+static volatile uint32_t drive_on[DRIVE_NUM];
+static volatile uint32_t drive_ready[DRIVE_NUM];  // enabled for lead time
+static uint32_t drive_onT[DRIVE_NUM];    // enable (cycles)
+static uint32_t drive_busyT[DRIVE_NUM];  // last pass with motor busy
+static uint32_t drive_req;               // drive_start() since last poll
+static uint32_t drive_t;                 // last poll (cycles)
+static uint32_t drive_frame;             // focus_getFrames() of last poll
+static uint32_t drive_drv;               // driven bridges of last poll
+static uint32_t drive_usT;               // cycles of HCLK per us
+// Accounting: ms and rest of cycles
+static uint32_t drive_upMs, drive_upC;
+static uint32_t drive_onMs[DRIVE_NUM], drive_onC[DRIVE_NUM];
+static uint32_t drive_drvMs[DRIVE_NUM], drive_drvC[DRIVE_NUM];
+//=============================================================================
+static void 
+drive_set(uint32_t m, uint32_t on)
+{
+	drive_ready[m] = 0;
+	BOARD_GPIO(drive_port[m])->BSRR = drive_en[m][on];
+	drive_on[m] = on;
+}
+//-----------------------------------------------------------------------------
+// After focus_init(), axis_init(), pole_init() (GPIO of EN_x), before 
+// pole_start()
+void 
+drive_init(void)
+{
+	uint32_t m;
+	
+	for (m = 0; m < DRIVE_NUM; ++m) {
+		drive_set(m, 0);
+		drive_onMs[m] = 0;
+		drive_onC[m] = 0;
+		drive_drvMs[m] = 0;
+		drive_drvC[m] = 0;
+	}
+	drive_req = 0;
+	drive_upMs = 0;
+	drive_upC = 0;
+	drive_t = irq_cycles();
+	drive_frame = focus_getFrames();
+	drive_drv = 0;
+	drive_usT = clock_getHclk() / 1000000U;
+}
+//=============================================================================
+// Main loop before drive of bridge of motor m: request driver (enabled by
+// drive_poll()); return 1 if bridge may be driven (enabled for lead time)
+uint32_t 
+drive_start(uint32_t m)
+{
+	drive_req |= 1U << m;
+	return drive_ready[m];
+}
+//-----------------------------------------------------------------------------
+// Disable driver at once (fault, Stop mode); bridge is stopped by owner
+void 
+drive_off(uint32_t m)
+{
+	if (drive_on[m])
+		drive_set(m, 0);
+}
+//-----------------------------------------------------------------------------
+// Before Stop mode (see power.c)
+void 
+drive_sleep(void)
+{
+	uint32_t m;
+	
+	for (m = 0; m < DRIVE_NUM; ++m)
+		drive_off(m);
+}
+//-----------------------------------------------------------------------------
+static void 
+drive_add(uint32_t *ms, uint32_t *c, uint32_t dt, uint32_t per)
+{
+	*c += dt;
+	if (*c >= per) {
+		*ms += *c / per;
+		*c %= per;
+	}
+}
+//-----------------------------------------------------------------------------
+// Main loop (each pass, see notes): enable busy drivers, disable after 
+// hold time, count on and drive time
+// 1. Driven bridges (focus, poles, axes 1 ...); poll on frame, change, 
+//    driver not ready
+// 2. Busy motors: bridge driven, drive_start(), calibration of focus
+// 3. Run time, on time, drive time (state of last poll)
+// 4. Enable busy (ready after lead time), disable idle after hold time
+void 
+drive_poll(void)
+{
+	uint32_t m, busy, drv, dt, now, st, n = focus_getFrames();
+	uint32_t per = drive_usT * 1000U;
+	uint32_t ready = 0;
+	
+  // 1. Driven bridges; poll on frame, change, driver not ready
+	drv = (focus_getDir() != FOCUS_DIR_STOP) << DRIVE_FOCUS | 
+		pole_getDrive() << DRIVE_POLE_1;
+	for (m = 1U; m < AXIS_NUM; ++m)
+		drv |= (axis_getDir(m) != FOCUS_DIR_STOP) << (DRIVE_AXIS + m - 1U);
+	for (m = 0; m < DRIVE_NUM; ++m)
+		ready |= drive_ready[m] << m;
+	if (n == drive_frame && drv == drive_drv && !(drive_req & ~ready))
+		return;
+	drive_frame = n;
+	now = irq_cycles();
+	st = focus_getState();
+	
+  // 2. Busy motors: bridge driven, drive_start(), calibration of focus
+	busy = drv | drive_req;
+	if (st & FOCUS_STATE_CALIB)
+		busy |= 1U << DRIVE_FOCUS;
+	if (st & FOCUS_STATE_ERR)
+		busy &= ~(1U << DRIVE_FOCUS);
+	drive_req = 0;
+	
+  // 3. Run time, on time, drive time (state of last poll)
+	dt = now - drive_t;
+	drive_t = now;
+	drive_add(&drive_upMs, &drive_upC, dt, per);
+	for (m = 0; m < DRIVE_NUM; ++m) {
+		if (drive_on[m])
+			drive_add(&drive_onMs[m], &drive_onC[m], dt, per);
+		if (drive_drv & 1U << m)
+			drive_add(&drive_drvMs[m], &drive_drvC[m], dt, per);
+	}
+	
+  // 4. Enable busy (ready after lead time), disable idle after hold time
+	for (m = 0; m < DRIVE_NUM; ++m) {
+		if (busy & 1U << m) {
+			if (!drive_on[m]) {
+				drive_onT[m] = now;
+				drive_set(m, 1U);
+			}
+			if (!drive_ready[m] && 
+				now - drive_onT[m] >= config.drive_lead * drive_usT)
+				drive_ready[m] = 1U;
+			drive_busyT[m] = now;
+		} else if (drive_on[m] && 
+			now - drive_busyT[m] >= config.drive_hold * per) {
+			drive_set(m, 0);
+		}
+	}
+	drive_drv = drv;
+}
+//=============================================================================
+// From CAN_SRV_DRIVE (saved in flash): lead - us, hold - ms
+int32_t 
+drive_setTime(uint32_t lead, uint32_t hold)
+{
+	if (lead > DRIVE_LEAD_MAX || hold > DRIVE_HOLD_MAX)
+		return -1;
+	config.drive_lead = lead;
+	config.drive_hold = hold;
+	config_request();
+	return 0;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+drive_isOn(uint32_t m)
+{
+	return m < DRIVE_NUM ? drive_on[m] : 0;
+}
+//-----------------------------------------------------------------------------
+// Per mille of run time (ms * 1000 fits in 32 bit up to 71 min)
+static uint32_t 
+drive_ratio(uint32_t ms)
+{
+	uint32_t up = drive_upMs;
+	
+	if (up > 0xFFFFFFFFU / 1000U) {
+		ms /= 1000U;
+		up /= 1000U;
+	}
+	if (!up)
+		return 0;
+	ms = ms * 1000U / up;
+	return ms > 1000U ? 1000U : ms;
+}
+//-----------------------------------------------------------------------------
+// Answer of CAN_SRV_DRIVE (without opcode and error): motor m (or 
+// DRIVE_CONFIG)
+void 
+drive_getStat(uint32_t m, uint32_t *l, uint32_t *h)
+{
+	*l = (m & 0xFFU) << CAN_SRV_ARG1_POS;
+	if (m == DRIVE_CONFIG) {
+		*h = config.drive_lead | config.drive_hold << 16;
+		return;
+	}
+	if (m >= DRIVE_NUM) {
+		*h = 0;
+		return;
+	}
+	*l |= drive_on[m] << CAN_SRV_ARG3_POS;
+	*h = drive_ratio(drive_onMs[m]) | drive_ratio(drive_drvMs[m]) << 16;
+}
+//=============================================================================
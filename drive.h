@@ -0,0 +1,33 @@
+//=============================================================================
+#ifndef DRIVE_H
+#define DRIVE_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+#include "board.h"
+//-----------------------------------------------------------------------------
+// Motor drivers (EN_x of H-bridge, see board.h)
+#define DRIVE_FOCUS    0U  // EN_3
+#define DRIVE_POLE_1   1U  // EN_1
+#define DRIVE_POLE_2   2U  // EN_2
+#define DRIVE_AXIS     3U  // EN_4, EN_5: axis a (1 ...) is DRIVE_AXIS + a - 1
+#define DRIVE_NUM      (DRIVE_AXIS + BOARD_AXIS_NUM - 1U)
+#define DRIVE_CONFIG   0xFFU  // CAN_SRV_DRIVE: lead and hold time
+//-----------------------------------------------------------------------------
+// Enable before first drive of bridge (us), enable after last drive (ms)
+#define DRIVE_LEAD_DEF  100U
+#define DRIVE_LEAD_MAX  10000U
+#define DRIVE_HOLD_DEF  50U
+#define DRIVE_HOLD_MAX  60000U
+//-----------------------------------------------------------------------------
+void drive_init(void);
+uint32_t drive_start(uint32_t m);
+void drive_off(uint32_t m);
+void drive_sleep(void);
+void drive_poll(void);
+int32_t drive_setTime(uint32_t lead, uint32_t hold);
+uint32_t drive_isOn(uint32_t m);
+void drive_getStat(uint32_t m, uint32_t *l, uint32_t *h);
+//=============================================================================
+#endif // DRIVE_H
+//=============================================================================
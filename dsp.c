@@ -0,0 +1,269 @@
+//=============================================================================
+/*
+* modules:
+ - CPU only (DSP instructions of Cortex-M4: SMLAD, SSAT)
+* notes:
+ - each kernel is written once on primitives DSP_SMLAD(), DSP_SAT16(),
+   DSP_LD2(): instructions with DSP_SIMD, C with same arithmetic without
+   it (32 bit wrap of sum as SMLAD, saturation as SSAT) => results are
+   bit-identical on host (host/dspbench.c checks both variants)
+ - samples are int16_t; sums are 32 bit without guard bits: 12 bit ADC
+   counts do not overflow any kernel
+ - dsp_bench(): cycles of kernel (DWT) over test vector and check sum of
+   outputs (same on host and target)
+*/
+//=============================================================================
+#include "main.h"
+#include "dsp.h"
+#include "irq.h"
+//=============================================================================
+// Two int16_t in one word (low, high) as for SMLAD
+#define DSP_PK(lo, hi)  \
+	((uint32_t)(uint16_t)(lo) | (uint32_t)(uint16_t)(hi) << 16)
+
+#if DSP_SIMD
+// x[0], x[1] by one load (x is aligned to word)
+#define DSP_SMLAD(x, y, acc)  __SMLAD((x), (y), (acc))
+#define DSP_SAT16(v)          __SSAT((v), 16)
+#define DSP_LD2(x)            (*(const uint32_t *)(x))
+#else
+#define DSP_SMLAD(x, y, acc)  dsp_smlad((x), (y), (acc))
+#define DSP_SAT16(v)          dsp_sat16(v)
+#define DSP_LD2(x)            DSP_PK((x)[0], (x)[1])
+#endif
+//-----------------------------------------------------------------------------
+// Test vector of dsp_bench(): ramp and noise in 12 bit
+#define DSP_VEC_N  (DSP_BENCH_N + DSP_MEDIAN_MAX)
+static __align(4) int16_t dsp_vec[DSP_VEC_N];
+static uint32_t dsp_vec_ok;
+// Low-pass (fc = fs / 20, Butterworth), Q2.14: b0, b1, b2, a1, a2
+static const int16_t dsp_lp[5] = { 330, 659, 330, 25576, -10509 };
+// Interpolation table (17 points over 12 bit: 256 counts per interval)
+static const int16_t dsp_tab[17] = {
+	0, 16, 64, 144, 256, 400, 576, 784, 1024, 1296, 1600, 1936, 2304,
+	2704, 3136, 3600, 4095
+};
+//=============================================================================
+#if !DSP_SIMD
+// SMLAD: acc + x [15:0] y [15:0] + x [31:16] y [31:16] (signed, 32 bit
+// wrap)
+static uint32_t 
+dsp_smlad(uint32_t x, uint32_t y, uint32_t acc)
+{
+	return acc +
+		(uint32_t)((int32_t)(int16_t)x * (int16_t)y) +
+		(uint32_t)((int32_t)(int16_t)(x >> 16) * (int16_t)(y >> 16));
+}
+//-----------------------------------------------------------------------------
+// SSAT #16
+static int32_t 
+dsp_sat16(int32_t v)
+{
+	if (v > 32767)
+		return 32767;
+	if (v < -32768)
+		return -32768;
+	return v;
+}
+#endif
+//=============================================================================
+// Mean of 2^sh samples (x is aligned to word), rounded down
+int32_t 
+dsp_mean(const int16_t *x, uint32_t sh)
+{
+	uint32_t n = 1U << sh, i, acc = 0;
+	
+	// Two samples per SMLAD (x 1 + x 1)
+	for (i = 0; i + 1U < n; i += 2U)
+		acc = DSP_SMLAD(DSP_LD2(&x[i]), 0x00010001U, acc);
+	if (n & 1U)
+		acc += (uint32_t)(int32_t)x[n - 1U];
+	return (int32_t)acc >> sh;
+}
+//=============================================================================
+// buf - 2^sh samples; filled by x0 (output x0 at once)
+void 
+dsp_avgInit(struct dsp_avg *a, int16_t *buf, uint32_t sh, int16_t x0)
+{
+	uint32_t i;
+	
+	a->buf = buf;
+	a->sh = sh;
+	a->i = 0;
+	for (i = 0; i < 1U << sh; ++i)
+		buf[i] = x0;
+	a->sum = x0 * (int32_t)(1U << sh);
+}
+//-----------------------------------------------------------------------------
+// Running sum: one add and one subtract per sample (same for DSP_SIMD)
+int16_t 
+dsp_avg(struct dsp_avg *a, int16_t x)
+{
+	a->sum += x - a->buf[a->i];
+	a->buf[a->i] = x;
+	a->i = (a->i + 1U) & ((1U << a->sh) - 1U);
+	return (int16_t)(a->sum >> a->sh);
+}
+//=============================================================================
+// c - b0, b1, b2, a1, a2 (Q2.14); state of steady x0 (DC gain 1)
+void 
+dsp_biquadInit(struct dsp_biquad *f, const int16_t *c, int16_t x0)
+{
+	f->b01 = DSP_PK(c[0], c[1]);
+	f->b2a1 = DSP_PK(c[2], c[3]);
+	f->a2 = c[4];
+	f->x1 = f->x2 = x0;
+	f->y1 = f->y2 = x0;
+}
+//-----------------------------------------------------------------------------
+// Two SMLAD and one MLA per sample; rounded, saturated to 16 bit
+int16_t 
+dsp_biquad(struct dsp_biquad *f, int16_t x)
+{
+	uint32_t acc = 1U << (DSP_BQ_SH - 1U);
+	int16_t y;
+	
+	acc = DSP_SMLAD(DSP_PK(x, f->x1), f->b01, acc);
+	acc = DSP_SMLAD(DSP_PK(f->x2, f->y1), f->b2a1, acc);
+	acc += (uint32_t)(f->a2 * f->y2);
+	y = (int16_t)DSP_SAT16((int32_t)acc >> DSP_BQ_SH);
+	
+	f->x2 = f->x1;
+	f->x1 = x;
+	f->y2 = f->y1;
+	f->y1 = y;
+	return y;
+}
+//=============================================================================
+// Median of n (up to DSP_MEDIAN_MAX) samples: lower one for even n;
+// insertion sort of copy (no DSP instruction for it)
+int16_t 
+dsp_median(const int16_t *x, uint32_t n)
+{
+	int16_t s[DSP_MEDIAN_MAX], v;
+	uint32_t i, j;
+	
+	if (n == 0)
+		return 0;
+	if (n > DSP_MEDIAN_MAX)
+		n = DSP_MEDIAN_MAX;
+	for (i = 0; i < n; ++i) {
+		v = x[i];
+		for (j = i; j > 0 && s[j - 1U] > v; --j)
+			s[j] = s[j - 1U];
+		s[j] = v;
+	}
+	return s[(n - 1U) / 2U];
+}
+//=============================================================================
+// kp, ki, kd - Q4.12; max - limit of output (and of integral term)
+void 
+dsp_pidInit(struct dsp_pid *p, int16_t kp, int16_t ki, int16_t kd,
+		int16_t max)
+{
+	p->kpd = DSP_PK(kp, kd);
+	p->ki = ki;
+	p->i = 0;
+	p->i_max = max * (int32_t)(1U << DSP_PID_SH);
+	p->e1 = 0;
+}
+//-----------------------------------------------------------------------------
+// One step for error e: integral (limited), then kp e + kd de by SMLAD
+int16_t 
+dsp_pid(struct dsp_pid *p, int16_t e)
+{
+	int32_t de = DSP_SAT16((int32_t)e - p->e1);
+	uint32_t acc;
+	
+	p->i += p->ki * e;
+	if (p->i > p->i_max)
+		p->i = p->i_max;
+	else if (p->i < -p->i_max)
+		p->i = -p->i_max;
+	
+	acc = DSP_SMLAD(DSP_PK(e, de), p->kpd, (uint32_t)p->i);
+	p->e1 = e;
+	return (int16_t)DSP_SAT16((int32_t)acc >> DSP_PID_SH);
+}
+//=============================================================================
+// Table tab at x with sh fraction bits (1 ... DSP_INTERP_MAX): point
+// x >> sh and next one (not read if fraction is 0), rounded
+int32_t 
+dsp_interp(const int16_t *tab, uint32_t sh, uint32_t x)
+{
+	uint32_t i = x >> sh;
+	uint32_t f = x & ((1U << sh) - 1U);
+	
+	if (!f)
+		return tab[i];
+	// tab[i] (2^sh - f) + tab[i + 1] f: weights < 2^14
+	return (int32_t)DSP_SMLAD(DSP_PK(tab[i], tab[i + 1U]),
+		DSP_PK((1U << sh) - f, f), 1U << (sh - 1U)) >> sh;
+}
+//=============================================================================
+// Run kernel k (DSP_K_x) over DSP_BENCH_N samples; return -1 if k is not
+// valid
+// cycles - DWT cycles of run, sum - check sum of outputs (16 bit)
+// 1. Test vector (once)
+// 2. Setup of kernel (not counted)
+// 3. Run
+int32_t 
+dsp_bench(uint32_t k, uint32_t *cycles, uint32_t *sum)
+{
+	static int16_t avg_buf[8];
+	struct dsp_avg a;
+	struct dsp_biquad f;
+	struct dsp_pid p;
+	uint32_t i, t0, s = 0, rnd = 2024U;
+	
+	if (k >= DSP_K_NUM)
+		return -1;
+	
+  // 1. Test vector (once)
+	if (!dsp_vec_ok) {
+		for (i = 0; i < DSP_VEC_N; ++i) {
+			rnd = rnd * 1664525U + 1013904223U;
+			dsp_vec[i] = (int16_t)((i * 61U + (rnd >> 24)) & 0xFFFU);
+		}
+		dsp_vec_ok = 1;
+	}
+	
+  // 2. Setup of kernel (not counted)
+	dsp_avgInit(&a, avg_buf, 3U, dsp_vec[0]);
+	dsp_biquadInit(&f, dsp_lp, dsp_vec[0]);
+	dsp_pidInit(&p, 8192, 205, 2048, 1000);
+	
+  // 3. Run
+	t0 = irq_cycles();
+	switch (k) {
+	case DSP_K_MEAN:
+		for (i = 0; i < DSP_BENCH_N; i += 4U)
+			s += (uint32_t)dsp_mean(&dsp_vec[i], 2U);
+		break;
+	case DSP_K_AVG:
+		for (i = 0; i < DSP_BENCH_N; ++i)
+			s += (uint32_t)dsp_avg(&a, dsp_vec[i]);
+		break;
+	case DSP_K_BIQUAD:
+		for (i = 0; i < DSP_BENCH_N; ++i)
+			s += (uint32_t)dsp_biquad(&f, dsp_vec[i]);
+		break;
+	case DSP_K_MEDIAN:
+		for (i = 0; i < DSP_BENCH_N; ++i)
+			s += (uint32_t)dsp_median(&dsp_vec[i], 5U);
+		break;
+	case DSP_K_PID:
+		for (i = 0; i < DSP_BENCH_N; ++i)
+			s += (uint32_t)dsp_pid(&p, (int16_t)(2048 - dsp_vec[i]));
+		break;
+	default:
+		for (i = 0; i < DSP_BENCH_N; ++i)
+			s += (uint32_t)dsp_interp(dsp_tab, 8U,
+				(uint32_t)dsp_vec[i]);
+		break;
+	}
+	*cycles = irq_cycles() - t0;
+	*sum = (s ^ s >> 16) & 0xFFFFU;
+	return 0;
+}
+//=============================================================================
@@ -0,0 +1,72 @@
+//=============================================================================
+#ifndef DSP_H
+#define DSP_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+// 1 - DSP instructions of Cortex-M4 (SMLAD, SSAT), 0 - portable C with
+// same results (bit-identical, see dsp.c)
+#ifndef DSP_SIMD
+#if defined(__ARM_ARCH_7EM__) || defined(__ARM_FEATURE_DSP)
+#define DSP_SIMD  1U
+#else
+#define DSP_SIMD  0U
+#endif
+#endif
+//-----------------------------------------------------------------------------
+// Fixed point: samples int16_t; biquad coefficients Q2.14, PID gains Q4.12
+#define DSP_BQ_SH       14U
+#define DSP_PID_SH      12U
+#define DSP_INTERP_MAX  14U  // fraction bits of dsp_interp()
+#define DSP_MEDIAN_MAX  9U
+//-----------------------------------------------------------------------------
+// Kernels of dsp_bench() (CAN_SRV_DSP_BENCH)
+#define DSP_K_MEAN      0U  // block of 4 samples
+#define DSP_K_AVG       1U  // moving average of 8 samples
+#define DSP_K_BIQUAD    2U  // low-pass
+#define DSP_K_MEDIAN    3U  // median of 5 samples
+#define DSP_K_PID       4U
+#define DSP_K_INTERP    5U  // table of 17 points
+#define DSP_K_NUM       6U
+
+#define DSP_BENCH_N     64U  // samples per run
+//-----------------------------------------------------------------------------
+// Moving average of 2^sh samples (buf - 2^sh samples of caller)
+struct dsp_avg {
+	int16_t *buf;
+	uint32_t sh;
+	uint32_t i;
+	int32_t sum;
+};
+// Biquad (direct form 1): y = b0 x + b1 x1 + b2 x2 + a1 y1 + a2 y2 (a1,
+// a2 with sign of addition); coefficients are packed for SMLAD
+struct dsp_biquad {
+	uint32_t b01;  // b0 [15:0], b1 [31:16]
+	uint32_t b2a1; // b2 [15:0], a1 [31:16]
+	int32_t a2;
+	int16_t x1, x2, y1, y2;
+};
+// PID: y = kp e + ki sum(e) + kd (e - e1), integral is limited to output
+// range (anti-windup); e of 12 bit ADC counts => no overflow of sum
+struct dsp_pid {
+	uint32_t kpd;  // kp [15:0], kd [31:16]
+	int32_t ki;
+	int32_t i;     // integral (Q4.12)
+	int32_t i_max;
+	int16_t e1;
+};
+//-----------------------------------------------------------------------------
+int32_t dsp_mean(const int16_t *x, uint32_t sh);
+void dsp_avgInit(struct dsp_avg *a, int16_t *buf, uint32_t sh, int16_t x0);
+int16_t dsp_avg(struct dsp_avg *a, int16_t x);
+void dsp_biquadInit(struct dsp_biquad *f, const int16_t *c, int16_t x0);
+int16_t dsp_biquad(struct dsp_biquad *f, int16_t x);
+int16_t dsp_median(const int16_t *x, uint32_t n);
+void dsp_pidInit(struct dsp_pid *p, int16_t kp, int16_t ki, int16_t kd,
+		int16_t max);
+int16_t dsp_pid(struct dsp_pid *p, int16_t e);
+int32_t dsp_interp(const int16_t *tab, uint32_t sh, uint32_t x);
+int32_t dsp_bench(uint32_t k, uint32_t *cycles, uint32_t *sum);
+//=============================================================================
+#endif // DSP_H
+//=============================================================================
@@ -0,0 +1,103 @@
+//=============================================================================
+/*
+* modules:
+ - FLASH (FPEC)
+* notes:
+ - CPU (and all interrupts from flash) is stalled while erase/program is 
+   busy (page erase ~ 20-40 ms): call only when motors are stopped
+ - programming by half-words; page must be erased before
+*/
+//=============================================================================
+#include "main.h"
+#include "flash.h"
+//=============================================================================
+#define FLASH_UNLOCK_KEY1  0x45670123U
+#define FLASH_UNLOCK_KEY2  0xCDEF89ABU
+//=============================================================================
+static void 
+flash_unlock(void)
+{
+	// Wait end of previous operation
+	while (FLASH->SR & FLASH_SR_BSY);
+	
+	if (FLASH->CR & FLASH_CR_LOCK) {
+		FLASH->KEYR = FLASH_UNLOCK_KEY1;
+		FLASH->KEYR = FLASH_UNLOCK_KEY2;
+	}
+}
+//-----------------------------------------------------------------------------
+// Wait end of operation, clear flags and return -1 on error
+static int32_t 
+flash_wait(void)
+{
+	uint32_t sr;
+	
+	while (FLASH->SR & FLASH_SR_BSY);
+	sr = FLASH->SR;
+	// Clear flags (write 1 to clear)
+	FLASH->SR = FLASH_SR_EOP | FLASH_SR_PGERR | FLASH_SR_WRPERR;
+	
+	if (sr & (FLASH_SR_PGERR | FLASH_SR_WRPERR))
+		return -1;
+	return 0;
+}
+//=============================================================================
+// 1. Unlock
+// 2. Page erase mode, address of page, start + wait
+// 3. Exit from page erase mode + lock
+int32_t 
+flash_erase(uint32_t addr)
+{
+	int32_t ret;
+	
+  // 1. Unlock
+	flash_unlock();
+	
+  // 2. Page erase mode, address of page, start + wait
+	FLASH->CR |= FLASH_CR_PER;
+	FLASH->AR = addr;
+	FLASH->CR |= FLASH_CR_STRT;
+	ret = flash_wait();
+	
+  // 3. Exit from page erase mode + lock
+	FLASH->CR &= ~FLASH_CR_PER;
+	FLASH->CR |= FLASH_CR_LOCK;
+	
+	return ret;
+}
+//-----------------------------------------------------------------------------
+// n - number of words
+// 1. Unlock
+// 2. Programming mode
+// 3. Write by half-words + wait + verify
+// 4. Exit from programming mode + lock
+int32_t 
+flash_write(uint32_t addr, const uint32_t *data, uint32_t n)
+{
+	volatile uint16_t *dst = (volatile uint16_t *)addr;
+	int32_t ret = 0;
+	uint32_t i;
+	uint16_t hw;
+	
+  // 1. Unlock
+	flash_unlock();
+	
+  // 2. Programming mode
+	FLASH->CR |= FLASH_CR_PG;
+	
+  // 3. Write by half-words + wait + verify
+	for (i = 0; i < 2U * n && ret == 0; ++i) {
+		hw = (uint16_t)(data[i / 2U] >> (16U * (i & 1U)));
+		dst[i] = hw;
+		ret = flash_wait();
+		if (dst[i] != hw)
+			ret = -1;
+	}
+	
+  // 4. Exit from programming mode + lock
+	FLASH->CR &= ~FLASH_CR_PG;
+	FLASH->CR |= FLASH_CR_LOCK;
+	
+	return ret;
+}
+//=============================================================================
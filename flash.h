@@ -0,0 +1,14 @@
+//=============================================================================
+#ifndef FLASH_H
+#define FLASH_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+#define FLASH_PAGE_SIZE  0x800U       // 2 KB
+#define FLASH_CFG_ADDR   0x0800F800U  // last page of 64 KB (configuration)
+//-----------------------------------------------------------------------------
+int32_t flash_erase(uint32_t addr);
+int32_t flash_write(uint32_t addr, const uint32_t *data, uint32_t n);
+//=============================================================================
+#endif // FLASH_H
+//=============================================================================
@@ -1,14 +1,15 @@
 //=============================================================================
 /*
 * modules:
- - GPIO A (AHB): pin 0 ("MC3_N"), pin 1 ("MC3_P")
- - GPIO B (AHB): pin 12 ("EN_3")
- - GPIO B (AHB): pin 13 ("VAR_RES_IR" for ADC 1)
+ - GPIO (AHB): "MC3_N", "MC3_P", "EN_3" (motor channel 3, see board.h; 
+   keys from axis_desc[AXIS_FOCUS])
+ - GPIO (AHB): "VAR_RES_IR" for ADC 1 (see board.h), potentiometers of 
+   other axes (axis.c)
  - ADC 1 (AHB)
  - TIM 2 (APB 1)
  - DMA 1 (AHB)
 * scheme:
-    GPIO B: pin 13
+    GPIO: "VAR_RES_IR"
         \
  TIM -> ADC *-->* MEMORY 
          \   \ /
@@ -17,41 +18,108 @@
  - TIM 2 prescaler from RCC: Figure 14. STM32F302x6/8 clock tree
  - errata -> ADC -> forbidden instructions and calibration
  - look for "<RCC>" for code depend on system clock frequence value 
+ - rate of frames (FOCUS_RATE_x, see focus_adapt()): TIM 2 period and 
+   potentiometer samples in ADC 1 sequence (mean is position); ARR and 
+   CCR2 are preloaded (ARPE, OC2PE) => new period starts at update event, 
+   no period is cut or runs over (CNT > new ARR); from PARK TIM 2 restarts 
+   at once (UG)
+ - time stamp of frame (focus_getStamp(), us): sum of TIM 2 periods of 
+   frames (period is written in DMA 1 interrupt of frame k, active from 
+   frame k + 2); does not count while TIM 2 is stopped (Stop mode)
+ - ADC 1 sequence and DMA 1 buffer from axis_desc[] (see axis.c): adc_n 
+   samples of each axis (block of axis a at a x adc_n: aligned to word 
+   for dsp_mean() with 2 and 4 samples), temperature sensor, internal 
+   reference voltage; sampling time of each channel in SMPR1 / SMPR2
+ - gear lash: potentiometer is on motor side, lens follows it with dead 
+   band of config.focus_lash; focus_control() (main loop) estimates lens 
+   position and controls it, so the same target is the same lens position
+   from both directions; unidirectional approach (config.focus_approach)
+   removes rest of error (lash is not measured exactly)
+ - focus offset of pole (config.focus_pole[]): pole changes optical path,
+   command with new pole and without focus gets focus target of new pole 
+   (cmd_get()), so focus moves in the same pass of main loop as TIM 6 
+   pulse of pole starts (not after end of pole move)
+ - "EN_3" is driven by drive.c (enabled around moves): focus_control() 
+   starts a move after drive_start(); keys are written on change only
 */
 //=============================================================================
 #include "main.h"
 #include "focus.h"
+#include "trace.h"
+#include "irq.h"
+#include "config.h"
+#include "calib.h"
+#include "clock.h"
+#include "board.h"
+#include "dsp.h"
+#include "axis.h"
+#include "boot.h"
+#include "stream.h"
+#include "drive.h"
+#include "cmd.h"
 //=============================================================================
-static __align(4) uint32_t adc_val[3];  // align(4) - 32 bit align for DMA 
-                                        // (not need - compilator)
+// ADC 1 channels (potentiometers - see axis.c): temperature sensor, internal 
+// reference voltage
+#define FOCUS_CH_TEMP  16U
+#define FOCUS_CH_VREF  18U
+// ADC 1 regular sequence: up to 16 conversions
+#define FOCUS_SEQ_MAX  (AXIS_NUM * FOCUS_SAMPLES_MAX + 2U)
+#if AXIS_NUM * FOCUS_SAMPLES_MAX + 2U > 16U
+#error "ADC 1 sequence: too many axes or samples"
+#endif
+//-----------------------------------------------------------------------------
+// <RCC> TIM 2 periods (1 MHz) and log2 of potentiometer samples 
+// (FOCUS_RATE_x order)
+static const uint32_t focus_per[FOCUS_RATE_NUM] = { 250U, 1000U, 200000U };
+static const uint32_t focus_sh[FOCUS_RATE_NUM] = { 0, 1U, 2U };
+//-----------------------------------------------------------------------------
+// Frame period of calibration (calib.c: 1 ms frames) and longest ADC 1 
+// sequence after trigger (FOCUS_SAMPLES_MAX x 614 cycles of focus, 74 
+// cycles of other axes, 2 x 32 cycles at 4 MHz: 778 us with 3 axes; FAST: 
+// 206.5 us of 250 us)
+#define FOCUS_MS_US   1000U
+#define FOCUS_SEQ_US  1000U
+#define FOCUS_VIA_NONE  0xFFFFFFFFU  // no move past target
+//=============================================================================
+static __align(4) int16_t adc_val[FOCUS_SEQ_MAX];
+                                        // align(4) - pairs of samples for 
+                                        // SMLAD (dsp_mean())
+static volatile uint32_t adc_good[AXIS_NUM + 2U];
+                                        // last good frame (mean of samples 
+                                        // of each axis, temp, vref)
+static uint32_t adc_sh;                 // log2 of potentiometer samples
+static uint32_t adc_n;                  // potentiometer samples (per axis)
+static uint32_t adc_len;                // ADC 1 sequence (DMA 1 data)
+static volatile uint32_t adc_rate;      // active rate (FOCUS_RATE_x)
+static volatile uint32_t adc_want;      // rate for DMA 1 interrupt
+static uint32_t adc_per[2];             // TIM 2 periods of next frames (us)
+static volatile uint32_t focus_stamp;   // end of last frame (us)
+static volatile uint32_t focus_frames;
+static uint32_t focus_mode;             // FOCUS_RATE_x or FOCUS_RATE_AUTO
+static uint32_t focus_arrT;             // stamp of arrival on target
 static volatile uint32_t focus_state;
+static volatile uint32_t focus_faults;      // faults without good frame
+static volatile uint32_t focus_recoveries;  // all re-arms of ADC/DMA/TIM
+static volatile uint32_t focus_dir;
+static int32_t focus_lens;                  // estimate (-1 - before frame)
+static uint32_t focus_via;                  // past target (approach)
+static uint32_t focus_viaT;                 // target of approach
+static uint32_t focus_viaDone;              // approach of target is done
+static uint32_t adc_calfact;                // after calibration at start
+static uint32_t focus_io[3];                // BSRR of FOCUS_DIR_x (keys)
 //=============================================================================
+// Keys from axis_desc[AXIS_FOCUS] (as axis_init()): one store per drive
 static void
 keys_init(void)
 {
-	// For delay
-	int32_t i;
-	
-	// Enable clock for GPIO A, B + delay
-	RCC->AHBENR |= RCC_AHBENR_GPIOAEN | RCC_AHBENR_GPIOBEN;
-	for (i = 0; i < 15; ++i);
-	
-	// Using pins: PA 0, PA 1, PB 12
-	
-	// Output mode
-	GPIOA->MODER |= GPIO_MODER_MODER0_0 | GPIO_MODER_MODER1_0;
-	GPIOB->MODER |= GPIO_MODER_MODER12_0;
+	const struct axis_desc *d = &axis_desc[AXIS_FOCUS];
 	
-	// High speed
-	GPIOA->OSPEEDR |= 
-		GPIO_OSPEEDER_OSPEEDR0_0 | GPIO_OSPEEDER_OSPEEDR0_1 |
-		GPIO_OSPEEDER_OSPEEDR1_0 | GPIO_OSPEEDER_OSPEEDR1_1;
-	GPIOB->OSPEEDR |= 
-		GPIO_OSPEEDER_OSPEEDR12_0 | GPIO_OSPEEDER_OSPEEDR12_1;
+	focus_io[FOCUS_DIR_STOP] = BOARD_BR(d->fwd) | BOARD_BR(d->back);
+	focus_io[FOCUS_DIR_FORWARD] = BOARD_BS(d->fwd) | BOARD_BR(d->back);
+	focus_io[FOCUS_DIR_BACK] = BOARD_BR(d->fwd) | BOARD_BS(d->back);
 	
-	// Pull-down
-	GPIOA->PUPDR |= GPIO_PUPDR_PUPDR0_1 | GPIO_PUPDR_PUPDR1_1;
-	GPIOB->PUPDR |= GPIO_PUPDR_PUPDR12_1;
+	// Output, high speed, pull-down: MC3_N, MC3_P, EN_3 (see board.c)
+	board_gpioInit(BOARD_GRP_FOCUS);
 }
 //-----------------------------------------------------------------------------
 static void 
@@ -65,7 +133,7 @@ dma1_init(void)
 	for (i = 0; i < 15; ++i);
 	
 	// Channel 1 for ADC 1 request
-	DMA1_Channel1->CCR |= 	DMA_CCR_MSIZE_1 |  // Memory size = 32 bit
+	DMA1_Channel1->CCR |= 	DMA_CCR_MSIZE_0 |  // Memory size = 16 bit
 				DMA_CCR_MINC |     // Memory increment mode
 				DMA_CCR_PSIZE_0 |  // Peripheral size = 16 bit 
 				DMA_CCR_CIRC |     // Circular mode
@@ -73,10 +141,12 @@ dma1_init(void)
 				                   //         interrupt enable
 				DMA_CCR_TEIE;      // Transfer error 
 				                   //         interrupt enable
-	DMA1_Channel1->CNDTR |= 3U;    // Number of data = 3
+	DMA1_Channel1->CNDTR = adc_len;     // Number of data (sequence)
 	DMA1_Channel1->CPAR = 
 			(uint32_t)&(ADC1->DR);     // Peripheral address
 	DMA1_Channel1->CMAR = (uint32_t)adc_val;   // Memory address
+	NVIC_SetPriority(DMA1_Channel1_IRQn,       // Priority (see irq.h)
+			IRQ_PRIO(IRQ_DMA1_PRE, IRQ_DMA1_SUB));
 	NVIC_EnableIRQ(DMA1_Channel1_IRQn);        // Enable interrupt from 
 	                                           // DMA Channel 1
 }
@@ -92,11 +162,12 @@ tim2_init(void)
 	for (i = 0; i < 15; ++i);
 	
   // OC2REF (CC2) toggles when TIMx_CNT == TIMx_CCR2 (need for ADC 1 trigger)
-	TIM2->CCMR1 |= TIM_CCMR1_OC2M_0 | TIM_CCMR1_OC2M_1;
+	TIM2->CCMR1 |= TIM_CCMR1_OC2M_0 | TIM_CCMR1_OC2M_1 | 
+		TIM_CCMR1_OC2PE;  // CCR2 preloaded (see focus_rate())
 	
   // Set value for CCR2 (must be equal to ARR for this application)
-	TIM2->CCR2 = 1000U;  // 1 MHz -> 1 KHz;
-	// ^^^^^^^^^^^^^^^^^^^^^-- OC2PE = 0 => not preloaded
+	TIM2->CCR2 = focus_per[adc_rate] - 1U;  // 1 MHz -> 1 KHz;
+	// ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^-- OC2PE = 1 => preloaded
 	
 	// <RCC>
   // Set prescaler
@@ -105,8 +176,9 @@ tim2_init(void)
 	// ^^^^^^^^^^^^^^^^-- preloaded => need UEV
 	
   // Set auto-reload value (must be equal to CCR2 for this application)
-	TIM2->ARR = 1000U;    // 1 MHz -> 1 KHz;
-	// ^^^^^^^^^^^^^^^^^^^^-- ARPE = 0 => not preloaded
+	TIM2->ARR = focus_per[adc_rate] - 1U;   // 1 MHz -> 1 KHz;
+	// ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^-- ARPE = 1 => preloaded
+	TIM2->CR1 |= TIM_CR1_ARPE;
 	
   // Set OC2 (CC2) signal as output (otherwise without interrupt)
 	// NOTE: reference manual - figure 216
@@ -121,24 +193,53 @@ tim2_init(void)
 	for (i = 0; i < 15; ++i);
 }
 //-----------------------------------------------------------------------------
+// Regular sequence of ADC 1 (ADSTART = 0): adc_n x potentiometer of each 
+// axis (axis_desc[] order), temperature sensor, internal reference voltage; 
+// L = length - 1
 static void 
-adc1_gpio_init(void)
+adc1_seq(void)
 {
-	// For delay
-	int32_t i;
+	uint32_t sqr[4] = { 0, 0, 0, 0 };
+	uint32_t i, a, ch;
 	
-	// Enable clock for GPIO B + delay
-	RCC->AHBENR |= RCC_AHBENR_GPIOBEN;
-	for (i = 0; i < 15; ++i);
-	
-	// PB 13: analog finction for ADC 1
-	GPIOB->MODER |= GPIO_MODER_MODER13_0 | GPIO_MODER_MODER13_1;
-	for (i = 0; i < 15; ++i);
+	adc_len = AXIS_NUM * adc_n + 2U;
+	sqr[0] = adc_len - 1U;
+	for (i = 0; i < adc_len; ++i) {
+		a = i / adc_n;
+		ch = a < AXIS_NUM ? axis_desc[a].ch : 
+			i == AXIS_NUM * adc_n ? FOCUS_CH_TEMP : FOCUS_CH_VREF;
+		// SQ(i + 1): 5 fields of 6 bits in register (SQR1: L is first)
+		sqr[(i + 1U) / 5U] |= ch << (6U * ((i + 1U) % 5U));
+	}
+	ADC1->SQR1 = sqr[0];
+	ADC1->SQR2 = sqr[1];
+	ADC1->SQR3 = sqr[2];
+	ADC1->SQR4 = sqr[3];
+}
+//-----------------------------------------------------------------------------
+// Sampling time (SMPx code) of channel: SMPR1 - channels 1 ... 9, SMPR2 - 
+// channels 10 ... 18 (3 bits each)
+static void 
+adc1_smp(uint32_t ch, uint32_t smp)
+{
+	if (ch < 10U)
+		ADC1->SMPR1 = (ADC1->SMPR1 & ~(7U << 3U * ch)) | smp << 3U * ch;
+	else
+		ADC1->SMPR2 = (ADC1->SMPR2 & ~(7U << 3U * (ch - 10U))) | 
+			smp << 3U * (ch - 10U);
+}
+//-----------------------------------------------------------------------------
+static void 
+adc1_gpio_init(void)
+{
+	// Analog function for ADC 1: "VAR_RES_IR", potentiometers of other 
+	// axes (see board.c)
+	board_gpioInit(BOARD_GRP_POT);
 }
 //-----------------------------------------------------------------------------
 // 1. Enable CLK
 // 2. Enable voltage regulator
-// 3. Calibration
+// 3. Calibration (warm boot: stored factor, see boot.c)
 // 4. Enable temperature sensor and internal reference voltage
 // 5. Enable ADC
 // 6. Order conversion and lenght
@@ -148,12 +249,14 @@ adc1_gpio_init(void)
 // 10. Enable DMA mode
 // 11 (disable). Setting AWD 1
 // 12 (disable). Enable interrupt for EOS
-// 13 (disable). Enable interrupt from ADC 1
+// 13. Enable interrupt for overrun
+// 14. Enable interrupt from ADC 1
 static void 
 adc1_init(void)
 {
 	// For delay
 	int32_t i;
+	uint32_t a;
 	
 	// Enable analog function for ADC 1
 	adc1_gpio_init();
@@ -182,13 +285,19 @@ adc1_init(void)
   // WARNING: for 8 MHz and 'for' devide into 2 assembler operations
 	for (i = 0; i < 2*(40) + 15; ++i);
  
-  // 3. Calibration
-	// Enable calibration
-	ADC1->CR |= ADC_CR_ADCAL;
-	// Wait calibration complete (also see datasheet -> 6.3.18 t CAL)
-	while (ADC1->CR & ADC_CR_ADCAL);
-	// <RCC>
-	for (i = 0; i < 2*4; ++i); // see "device errata"
+  // 3. Calibration (warm boot: stored factor, see boot.c)
+	// Keep factor for restart after Stop mode (see focus_wake())
+	adc_calfact = boot_getCalfact();
+	if (adc_calfact == BOOT_NONE) {
+		// Enable calibration
+		ADC1->CR |= ADC_CR_ADCAL;
+		// Wait calibration complete (also see datasheet -> 6.3.18 t CAL)
+		while (ADC1->CR & ADC_CR_ADCAL);
+		// <RCC>
+		for (i = 0; i < 2*4; ++i); // see "device errata"
+		adc_calfact = ADC1->CALFACT;
+		boot_setCalfact(adc_calfact);
+	}
 	
   // 4. Enable temperature sensor and internal reference voltage
 	ADC1_COMMON->CCR |= ADC_CCR_TSEN | ADC_CCR_VREFEN;
@@ -204,27 +313,26 @@ adc1_init(void)
 	while (!(ADC1->ISR & ADC_ISR_ADRDY));
 	// Clear ready flag
 	// ADC1->ISR |= ADC_ISR_ADRDY;
+	// Calibration factor (ADEN = 1, ADSTART = 0; same after calibration)
+	ADC1->CALFACT = adc_calfact;
 	
-  // 6. Order conversion and lenght: 
-	// ADCx_SQR1_1 = ADC1_IN13
-	// ADCx_SQR1_2 = ADC1_IN16 
-	// ADCx_SQR1_3 = ADC1_IN18 
-	// lenght L = 3
-	ADC1->SQR1 |= 
-		ADC_SQR1_SQ1_0 | ADC_SQR1_SQ1_2 | ADC_SQR1_SQ1_3 |  // 13
-		ADC_SQR1_SQ2_4 |                                    // 16
-		ADC_SQR1_SQ3_1 | ADC_SQR1_SQ3_4 |                   // 18
-		ADC_SQR1_L_1;                                       // L - 1
+  // 6. Order conversion and lenght (see adc1_seq()): 
+	// ADCx_SQR1_1 ... = channel of axis 0 (adc_n samples), axis 1 ...
+	// next = ADC1_IN16 
+	// next = ADC1_IN18 
+	// lenght L = AXIS_NUM x adc_n + 2
+	adc1_seq();
 	
 	// <RCC> and HCLK prescaler (see above)
-  // 7. Sampling time
-	// 601.5 ADC clock cycles for potentiometer 
+  // 7. Sampling time (SMPR2 for channels 10 ... 18)
+	// axis_desc[]: 601.5 ADC clock cycles for potentiometer of focus, 61.5 
+	// for buffered potentiometers
 	// 19.5 ADC clock cycles for TempSens (2.2 us; see datasheet: 6.3.22)
 	// 19.5 ADC clock cycles for T_S_vrefint (2.2 us; see datasheet: 6.3.4)
-	ADC1->SMPR1 |= 
-		ADC_SMPR1_SMP1_0 | ADC_SMPR1_SMP1_1 | ADC_SMPR1_SMP1_2 |
-		ADC_SMPR1_SMP2_2 |
-		ADC_SMPR1_SMP3_2;
+	for (a = 0; a < AXIS_NUM; ++a)
+		adc1_smp(axis_desc[a].ch, axis_desc[a].smp);
+	adc1_smp(FOCUS_CH_TEMP, AXIS_SMP_19);
+	adc1_smp(FOCUS_CH_VREF, AXIS_SMP_19);
 	
   // 8. Set resolution (T SAR depends on RES[2:0] (Table 89) and Figure 58 !!!)
 	// Resolution: 12 bit (t sar == xx ADC clock cycles (Figure 58))
@@ -256,18 +364,42 @@ adc1_init(void)
   // 12. Enable interrupt for EOS
 	// ADC1->IER |= ADC_IER_EOSIE;
 	
-  // 13. Enable interrupt from ADC 1
-	// NVIC_EnableIRQ(ADC1_IRQn);
+  // 13. Enable interrupt for overrun
+	ADC1->IER |= ADC_IER_OVRIE;
+	
+  // 14. Enable interrupt from ADC 1 (priority - see irq.h)
+	NVIC_SetPriority(ADC1_IRQn, IRQ_PRIO(IRQ_ADC1_PRE, IRQ_ADC1_SUB));
+	NVIC_EnableIRQ(ADC1_IRQn);
 }
 //-----------------------------------------------------------------------------
 void 
 focus_init(void)
 {
-	focus_pos = &adc_val[0];
-	temp = &adc_val[1];
-	vref = &adc_val[2];
+	focus_pos = &adc_good[AXIS_FOCUS];
+	temp = &adc_good[AXIS_NUM];
+	vref = &adc_good[AXIS_NUM + 1U];
 	
 	focus_state = FOCUS_STATE_NOSTART;
+	focus_faults = 0;
+	focus_recoveries = 0;
+	focus_dir = FOCUS_DIR_STOP;
+	focus_lens = -1;
+	focus_via = FOCUS_VIA_NONE;
+	focus_viaT = FOCUS_VIA_NONE;
+	focus_viaDone = 0;
+	
+	// Rate of frames at start (calibration: 1 ms frames)
+	adc_rate = FOCUS_RATE_NORMAL;
+	adc_want = FOCUS_RATE_NORMAL;
+	adc_sh = focus_sh[adc_rate];
+	adc_n = 1U << adc_sh;
+	adc_len = AXIS_NUM * adc_n + 2U;
+	adc_per[0] = focus_per[adc_rate];
+	adc_per[1] = focus_per[adc_rate];
+	focus_stamp = 0;
+	focus_frames = 0;
+	focus_mode = FOCUS_RATE_AUTO;
+	focus_arrT = 0;
 	
 	keys_init();
 	dma1_init();
@@ -304,39 +436,233 @@ focus_start(void)
 	tim2_start();
 }
 //=============================================================================
+// Keys on change only (calib.c: each frame in DMA 1 interrupt)
 void 
-focus_keysEn(void)
+focus_keysForward(void)
 {
-	// Enable EN_3
-	GPIOB->BSRR |= GPIO_BSRR_BS_12;
+	if (focus_dir == FOCUS_DIR_FORWARD)
+		return;
+	// Set MC3_N, reset MC3_P
+	BOARD_GPIO(axis_desc[AXIS_FOCUS].port)->BSRR = 
+		focus_io[FOCUS_DIR_FORWARD];
+	focus_dir = FOCUS_DIR_FORWARD;
 }
 //-----------------------------------------------------------------------------
 void 
-focus_keysDis(void)
+focus_keysBack(void)
 {
-	// Disable EN_3
-	GPIOB->BSRR |= GPIO_BSRR_BR_12;
+	if (focus_dir == FOCUS_DIR_BACK)
+		return;
+	// Reset MC3_N, set MC3_P
+	BOARD_GPIO(axis_desc[AXIS_FOCUS].port)->BSRR = focus_io[FOCUS_DIR_BACK];
+	focus_dir = FOCUS_DIR_BACK;
 }
 //-----------------------------------------------------------------------------
 void 
-focus_keysForward(void)
+focus_keysStop(void)
 {
-	// Set MC3_N, reset MC3_P
-	GPIOA->BSRR |= GPIO_BSRR_BS_0 | GPIO_BSRR_BR_1;
+	if (focus_dir == FOCUS_DIR_STOP)
+		return;
+	// Reset MC3_N, reset MC3_P
+	BOARD_GPIO(axis_desc[AXIS_FOCUS].port)->BSRR = focus_io[FOCUS_DIR_STOP];
+	focus_dir = FOCUS_DIR_STOP;
+}
+//=============================================================================
+// Stop TIM 2 and regular conversions of ADC 1 (DMA 1 gets no new request); 
+// return TIM 2 ticks after trigger of last good frame (CC2IF - trigger of 
+// lost frame, it is cleared in DMA 1 interrupt)
+static uint32_t
+focus_halt(void)
+{
+	uint32_t t;
+	
+	// Stop TIM 2 (no new triggers)
+	TIM2->CR1 &= ~TIM_CR1_CEN;
+	t = TIM2->CNT + 1U;
+	if (TIM2->SR & TIM_SR_CC2IF)
+		t += adc_per[0];
+	
+	// Stop regular conversions of ADC 1 + confirm
+	if (ADC1->CR & ADC_CR_ADSTART) {
+		ADC1->CR |= ADC_CR_ADSTP;
+		while (ADC1->CR & ADC_CR_ADSTP);
+	}
+	return t;
+}
+//-----------------------------------------------------------------------------
+// Arm DMA 1 Channel 1, ADC 1 and TIM 2 (after focus_halt(), ADC 1 is 
+// enabled); TIM 2 period from cnt (first trigger at CNT == CCR2)
+// 1. Disable DMA 1 Channel 1 + clear all flags of channel
+// 2. Reload number of data and memory address
+// 3. Clear overrun and conversion flags of ADC 1
+// 4. TIM 2 period from cnt (preloaded ARR and CCR2 are loaded by UG)
+// 5. Activate DMA 1 Channel 1, ADC 1, TIM 2
+static void
+focus_arm(uint32_t cnt)
+{
+  // 1. Disable DMA 1 Channel 1 + clear all flags of channel
+	DMA1_Channel1->CCR &= ~DMA_CCR_EN;
+	DMA1->IFCR |= DMA_IFCR_CGIF1;
+	
+  // 2. Reload number of data and memory address
+	DMA1_Channel1->CNDTR = adc_len;
+	DMA1_Channel1->CMAR = (uint32_t)adc_val;
+	
+  // 3. Clear overrun and conversion flags of ADC 1 (write 1 to clear)
+	ADC1->ISR = ADC_ISR_OVR | ADC_ISR_EOS | ADC_ISR_EOC | ADC_ISR_EOSMP;
+	
+  // 4. TIM 2 period from cnt (preloaded ARR and CCR2 are loaded by UG)
+	TIM2->EGR = TIM_EGR_UG;
+	TIM2->CNT = cnt;
+	adc_per[0] = focus_per[adc_rate] - 1U - cnt;
+	adc_per[1] = focus_per[adc_rate];
+	
+  // 5. Activate DMA 1 Channel 1, ADC 1, TIM 2
+	focus_start();
+}
+//-----------------------------------------------------------------------------
+// Rate of frames adc_want (from DMA 1 interrupt or with interrupts 
+// disabled): after frame, ADC 1 sequence is not converted
+// 1. ADC 1 sequence and number of data of DMA 1 Channel 1 (samples)
+// 2. TIM 2 period (ARR == CCR2, preloaded): no update event between writes
+// 3. Restart of TIM 2 (UG): frame in progress ends after new period
+// 4. Periods of next frames for time stamps
+static void
+focus_rate(uint32_t restart)
+{
+	uint32_t r = adc_want;
+	uint32_t per = focus_per[r];
+	uint32_t cnt;
+	
+  // 1. ADC 1 sequence and number of data of DMA 1 Channel 1 (samples)
+	if (focus_sh[r] != adc_sh) {
+		// Stop regular conversions of ADC 1 + confirm
+		ADC1->CR |= ADC_CR_ADSTP;
+		while (ADC1->CR & ADC_CR_ADSTP);
+		adc_sh = focus_sh[r];
+		adc_n = 1U << adc_sh;
+		adc1_seq();
+		DMA1_Channel1->CCR &= ~DMA_CCR_EN;
+		DMA1_Channel1->CNDTR = adc_len;
+		DMA1_Channel1->CCR |= DMA_CCR_EN;
+		adc1_start();
+	}
+	
+  // 2. TIM 2 period (ARR == CCR2, preloaded): no update event between writes
+	TIM2->CR1 |= TIM_CR1_UDIS;
+	TIM2->ARR = per - 1U;
+	TIM2->CCR2 = per - 1U;
+	TIM2->CR1 &= ~TIM_CR1_UDIS;
+	
+  // 3. Restart of TIM 2 (UG): frame in progress ends after new period
+	if (restart) {
+		cnt = TIM2->CNT;
+		TIM2->EGR = TIM_EGR_UG;
+		adc_per[0] = cnt + per;
+	}
+	
+  // 4. Periods of next frames for time stamps
+	adc_per[1] = per;
+	adc_rate = r;
 }
 //-----------------------------------------------------------------------------
+// Re-arm ADC 1, DMA 1 Channel 1 and TIM 2 in place (without reset and new 
+// calibration); next frame comes after one TIM 2 period, main loop works 
+// with last good frame (adc_good) until it; time stamp of next frame 
+// includes time of lost frame
+// 1. Stop TIM 2 and regular conversions of ADC 1
+// 2. Arm DMA 1 Channel 1, ADC 1, TIM 2 (TIM 2 period from zero)
+// 3. Disable driver if faults are repeated without good frame
+static void
+focus_recover(void)
+{
+	uint32_t t;
+	
+  // 1. Stop TIM 2 and regular conversions of ADC 1
+	t = focus_halt();
+	
+  // 2. Arm DMA 1 Channel 1, ADC 1, TIM 2 (TIM 2 period from zero)
+	focus_arm(0);
+	adc_per[0] += t;
+	
+	++focus_recoveries;
+	
+  // 3. Disable driver if faults are repeated without good frame (main loop 
+  //    enables it for next move)
+	if (++focus_faults >= FOCUS_FAULT_MAX) {
+		drive_off(DRIVE_FOCUS);
+		// Set ERR flag
+		focus_state |= FOCUS_STATE_ERR;
+	}
+}
+//=============================================================================
+// Before Stop mode (see power.c): main loop waits first frame after 
+// focus_wake() (NOSTART); ADC 1 voltage regulator, temperature sensor and 
+// internal reference are disabled (current in Stop mode)
+// 1. Stop keys (drivers: drive_sleep())
+// 2. Stop TIM 2 and regular conversions of ADC 1
+// 3. Disable ADC 1 + confirm
+// 4. Disable voltage regulator, temperature sensor and internal reference
+// 5. Disable DMA 1 Channel 1 + clear all flags of channel
+// 6. Set NOSTART flag (no frame after it)
 void 
-focus_keysBack(void)
+focus_sleep(void)
 {
-	// Reset MC3_N, set MC3_P
-	GPIOA->BSRR |= GPIO_BSRR_BR_0 | GPIO_BSRR_BS_1;
+  // 1. Stop keys (drivers: drive_sleep())
+	focus_keysStop();
+	
+  // 2. Stop TIM 2 and regular conversions of ADC 1
+	focus_halt();
+	
+  // 3. Disable ADC 1 + confirm
+	ADC1->CR |= ADC_CR_ADDIS;
+	while (ADC1->CR & ADC_CR_ADEN);
+	
+  // 4. Disable voltage regulator (ADVREGEN: 01 -> 00 -> 10), temperature 
+  //    sensor and internal reference
+	ADC1->CR &= ~ADC_CR_ADVREGEN;
+	ADC1->CR |= ADC_CR_ADVREGEN_1;
+	ADC1_COMMON->CCR &= ~(ADC_CCR_TSEN | ADC_CCR_VREFEN);
+	
+  // 5. Disable DMA 1 Channel 1 + clear all flags of channel
+	DMA1_Channel1->CCR &= ~DMA_CCR_EN;
+	DMA1->IFCR |= DMA_IFCR_CGIF1;
+	
+  // 6. Set NOSTART flag (no frame after it)
+	focus_state |= FOCUS_STATE_NOSTART;
 }
 //-----------------------------------------------------------------------------
+// After Stop mode (clock is restored): without new calibration (factor of 
+// start) and first TIM 2 trigger after one tick => first frame after one 
+// ADC sequence clears NOSTART
+// 1. Enable voltage regulator (ADVREGEN: 10 -> 00 -> 01), temperature 
+//    sensor and internal reference + wait FOCUS_STUP_US
+// 2. Enable ADC 1 + confirm
+// 3. Calibration factor (ADEN = 1, ADSTART = 0)
+// 4. Arm DMA 1 Channel 1, ADC 1, TIM 2
 void 
-focus_keysStop(void)
+focus_wake(void)
 {
-	// Reset MC3_N, reset MC3_P
-	GPIOA->BSRR |= GPIO_BSRR_BR_0 | GPIO_BSRR_BR_1;
+	uint32_t t0;
+	
+  // 1. Enable voltage regulator, temperature sensor and internal reference
+	ADC1->CR &= ~ADC_CR_ADVREGEN;
+	ADC1->CR |= ADC_CR_ADVREGEN_0;
+	ADC1_COMMON->CCR |= ADC_CCR_TSEN | ADC_CCR_VREFEN;
+	t0 = irq_cycles();
+	while (irq_cycles() - t0 < 
+		FOCUS_STUP_US * (clock_getHclk() / 1000000U));
+	
+  // 2. Enable ADC 1 + confirm (ADRDY of last enable is cleared)
+	ADC1->ISR = ADC_ISR_ADRDY;
+	ADC1->CR |= ADC_CR_ADEN;
+	while (!(ADC1->ISR & ADC_ISR_ADRDY));
+	
+  // 3. Calibration factor (ADEN = 1, ADSTART = 0)
+	ADC1->CALFACT = adc_calfact;
+	
+  // 4. Arm DMA 1 Channel 1, ADC 1, TIM 2
+	focus_arm(TIM2->CCR2 - 1U);
 }
 //=============================================================================
 uint32_t 
@@ -344,10 +670,280 @@ focus_getState(void)
 {
 	return focus_state;
 }
+//-----------------------------------------------------------------------------
+uint32_t 
+focus_getRecoveries(void)
+{
+	return focus_recoveries;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+focus_getDir(void)
+{
+	return focus_dir;
+}
+//-----------------------------------------------------------------------------
+// Last good frame: mean of samples of axis a (ADC counts, see axis.c)
+uint32_t 
+focus_getAxis(uint32_t a)
+{
+	return adc_good[a];
+}
+//=============================================================================
+// Main loop: on/off control with hysteresis in ADC counts (see 
+// FOCUS_BAND_x and calibration); return 1 if focus is stopped on target
+// 1. Lens position: follows potentiometer with dead band of gear lash
+// 2. New target: unidirectional approach is not done
+// 3. On/off control of lens position to target (or past it); move against
+//    approach direction goes config.focus_over past target first (once 
+//    for each target: no loop if coast runs over target)
+uint32_t 
+focus_control(uint32_t pos, uint32_t target)
+{
+	int32_t err, h = (int32_t)(config.focus_lash / 2U);
+	int32_t start = (int32_t)config.focus_band_start;
+	int32_t stop = (int32_t)config.focus_band_stop;
+	uint32_t dir, over = config.focus_over;
+	
+  // 1. Lens position
+	if (focus_lens < 0)
+		focus_lens = (int32_t)pos;
+	else if ((int32_t)pos - focus_lens > h)
+		focus_lens = (int32_t)pos - h;
+	else if (focus_lens - (int32_t)pos > h)
+		focus_lens = (int32_t)pos + h;
+	
+  // 2. New target: unidirectional approach is not done
+	if (target != focus_viaT) {
+		focus_viaT = target;
+		focus_via = FOCUS_VIA_NONE;
+		focus_viaDone = 0;
+	}
+	
+  // 3. On/off control of lens position to target (or past it)
+	err = focus_lens - (int32_t)(focus_via != FOCUS_VIA_NONE ? 
+		focus_via : target);
+	if (focus_dir == FOCUS_DIR_FORWARD) {
+		if (err >= -stop)
+			focus_keysStop();
+		return 0;
+	}
+	if (focus_dir == FOCUS_DIR_BACK) {
+		if (err <= stop)
+			focus_keysStop();
+		return 0;
+	}
+	if (focus_via != FOCUS_VIA_NONE) {
+		// Stopped past target: approach from configured side
+		focus_via = FOCUS_VIA_NONE;
+		focus_viaDone = 1U;
+		err = focus_lens - (int32_t)target;
+	}
+	if (err > start)
+		dir = FOCUS_DIR_BACK;
+	else if (err < -start)
+		dir = FOCUS_DIR_FORWARD;
+	else
+		return 1;
+	// Driver enabled for lead time before move (see drive.c)
+	if (!drive_start(DRIVE_FOCUS))
+		return 0;
+	if (config.focus_approach != FOCUS_APPROACH_BOTH && 
+		dir != config.focus_approach && !focus_viaDone)
+		focus_via = focus_clamp(dir == FOCUS_DIR_BACK ? 
+			(target > over ? target - over : 0) : target + over);
+	if (dir == FOCUS_DIR_BACK)
+		focus_keysBack();
+	else
+		focus_keysForward();
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// From CAN_SRV_FOCUS_LASH (saved in flash): approach - FOCUS_APPROACH_BOTH
+// or FOCUS_DIR_x, over - counts past target (more than start band), 
+// lash - counts (up to FOCUS_LASH_MAX)
+int32_t 
+focus_setLash(uint32_t approach, uint32_t over, uint32_t lash)
+{
+	if (approach > FOCUS_DIR_BACK || lash > FOCUS_LASH_MAX || 
+		over <= config.focus_band_start)
+		return -1;
+	config.focus_approach = approach;
+	config.focus_over = over;
+	config.focus_lash = lash;
+	config_request();
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Estimate of lens position (ADC counts, see focus_control())
+uint32_t 
+focus_getLens(void)
+{
+	return focus_lens < 0 ? 0 : (uint32_t)focus_lens;
+}
+//-----------------------------------------------------------------------------
+// From CAN_SRV_POLE_FOCUS (saved in flash): off - focus offset of pole 
+// (ADC counts, signed)
+int32_t 
+focus_setPoleOffset(uint32_t pole, int32_t off)
+{
+	if (pole >= CONFIG_POLE_NUM || off > FOCUS_POLE_MAX || 
+		off < -FOCUS_POLE_MAX)
+		return -1;
+	config.focus_pole[pole] = off;
+	config_request();
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Focus target for move of pole from -> to (main loop, see cmd_get()): 
+// target + difference of offsets, clamped to range
+uint32_t 
+focus_forPole(uint32_t target, uint32_t from, uint32_t to)
+{
+	int32_t t;
+	
+	if (from >= CONFIG_POLE_NUM || to >= CONFIG_POLE_NUM || from == to)
+		return target;
+	t = (int32_t)target + config.focus_pole[to] - config.focus_pole[from];
+	return focus_clamp(t < 0 ? 0 : (uint32_t)t);
+}
+//-----------------------------------------------------------------------------
+// Main loop: rate of frames from state of focus (FOCUS_RATE_AUTO) or fixed 
+// rate (focus_setRate()); DMA 1 interrupt sets new rate after next frame, 
+// from PARK (long period) TIM 2 restarts here
+// 1. Rate: calibration - NORMAL (1 ms frames), fixed rate (fixed PARK 
+//    while not moving only: 200 ms frames overshoot), move (of any 
+//    axis) - FAST, NORMAL after stop (coast, mean of samples against 
+//    noise) up to FOCUS_PARK_MS on target, PARK after
+// 2. Restart from PARK if ADC 1 sequence is not converted (else next frame)
+void 
+focus_adapt(uint32_t arrived)
+{
+	uint32_t r, t = focus_stamp;
+	uint32_t moving = focus_dir != FOCUS_DIR_STOP || axis_isMoving();
+	
+	if (focus_state & (FOCUS_STATE_NOSTART | FOCUS_STATE_ERR))
+		return;
+	
+  // 1. Rate
+	if (!arrived || moving)
+		focus_arrT = t;
+	if (focus_state & FOCUS_STATE_CALIB)
+		r = FOCUS_RATE_NORMAL;
+	else if (focus_mode < FOCUS_RATE_NUM && 
+		!(moving && focus_mode == FOCUS_RATE_PARK))
+		r = focus_mode;
+	else if (moving)
+		r = FOCUS_RATE_FAST;
+	else if (t - focus_arrT < FOCUS_PARK_MS * 1000U)
+		r = FOCUS_RATE_NORMAL;
+	else
+		r = FOCUS_RATE_PARK;
+	if (r == adc_want)
+		return;
+	adc_want = r;
+	
+  // 2. Restart from PARK if ADC 1 sequence is not converted
+	if (adc_rate != FOCUS_RATE_PARK)
+		return;
+	__disable_irq();
+	if (adc_want != adc_rate && TIM2->CNT > FOCUS_SEQ_US)
+		focus_rate(1);
+	__enable_irq();
+}
+//-----------------------------------------------------------------------------
+// FOCUS_RATE_x (fixed) or FOCUS_RATE_AUTO; runtime only (not stored)
+int32_t 
+focus_setRate(uint32_t mode)
+{
+	if (mode >= FOCUS_RATE_NUM && mode != FOCUS_RATE_AUTO)
+		return -1;
+	focus_mode = mode;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+focus_getRate(void)
+{
+	return adc_rate;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+focus_getMode(void)
+{
+	return focus_mode;
+}
+//-----------------------------------------------------------------------------
+// End of last frame (us, see notes)
+uint32_t 
+focus_getStamp(void)
+{
+	return focus_stamp;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+focus_getFrames(void)
+{
+	return focus_frames;
+}
+//-----------------------------------------------------------------------------
+// Legacy step (0 ... FOCUS_MAX) -> ADC counts (center of step)
+uint32_t 
+focus_fromStep(uint32_t s)
+{
+	return config.focus_min + (2U * s + 1U) * 
+		(config.focus_max - config.focus_min) / (2U * (FOCUS_MAX + 1U));
+}
+//-----------------------------------------------------------------------------
+// ADC counts -> legacy step (0 ... FOCUS_MAX)
+uint32_t 
+focus_toStep(uint32_t p)
+{
+	uint32_t s;
+	
+	if (p <= config.focus_min)
+		return 0;
+	s = (p - config.focus_min) * (FOCUS_MAX + 1U) / 
+		(config.focus_max - config.focus_min);
+	return s > FOCUS_MAX ? FOCUS_MAX : s;
+}
+//-----------------------------------------------------------------------------
+// ADC counts -> ADC counts in calibrated range
+uint32_t 
+focus_clamp(uint32_t p)
+{
+	if (p < config.focus_min)
+		return config.focus_min;
+	if (p > config.focus_max)
+		return config.focus_max;
+	return p;
+}
+//=============================================================================
+void 
+focus_calibEn(void)
+{
+	focus_state |= FOCUS_STATE_CALIB;
+}
+//-----------------------------------------------------------------------------
+void 
+focus_calibDis(void)
+{
+	focus_state &= ~FOCUS_STATE_CALIB;
+}
 //=============================================================================
 void 
 ADC1_IRQHandler(void)
 {
+	// Entry time
+	uint32_t t0 = irq_cycles();
+	
+	if (ADC1->ISR & ADC_ISR_OVR) {
+		// Exclude the cause of the interrupt (write 1 to clear)
+		ADC1->ISR = ADC_ISR_OVR;
+		// Frame in DMA buffer is shifted => re-arm ADC 1, DMA 1, TIM 2
+		focus_recover();
+	}
+	
 	/*
 	if (ADC1->ISR & ADC_ISR_AWD1) {
 		// Clear flag
@@ -365,6 +961,8 @@ ADC1_IRQHandler(void)
 	__nop();
 	__nop();
 	*/
+	
+	irq_add(IRQ_SRC_ADC1, t0, IRQ_NOLAT);
 }
 //=============================================================================
 void 
@@ -372,34 +970,64 @@ DMA1_Channel1_IRQHandler(void)
 {
 	// Start flag
 	static uint32_t first_time;
+	uint32_t per, a;
+	// Entry time and latency from TIM 2 trigger (CNT == 0 after trigger; 
+	// ADC conversion time is included)
+	uint32_t t0 = irq_cycles();
+	uint32_t lat = TIM2->CNT * (TIM2->PSC + 1U);
 	
-	if (DMA1->ISR & DMA_ISR_TCIF1) { 
-		// Exclude the cause of the interrupt
+	if (DMA1->ISR & DMA_ISR_TEIF1) {
+		// Exclude the cause of the interrupt (channel disabled by hardware)
+		DMA1->IFCR |= DMA_IFCR_CTEIF1;
+		// Frame is not valid => re-arm ADC 1, DMA 1, TIM 2
+		focus_recover();
+	} else if (DMA1->ISR & DMA_ISR_TCIF1) { 
+		// Exclude the cause of the interrupt; trigger of frame (CC2IF, see 
+		// focus_halt())
 		DMA1->IFCR |= DMA_IFCR_CTCIF1;
-		// Enable keys
-		focus_keysEn();
+		TIM2->SR = ~TIM_SR_CC2IF;
+		
+		// Latch good frame for main loop (mean of potentiometer samples of 
+		// each axis)
+		for (a = 0; a < AXIS_NUM; ++a)
+			adc_good[a] = (uint32_t)dsp_mean(&adc_val[a * adc_n], adc_sh);
+		adc_good[AXIS_NUM] = (uint16_t)adc_val[AXIS_NUM * adc_n];
+		adc_good[AXIS_NUM + 1U] = (uint16_t)adc_val[AXIS_NUM * adc_n + 1U];
 		
+		// Time stamp (period of this frame), period of frame in progress
+		per = adc_per[0];
+		focus_stamp += per;
+		adc_per[0] = adc_per[1];
+		++focus_frames;
+		
+		// Clear faults and ERR flag (driver: drive.c, not each frame)
+		focus_faults = 0;
+		focus_state &= ~FOCUS_STATE_ERR;
+		
+		// Clear NOSTART flag (for main loop; also after Stop mode)
+		focus_state &= ~FOCUS_STATE_NOSTART;
 		if (!first_time) {
-			// Clear NOSTART flag (for main loop)
-			focus_state &= ~FOCUS_STATE_NOSTART;
-			// Set focus_target as focus_pos
-			focus_target = 
-				(*focus_pos & FOCUS_MASK) / FOCUS_DEVIDER;
+			// Set focus_target as focus_pos (warm boot: stored target, see
+			// main_init(); command before first frame is kept)
+			if (boot_getFocus() == BOOT_FOCUS_NONE && !cmd_getApplied())
+				focus_target = *focus_pos & FOCUS_MASK;
 			// Set first_time flag
 			first_time = 1;
 		}
+		
+		// Calibration (if run): 1 ms frames (see focus_adapt())
+		if (per == FOCUS_MS_US)
+			calib_tick(*focus_pos & FOCUS_MASK);
+		
+		// Flight recorder, position streaming
+		trace_sample();
+		stream_sample();
+		
+		// New rate: from PARK at once (else next frame after 200 ms)
+		if (adc_want != adc_rate)
+			focus_rate(adc_rate == FOCUS_RATE_PARK);
 	}
 	
-	if (DMA1->ISR & DMA_ISR_TCIF1) {
-		// Exclude the cause of the interrupt
-		DMA1->IFCR |= DMA_IFCR_CTEIF1;
-		// Disable keys
-		focus_keysDis();
-		// Set ERR flag
-		focus_state |= FOCUS_STATE_ERR;
-	} else {
-		// Clear ERR flag
-		focus_state &= ~FOCUS_STATE_ERR;
-	}
+	irq_add(IRQ_SRC_DMA1, t0, lat);
 }
 //=============================================================================
@@ -7,18 +7,83 @@
 #define FOCUS_STATE_OK        0x00U
 #define FOCUS_STATE_NOSTART   0x04U
 #define FOCUS_STATE_ERR       0x08U
+#define FOCUS_STATE_CALIB     0x20U
+//-----------------------------------------------------------------------------
+#define FOCUS_DIR_STOP     0U
+#define FOCUS_DIR_FORWARD  1U
+#define FOCUS_DIR_BACK     2U
 //-----------------------------------------------------------------------------
 #define FOCUS_DEVIDER    100U
 #define FOCUS_MASK       0x00000FFFU
 //-----------------------------------------------------------------------------
+// Targets are in ADC counts (0 ... FOCUS_MASK); step of legacy command 
+// (0 ... FOCUS_MAX) is the center of 1 / (FOCUS_MAX + 1) of calibrated 
+// range (FOCUS_DEVIDER counts without calibration)
+//-----------------------------------------------------------------------------
+// Hysteresis of on/off control (ADC counts) without calibration: move 
+// starts if |error| is greater than START, stops if |error| is not greater 
+// than STOP (motor coasts after stop)
+#define FOCUS_BAND_START  12U
+#define FOCUS_BAND_STOP   4U
+//-----------------------------------------------------------------------------
+// Gear lash between potentiometer (motor side) and lens: config.focus_lash
+// (ADC counts, measured at lens); last move to target in one direction 
+// (config.focus_approach - FOCUS_DIR_x) or in both, move against it goes 
+// config.focus_over past target first (see focus_control())
+#define FOCUS_APPROACH_BOTH  0U
+#define FOCUS_LASH_MAX       255U
+#define FOCUS_OVER_DEF       (3U * FOCUS_BAND_START)
+//-----------------------------------------------------------------------------
+// Focus offset of each pole (config.focus_pole[], ADC counts): command with
+// pole and without focus moves focus by difference of offsets of new and 
+// old pole (see focus_forPole())
+#define FOCUS_POLE_MAX  ((int32_t)FOCUS_MASK)
+//-----------------------------------------------------------------------------
+// Faults (DMA transfer error or ADC overrun) without good frame before 
+// driver is disabled (up to next good frame)
+#define FOCUS_FAULT_MAX  3U
+//-----------------------------------------------------------------------------
+// Wake-up (see focus_wake()): T ADCVREG_STUP and t START (datasheet)
+#define FOCUS_STUP_US  10U
+//-----------------------------------------------------------------------------
+// Rate of frames: TIM 2 period and potentiometer samples in frame (see 
+// focus_adapt()); FOCUS_RATE_AUTO - from state of focus
+#define FOCUS_RATE_FAST    0U     // 4 KHz x 1 sample: move
+#define FOCUS_RATE_NORMAL  1U     // 1 KHz x 2 samples: stop, calibration
+#define FOCUS_RATE_PARK    2U     // 5 Hz x 4 samples: parked (fixed: 
+                                  // FAST while moving)
+#define FOCUS_RATE_NUM     3U
+#define FOCUS_RATE_AUTO    0xFEU
+#define FOCUS_SAMPLES_MAX  4U
+#define FOCUS_PARK_MS      1000U  // on target before PARK
+//-----------------------------------------------------------------------------
 void focus_init(void);
 void focus_start(void);
-void focus_keysEn(void);
-void focus_keysDis(void);
+void focus_sleep(void);
+void focus_wake(void);
 void focus_keysForward(void);
 void focus_keysBack(void);
 void focus_keysStop(void);
 uint32_t focus_getState(void);
+uint32_t focus_getRecoveries(void);
+uint32_t focus_getDir(void);
+uint32_t focus_getAxis(uint32_t a);
+uint32_t focus_control(uint32_t pos, uint32_t target);
+int32_t focus_setLash(uint32_t approach, uint32_t over, uint32_t lash);
+uint32_t focus_getLens(void);
+int32_t focus_setPoleOffset(uint32_t pole, int32_t off);
+uint32_t focus_forPole(uint32_t target, uint32_t from, uint32_t to);
+uint32_t focus_fromStep(uint32_t s);
+uint32_t focus_toStep(uint32_t p);
+uint32_t focus_clamp(uint32_t p);
+void focus_calibEn(void);
+void focus_calibDis(void);
+void focus_adapt(uint32_t arrived);
+int32_t focus_setRate(uint32_t mode);
+uint32_t focus_getRate(void);
+uint32_t focus_getMode(void);
+uint32_t focus_getStamp(void);
+uint32_t focus_getFrames(void);
 //=============================================================================
 #endif // FOCUS_H
 //=============================================================================
@@ -0,0 +1,1353 @@
+//=============================================================================
+/*
+* Host benchmark of firmware with simulated peripherals (see sim.c)
+* usage:
+ - bench [-s scenario] [-b baseline] [-w baseline]
+   metrics (JSON) to stdout; -b - compare with baseline (exit code 1 on
+   regression); -w - write baseline from this run (with margins)
+* scenarios:
+ - step - one move of focus (high resolution command)
+ - sweep - steps over full range
+ - pole_cycle - pole 1, 2, 0 with state requests (CAN_ID_CTRL) each 10 ms
+ - command_storm - commands back to back on bus with state requests; last
+   command must be reached
+ - adc_noise - noise burst on potentiometer after arrival
+ - adc_fault - DMA transfer error and ADC overrun during move
+ - can_errors - state requests with TX errors, arbitration loss and
+   bus-off (CAN_RETRY_SW), then errors with CAN_RETRY_HW
+ - can_autobaud - network at 500 kbit/s, node in CAN_RATE_AUTO (search
+   from 1 Mbit/s), then state requests and move
+ - idle_wake - quiet period 500 ms (CAN_SRV_POWER): Stop mode, wake-up by
+   state requests, move, Stop mode again, wake-up
+ - rate_fast, rate_1k, rate_park - step with fixed rate of ADC frames 
+   (CAN_SRV_FOCUS_RATE), "step" is with automatic rate; fixed PARK is 
+   FAST while moving (PARK at once after stop)
+ - events - moves of focus and pole without state requests (end of move 
+   by CAN_ID_EVENT), commands with focus out of range and invalid pole
+ - axes - focus, zoom and iris move at once (CAN_SRV_AXIS), then back
+ - bus_load - other node sends 2000 frames/s (ID 0x050) with state 
+   requests and moves
+ - lash_off, lash_comp, lash_uni - plant with gear lash of 40 counts, 
+   moves to same target from both sides: no compensation, lash stored 
+   (CAN_SRV_FOCUS_LASH), lash and approach from below (FOCUS_DIR_FORWARD)
+ - warm_boot - moves of focus and pole, software reset, then moves again;
+   warm_moving - reset during pole move (pole is re-homed)
+ - scene_seq, scene_pole - changes of pole with focus of each pole: focus
+   command after end of pole move (host), focus offsets of poles 
+   (CAN_SRV_POLE_FOCUS) with pole command only
+ - calib_cmd - calibration of focus (CAN_SRV_CALIB_START) with state 
+   requests: command while it runs is rejected, command after its end 
+   is reached (no segment of settle metrics while calibration)
+ - boot_cmd - focus command at power-on, before first frame of focus 
+   encoder: move starts with first frame, end of move is answered
+ - stream, stream_ctrl - log of focus trajectory at 1 KHz during moves: 
+   position streaming (CAN_SRV_STREAM, decoded by decode.c), state 
+   requests each 1 ms (one sample per answer)
+* metrics:
+ - settle_ms - from change of target up to last sample out of start band
+   or moving (last change of scenario and changes longer than
+   BENCH_SEGMENT_MS); unsettled - changes without settle
+ - overshoot - counts after target in direction of move
+ - settle and overshoot are of lens (same as motor without gear lash);
+   lens_err - max error of lens at end of segment (as settle_ms), 
+   lens_spread - max - min of this error (repeatability)
+ - boot_ms - reset-to-operational: from (last) reset up to first pass of 
+   main loop with focus and pole ready; warm - warm boot (boot.c)
+ - scene_ms - max time from pole command of scene change up to pole 
+   stopped on new pole and lens in start band of focus of scene
+ - log_sps - logged samples per s (stream frames or state answers) from 
+   first log frame; log_bus_pm - bus load of log frames (0.1 %, state: 
+   requests and answers); log_sps_pct - samples per s per 1 % of bus; 
+   stream_gaps - gaps of sequence; stream_err - max decoded sample 
+   against plant (motor) at time of its tick
+ - en_focus_pm, en_pole_pm, en_axis_pm - on time of driver (EN_x) of 
+   focus, max of pole motors, max of axes 1 ... (0.1 % of run time, 
+   drive.c); drv_focus_pm - drive time of focus bridge
+ - restarts - starts of motor after first stop on target
+ - isr_x_cycles - max duration of handler, dma1_jitter_cycles (irq.c)
+ - loop_per_ms - passes of main loop per ms
+ - frames_dropped - lost by overrun of FIFO 0
+ - pulse_over_us - longest pole pulse over TIM 6 period
+ - ctrl_reply_us - max time from state request up to end of answer
+ - recoveries - re-arms of ADC / DMA / TIM 2 (focus.c)
+ - replies_lost - state requests without answer
+ - boff_recovery_us - max time of bus-off (can.c)
+ - baud_ms - time of rate search (CAN_RATE_AUTO) up to normal mode
+ - wake_us - max time from SOF of wake-up frame up to ready (power.c)
+ - idle_ua - average supply current of MCU (estimate: SIM_RUN_UA,
+   SIM_STOP_UA in Stop mode)
+ - isr_us_per_s - time in interrupt handlers (CPU load), frames_per_s - 
+   ADC frames (focus.c)
+ - stamp_err_us - max error of time stamp of frame (focus_getStamp()) 
+   against TIM 2 trigger of frame (sim_getFrame()) after first frame 
+   (and after wake-up)
+ - ack_us - max time from command up to end of its acknowledge or 
+   rejection (CAN_ID_EVENT); acks_lost - applied commands without 
+   acknowledge
+ - done_missing - moves of acknowledged commands without end (not 
+   superseded), ends without move and ends at other target than of 
+   command; done_early - end of focus move 
+   while focus is out of start band or moving (not if newer command is 
+   received before end is sent); rejects - rejection events
+ - axis_settle_ms - as settle_ms for zoom and iris (CAN_SRV_AXIS targets);
+   axisN_cycles - max cost of controller of axis N per pass of main loop
+   (axis.c)
+ - bus_load_pm - bus load of last window of node (CAN_SRV_CAN_LOAD, 
+   0.1 %), bus_load_err_pm - against frames on bus in last second of 
+   scenario (sim_getBus()); fifo_max - max fill of FIFO 0 and 1; 
+   cmd_lat_us - max command latency (CAN RX interrupt up to main loop), 
+   tx_delay_us - max TX delay of threads 0, 1 (can.c)
+* notes:
+ - each scenario runs in own process (firmware from reset); warm reset 
+   (ACT_RESET) goes on in standby process forked before main_init() (see 
+   bench_standby()): metrics are of last run after reset
+ - baseline: one metric per line - "scenario.metric": {"max" | "min": x}
+ - exit code 2 if scenario fails or its results do not fit in 
+   BENCH_RESULT_MAX (no output, baseline is not written)
+*/
+//=============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+//-----------------------------------------------------------------------------
+#include "sim.h"
+#include "plant.h"
+#include "main.h"
+#include "focus.h"
+#include "can.h"
+#include "irq.h"
+#include "cmd.h"
+#include "config.h"
+#include "power.h"
+#include "axis.h"
+#include "pole.h"
+#include "boot.h"
+#include "stream.h"
+#include "decode.h"
+#include "drive.h"
+//=============================================================================
+#define BENCH_SEGMENT_MS   200U   // shorter changes of target: not settled
+#define BENCH_MARGIN       0.10   // of baseline (relative)
+#define BENCH_RESULT_MAX   2048U
+#define BENCH_NAME_MAX     96U
+#define BENCH_KEEP_FOCUS   0xFFFFU
+#define BENCH_KEEP_POLE    0xFFU
+#define BENCH_NONE         0xFFFFFFFFU
+#define BENCH_POS_MAX      16384U  // ms of plant positions (stream_err)
+//-----------------------------------------------------------------------------
+#define ACT_END    0U
+#define ACT_FOCUS  1U  // a - focus (ADC counts)
+#define ACT_POLE   2U  // a - pole
+#define ACT_CTRL   3U  // a - period of state requests (ms), 0 - off
+#define ACT_NOISE  4U  // a - noise amplitude (counts)
+#define ACT_STORM  5U  // a - commands, b - state request each b commands
+#define ACT_FAULT  6U  // a - SIM_FAULT_x
+#define ACT_SRV    7U  // a - low word of service request (CAN_ID_SRV),
+                       // b - high word
+#define ACT_CANERR 8U  // next TX attempts: a - with error, b - arb. lost
+#define ACT_BAUD   9U  // a - rate of network (bit/s), b - 1: node to
+                       // CAN_RATE_AUTO (as by installation tool)
+#define ACT_AXIS   10U // a - axis (AXIS_x), b - target (ADC counts)
+#define ACT_BUS    11U // a - period of frames of other node (us), 0 - off;
+                       // b - ID
+#define ACT_RESET  12U // a - reset flags (RCC CSR: cause of reset)
+#define ACT_SCENE  13U // scene change: a - pole, b - focus of scene; pole 
+                       // command only (focus from CAN_SRV_POLE_FOCUS)
+#define ACT_SEQ    14U // as ACT_SCENE, focus command after end of pole 
+                       // move (CAN_EV_POLE_DONE)
+//=============================================================================
+struct act {
+	uint32_t t_ms;
+	uint32_t op;
+	uint32_t a;
+	uint32_t b;
+};
+
+struct scenario {
+	const char *name;
+	double pos;        // start position of focus
+	uint32_t end_ms;
+	struct act act[16];
+	double lash;       // gear lash of focus (plant)
+};
+
+// dir: 1 - lower is better (baseline "max"), -1 - higher is better
+// ("min"), 0 - information only
+struct metric {
+	const char *name;
+	int32_t dir;
+	double slack;      // absolute margin of baseline
+};
+
+struct result {
+	char name[BENCH_NAME_MAX];
+	double v;
+};
+//-----------------------------------------------------------------------------
+// Focus (start position of scenario), zoom, iris
+static const struct plant_param plant[PLANT_MOTORS] = {
+	{ .pos = 0, .speed = 1.0, .tau_drive = 20.0, .tau_coast = 3.0,
+		.stop_lo = 40.0, .stop_hi = 4050.0, .noise = 1.5, .seed = 12345U },
+	{ .pos = 800, .speed = 2.0, .tau_drive = 10.0, .tau_coast = 2.0,
+		.stop_lo = 40.0, .stop_hi = 4050.0, .noise = 1.5, .seed = 23456U },
+	{ .pos = 3000, .speed = 2.0, .tau_drive = 10.0, .tau_coast = 2.0,
+		.stop_lo = 40.0, .stop_hi = 4050.0, .noise = 1.5, .seed = 34567U },
+};
+
+static const struct scenario scenarios[] = {
+	{ "step", 1000, 3000, {
+		{ 50, ACT_FOCUS, 3000, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "sweep", 200, 6200, {
+		{ 50, ACT_FOCUS, 650, 0 },
+		{ 750, ACT_FOCUS, 1100, 0 },
+		{ 1450, ACT_FOCUS, 1550, 0 },
+		{ 2150, ACT_FOCUS, 2000, 0 },
+		{ 2850, ACT_FOCUS, 2450, 0 },
+		{ 3550, ACT_FOCUS, 2900, 0 },
+		{ 4250, ACT_FOCUS, 3350, 0 },
+		{ 4950, ACT_FOCUS, 3800, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "pole_cycle", 2000, 4800, {
+		{ 1100, ACT_CTRL, 10, 0 },
+		{ 1100, ACT_POLE, POLE_1, 0 },
+		{ 2300, ACT_POLE, POLE_2, 0 },
+		{ 3500, ACT_POLE, POLE_0, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "command_storm", 2000, 1500, {
+		{ 100, ACT_STORM, 400, 16 },
+		{ 100, ACT_FOCUS, 2500, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "adc_noise", 1500, 3000, {
+		{ 50, ACT_FOCUS, 2500, 0 },
+		{ 1500, ACT_NOISE, 20, 0 },
+		{ 2500, ACT_NOISE, 2, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "adc_fault", 1000, 2500, {
+		{ 50, ACT_FOCUS, 2500, 0 },
+		{ 500, ACT_FAULT, SIM_FAULT_DMA_TE, 0 },
+		{ 900, ACT_FAULT, SIM_FAULT_ADC_OVR, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "can_errors", 2000, 2000, {
+		{ 100, ACT_CTRL, 10, 0 },
+		{ 300, ACT_CANERR, 3, 0 },
+		{ 600, ACT_CANERR, 0, 6 },
+		{ 900, ACT_CANERR, 40, 0 },
+		{ 1400, ACT_SRV, CAN_SRV_CAN_RETRY << CAN_SRV_OP_POS |
+			CAN_RETRY_HW << CAN_SRV_ARG1_POS, 0 },
+		{ 1500, ACT_CANERR, 10, 2 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "can_autobaud", 2000, 1500, {
+		{ 0, ACT_BAUD, 500000, 1 },
+		{ 0, ACT_CTRL, 10, 0 },
+		{ 500, ACT_FOCUS, 2600, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "idle_wake", 2000, 5000, {
+		{ 0, ACT_SRV, CAN_SRV_POWER << CAN_SRV_OP_POS |
+			5U << CAN_SRV_ARG1_POS, 0 },
+		{ 2500, ACT_CTRL, 10, 0 },
+		{ 2700, ACT_CTRL, 0, 0 },
+		{ 2800, ACT_FOCUS, 2600, 0 },
+		{ 4600, ACT_CTRL, 10, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "rate_fast", 1000, 3000, {
+		{ 0, ACT_SRV, CAN_SRV_FOCUS_RATE << CAN_SRV_OP_POS |
+			FOCUS_RATE_FAST << CAN_SRV_ARG1_POS, 0 },
+		{ 50, ACT_FOCUS, 3000, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "rate_1k", 1000, 3000, {
+		{ 0, ACT_SRV, CAN_SRV_FOCUS_RATE << CAN_SRV_OP_POS |
+			FOCUS_RATE_NORMAL << CAN_SRV_ARG1_POS, 0 },
+		{ 50, ACT_FOCUS, 3000, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "rate_park", 1000, 3000, {
+		{ 0, ACT_SRV, CAN_SRV_FOCUS_RATE << CAN_SRV_OP_POS |
+			FOCUS_RATE_PARK << CAN_SRV_ARG1_POS, 0 },
+		{ 50, ACT_FOCUS, 3000, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "events", 1000, 4000, {
+		{ 50, ACT_FOCUS, 3000, 0 },
+		{ 60, ACT_FOCUS, FOCUS_MASK + 1U, 0 },
+		{ 70, ACT_POLE, POLE_2 + 1U, 0 },
+		{ 1100, ACT_POLE, POLE_1, 0 },
+		{ 2300, ACT_FOCUS, 1500, 0 },
+		{ 2300, ACT_POLE, POLE_0, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "axes", 1000, 4000, {
+		{ 50, ACT_FOCUS, 2500, 0 },
+		{ 50, ACT_AXIS, AXIS_ZOOM, 2500 },
+		{ 50, ACT_AXIS, AXIS_IRIS, 1200 },
+		{ 2000, ACT_FOCUS, 1500, 0 },
+		{ 2000, ACT_AXIS, AXIS_ZOOM, 600 },
+		{ 2000, ACT_AXIS, AXIS_IRIS, 3400 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "bus_load", 1000, 3000, {
+		{ 0, ACT_BUS, 500, 0x050 },
+		{ 0, ACT_CTRL, 10, 0 },
+		{ 50, ACT_FOCUS, 3000, 0 },
+		{ 1500, ACT_FOCUS, 1500, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "lash_off", 1000, 10500, {
+		{ 50, ACT_FOCUS, 2000, 0 },
+		{ 1500, ACT_FOCUS, 3000, 0 },
+		{ 3000, ACT_FOCUS, 2000, 0 },
+		{ 4500, ACT_FOCUS, 1200, 0 },
+		{ 6000, ACT_FOCUS, 2000, 0 },
+		{ 7500, ACT_FOCUS, 2800, 0 },
+		{ 9000, ACT_FOCUS, 2000, 0 },
+		{ 0, ACT_END, 0, 0 } }, 40.0 },
+	{ "lash_comp", 1000, 10500, {
+		{ 0, ACT_SRV, CAN_SRV_FOCUS_LASH << CAN_SRV_OP_POS |
+			FOCUS_APPROACH_BOTH << CAN_SRV_ARG1_POS |
+			FOCUS_OVER_DEF << CAN_SRV_ARG2_POS, 40 },
+		{ 50, ACT_FOCUS, 2000, 0 },
+		{ 1500, ACT_FOCUS, 3000, 0 },
+		{ 3000, ACT_FOCUS, 2000, 0 },
+		{ 4500, ACT_FOCUS, 1200, 0 },
+		{ 6000, ACT_FOCUS, 2000, 0 },
+		{ 7500, ACT_FOCUS, 2800, 0 },
+		{ 9000, ACT_FOCUS, 2000, 0 },
+		{ 0, ACT_END, 0, 0 } }, 40.0 },
+	{ "lash_uni", 1000, 10500, {
+		{ 0, ACT_SRV, CAN_SRV_FOCUS_LASH << CAN_SRV_OP_POS |
+			FOCUS_DIR_FORWARD << CAN_SRV_ARG1_POS |
+			FOCUS_OVER_DEF << CAN_SRV_ARG2_POS, 40 },
+		{ 50, ACT_FOCUS, 2000, 0 },
+		{ 1500, ACT_FOCUS, 3000, 0 },
+		{ 3000, ACT_FOCUS, 2000, 0 },
+		{ 4500, ACT_FOCUS, 1200, 0 },
+		{ 6000, ACT_FOCUS, 2000, 0 },
+		{ 7500, ACT_FOCUS, 2800, 0 },
+		{ 9000, ACT_FOCUS, 2000, 0 },
+		{ 0, ACT_END, 0, 0 } }, 40.0 },
+	{ "warm_boot", 1000, 5000, {
+		{ 50, ACT_FOCUS, 2500, 0 },
+		{ 1200, ACT_POLE, POLE_2, 0 },
+		{ 3000, ACT_RESET, RCC_CSR_SFTRSTF | RCC_CSR_PINRSTF, 0 },
+		{ 3500, ACT_FOCUS, 1500, 0 },
+		{ 3500, ACT_POLE, POLE_1, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "warm_moving", 1000, 4500, {
+		{ 50, ACT_FOCUS, 2500, 0 },
+		{ 1200, ACT_POLE, POLE_1, 0 },
+		{ 1500, ACT_RESET, RCC_CSR_PINRSTF, 0 },
+		{ 3000, ACT_FOCUS, 1500, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "stream", 500, 6000, {
+		{ 0, ACT_SRV, CAN_SRV_STREAM << CAN_SRV_OP_POS |
+			4U << CAN_SRV_ARG1_POS | AXIS_FOCUS << CAN_SRV_ARG2_POS, 0 },
+		{ 50, ACT_FOCUS, 3000, 0 },
+		{ 3000, ACT_FOCUS, 1000, 0 },
+		{ 5200, ACT_FOCUS, 1500, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "stream_ctrl", 500, 6000, {
+		{ 0, ACT_CTRL, 1, 0 },
+		{ 50, ACT_FOCUS, 3000, 0 },
+		{ 3000, ACT_FOCUS, 1000, 0 },
+		{ 5200, ACT_FOCUS, 1500, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "scene_seq", 500, 11000, {
+		{ 50, ACT_FOCUS, 2000, 0 },
+		{ 2000, ACT_SEQ, POLE_1, 2300 },
+		{ 5000, ACT_SEQ, POLE_2, 1700 },
+		{ 8000, ACT_SEQ, POLE_0, 2000 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "scene_pole", 500, 11000, {
+		{ 0, ACT_SRV, CAN_SRV_POLE_FOCUS << CAN_SRV_OP_POS |
+			POLE_1 << CAN_SRV_ARG1_POS | 1U << CAN_SRV_ARG2_POS, 300 },
+		{ 0, ACT_SRV, CAN_SRV_POLE_FOCUS << CAN_SRV_OP_POS |
+			POLE_2 << CAN_SRV_ARG1_POS | 1U << CAN_SRV_ARG2_POS, 
+			(uint16_t)-300 },
+		{ 50, ACT_FOCUS, 2000, 0 },
+		{ 2000, ACT_SCENE, POLE_1, 2300 },
+		{ 5000, ACT_SCENE, POLE_2, 1700 },
+		{ 8000, ACT_SCENE, POLE_0, 2000 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "calib_cmd", 2000, 5000, {
+		{ 0, ACT_CTRL, 10, 0 },
+		{ 50, ACT_SRV, CAN_SRV_CALIB_START << CAN_SRV_OP_POS, 0 },
+		{ 500, ACT_FOCUS, 1500, 0 },
+		{ 3000, ACT_FOCUS, 2500, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+	{ "boot_cmd", 2000, 2000, {
+		{ 0, ACT_FOCUS, 2500, 0 },
+		{ 0, ACT_END, 0, 0 } } },
+};
+
+static const struct metric metrics[] = {
+	{ "settle_ms", 1, 20 },
+	{ "overshoot", 1, 2 },
+	{ "restarts", 1, 1 },
+	{ "unsettled", 1, 0 },
+	{ "isr_dma1_cycles", 1, 16 },
+	{ "isr_can_cycles", 1, 16 },
+	{ "isr_tim6_cycles", 1, 16 },
+	{ "dma1_jitter_cycles", 1, 16 },
+	{ "loop_per_ms", -1, 0 },
+	{ "frames_dropped", 1, 0 },
+	{ "pulse_over_us", 1, 5 },
+	{ "ctrl_reply_us", 1, 10 },
+	{ "recoveries", 1, 0 },
+	{ "replies_lost", 1, 0 },
+	{ "boff_recovery_us", 1, 20 },
+	{ "baud_ms", 1, 20 },
+	{ "wake_us", 1, 20 },
+	{ "idle_ua", 1, 50 },
+	{ "isr_us_per_s", 1, 20 },
+	{ "frames_per_s", 0, 0 },
+	{ "stamp_err_us", 1, 20 },
+	{ "cmd_applied", 0, 0 },
+	{ "cmd_superseded", 0, 0 },
+	{ "ack_us", 1, 20 },
+	{ "acks_lost", 1, 0 },
+	{ "done_missing", 1, 0 },
+	{ "done_early", 1, 0 },
+	{ "rejects", 0, 0 },
+	{ "axis_settle_ms", 1, 20 },
+	{ "axis0_cycles", 1, 16 },
+	{ "axis1_cycles", 1, 16 },
+	{ "axis2_cycles", 1, 16 },
+	{ "bus_load_pm", 0, 0 },
+	{ "bus_load_err_pm", 1, 10 },
+	{ "fifo_max", 1, 0 },
+	{ "cmd_lat_us", 1, 20 },
+	{ "tx_delay_us", 1, 20 },
+	{ "lens_err", 1, 1 },
+	{ "lens_spread", 1, 2 },
+	{ "boot_ms", 1, 5 },
+	{ "warm", 0, 0 },
+	{ "scene_ms", 1, 20 },
+	{ "log_sps", -1, 0 },
+	{ "log_bus_pm", 1, 2 },
+	{ "log_sps_pct", -1, 0 },
+	{ "stream_gaps", 1, 0 },
+	{ "stream_err", 1, 2 },
+	{ "en_focus_pm", 1, 20 },
+	{ "en_pole_pm", 1, 20 },
+	{ "en_axis_pm", 1, 20 },
+	{ "drv_focus_pm", 0, 0 },
+};
+
+#define SCENARIO_NUM  (sizeof(scenarios) / sizeof(scenarios[0]))
+#define METRIC_NUM    (sizeof(metrics) / sizeof(metrics[0]))
+//-----------------------------------------------------------------------------
+static struct result results[BENCH_RESULT_MAX];
+static uint32_t result_num;
+//=============================================================================
+// Scenario (in child process)
+static uint32_t seq;
+static uint32_t rnd = 2024U;
+static uint32_t ctrl_ms;
+static uint64_t ctrl_t;
+static uint64_t baud_t;     // start of rate search (0 - none)
+static double baud_ms;
+static uint64_t wake_t;     // last wake-up (SOF) with ready
+static uint64_t wake_max;   // cycles
+static uint32_t stamp_frames;  // frames at last check
+static uint64_t stamp_t;       // reference: trigger, time stamp
+static uint32_t stamp_us;
+static uint64_t stamp_stop;    // time in Stop mode at reference
+static double stamp_err;
+static uint32_t ev_num;        // checked TX frames
+static uint32_t ev_focus;      // acknowledged move: 0 - none, seq ID + 1
+static uint32_t ev_pole;
+static uint32_t ev_acks;
+static uint32_t ev_rejects;
+static uint32_t ev_bad;        // end without move or at other target
+static uint32_t ev_early;
+static uint64_t ev_ack_max;    // cycles
+static uint64_t ax_t[PLANT_MOTORS];    // last target of axis (0 - none)
+static uint64_t ax_bad[PLANT_MOTORS];  // last sample out of band or moving
+static uint32_t bus_us;        // frames of other node (ACT_BUS)
+static uint32_t bus_id;
+static uint64_t bus_t;
+static uint64_t bus_t0;        // start of last second (0 - before)
+static uint64_t bus_c0;        // sim_getBus() at bus_t0
+static double boot_ms;         // 0 - not yet operational
+static uint64_t scene_t;       // last scene change (0 - none)
+static uint64_t scene_bad;     // last sample not in scene
+static uint32_t scene_pole;
+static uint32_t scene_focus;
+static uint32_t scene_wait;    // focus command after end of pole move
+static double scene_max;       // ms
+static uint64_t strm_t0;       // start of stream (0 - none)
+static double pos_ms[BENCH_POS_MAX];   // plant (motor) each ms
+// Run of scenario (kept over warm reset)
+static struct {
+	uint32_t act;      // next action
+	uint64_t end;
+	uint64_t boot;     // last reset
+	uint64_t sample;
+} run;
+static int standby_fd = -1;    // to standby process (see bench_standby())
+static pid_t standby_pid;
+//-----------------------------------------------------------------------------
+// Segment of constant focus target
+static struct {
+	uint32_t target;
+	uint64_t t;          // start
+	uint64_t bad;        // last sample out of band or moving
+	uint64_t ok;         // first sample in band and stopped (0 - none)
+	int32_t dir;         // direction to target
+	uint32_t moving;
+	double overshoot;
+	double settle_max;
+	double overshoot_max;
+	uint32_t restarts;
+	uint32_t unsettled;
+	double lens;         // error of lens at last sample
+	double err_max;      // of lens at end of segment
+	double err_lo;
+	double err_hi;
+	uint32_t errs;       // segments in err_x
+} seg;
+//-----------------------------------------------------------------------------
+static void 
+bench_cmd(uint32_t focus, uint32_t pole)
+{
+	seq = (seq + 1U) & 0xFFU;
+	sim_canRx(CAN_ID_CMD, 8,
+		pole << CAN_POLE_POS | seq << CAN_SEQ_POS |
+		CAN_VER_HIRES << CAN_VER_POS,
+		focus << CAN_FOCUS_HR_POS);
+}
+//-----------------------------------------------------------------------------
+// State of bench kept over warm reset (wr - 1 to standby, 0 from parent)
+static int32_t 
+bench_keep(int fd, uint32_t wr)
+{
+	if (sim_pipe(fd, &run, sizeof(run), wr) ||
+		sim_pipe(fd, &seq, sizeof(seq), wr) ||
+		sim_pipe(fd, &rnd, sizeof(rnd), wr) ||
+		sim_pipe(fd, &ctrl_ms, sizeof(ctrl_ms), wr) ||
+		sim_pipe(fd, &ctrl_t, sizeof(ctrl_t), wr) ||
+		sim_pipe(fd, &bus_us, sizeof(bus_us), wr) ||
+		sim_pipe(fd, &bus_id, sizeof(bus_id), wr) ||
+		sim_pipe(fd, &bus_t, sizeof(bus_t), wr))
+		return -1;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Warm reset: simulator, plant and run go to standby process, this one 
+// ends with it (metrics are of standby)
+static void 
+bench_reset(uint32_t csr)
+{
+	int st;
+
+	run.boot = sim_now();
+	if (standby_fd < 0 ||
+		sim_pipe(standby_fd, &csr, sizeof(csr), 1U) ||
+		sim_save(standby_fd) || plant_save(standby_fd) ||
+		bench_keep(standby_fd, 1U)) {
+		fprintf(stderr, "bench: reset is not handed over\n");
+		_exit(2);
+	}
+	close(standby_fd);
+	if (waitpid(standby_pid, &st, 0) < 0 || !WIFEXITED(st))
+		_exit(2);
+	_exit(WEXITSTATUS(st));
+}
+//-----------------------------------------------------------------------------
+// End of scene change (next one or end of scenario)
+static void 
+scene_close(void)
+{
+	double ms;
+
+	if (!scene_t)
+		return;
+	ms = (double)(scene_bad + SIM_CYCLES_MS - scene_t) / SIM_CYCLES_MS;
+	if (ms > scene_max)
+		scene_max = ms;
+	scene_t = 0;
+}
+//-----------------------------------------------------------------------------
+// Each ms: pole and lens against scene
+static void 
+scene_sample(void)
+{
+	if (scene_t && (pole_isMoving() || pole_getPole() != scene_pole ||
+		fabs(plant_getLens() - scene_focus) > config.focus_band_start ||
+		focus_getDir() != FOCUS_DIR_STOP || fabs(plant_getSpeed()) >= 0.01))
+		scene_bad = sim_now();
+}
+//-----------------------------------------------------------------------------
+static void 
+bench_act(const struct act *a)
+{
+	uint32_t i;
+
+	switch (a->op) {
+	case ACT_FOCUS:
+		bench_cmd(a->a, BENCH_KEEP_POLE);
+		break;
+	case ACT_POLE:
+		bench_cmd(BENCH_KEEP_FOCUS, a->a);
+		break;
+	case ACT_CTRL:
+		ctrl_ms = a->a;
+		ctrl_t = sim_now();
+		break;
+	case ACT_NOISE:
+		plant_setNoise(a->a);
+		break;
+	case ACT_STORM:
+		for (i = 0; i < a->a; ++i) {
+			rnd = rnd * 1664525U + 1013904223U;
+			bench_cmd(500U + (rnd >> 8) % 3000U, BENCH_KEEP_POLE);
+			if (a->b && i % a->b == 0)
+				sim_canRx(CAN_ID_CTRL, 0, 0, 0);
+		}
+		break;
+	case ACT_FAULT:
+		sim_fault(a->a);
+		break;
+	case ACT_SRV:
+		sim_canRx(CAN_ID_SRV, 8, a->a, a->b);
+		break;
+	case ACT_CANERR:
+		sim_canError(a->a, a->b);
+		break;
+	case ACT_BAUD:
+		sim_canRate(a->a);
+		if (a->b) {
+			can_setRate(CAN_RATE_AUTO);
+			baud_t = sim_now();
+		}
+		break;
+	case ACT_AXIS:
+		sim_canRx(CAN_ID_SRV, 8, CAN_SRV_AXIS << CAN_SRV_OP_POS |
+			a->a << CAN_SRV_ARG1_POS | 1U << CAN_SRV_ARG2_POS, a->b);
+		if (a->a < PLANT_MOTORS)
+			ax_t[a->a] = ax_bad[a->a] = sim_now();
+		break;
+	case ACT_BUS:
+		bus_us = a->a;
+		bus_id = a->b;
+		bus_t = sim_now();
+		break;
+	case ACT_RESET:
+		bench_reset(a->a);
+		break;
+	case ACT_SCENE:
+	case ACT_SEQ:
+		scene_close();
+		scene_t = scene_bad = sim_now();
+		scene_pole = a->a;
+		scene_focus = a->b;
+		scene_wait = a->op == ACT_SEQ;
+		bench_cmd(BENCH_KEEP_FOCUS, a->a);
+		break;
+	default:
+		break;
+	}
+}
+//-----------------------------------------------------------------------------
+static void 
+seg_close(uint64_t t, uint32_t last)
+{
+	double settle;
+
+	if (!last && t - seg.t < (uint64_t)BENCH_SEGMENT_MS * SIM_CYCLES_MS)
+		return;
+	if (!seg.ok || seg.bad >= t - SIM_CYCLES_MS) {
+		++seg.unsettled;
+		settle = (double)(t - seg.t) / SIM_CYCLES_MS;
+	} else if (seg.bad < seg.t) {
+		settle = 0;
+	} else {
+		settle = (double)(seg.bad + SIM_CYCLES_MS - seg.t) / SIM_CYCLES_MS;
+	}
+	if (settle > seg.settle_max)
+		seg.settle_max = settle;
+	if (seg.overshoot > seg.overshoot_max)
+		seg.overshoot_max = seg.overshoot;
+	if (!seg.target)
+		return;
+	if (fabs(seg.lens) > seg.err_max)
+		seg.err_max = fabs(seg.lens);
+	if (!seg.errs++ || seg.lens < seg.err_lo)
+		seg.err_lo = seg.lens;
+	if (seg.errs == 1U || seg.lens > seg.err_hi)
+		seg.err_hi = seg.lens;
+}
+//-----------------------------------------------------------------------------
+// Each ms: settle, overshoot and restarts of focus
+static void 
+seg_sample(void)
+{
+	uint64_t t = sim_now();
+	uint32_t target = focus_target;
+	double pos = plant_getLens();
+	double over;
+	uint32_t moving = focus_getDir() != FOCUS_DIR_STOP;
+	uint32_t ok = fabs(pos - target) <= config.focus_band_start &&
+		!moving && fabs(plant_getSpeed()) < 0.01;
+
+	// Calibration moves focus (calib.c): new segment after its end
+	if (focus_getState() & FOCUS_STATE_CALIB) {
+		seg.target = 0;
+		return;
+	}
+	if (target != seg.target) {
+		seg_close(t, 0);
+		seg.target = target;
+		seg.t = t;
+		seg.ok = 0;
+		seg.dir = pos < target ? 1 : -1;
+		seg.overshoot = 0;
+	}
+	if (!ok)
+		seg.bad = t;
+	else if (!seg.ok)
+		seg.ok = t;
+	if (moving && !seg.moving && seg.ok)
+		++seg.restarts;
+	seg.moving = moving;
+
+	over = (pos - target) * seg.dir;
+	if (over > seg.overshoot)
+		seg.overshoot = over;
+	seg.lens = pos - target;
+}
+//-----------------------------------------------------------------------------
+// Each ms: zoom and iris against their targets
+static void 
+ax_sample(void)
+{
+	uint32_t a;
+
+	for (a = 1U; a < AXIS_NUM && a < PLANT_MOTORS; ++a)
+		if (ax_t[a] && (fabs(plant_getAxis(a) - axis_getTarget(a)) >
+			axis_desc[a].band_start || axis_getDir(a) != FOCUS_DIR_STOP))
+			ax_bad[a] = sim_now();
+}
+//-----------------------------------------------------------------------------
+// Longest settle of zoom and iris (ms)
+static double 
+ax_settle(void)
+{
+	double max = 0, settle;
+	uint32_t a;
+
+	for (a = 1U; a < PLANT_MOTORS; ++a) {
+		settle = (double)(ax_bad[a] - ax_t[a]) / SIM_CYCLES_MS;
+		if (settle > max)
+			max = settle;
+	}
+	return max;
+}
+//-----------------------------------------------------------------------------
+// Max time from state request up to end of answer (cycles); answer is for
+// last request before it (requests without answer are skipped)
+static uint64_t 
+ctrl_reply(void)
+{
+	uint64_t max = 0;
+	uint32_t i, j, req = BENCH_NONE;
+	const struct sim_frame *tx;
+
+	for (i = 0, j = 0; i < sim_txNum(); ++i) {
+		tx = sim_tx(i);
+		if (tx->id != CAN_ID_CTRL)
+			continue;
+		for (; j < sim_rxNum() && sim_rx(j)->t <= tx->t; ++j)
+			if (sim_rx(j)->id == CAN_ID_CTRL && !sim_rx(j)->drop)
+				req = j;
+		if (req == BENCH_NONE)
+			continue;
+		if (tx->t - sim_rx(req)->t > max)
+			max = tx->t - sim_rx(req)->t;
+		req = BENCH_NONE;
+	}
+	return max;
+}
+//-----------------------------------------------------------------------------
+// State requests (stored in FIFO) without answer
+static uint32_t 
+ctrl_lost(void)
+{
+	uint32_t i, req = 0, ans = 0;
+
+	for (i = 0; i < sim_rxNum(); ++i)
+		if (sim_rx(i)->id == CAN_ID_CTRL && !sim_rx(i)->drop)
+			++req;
+	for (i = 0; i < sim_txNum(); ++i)
+		if (sim_tx(i)->id == CAN_ID_CTRL)
+			++ans;
+	return req > ans ? req - ans : 0;
+}
+//-----------------------------------------------------------------------------
+// After each pass of main loop: time stamp of new frame against time of 
+// its trigger (new reference after Stop mode)
+static void 
+stamp_check(void)
+{
+	uint32_t n = focus_getFrames();
+	double err;
+
+	if (n == stamp_frames)
+		return;
+	stamp_frames = n;
+	if (!stamp_t || sim_getStop() != stamp_stop) {
+		stamp_t = sim_getFrame();
+		stamp_us = focus_getStamp();
+		stamp_stop = sim_getStop();
+		return;
+	}
+	err = fabs((double)(sim_getFrame() - stamp_t) / SIM_CYCLES_US -
+		(double)(focus_getStamp() - stamp_us));
+	if (err > stamp_err)
+		stamp_err = err;
+}
+//-----------------------------------------------------------------------------
+// Command with sequence ID (latest one) received up to event t
+static const struct sim_frame * 
+ev_command(uint32_t id, uint64_t t)
+{
+	uint32_t i = sim_rxNum();
+	const struct sim_frame *rx;
+
+	while (i--) {
+		rx = sim_rx(i);
+		if (rx->id == CAN_ID_CMD && rx->t <= t &&
+			(rx->l & CAN_SEQ_MSK) >> CAN_SEQ_POS == id)
+			return rx;
+	}
+	return NULL;
+}
+//-----------------------------------------------------------------------------
+// Time from command with sequence ID up to event t
+static uint64_t 
+ev_latency(uint32_t id, uint64_t t)
+{
+	const struct sim_frame *rx = ev_command(id, t);
+
+	return rx ? t - rx->t : 0;
+}
+//-----------------------------------------------------------------------------
+// Command after one with sequence ID received up to event t (end of move 
+// is queued before, plant follows newer command)
+static uint32_t 
+ev_newer(uint32_t id, uint64_t t)
+{
+	uint32_t i = sim_rxNum();
+	const struct sim_frame *rx;
+
+	while (i--) {
+		rx = sim_rx(i);
+		if (rx->id == CAN_ID_CMD && rx->t <= t)
+			return (rx->l & CAN_SEQ_MSK) >> CAN_SEQ_POS != id;
+	}
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// After each pass of main loop: new events against plant (see metrics)
+static void 
+ev_check(void)
+{
+	const struct sim_frame *tx, *rx;
+	uint32_t type, id, a1, focus;
+	uint64_t lat;
+
+	for (; ev_num < sim_txNum(); ++ev_num) {
+		tx = sim_tx(ev_num);
+		if (tx->id != CAN_ID_EVENT)
+			continue;
+		type = tx->l >> CAN_EV_TYPE_POS & 0xFFU;
+		id = tx->l >> CAN_EV_SEQ_POS & 0xFFU;
+		a1 = tx->l >> CAN_EV_ARG1_POS & 0xFFU;
+		switch (type) {
+		case CAN_EV_ACK:
+		case CAN_EV_REJECT:
+			lat = ev_latency(id, tx->t);
+			if (lat > ev_ack_max)
+				ev_ack_max = lat;
+			if (type == CAN_EV_REJECT) {
+				++ev_rejects;
+				break;
+			}
+			++ev_acks;
+			if (a1 & CAN_EV_FOCUS)
+				ev_focus = id + 1U;
+			if (a1 & CAN_EV_POLE)
+				ev_pole = id + 1U;
+			break;
+		case CAN_EV_FOCUS_DONE:
+			rx = ev_command(id, tx->t);
+			focus = rx ? rx->h >> CAN_FOCUS_HR_POS & CAN_FOCUS_HR_MSK :
+				CAN_FOCUS_HR_KEEP;
+			if (ev_focus != id + 1U)
+				++ev_bad;
+			else if (!a1 && focus != CAN_FOCUS_HR_KEEP &&
+				tx->h >> CAN_STATE_TARGET_HR_POS != focus)
+				++ev_bad;
+			ev_focus = 0;
+			if (!a1 && !ev_newer(id, tx->t) &&
+				(fabs(plant_getLens() -
+				(tx->h >> CAN_STATE_TARGET_HR_POS)) >
+				config.focus_band_start ||
+				focus_getDir() != FOCUS_DIR_STOP))
+				++ev_early;
+			break;
+		case CAN_EV_POLE_DONE:
+			if (ev_pole != id + 1U)
+				++ev_bad;
+			ev_pole = 0;
+			if (scene_wait) {
+				bench_cmd(scene_focus, BENCH_KEEP_POLE);
+				scene_wait = 0;
+			}
+			break;
+		default:
+			++ev_bad;
+			break;
+		}
+	}
+}
+//-----------------------------------------------------------------------------
+// Trajectory logs on bus: stream frames (decoded) or state requests and 
+// answers; decoded samples against plant at time of tick
+static void 
+log_stat(FILE *out)
+{
+	const struct sim_frame *f;
+	struct decode d;
+	uint16_t v[DECODE_SAMPLES_MAX];
+	uint64_t t0 = 0, bus = 0, t_us, ms;
+	uint32_t i, k, n = 0;
+	int32_t r;
+	double s, err = 0;
+
+	decode_init(&d);
+	for (i = 0; i < sim_txNum() + sim_rxNum(); ++i) {
+		f = i < sim_txNum() ? sim_tx(i) : sim_rx(i - sim_txNum());
+		if (f->id == CAN_ID_STREAM && i < sim_txNum()) {
+			r = decode_frame(&d, f->l, f->h, v, &t_us);
+			for (k = 0; r > 0 && k < (uint32_t)r; ++k) {
+				ms = (strm_t0 + ((t_us + (k + 1U) * d.per_us) * 
+					SIM_CYCLES_US)) / SIM_CYCLES_MS;
+				if (ms < BENCH_POS_MAX && fabs(v[k] - pos_ms[ms]) > err)
+					err = fabs(v[k] - pos_ms[ms]);
+			}
+			n += r > 0 ? (uint32_t)r : 0;
+		} else if (f->id == CAN_ID_CTRL) {
+			n += i < sim_txNum();
+		} else {
+			continue;
+		}
+		bus += sim_canFrame(f->dlc);
+		if (!t0 || f->t < t0)
+			t0 = f->t;
+	}
+	s = t0 && sim_now() > t0 ? (double)(sim_now() - t0) / SIM_HCLK_HZ : 0;
+	fprintf(out, "log_sps %.1f\n", s ? n / s : 0);
+	fprintf(out, "log_bus_pm %.1f\n", 
+		s ? (double)bus * 1000.0 / (double)(sim_now() - t0) : 0);
+	fprintf(out, "log_sps_pct %.1f\n", 
+		bus ? n / s / ((double)bus * 100.0 / (double)(sim_now() - t0)) : 0);
+	fprintf(out, "stream_gaps %u\n", d.gaps + d.bad);
+	fprintf(out, "stream_err %.1f\n", err);
+}
+//-----------------------------------------------------------------------------
+// Before main_init(): process for next warm reset (ACT_RESET) of scenario;
+// standby waits for state of parent (ends without it) and returns as 
+// firmware after reset
+static void 
+bench_standby(const struct scenario *s)
+{
+	const struct act *a;
+	uint32_t csr;
+	int fd[2];
+
+	for (;;) {
+		for (a = &s->act[run.act]; a->op != ACT_END && a->op != ACT_RESET;
+			++a)
+			;
+		if (a->op == ACT_END)
+			return;
+		if (pipe(fd) || (standby_pid = fork()) < 0) {
+			perror("bench: standby");
+			_exit(2);
+		}
+		if (standby_pid) {
+			close(fd[0]);
+			standby_fd = fd[1];
+			return;
+		}
+		close(fd[1]);
+		if (sim_pipe(fd[0], &csr, sizeof(csr), 0) || sim_load(fd[0], csr) ||
+			plant_load(fd[0]) || bench_keep(fd[0], 0))
+			_exit(0);
+		close(fd[0]);
+	}
+}
+//-----------------------------------------------------------------------------
+static void 
+bench_run(const struct scenario *s, FILE *out)
+{
+	struct plant_param p[PLANT_MOTORS];
+	uint64_t t, pulse;
+	uint64_t loops = 0;
+	uint32_t l, h, ld, m;
+	double ms, stop, bus;
+
+	memcpy(p, plant, sizeof(p));
+	p[0].pos = s->pos;
+	p[0].lash = s->lash;
+	sim_init();
+	plant_init(p, PLANT_MOTORS);
+	run.end = sim_now() + (uint64_t)s->end_ms * SIM_CYCLES_MS;
+	run.sample = sim_now();
+	bench_standby(s);
+	main_init();
+
+	memset(&seg, 0, sizeof(seg));
+	seg.t = run.boot;
+	wake_t = SIM_NEVER;
+	while ((t = sim_now()) < run.end) {
+		while (s->act[run.act].op != ACT_END &&
+			t >= (uint64_t)s->act[run.act].t_ms * SIM_CYCLES_MS)
+			bench_act(&s->act[run.act++]);
+		if (ctrl_ms && t >= ctrl_t) {
+			sim_canRx(CAN_ID_CTRL, 0, 0, 0);
+			ctrl_t += (uint64_t)ctrl_ms * SIM_CYCLES_MS;
+		}
+		if (bus_us && t >= bus_t) {
+			sim_canRx(bus_id, 8, (uint32_t)(t / SIM_CYCLES_US), 0);
+			bus_t += (uint64_t)bus_us * SIM_CYCLES_US;
+		}
+		if (!bus_t0 && t + 1000U * SIM_CYCLES_MS >= run.end) {
+			bus_t0 = t;
+			bus_c0 = sim_getBus();
+		}
+
+		main_loop();
+		++loops;
+		sim_idle(SIM_LOOP_CYCLES);
+		stamp_check();
+		ev_check();
+		if (!strm_t0 && stream_isOn())
+			strm_t0 = sim_now();
+		if (!boot_ms && focus_getState() == FOCUS_STATE_OK &&
+			pole_getState() == POLE_STATE_OK)
+			boot_ms = (double)(sim_now() - run.boot) / SIM_CYCLES_MS;
+
+		if (sim_now() >= run.sample) {
+			seg_sample();
+			ax_sample();
+			scene_sample();
+			if (sim_now() / SIM_CYCLES_MS < BENCH_POS_MAX)
+				pos_ms[sim_now() / SIM_CYCLES_MS] = plant_getPos();
+			run.sample += SIM_CYCLES_MS;
+		}
+		if (baud_t && can_getRate() != CAN_RATE_NONE) {
+			baud_ms = (double)(sim_now() - baud_t) / SIM_CYCLES_MS;
+			baud_t = 0;
+		}
+		if (sim_getWake() != wake_t &&
+			power_getState() == POWER_STATE_RUN) {
+			wake_t = sim_getWake();
+			if (sim_now() - wake_t > wake_max)
+				wake_max = sim_now() - wake_t;
+		}
+	}
+	seg_close(sim_now(), 1);
+	scene_close();
+
+	ms = (double)(sim_now() - run.boot) / SIM_CYCLES_MS;
+	pulse = plant_getPulseMax();
+	pulse = pulse > (uint64_t)(TIM6->ARR + 1U) * (TIM6->PSC + 1U) ?
+		pulse - (uint64_t)(TIM6->ARR + 1U) * (TIM6->PSC + 1U) : 0;
+
+	fprintf(out, "settle_ms %.1f\n", seg.settle_max);
+	fprintf(out, "overshoot %.1f\n", seg.overshoot_max);
+	fprintf(out, "restarts %u\n", seg.restarts);
+	fprintf(out, "unsettled %u\n", seg.unsettled);
+	fprintf(out, "isr_dma1_cycles %u\n", irq_getDuration(IRQ_SRC_DMA1));
+	fprintf(out, "isr_can_cycles %u\n", irq_getDuration(IRQ_SRC_CAN_RX0));
+	fprintf(out, "isr_tim6_cycles %u\n", irq_getDuration(IRQ_SRC_TIM6));
+	fprintf(out, "dma1_jitter_cycles %u\n", irq_getJitter(IRQ_SRC_DMA1));
+	fprintf(out, "loop_per_ms %.1f\n", loops / ms);
+	fprintf(out, "frames_dropped %u\n", sim_getDropped());
+	fprintf(out, "pulse_over_us %.1f\n", (double)pulse / SIM_CYCLES_US);
+	fprintf(out, "ctrl_reply_us %.1f\n",
+		(double)ctrl_reply() / SIM_CYCLES_US);
+	fprintf(out, "recoveries %u\n", focus_getRecoveries());
+	fprintf(out, "replies_lost %u\n", ctrl_lost());
+	can_getStat(2, &l, &h);
+	fprintf(out, "boff_recovery_us %.1f\n", (double)h / SIM_CYCLES_US);
+	fprintf(out, "baud_ms %.1f\n", baud_t ? ms : baud_ms);
+	fprintf(out, "wake_us %.1f\n", (double)wake_max / SIM_CYCLES_US);
+	stop = (double)sim_getStop() / SIM_CYCLES_MS;
+	fprintf(out, "idle_ua %.1f\n",
+		(SIM_RUN_UA * (ms - stop) + SIM_STOP_UA * stop) / ms);
+	fprintf(out, "isr_us_per_s %.1f\n",
+		(double)sim_getIsr() / SIM_CYCLES_US / (ms / 1000.0));
+	fprintf(out, "frames_per_s %.1f\n", focus_getFrames() / (ms / 1000.0));
+	fprintf(out, "stamp_err_us %.1f\n", stamp_err);
+	fprintf(out, "cmd_applied %u\n", cmd_getApplied());
+	fprintf(out, "cmd_superseded %u\n", cmd_getSuperseded());
+	fprintf(out, "ack_us %.1f\n", (double)ev_ack_max / SIM_CYCLES_US);
+	fprintf(out, "acks_lost %u\n", cmd_getApplied() > ev_acks ?
+		cmd_getApplied() - ev_acks : 0);
+	fprintf(out, "done_missing %u\n",
+		(ev_focus != 0) + (ev_pole != 0) + ev_bad);
+	fprintf(out, "done_early %u\n", ev_early);
+	fprintf(out, "rejects %u\n", ev_rejects);
+	fprintf(out, "axis_settle_ms %.1f\n", ax_settle());
+	for (l = 0; l < PLANT_MOTORS; ++l)
+		fprintf(out, "axis%u_cycles %u\n", l, axis_getCycles(l));
+	can_getLoad(0, &l, &h);
+	ld = h & 0xFFFFU;
+	bus = (double)(sim_getBus() - bus_c0) * 1000.0 /
+		(double)(sim_now() - bus_t0);
+	fprintf(out, "bus_load_pm %u\n", ld);
+	fprintf(out, "bus_load_err_pm %.1f\n", fabs(ld - bus));
+	l = l >> CAN_SRV_ARG2_POS & 0xFFU;
+	fprintf(out, "fifo_max %u\n", (l & 0xFU) > l >> 4 ? l & 0xFU : l >> 4);
+	can_getLoad(3, &l, &h);
+	fprintf(out, "cmd_lat_us %u\n", l >> CAN_SRV_ARG2_POS & 0xFFFFU);
+	fprintf(out, "tx_delay_us %u\n", (h & 0xFFFFU) > h >> 16 ?
+		h & 0xFFFFU : h >> 16);
+	fprintf(out, "lens_err %.1f\n", seg.err_max);
+	fprintf(out, "lens_spread %.1f\n", seg.err_hi - seg.err_lo);
+	fprintf(out, "boot_ms %.1f\n", boot_ms ? boot_ms : ms);
+	fprintf(out, "warm %u\n", boot_isWarm());
+	fprintf(out, "scene_ms %.1f\n", scene_max);
+	log_stat(out);
+	drive_getStat(DRIVE_FOCUS, &l, &h);
+	fprintf(out, "en_focus_pm %u\n", h & 0xFFFFU);
+	fprintf(out, "drv_focus_pm %u\n", h >> 16);
+	drive_getStat(DRIVE_POLE_1, &l, &h);
+	ld = h & 0xFFFFU;
+	drive_getStat(DRIVE_POLE_2, &l, &h);
+	fprintf(out, "en_pole_pm %u\n", ld > (h & 0xFFFFU) ? ld : h & 0xFFFFU);
+	for (ld = 0, m = DRIVE_AXIS; m < DRIVE_NUM; ++m) {
+		drive_getStat(m, &l, &h);
+		if ((h & 0xFFFFU) > ld)
+			ld = h & 0xFFFFU;
+	}
+	fprintf(out, "en_axis_pm %u\n", ld);
+}
+//=============================================================================
+// Parent process: run scenario in child (all in parallel)
+static int32_t 
+bench_fork(const struct scenario *s, pid_t *pid)
+{
+	int fd[2];
+	FILE *out;
+
+	if (pipe(fd))
+		return -1;
+	*pid = fork();
+	if (*pid < 0)
+		return -1;
+	if (*pid == 0) {
+		close(fd[0]);
+		out = fdopen(fd[1], "w");
+		bench_run(s, out);
+		fclose(out);
+		_exit(0);
+	}
+	close(fd[1]);
+	return fd[0];
+}
+//-----------------------------------------------------------------------------
+// Read "metric value" lines of child; -1 if child failed or table of 
+// results is full (truncated baseline)
+static int32_t 
+bench_collect(const struct scenario *s, int fd, pid_t pid)
+{
+	FILE *in = fdopen(fd, "r");
+	char name[BENCH_NAME_MAX];
+	double v;
+	uint32_t over = 0;
+	int st;
+
+	while (fscanf(in, "%63s %lf", name, &v) == 2) {
+		// Table is full: rest is read (child exits), scenario fails
+		if (result_num >= BENCH_RESULT_MAX) {
+			++over;
+			continue;
+		}
+		snprintf(results[result_num].name, BENCH_NAME_MAX, "%s.%.*s",
+			s->name, BENCH_NAME_MAX / 2, name);
+		results[result_num++].v = v;
+	}
+	fclose(in);
+	if (over)
+		fprintf(stderr, "%s: %u results over BENCH_RESULT_MAX (%u)\n",
+			s->name, over, BENCH_RESULT_MAX);
+	if (waitpid(pid, &st, 0) < 0 || !WIFEXITED(st) || WEXITSTATUS(st) ||
+		over)
+		return -1;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+static const struct metric * 
+bench_metric(const char *name)
+{
+	const char *m = strchr(name, '.');
+	uint32_t i;
+
+	for (i = 0; m && i < METRIC_NUM; ++i)
+		if (!strcmp(m + 1, metrics[i].name))
+			return &metrics[i];
+	return 0;
+}
+//-----------------------------------------------------------------------------
+static void 
+bench_json(void)
+{
+	uint32_t i;
+	const char *dot;
+	int len, prev = 0;
+
+	printf("{\n");
+	for (i = 0; i < result_num; ++i) {
+		dot = strchr(results[i].name, '.');
+		len = (int)(dot - results[i].name);
+		if (i == 0 || strncmp(results[i].name, results[i - 1U].name,
+			len + 1)) {
+			if (i)
+				printf("\n  },\n");
+			printf("  \"%.*s\": {\n", len, results[i].name);
+			prev = 0;
+		}
+		printf("%s    \"%s\": %.1f", prev ? ",\n" : "", dot + 1,
+			results[i].v);
+		prev = 1;
+	}
+	printf("%s}\n", result_num ? "\n  }\n" : "");
+}
+//-----------------------------------------------------------------------------
+static int32_t 
+bench_write(const char *path)
+{
+	FILE *f = fopen(path, "w");
+	const struct metric *m;
+	uint32_t i, n = 0;
+	double b;
+
+	if (!f)
+		return -1;
+	fprintf(f, "{\n");
+	for (i = 0; i < result_num; ++i) {
+		m = bench_metric(results[i].name);
+		if (!m || !m->dir)
+			continue;
+		if (m->dir > 0)
+			b = results[i].v * (1.0 + BENCH_MARGIN) + m->slack;
+		else
+			b = results[i].v * (1.0 - BENCH_MARGIN) - m->slack;
+		fprintf(f, "%s  \"%s\": {\"%s\": %.1f}", n++ ? ",\n" : "",
+			results[i].name, m->dir > 0 ? "max" : "min",
+			b < 0 ? 0.0 : b);
+	}
+	fprintf(f, "\n}\n");
+	fclose(f);
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Return number of regressions or -1
+static int32_t 
+bench_compare(const char *path, const char *only)
+{
+	FILE *f = fopen(path, "r");
+	char line[256], name[BENCH_NAME_MAX], kind[8];
+	double b;
+	uint32_t i, len;
+	int32_t fail = 0;
+
+	if (!f)
+		return -1;
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, " \"%63[^\"]\": {\"%7[^\"]\": %lf", name, kind,
+			&b) != 3)
+			continue;
+		len = (uint32_t)strlen(only ? only : "");
+		if (only && (strncmp(name, only, len) || name[len] != '.'))
+			continue;
+		for (i = 0; i < result_num; ++i)
+			if (!strcmp(results[i].name, name))
+				break;
+		if (i == result_num) {
+			fprintf(stderr, "FAIL %s: no result\n", name);
+			++fail;
+		} else if ((!strcmp(kind, "max") && results[i].v > b) ||
+			(!strcmp(kind, "min") && results[i].v < b)) {
+			fprintf(stderr, "FAIL %s: %.1f (%s %.1f)\n", name,
+				results[i].v, kind, b);
+			++fail;
+		} else {
+			fprintf(stderr, "pass %s: %.1f (%s %.1f)\n", name,
+				results[i].v, kind, b);
+		}
+	}
+	fclose(f);
+	return fail;
+}
+//=============================================================================
+int 
+main(int argc, char **argv)
+{
+	const char *only = 0, *base = 0, *write = 0;
+	int fd[SCENARIO_NUM];
+	pid_t pid[SCENARIO_NUM];
+	uint32_t i;
+	int32_t fail;
+	int c;
+
+	while ((c = getopt(argc, argv, "s:b:w:")) != -1) {
+		if (c == 's')
+			only = optarg;
+		else if (c == 'b')
+			base = optarg;
+		else if (c == 'w')
+			write = optarg;
+		else {
+			fprintf(stderr, "usage: %s [-s scenario] [-b baseline] "
+				"[-w baseline]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	for (i = 0; i < SCENARIO_NUM; ++i) {
+		fd[i] = -1;
+		if (only && strcmp(only, scenarios[i].name))
+			continue;
+		fd[i] = bench_fork(&scenarios[i], &pid[i]);
+		if (fd[i] < 0) {
+			fprintf(stderr, "%s: not started\n", scenarios[i].name);
+			return 2;
+		}
+	}
+	for (i = 0; i < SCENARIO_NUM; ++i) {
+		if (fd[i] >= 0 && bench_collect(&scenarios[i], fd[i], pid[i])) {
+			fprintf(stderr, "%s: failed\n", scenarios[i].name);
+			return 2;
+		}
+	}
+	bench_json();
+
+	if (write && bench_write(write)) {
+		fprintf(stderr, "%s: not written\n", write);
+		return 2;
+	}
+	if (base) {
+		fail = bench_compare(base, only);
+		if (fail < 0) {
+			fprintf(stderr, "%s: not read\n", base);
+			return 2;
+		}
+		fprintf(stderr, "%s\n", fail ? "REGRESSION" : "PASS");
+		return fail ? 1 : 0;
+	}
+	return 0;
+}
+//=============================================================================
@@ -0,0 +1,140 @@
+//=============================================================================
+/*
+* Host stress test of command slot (see cmd.c): writer (cmd_put(), CAN RX
+* interrupt) between reads of reader (cmd_get(), main loop)
+* usage:
+ - cmdtest [-n gets] [-r seed]
+* notes:
+ - cmd.c is built with CMD_TEST (see Makefile): cmd_testHook() runs
+   between field reads of slot in cmd_get(); it puts 0 ... 2 commands
+   (random): 2 commands overwrite slot in copy (torn read), 1 - next
+   slot; both change cmd_seq => copy is repeated
+ - command k: focus, pole of k (CT_FOCUS(), CT_POLE()), id k => mixed
+   slot is seen as focus / pole not of id
+ - commands between gets as well (superseded)
+ - checks: no mixed command, got command is latest put (latest wins),
+   received = put, applied = gets, applied + superseded = received; torn
+   reads and repeats of copy did happen
+* output: one line of counts; exit code 1 if any check fails
+*/
+//=============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+//-----------------------------------------------------------------------------
+#include "sim.h"
+#include "cmd.h"
+#include "focus.h"
+//=============================================================================
+#define CT_GETS_DEF   200000U
+#define CT_HOOKS_MAX  24U      // per cmd_get(): no puts after (ends copy)
+#define CT_FOCUS(k)   ((k) * 37U & FOCUS_MASK)
+#define CT_POLE(k)    ((k) % 5U == 0 ? CMD_KEEP : (k) % 3U)
+//-----------------------------------------------------------------------------
+static uint32_t ct_rnd = 1U;
+static uint32_t ct_put;        // commands put (id of latest)
+static uint32_t ct_hooks;      // in this cmd_get()
+static uint32_t ct_torn;       // 2 puts in copy (slot is overwritten)
+static uint32_t ct_repeats;    // copies repeated
+static uint32_t ct_fail;
+//=============================================================================
+static uint32_t 
+ct_next(void)
+{
+	ct_rnd = ct_rnd * 1664525U + 1013904223U;
+	return ct_rnd >> 16;
+}
+//-----------------------------------------------------------------------------
+// n commands as CAN RX interrupt
+static void 
+ct_putN(uint32_t n)
+{
+	uint32_t k;
+
+	for (; n; --n) {
+		k = ++ct_put;
+		cmd_put(CT_FOCUS(k), CT_POLE(k), k);
+	}
+}
+//-----------------------------------------------------------------------------
+// 0 ... 2 commands between reads of cmd_get() (see cmd.c)
+void 
+cmd_testHook(void)
+{
+	uint32_t r = ct_next() & 7U, n;
+
+	if (++ct_hooks > CT_HOOKS_MAX)
+		return;
+	n = r < 4U ? 0 : r < 6U ? 1U : 2U;
+	if (n == 2U)
+		++ct_torn;
+	ct_putN(n);
+}
+//-----------------------------------------------------------------------------
+static void 
+ct_check(uint32_t ok, const char *what, uint32_t a, uint32_t b)
+{
+	if (ok)
+		return;
+	if (ct_fail++ < 10U)
+		fprintf(stderr, "cmdtest: %s (%u, %u)\n", what, a, b);
+}
+//=============================================================================
+int 
+main(int argc, char **argv)
+{
+	uint32_t gets = CT_GETS_DEF, i, focus, pole, id, applied = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:r:")) != -1) {
+		if (c == 'n')
+			gets = (uint32_t)atoi(optarg);
+		else if (c == 'r')
+			ct_rnd = (uint32_t)strtoul(optarg, NULL, 0);
+		else {
+			fprintf(stderr, "usage: %s [-n gets] [-r seed]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	sim_init();
+	cmd_init();
+	for (i = 0; i < gets; ++i) {
+		// Commands between passes of main loop
+		ct_putN(ct_next() % 3U);
+		ct_hooks = 0;
+		if (cmd_get(&focus, &pole, &id)) {
+			ct_check(cmd_getReceived() == cmd_getLast(), "no command",
+				cmd_getReceived(), cmd_getLast());
+			continue;
+		}
+		++applied;
+		if (ct_hooks > 3U)
+			ct_repeats += ct_hooks / 3U - 1U;
+		ct_check(focus == CT_FOCUS(id) && pole == CT_POLE(id),
+			"mixed command", id, focus);
+		ct_check(id == ct_put, "not latest", id, ct_put);
+	}
+	// Last command (without puts in copy)
+	ct_hooks = CT_HOOKS_MAX;
+	if (!cmd_get(&focus, &pole, &id)) {
+		++applied;
+		ct_check(id == ct_put, "not latest", id, ct_put);
+	}
+
+	ct_check(cmd_getReceived() == ct_put, "received", cmd_getReceived(),
+		ct_put);
+	ct_check(cmd_getApplied() == applied, "applied", cmd_getApplied(),
+		applied);
+	ct_check(cmd_getApplied() + cmd_getSuperseded() == cmd_getReceived(),
+		"applied + superseded", cmd_getApplied() + cmd_getSuperseded(),
+		cmd_getReceived());
+	ct_check(ct_torn > 0, "no torn read", ct_torn, 0);
+	ct_check(ct_repeats > 0, "no repeat", ct_repeats, 0);
+
+	printf("put %u applied %u superseded %u torn %u repeats %u: %s\n",
+		ct_put, cmd_getApplied(), cmd_getSuperseded(), ct_torn,
+		ct_repeats, ct_fail ? "FAIL" : "PASS");
+	return ct_fail ? 1 : 0;
+}
+//=============================================================================
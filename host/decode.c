@@ -0,0 +1,62 @@
+//=============================================================================
+/*
+* Host decoder of position stream (CAN_ID_STREAM, see stream.c)
+* notes:
+ - frame: first sample (12 bits) and n deltas of "bits" width (two's 
+   complement) in high word; period in units of STREAM_PER_US
+ - sequence of frame: skipped numbers are gaps (frame lost on bus or 
+   samples lost in node); time of samples goes on without the gap
+ - no firmware state: also for logs of real bus
+*/
+//=============================================================================
+#include <string.h>
+//-----------------------------------------------------------------------------
+#include "decode.h"
+#include "stream.h"
+//=============================================================================
+void 
+decode_init(struct decode *d)
+{
+	memset(d, 0, sizeof(*d));
+}
+//-----------------------------------------------------------------------------
+// Samples of frame (l - low word, h - high word) to out; t_us - time of 
+// first one (from first frame); return number of samples or -1 (not valid)
+int32_t 
+decode_frame(struct decode *d, uint32_t l, uint32_t h, uint16_t *out,
+	uint64_t *t_us)
+{
+	uint32_t seq = l >> STREAM_SEQ_POS & 0xFFU;
+	uint32_t per = l >> STREAM_PER_POS & 0xFU;
+	uint32_t bits = l >> STREAM_BITS_POS & 0xFU;
+	uint32_t n = l >> STREAM_N_POS & 0xFU;
+	uint32_t i, v, m;
+	int32_t s;
+
+	if (!per || bits < STREAM_BITS_MIN || bits > STREAM_BITS_MAX ||
+		n * bits > STREAM_DATA_BITS) {
+		++d->bad;
+		return -1;
+	}
+	if (d->frames)
+		d->gaps += (seq - d->seq) & 0xFFU;
+	d->seq = (seq + 1U) & 0xFFU;
+
+	s = (int32_t)(l >> STREAM_FIRST_POS & 0xFFFU);
+	out[0] = (uint16_t)s;
+	m = (1U << bits) - 1U;
+	for (i = 0; i < n; ++i) {
+		v = h >> (i * bits) & m;
+		// Sign extension of delta
+		s += (int32_t)(v ^ 1U << (bits - 1U)) - (int32_t)(1U << (bits - 1U));
+		out[i + 1U] = (uint16_t)(s & 0xFFF);
+	}
+
+	d->per_us = per * STREAM_PER_US;
+	*t_us = d->t_us;
+	d->t_us += (uint64_t)(n + 1U) * d->per_us;
+	++d->frames;
+	d->samples += n + 1U;
+	return (int32_t)(n + 1U);
+}
+//=============================================================================
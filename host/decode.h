@@ -0,0 +1,27 @@
+//=============================================================================
+#ifndef DECODE_H
+#define DECODE_H
+//=============================================================================
+#include <stdint.h>
+//-----------------------------------------------------------------------------
+// Samples of one frame (CAN_ID_STREAM): first + deltas
+#define DECODE_SAMPLES_MAX  16U
+//-----------------------------------------------------------------------------
+// Decoder of position stream (see stream.h); time of sample i of frame is 
+// t_us of decode_frame() result + i x per_us
+struct decode {
+	uint32_t frames;
+	uint32_t samples;
+	uint32_t gaps;      // skipped sequence numbers (lost frames or samples)
+	uint32_t bad;       // frames not valid (not counted)
+	uint32_t seq;       // next expected
+	uint32_t per_us;    // period of last frame
+	uint64_t t_us;      // time of next sample (gaps are not counted)
+};
+//-----------------------------------------------------------------------------
+void decode_init(struct decode *d);
+int32_t decode_frame(struct decode *d, uint32_t l, uint32_t h, 
+	uint16_t *out, uint64_t *t_us);
+//=============================================================================
+#endif // DECODE_H
+//=============================================================================
@@ -0,0 +1,154 @@
+//=============================================================================
+/*
+* Host check and micro-benchmark of fixed-point kernels (see dsp.c)
+* usage:
+ - dspbench [-n iterations]
+   compares portable C (DSP_SIMD 0) with DSP instruction variant (DSP_SIMD
+   1 on emulated SMLAD, SSAT of sim.c; dsp_simd.o, names simd_x) on random
+   full range inputs, then runs dsp_bench() of both variants; exit code 1
+   if any output differs
+* output (one line per kernel):
+ - kernel, check sum of dsp_bench() (compare with CAN_SRV_DSP_BENCH of
+   target: cycles per sample are measured there), host ns per sample of
+   both variants (emulated instructions are calls on host: not a measure
+   of target)
+*/
+//=============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+//-----------------------------------------------------------------------------
+#include "sim.h"
+#include "dsp.h"
+//=============================================================================
+#define DB_ITER_DEF  200000U
+#define DB_RUNS      2000U   // dsp_bench() runs for time
+//-----------------------------------------------------------------------------
+// dsp.c with DSP_SIMD 1 (see Makefile)
+int32_t simd_mean(const int16_t *x, uint32_t sh);
+void simd_avgInit(struct dsp_avg *a, int16_t *buf, uint32_t sh, int16_t x0);
+int16_t simd_avg(struct dsp_avg *a, int16_t x);
+void simd_biquadInit(struct dsp_biquad *f, const int16_t *c, int16_t x0);
+int16_t simd_biquad(struct dsp_biquad *f, int16_t x);
+int16_t simd_median(const int16_t *x, uint32_t n);
+void simd_pidInit(struct dsp_pid *p, int16_t kp, int16_t ki, int16_t kd,
+	int16_t max);
+int16_t simd_pid(struct dsp_pid *p, int16_t e);
+int32_t simd_interp(const int16_t *tab, uint32_t sh, uint32_t x);
+int32_t simd_bench(uint32_t k, uint32_t *cycles, uint32_t *sum);
+//-----------------------------------------------------------------------------
+static const char *db_names[DSP_K_NUM] = {
+	"mean", "avg", "biquad", "median", "pid", "interp",
+};
+static uint32_t rnd = 2024U;
+static uint32_t db_fail;
+//=============================================================================
+static int16_t 
+db_rnd(void)
+{
+	rnd = rnd * 1664525U + 1013904223U;
+	return (int16_t)(rnd >> 16);
+}
+//-----------------------------------------------------------------------------
+static void 
+db_diff(uint32_t k, uint32_t i, int32_t a, int32_t b)
+{
+	if (a == b)
+		return;
+	if (db_fail++ < 10U)
+		fprintf(stderr, "FAIL %s: iteration %u: %d (C) != %d (SIMD)\n",
+			db_names[k], i, a, b);
+}
+//-----------------------------------------------------------------------------
+// Random inputs over full range of int16_t (saturation and wrap of sums)
+static void 
+db_check(uint32_t iter)
+{
+	static __attribute__((aligned(4))) int16_t x[16], buf_c[16], buf_s[16];
+	int16_t c[5], tab[17];
+	struct dsp_avg ac, as;
+	struct dsp_biquad fc, fs;
+	struct dsp_pid pc, ps;
+	uint32_t i, j, sh, xi;
+
+	for (i = 0; i < iter; ++i) {
+		for (j = 0; j < 16U; ++j)
+			x[j] = db_rnd();
+		sh = (uint32_t)db_rnd() & 3U;
+		db_diff(DSP_K_MEAN, i, dsp_mean(x, sh), simd_mean(x, sh));
+		db_diff(DSP_K_MEDIAN, i, dsp_median(x, 1U + i % DSP_MEDIAN_MAX),
+			simd_median(x, 1U + i % DSP_MEDIAN_MAX));
+
+		// New state each 64 iterations (state runs between them)
+		if (i % 64U == 0) {
+			for (j = 0; j < 5U; ++j)
+				c[j] = db_rnd();
+			dsp_avgInit(&ac, buf_c, sh, x[0]);
+			simd_avgInit(&as, buf_s, sh, x[0]);
+			dsp_biquadInit(&fc, c, x[0]);
+			simd_biquadInit(&fs, c, x[0]);
+			dsp_pidInit(&pc, c[0], c[1], c[2], c[3]);
+			simd_pidInit(&ps, c[0], c[1], c[2], c[3]);
+		}
+		db_diff(DSP_K_AVG, i, dsp_avg(&ac, x[1]), simd_avg(&as, x[1]));
+		db_diff(DSP_K_BIQUAD, i, dsp_biquad(&fc, x[2]),
+			simd_biquad(&fs, x[2]));
+		db_diff(DSP_K_PID, i, dsp_pid(&pc, x[3]), simd_pid(&ps, x[3]));
+
+		for (j = 0; j < 17U; ++j)
+			tab[j] = db_rnd();
+		sh = 1U + i % DSP_INTERP_MAX;
+		xi = (uint32_t)(uint16_t)db_rnd() % (16U << sh);
+		db_diff(DSP_K_INTERP, i, dsp_interp(tab, sh, xi),
+			simd_interp(tab, sh, xi));
+	}
+}
+//-----------------------------------------------------------------------------
+static double 
+db_ns(int32_t (*bench)(uint32_t, uint32_t *, uint32_t *), uint32_t k)
+{
+	struct timespec t0, t1;
+	uint32_t i, cycles, sum;
+
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	for (i = 0; i < DB_RUNS; ++i)
+		bench(k, &cycles, &sum);
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) /
+		((double)DB_RUNS * DSP_BENCH_N);
+}
+//=============================================================================
+int 
+main(int argc, char **argv)
+{
+	uint32_t iter = DB_ITER_DEF, k, cyc, sum_c, sum_s;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:")) != -1) {
+		if (c == 'n') {
+			iter = (uint32_t)strtoul(optarg, 0, 0);
+		} else {
+			fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	sim_init();
+	db_check(iter);
+
+	printf("%-8s %6s %10s %10s\n", "kernel", "sum", "c_ns", "simd_ns");
+	for (k = 0; k < DSP_K_NUM; ++k) {
+		dsp_bench(k, &cyc, &sum_c);
+		simd_bench(k, &cyc, &sum_s);
+		db_diff(k, DSP_BENCH_N, (int32_t)sum_c, (int32_t)sum_s);
+		printf("%-8s 0x%04X %10.1f %10.1f\n", db_names[k], sum_c,
+			db_ns(dsp_bench, k), db_ns(simd_bench, k));
+	}
+
+	fprintf(stderr, "%s (%u iterations)\n", db_fail ? "MISMATCH" :
+		"bit-identical", iter);
+	return db_fail ? 1 : 0;
+}
+//=============================================================================
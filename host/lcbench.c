@@ -0,0 +1,234 @@
+//=============================================================================
+/*
+* Throughput of commands over CAN: pipelined commands to N nodes (see
+* lensctl.c)
+* usage:
+ - lcbench [-n nodes] [-w window | -p] [-t s] [-s node | -i prefix] [-x] 
+   [-l us] [-r seed]
+   -n - nodes (default 1, up to LB_NODES_MAX), -w - commands in flight per
+   node (default 16, 1 - send and wait for acknowledge), -p - command, 
+   then state requests (CAN_ID_CTRL) up to new target (as old scripts), 
+   -t - time of run (default 5 s), -s - simulated nodes (path of lcnode,
+   default ./lcnode) on socket pairs, -i - SocketCAN interfaces prefix0 
+   ... (one node per interface, e.g. vcan), -x - simulated nodes not 
+   paced to wall clock, -l - latency of host adapter of simulated nodes
+   (each way, us), -r - seed of focus targets
+* notes:
+ - each node gets random focus targets (LB_FOCUS_LO ... LB_FOCUS_HI)
+   whenever it has less than window commands in flight; after time of run
+   commands in flight are waited for (LB_DRAIN_MS)
+ - node applies latest command and acknowledges it with count of 
+   superseded ones: answered = applied + superseded + rejected
+ - -p: next command when state answer has target of command (applied by 
+   main loop of node: answer of CAN RX interrupt may be older); events of 
+   node are on (bus load as before)
+ - simulated nodes start cold (calibration at start): run starts when all
+   nodes are operational (CAN_SRV_BOOT)
+* output: one line per node, then total; exit code 1 if any command was
+  not answered, 2 - usage or socket
+*/
+//=============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+//-----------------------------------------------------------------------------
+#include "lensctl.h"
+#include "can.h"
+//=============================================================================
+#define LB_NODES_MAX  32U
+#define LB_FOCUS_LO   200U
+#define LB_FOCUS_HI   3800U
+#define LB_BOOT_MS    10000U  // nodes operational
+#define LB_DRAIN_MS   2000U
+//-----------------------------------------------------------------------------
+static struct lc_node lb_node[LB_NODES_MAX];
+static uint32_t lb_num = 1U;
+static uint32_t lb_window = 16U;
+static uint32_t lb_rnd = 1U;
+static uint32_t lb_polled;               // -p
+static uint32_t lb_target[LB_NODES_MAX];  // -p: target of last command
+static uint32_t lb_states[LB_NODES_MAX];  // -p: answers before request
+//=============================================================================
+static uint32_t 
+lb_focus(void)
+{
+	lb_rnd = lb_rnd * 1664525U + 1013904223U;
+	return LB_FOCUS_LO + (lb_rnd >> 8) % (LB_FOCUS_HI - LB_FOCUS_LO);
+}
+//-----------------------------------------------------------------------------
+// Service request to all nodes up to answer; return -1 on timeout
+static int32_t 
+lb_srvAll(uint32_t op, uint64_t end)
+{
+	uint32_t srv[LB_NODES_MAX];
+	uint32_t i, wait;
+
+	for (i = 0; i < lb_num; ++i) {
+		srv[i] = lb_node[i].srv;
+		if (lc_srv(&lb_node[i], op, 0, 0, 0, 0))
+			return -1;
+	}
+	do {
+		if (lc_now() >= end || lc_poll(lb_node, lb_num, 10) < 0)
+			return -1;
+		for (wait = 0, i = 0; i < lb_num; ++i)
+			wait += lb_node[i].srv == srv[i];
+	} while (wait);
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// All nodes operational (reset-to-operational of CAN_SRV_BOOT)
+static int32_t 
+lb_boot(void)
+{
+	uint64_t end = lc_now() + LB_BOOT_MS * 1000000ULL;
+	uint32_t i, wait;
+
+	do {
+		if (lb_srvAll(CAN_SRV_BOOT, end))
+			return -1;
+		for (wait = 0, i = 0; i < lb_num; ++i)
+			wait += !lb_node[i].srv_last.h;
+		if (wait)
+			usleep(20000U);
+	} while (wait);
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Node with free window gets commands; -p: command, then state requests 
+// up to its target
+static void 
+lb_send(uint32_t i)
+{
+	struct lc_node *n = &lb_node[i];
+
+	if (!lb_polled) {
+		while (lc_inflight(n) < lb_window)
+			if (lc_cmd(n, lb_focus(), LC_KEEP) < 0)
+				return;
+		return;
+	}
+	if (n->states == lb_states[i] && n->sent)
+		return;
+	if (!n->sent || n->target == lb_target[i]) {
+		lb_target[i] = lb_focus();
+		if (lc_cmd(n, lb_target[i], LC_KEEP) < 0)
+			return;
+	}
+	lb_states[i] = n->states;
+	lc_ctrl(n);
+}
+//-----------------------------------------------------------------------------
+static void 
+lb_print(const char *name, const struct lc_node *n, double s)
+{
+	uint32_t answered = n->acked + n->superseded + n->rejected;
+
+	printf("%-6s sent %7u applied %7u superseded %7u rejected %4u "
+		"lost %4u  cmd/s %8.0f  applied/s %7.0f  ack us avg %6.0f "
+		"max %7.0f\n", name, n->sent, n->acked, n->superseded, 
+		n->rejected, n->sent - answered, answered / s, n->acked / s,
+		n->acked ? (double)n->lat_sum / n->acked / 1000.0 : 0.0,
+		(double)n->lat_max / 1000.0);
+}
+//=============================================================================
+int 
+main(int argc, char **argv)
+{
+	const char *node = "./lcnode", *prefix = NULL;
+	struct lc_node all;
+	char name[32], opt[32];
+	uint64_t t0, end;
+	uint32_t run_s = 5U, fast = 0, lat = 0, i;
+	double s;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:w:pt:s:i:xl:r:")) != -1) {
+		if (c == 'n')
+			lb_num = (uint32_t)atoi(optarg);
+		else if (c == 'w')
+			lb_window = (uint32_t)atoi(optarg);
+		else if (c == 'p')
+			lb_polled = 1U;
+		else if (c == 't')
+			run_s = (uint32_t)atoi(optarg);
+		else if (c == 's')
+			node = optarg;
+		else if (c == 'i')
+			prefix = optarg;
+		else if (c == 'x')
+			fast = 1U;
+		else if (c == 'l')
+			lat = (uint32_t)atoi(optarg);
+		else if (c == 'r')
+			lb_rnd = (uint32_t)atoi(optarg);
+		else
+			return 2;
+	}
+	if (!lb_num || lb_num > LB_NODES_MAX || !lb_window || 
+		lb_window > LC_WINDOW_MAX) {
+		fprintf(stderr, "lcbench: nodes 1 ... %u, window 1 ... %u\n", 
+			LB_NODES_MAX, LC_WINDOW_MAX);
+		return 2;
+	}
+	snprintf(opt, sizeof(opt), "-%sl%u", fast ? "x" : "", lat);
+	for (i = 0; i < lb_num; ++i) {
+		snprintf(name, sizeof(name), "%s%u", prefix ? prefix : "", i);
+		if (prefix ? lc_open(&lb_node[i], name) : 
+			lc_spawn(&lb_node[i], node, opt)) {
+			perror(prefix ? name : node);
+			return 2;
+		}
+	}
+	if (lb_boot()) {
+		fprintf(stderr, "lcbench: nodes are not operational\n");
+		return 2;
+	}
+
+	// Run: window of each node full
+	t0 = lc_now();
+	end = t0 + run_s * 1000000000ULL;
+	while (lc_now() < end) {
+		for (i = 0; i < lb_num; ++i)
+			lb_send(i);
+		if (lc_poll(lb_node, lb_num, 10) < 0) {
+			fprintf(stderr, "lcbench: node closed\n");
+			return 2;
+		}
+	}
+	s = (double)(lc_now() - t0) / 1e9;
+
+	// Drain: commands in flight
+	end = lc_now() + LB_DRAIN_MS * 1000000ULL;
+	for (;;) {
+		for (c = 0, i = 0; i < lb_num; ++i)
+			c += lc_inflight(&lb_node[i]) != 0;
+		if (!c || lc_now() >= end || lc_poll(lb_node, lb_num, 10) < 0)
+			break;
+	}
+
+	if (lb_polled)
+		printf("nodes %u polled latency %u us time %.2f s\n", lb_num, 
+			lat, s);
+	else
+		printf("nodes %u window %u latency %u us time %.2f s\n", lb_num,
+			lb_window, lat, s);
+	memset(&all, 0, sizeof(all));
+	for (i = 0; i < lb_num; ++i) {
+		snprintf(name, sizeof(name), "%u", i);
+		lb_print(name, &lb_node[i], s);
+		all.sent += lb_node[i].sent;
+		all.acked += lb_node[i].acked;
+		all.superseded += lb_node[i].superseded;
+		all.rejected += lb_node[i].rejected;
+		all.lat_sum += lb_node[i].lat_sum;
+		if (lb_node[i].lat_max > all.lat_max)
+			all.lat_max = lb_node[i].lat_max;
+	}
+	lb_print("total", &all, s);
+	for (i = 0; i < lb_num; ++i)
+		lc_close(&lb_node[i]);
+	return lc_inflight(&all) || !all.sent;
+}
+//=============================================================================
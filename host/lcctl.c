@@ -0,0 +1,179 @@
+//=============================================================================
+/*
+* Command line tool of one node (see lensctl.c)
+* usage:
+ - lcctl [-i ifname | -s node] [-w ms] command ...
+   -i - SocketCAN interface (default "can0"), -s - simulated node (path 
+   of lcnode) on socket pair, -w - timeout of each answer (default 2000)
+* commands (in order, each waits for its answer):
+ - move focus pole    - command (ADC counts, pole 0 ... 2; "-" - keep), 
+                        waits for acknowledge and end of each move
+ - state              - state request: pole, focus position and target
+ - srv op a1 a2 a3 h  - service request (CAN_SRV_x, numbers as strtoul() 
+                        with base 0), prints answer
+ - stream per ms      - position streaming (CAN_SRV_STREAM, period x 
+                        250 us) for ms, prints samples (us, counts)
+ - wait ms            - waits (frames of node are read)
+* exit code: 0, 1 - timeout or rejected command, 2 - usage or socket
+*/
+//=============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+//-----------------------------------------------------------------------------
+#include "lensctl.h"
+#include "can.h"
+//=============================================================================
+#define CTL_WAIT_DEF  2000U
+//-----------------------------------------------------------------------------
+static struct lc_node ctl;
+static uint32_t ctl_wait = CTL_WAIT_DEF;
+static uint32_t ctl_rej;                  // rejected before command
+static uint32_t ctl_focus, ctl_pole;      // ends of moves before command
+//=============================================================================
+static uint32_t 
+ctl_num(const char *s)
+{
+	return strcmp(s, "-") ? (uint32_t)strtoul(s, NULL, 0) : LC_KEEP;
+}
+//-----------------------------------------------------------------------------
+// Frames of node up to time (ms from now) or until done() returns 1; 
+// return 0 if done, -1 on timeout or closed socket
+static int32_t 
+ctl_until(uint32_t ms, int32_t (*done)(uint32_t), uint32_t arg)
+{
+	uint64_t end = lc_now() + (uint64_t)ms * 1000000U;
+	uint64_t t;
+
+	while (!done || !done(arg)) {
+		t = lc_now();
+		if (t >= end)
+			return done ? -1 : 0;
+		if (lc_poll(&ctl, 1U, (int32_t)((end - t) / 1000000U) + 1) < 0)
+			return -1;
+	}
+	return 0;
+}
+//-----------------------------------------------------------------------------
+static int32_t 
+ctl_state(uint32_t n)
+{
+	return ctl.states != n;
+}
+//-----------------------------------------------------------------------------
+static int32_t 
+ctl_srv(uint32_t n)
+{
+	return ctl.srv != n;
+}
+//-----------------------------------------------------------------------------
+// Command is rejected or acknowledged and each of its moves (acknowledge: 
+// focus also follows pole, see cmd.c) has ended
+static int32_t 
+ctl_moved(uint32_t arg)
+{
+	(void)arg;
+	if (ctl.rejected != ctl_rej)
+		return 1;
+	if (lc_inflight(&ctl))
+		return 0;
+	return (!(ctl.moves & CAN_EV_FOCUS) || ctl.focus_done != ctl_focus) &&
+		(!(ctl.moves & CAN_EV_POLE) || ctl.pole_done != ctl_pole);
+}
+//-----------------------------------------------------------------------------
+static int32_t 
+ctl_move(uint32_t focus, uint32_t pole)
+{
+	ctl_rej = ctl.rejected;
+	ctl_focus = ctl.focus_done;
+	ctl_pole = ctl.pole_done;
+	if (lc_cmd(&ctl, focus, pole) < 0)
+		return -1;
+	if (ctl_until(ctl_wait, ctl_moved, 0)) {
+		fprintf(stderr, "lcctl: move: timeout\n");
+		return -1;
+	}
+	if (ctl.rejected != ctl_rej) {
+		fprintf(stderr, "lcctl: move: rejected\n");
+		return -1;
+	}
+	printf("move: pole %u focus %u target %u\n", ctl.pole, ctl.pos,
+		ctl.target);
+	return 0;
+}
+//-----------------------------------------------------------------------------
+static void 
+ctl_sample(struct lc_node *n, const uint16_t *v, int32_t num, uint64_t t_us)
+{
+	int32_t i;
+
+	for (i = 0; i < num; ++i)
+		printf("%llu %u\n", (unsigned long long)(t_us + 
+			(uint64_t)i * n->stream.per_us), v[i]);
+}
+//=============================================================================
+int 
+main(int argc, char **argv)
+{
+	const char *ifname = "can0", *node = NULL;
+	uint32_t n;
+	int c, i;
+
+	while ((c = getopt(argc, argv, "i:s:w:")) != -1) {
+		if (c == 'i')
+			ifname = optarg;
+		else if (c == 's')
+			node = optarg;
+		else if (c == 'w')
+			ctl_wait = (uint32_t)atoi(optarg);
+		else
+			return 2;
+	}
+	if (node ? lc_spawn(&ctl, node, NULL) : lc_open(&ctl, ifname)) {
+		perror(node ? node : ifname);
+		return 2;
+	}
+
+	for (i = optind; i < argc; ) {
+		if (!strcmp(argv[i], "move") && i + 2 < argc) {
+			if (ctl_move(ctl_num(argv[i + 1]), ctl_num(argv[i + 2])))
+				return 1;
+			i += 3;
+		} else if (!strcmp(argv[i], "state")) {
+			n = ctl.states;
+			if (lc_ctrl(&ctl) || ctl_until(ctl_wait, ctl_state, n))
+				return 1;
+			printf("state: pole %u focus %u target %u\n", ctl.pole, 
+				ctl.pos, ctl.target);
+			i += 1;
+		} else if (!strcmp(argv[i], "srv") && i + 5 < argc) {
+			n = ctl.srv;
+			if (lc_srv(&ctl, ctl_num(argv[i + 1]), ctl_num(argv[i + 2]),
+				ctl_num(argv[i + 3]), ctl_num(argv[i + 4]), 
+				ctl_num(argv[i + 5])) || 
+				ctl_until(ctl_wait, ctl_srv, n))
+				return 1;
+			printf("srv: 0x%08X 0x%08X\n", ctl.srv_last.l, ctl.srv_last.h);
+			i += 6;
+		} else if (!strcmp(argv[i], "stream") && i + 2 < argc) {
+			ctl.on_samples = ctl_sample;
+			if (lc_srv(&ctl, CAN_SRV_STREAM, ctl_num(argv[i + 1]), 0, 0, 0) ||
+				ctl_until(ctl_num(argv[i + 2]), NULL, 0) ||
+				lc_srv(&ctl, CAN_SRV_STREAM, 0, 0, 0, 0))
+				return 1;
+			ctl.on_samples = NULL;
+			i += 3;
+		} else if (!strcmp(argv[i], "wait") && i + 1 < argc) {
+			if (ctl_until(ctl_num(argv[i + 1]), NULL, 0))
+				return 1;
+			i += 2;
+		} else {
+			fprintf(stderr, "lcctl: %s: unknown command\n", argv[i]);
+			return 2;
+		}
+	}
+	lc_close(&ctl);
+	return 0;
+}
+//=============================================================================
@@ -0,0 +1,250 @@
+//=============================================================================
+/*
+* Simulated node: firmware in simulator (see sim.c) on SocketCAN interface
+* or socket of lensctl.c (lc_spawn())
+* usage:
+ - lcnode -i ifname [-x] [-l us] - raw CAN socket (e.g. vcan0: ip link 
+   add dev vcan0 type vcan; ip link set vcan0 up)
+ - lcnode -f fd [-x] [-l us]      - datagrams of struct can_frame on fd
+   -x - fast: not paced to wall clock (time of simulator is free), -l - 
+   latency of host adapter each way (e.g. USB-CAN, default 0)
+* notes:
+ - one frame of bus is one datagram: frames from socket are RX of node at 
+   time of simulator when read, TX of node goes to socket at end of frame
+ - latency: frames from socket are on bus after it (queue of up to 
+   LN_DELAY_MAX frames), TX of node goes to socket after it; steps of 
+   LN_STEP_US
+ - paced: simulator waits while it is ahead of wall clock by more than 
+   LN_AHEAD_US (frames wake it up); slower than wall clock if host is slow
+ - ends when socket is closed (peer ends) or on system reset of firmware
+ - plant: focus, zoom, iris as in bench.c (focus at 1000)
+*/
+//=============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+//-----------------------------------------------------------------------------
+#include "sim.h"
+#include "plant.h"
+#include "main.h"
+#include "can.h"
+//=============================================================================
+#define LN_STEP_US    100U   // frames to and from socket each step
+#define LN_AHEAD_US   1000U  // simulator ahead of wall clock (paced)
+#define LN_DELAY_MAX  1024U  // frames from socket in latency
+//-----------------------------------------------------------------------------
+static const struct plant_param ln_plant[PLANT_MOTORS] = {
+	{ .pos = 1000, .speed = 1.0, .tau_drive = 20.0, .tau_coast = 3.0,
+		.stop_lo = 40.0, .stop_hi = 4050.0, .noise = 1.5, .seed = 12345U },
+	{ .pos = 800, .speed = 2.0, .tau_drive = 10.0, .tau_coast = 2.0,
+		.stop_lo = 40.0, .stop_hi = 4050.0, .noise = 1.5, .seed = 23456U },
+	{ .pos = 3000, .speed = 2.0, .tau_drive = 10.0, .tau_coast = 2.0,
+		.stop_lo = 40.0, .stop_hi = 4050.0, .noise = 1.5, .seed = 34567U },
+};
+static int ln_fd = -1;
+static uint32_t ln_tx;       // TX frames of log sent to socket
+static uint64_t ln_lat;      // latency (cycles)
+static struct sim_frame ln_delay[LN_DELAY_MAX];  // t - on bus
+static uint32_t ln_head, ln_num;
+//=============================================================================
+static uint64_t 
+ln_wallUs(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000U + (uint64_t)ts.tv_nsec / 1000U;
+}
+//-----------------------------------------------------------------------------
+// Raw CAN socket: requests to node only
+static int 
+ln_open(const char *ifname)
+{
+	static const uint32_t ids[] = { CAN_ID_CMD, CAN_ID_CTRL, CAN_ID_SRV };
+	struct can_filter flt[sizeof(ids) / sizeof(ids[0])];
+	struct sockaddr_can addr;
+	struct ifreq ifr;
+	uint32_t i;
+	int fd;
+
+	fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+	if (fd < 0)
+		return -1;
+	memset(&ifr, 0, sizeof(ifr));
+	snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+	for (i = 0; i < sizeof(ids) / sizeof(ids[0]); ++i) {
+		flt[i].can_id = ids[i];
+		flt[i].can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.can_family = AF_CAN;
+	if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0 ||
+		setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, flt, sizeof(flt)) < 0) {
+		close(fd);
+		return -1;
+	}
+	addr.can_ifindex = ifr.ifr_ifindex;
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+//-----------------------------------------------------------------------------
+// Frames after latency to RX queue of simulator
+static void 
+ln_rxDue(void)
+{
+	struct sim_frame *f;
+
+	while (ln_num && ln_delay[ln_head].t <= sim_now()) {
+		f = &ln_delay[ln_head];
+		sim_canRx(f->id, f->dlc, f->l, f->h);
+		ln_head = (ln_head + 1U) % LN_DELAY_MAX;
+		--ln_num;
+	}
+}
+//-----------------------------------------------------------------------------
+// Frames from socket to RX queue of simulator (after latency); return -1 
+// if closed
+static int32_t 
+ln_rx(void)
+{
+	struct can_frame cf;
+	struct sim_frame *f;
+	uint32_t l, h, i;
+	ssize_t r;
+
+	for (;;) {
+		if (ln_num == LN_DELAY_MAX) {
+			ln_rxDue();
+			return 0;
+		}
+		r = recv(ln_fd, &cf, sizeof(cf), MSG_DONTWAIT);
+		if (r < 0)
+			return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+		if (r == 0)
+			return -1;
+		if (r != (ssize_t)sizeof(cf) || cf.can_id & CAN_EFF_FLAG)
+			continue;
+		l = h = 0;
+		for (i = 0; i < 4U; ++i) {
+			l |= (uint32_t)cf.data[i] << (8U * i);
+			h |= (uint32_t)cf.data[4U + i] << (8U * i);
+		}
+		f = &ln_delay[(ln_head + ln_num++) % LN_DELAY_MAX];
+		f->t = sim_now() + ln_lat;
+		f->id = cf.can_id & CAN_SFF_MASK;
+		f->dlc = cf.len;
+		f->l = l;
+		f->h = h;
+		ln_rxDue();
+	}
+}
+//-----------------------------------------------------------------------------
+// TX frames of firmware (log) to socket after latency; blocks if socket is
+// full (as bus)
+static int32_t 
+ln_txFlush(void)
+{
+	const struct sim_frame *f;
+	struct can_frame cf;
+	uint32_t i;
+
+	for (; ln_tx < sim_txNum(); ++ln_tx) {
+		f = sim_tx(ln_tx);
+		if (f->t + ln_lat > sim_now())
+			break;
+		memset(&cf, 0, sizeof(cf));
+		cf.can_id = f->id;
+		cf.len = (uint8_t)f->dlc;
+		for (i = 0; i < 4U; ++i) {
+			cf.data[i] = (uint8_t)(f->l >> (8U * i));
+			cf.data[4U + i] = (uint8_t)(f->h >> (8U * i));
+		}
+		if (send(ln_fd, &cf, sizeof(cf), 0) != (ssize_t)sizeof(cf))
+			return -1;
+	}
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Logs of simulator are bounded (SIM_LOG_SIZE): drop frames already passed
+static void 
+ln_trim(void)
+{
+	if (sim_rxNum() < SIM_LOG_SIZE / 2U && sim_txNum() < SIM_LOG_SIZE / 2U)
+		return;
+	sim_canTrim(ln_tx);
+	ln_tx = 0;
+}
+//=============================================================================
+int 
+main(int argc, char **argv)
+{
+	const char *ifname = NULL;
+	struct pollfd p;
+	uint64_t wall0, sim0, step, ahead;
+	uint32_t fast = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "i:f:xl:")) != -1) {
+		if (c == 'i')
+			ifname = optarg;
+		else if (c == 'f')
+			ln_fd = atoi(optarg);
+		else if (c == 'x')
+			fast = 1U;
+		else if (c == 'l')
+			ln_lat = (uint64_t)atoi(optarg) * SIM_CYCLES_US;
+		else
+			return 2;
+	}
+	if (ifname)
+		ln_fd = ln_open(ifname);
+	if (ln_fd < 0) {
+		fprintf(stderr, "usage: lcnode -i ifname | -f fd [-x] [-l us]\n");
+		return 2;
+	}
+
+	sim_init();
+	plant_init(ln_plant, PLANT_MOTORS);
+	main_init();
+
+	wall0 = ln_wallUs();
+	sim0 = sim_now();
+	step = sim_now();
+	p.fd = ln_fd;
+	p.events = POLLIN;
+	for (;;) {
+		main_loop();
+		sim_idle(SIM_LOOP_CYCLES);
+		if (sim_now() < step)
+			continue;
+		step = sim_now() + LN_STEP_US * SIM_CYCLES_US;
+
+		ln_rxDue();
+		if (ln_txFlush() || ln_rx())
+			break;
+		ln_trim();
+		if (fast)
+			continue;
+		// Paced: wait for wall clock (or frame)
+		ahead = (sim_now() - sim0) / SIM_CYCLES_US;
+		if (ahead < ln_wallUs() - wall0 + LN_AHEAD_US)
+			continue;
+		ahead -= ln_wallUs() - wall0;
+		if (poll(&p, 1, (int)(ahead / 1000U)) < 0 && errno != EINTR)
+			break;
+	}
+	return 0;
+}
+//=============================================================================
@@ -0,0 +1,330 @@
+//=============================================================================
+/*
+* Host library of node protocol (can.h) over SocketCAN
+* notes:
+ - transport: datagrams of struct can_frame, raw CAN socket (lc_open()) 
+   or socket pair of simulated node (lc_spawn(), lcnode.c); non-blocking
+ - IDs of can.h are fixed => one node per CAN interface; many nodes are 
+   many lc_node (lc_poll() on all of them)
+ - pipelined commands: lc_cmd() does not wait; node applies latest 
+   command (cmd.c) and acknowledges it with count of superseded commands 
+   before it => each sent command is acked, superseded or rejected; 
+   in flight is the rest (caller limits it, see LC_WINDOW_MAX)
+ - end of move events are of latest command with this target only
+*/
+//=============================================================================
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+//-----------------------------------------------------------------------------
+#include "lensctl.h"
+#include "can.h"
+//=============================================================================
+#define LC_POLL_MAX  64U  // nodes of one lc_poll()
+//=============================================================================
+// Monotonic time (ns)
+uint64_t 
+lc_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+//-----------------------------------------------------------------------------
+// Node on fd (datagrams of struct can_frame)
+void 
+lc_attach(struct lc_node *n, int fd)
+{
+	memset(n, 0, sizeof(*n));
+	n->fd = fd;
+	decode_init(&n->stream);
+}
+//-----------------------------------------------------------------------------
+// Raw CAN socket on interface (e.g. "can0", "vcan0"): answers of node only;
+// return -1 on error (errno)
+int32_t 
+lc_open(struct lc_node *n, const char *ifname)
+{
+	static const uint32_t ids[] = { CAN_ID_CTRL, CAN_ID_SRV, CAN_ID_EVENT,
+		CAN_ID_STREAM, CAN_ID_TRACE };
+	struct can_filter flt[sizeof(ids) / sizeof(ids[0])];
+	struct sockaddr_can addr;
+	struct ifreq ifr;
+	uint32_t i;
+	int fd;
+
+	fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK, CAN_RAW);
+	if (fd < 0)
+		return -1;
+	memset(&ifr, 0, sizeof(ifr));
+	snprintf(ifr.ifr_name, sizeof(ifr.ifr_name), "%s", ifname);
+	if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0)
+		goto err;
+	for (i = 0; i < sizeof(ids) / sizeof(ids[0]); ++i) {
+		flt[i].can_id = ids[i];
+		flt[i].can_mask = CAN_SFF_MASK | CAN_EFF_FLAG | CAN_RTR_FLAG;
+	}
+	if (setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, flt, sizeof(flt)) < 0)
+		goto err;
+	memset(&addr, 0, sizeof(addr));
+	addr.can_family = AF_CAN;
+	addr.can_ifindex = ifr.ifr_ifindex;
+	if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+		goto err;
+	lc_attach(n, fd);
+	return 0;
+err:
+	close(fd);
+	return -1;
+}
+//-----------------------------------------------------------------------------
+// Simulated node (firmware in simulator, path - lcnode) on socket pair; 
+// opt - options of lcnode (one argument, e.g. "-xl1000") or NULL; return
+// -1 on error
+int32_t 
+lc_spawn(struct lc_node *n, const char *path, const char *opt)
+{
+	char arg[16];
+	int sv[2];
+	pid_t pid;
+
+	if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0)
+		return -1;
+	pid = fork();
+	if (pid < 0) {
+		close(sv[0]);
+		close(sv[1]);
+		return -1;
+	}
+	if (pid == 0) {
+		close(sv[0]);
+		snprintf(arg, sizeof(arg), "%d", sv[1]);
+		execl(path, path, "-f", arg, opt, (char *)0);
+		perror(path);
+		_exit(127);
+	}
+	close(sv[1]);
+	lc_attach(n, sv[0]);
+	n->pid = pid;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Simulated node ends when its socket is closed
+void 
+lc_close(struct lc_node *n)
+{
+	if (n->fd >= 0)
+		close(n->fd);
+	n->fd = -1;
+}
+//=============================================================================
+// Return -1 if not sent (EAGAIN: try again after lc_poll())
+int32_t 
+lc_send(struct lc_node *n, const struct lc_frame *f)
+{
+	struct can_frame cf;
+	uint32_t i;
+
+	memset(&cf, 0, sizeof(cf));
+	cf.can_id = f->id & CAN_SFF_MASK;
+	cf.len = f->dlc > 8U ? 8U : (uint8_t)f->dlc;
+	for (i = 0; i < 4U; ++i) {
+		cf.data[i] = (uint8_t)(f->l >> (8U * i));
+		cf.data[4U + i] = (uint8_t)(f->h >> (8U * i));
+	}
+	if (send(n->fd, &cf, sizeof(cf), MSG_DONTWAIT) != (ssize_t)sizeof(cf))
+		return -1;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Command with high resolution focus (ADC counts) and pole, LC_KEEP - not 
+// changed; does not wait; return sequence ID or -1 (not sent)
+int32_t 
+lc_cmd(struct lc_node *n, uint32_t focus, uint32_t pole)
+{
+	struct lc_frame f;
+	uint32_t seq = (n->seq + 1U) & 0xFFU;
+
+	f.id = CAN_ID_CMD;
+	f.dlc = 8U;
+	f.l = (pole == LC_KEEP ? CAN_POLE_KEEP : pole & 0xFFU) << CAN_POLE_POS |
+		seq << CAN_SEQ_POS | CAN_VER_HIRES << CAN_VER_POS;
+	f.h = (focus == LC_KEEP ? CAN_FOCUS_HR_KEEP : focus & 0xFFFFU) <<
+		CAN_FOCUS_HR_POS;
+	if (lc_send(n, &f))
+		return -1;
+	n->seq = seq;
+	n->t_sent[seq] = lc_now();
+	++n->sent;
+	return (int32_t)seq;
+}
+//-----------------------------------------------------------------------------
+// State request (answer updates pos, target, pole)
+int32_t 
+lc_ctrl(struct lc_node *n)
+{
+	struct lc_frame f = { CAN_ID_CTRL, 0, 0, 0 };
+
+	return lc_send(n, &f);
+}
+//-----------------------------------------------------------------------------
+// Service request (CAN_SRV_x): answer in srv_last
+int32_t 
+lc_srv(struct lc_node *n, uint32_t op, uint32_t a1, uint32_t a2, 
+	uint32_t a3, uint32_t h)
+{
+	struct lc_frame f;
+
+	f.id = CAN_ID_SRV;
+	f.dlc = 8U;
+	f.l = (op & CAN_SRV_OP_MSK) << CAN_SRV_OP_POS |
+		(a1 & CAN_SRV_ARG_MSK) << CAN_SRV_ARG1_POS |
+		(a2 & CAN_SRV_ARG_MSK) << CAN_SRV_ARG2_POS |
+		(a3 & CAN_SRV_ARG_MSK) << CAN_SRV_ARG3_POS;
+	f.h = h;
+	return lc_send(n, &f);
+}
+//=============================================================================
+// Acknowledge of command id with superseded commands before it
+static void 
+lc_ack(struct lc_node *n, uint32_t id, uint32_t superseded)
+{
+	uint64_t lat = lc_now() - n->t_sent[id & 0xFFU];
+
+	++n->acked;
+	n->superseded += superseded;
+	n->lat_sum += lat;
+	if (lat > n->lat_max)
+		n->lat_max = lat;
+}
+//-----------------------------------------------------------------------------
+// One frame of node
+void 
+lc_feed(struct lc_node *n, const struct lc_frame *f)
+{
+	uint32_t type, id, a1, a2;
+	uint16_t v[DECODE_SAMPLES_MAX];
+	uint64_t t_us;
+	int32_t num;
+
+	switch (f->id) {
+	case CAN_ID_CTRL:
+		if (f->dlc < 8U)
+			break;
+		n->pole = f->l >> CAN_POLE_POS & CAN_POLE_MSK;
+		n->pos = f->h >> CAN_STATE_FOCUS_HR_POS & 0xFFFFU;
+		n->target = f->h >> CAN_STATE_TARGET_HR_POS & 0xFFFFU;
+		++n->states;
+		break;
+	case CAN_ID_EVENT:
+		type = f->l >> CAN_EV_TYPE_POS & 0xFFU;
+		id = f->l >> CAN_EV_SEQ_POS & 0xFFU;
+		a1 = f->l >> CAN_EV_ARG1_POS & 0xFFU;
+		a2 = f->l >> CAN_EV_ARG2_POS & 0xFFU;
+		n->pos = f->h >> CAN_STATE_FOCUS_HR_POS & 0xFFFFU;
+		n->target = f->h >> CAN_STATE_TARGET_HR_POS & 0xFFFFU;
+		++n->events;
+		if (type == CAN_EV_ACK) {
+			lc_ack(n, id, a2);
+			n->moves = a1;
+		} else if (type == CAN_EV_REJECT) {
+			++n->rejected;
+		} else if (type == CAN_EV_FOCUS_DONE) {
+			++n->focus_done;
+			n->last_done = id + 1U;
+		} else if (type == CAN_EV_POLE_DONE) {
+			++n->pole_done;
+			n->last_done = id + 1U;
+			if (!a1)
+				n->pole = a2;
+		}
+		break;
+	case CAN_ID_SRV:
+		n->srv_last = *f;
+		++n->srv;
+		break;
+	case CAN_ID_STREAM:
+		num = decode_frame(&n->stream, f->l, f->h, v, &t_us);
+		if (num > 0 && n->on_samples)
+			n->on_samples(n, v, num, t_us);
+		break;
+	default:
+		break;
+	}
+}
+//-----------------------------------------------------------------------------
+// All frames ready on socket of node; return frames or -1 (closed, error)
+int32_t 
+lc_recv(struct lc_node *n)
+{
+	struct can_frame cf;
+	struct lc_frame f;
+	ssize_t r;
+	int32_t num = 0;
+	uint32_t i;
+
+	for (;;) {
+		r = recv(n->fd, &cf, sizeof(cf), MSG_DONTWAIT);
+		if (r < 0)
+			return errno == EAGAIN || errno == EWOULDBLOCK ? num : -1;
+		if (r == 0)
+			return -1;
+		if (r != (ssize_t)sizeof(cf) || cf.can_id & CAN_EFF_FLAG)
+			continue;
+		f.id = cf.can_id & CAN_SFF_MASK;
+		f.dlc = cf.len;
+		f.l = f.h = 0;
+		for (i = 0; i < 4U; ++i) {
+			f.l |= (uint32_t)cf.data[i] << (8U * i);
+			f.h |= (uint32_t)cf.data[4U + i] << (8U * i);
+		}
+		lc_feed(n, &f);
+		++num;
+	}
+}
+//-----------------------------------------------------------------------------
+// Wait for frames of any node (up to timeout, -1 - forever), then all 
+// ready frames; return frames or -1 (node closed or error)
+int32_t 
+lc_poll(struct lc_node *n, uint32_t num, int32_t timeout_ms)
+{
+	struct pollfd p[LC_POLL_MAX];
+	uint32_t i;
+	int32_t r, all = 0;
+
+	if (num > LC_POLL_MAX)
+		num = LC_POLL_MAX;
+	for (i = 0; i < num; ++i) {
+		p[i].fd = n[i].fd;
+		p[i].events = POLLIN;
+		p[i].revents = 0;
+	}
+	if (poll(p, num, timeout_ms) < 0)
+		return errno == EINTR ? 0 : -1;
+	for (i = 0; i < num; ++i) {
+		if (!p[i].revents)
+			continue;
+		r = lc_recv(&n[i]);
+		if (r < 0)
+			return -1;
+		all += r;
+	}
+	return all;
+}
+//-----------------------------------------------------------------------------
+// Commands without answer yet
+uint32_t 
+lc_inflight(const struct lc_node *n)
+{
+	return n->sent - n->acked - n->superseded - n->rejected;
+}
+//=============================================================================
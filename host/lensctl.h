@@ -0,0 +1,72 @@
+//=============================================================================
+#ifndef LENSCTL_H
+#define LENSCTL_H
+//=============================================================================
+#include <stdint.h>
+//-----------------------------------------------------------------------------
+#include "decode.h"
+//-----------------------------------------------------------------------------
+#define LC_KEEP       0xFFFFFFFFU  // target is not changed by command
+#define LC_SEQ_NUM    256U         // sequence IDs of commands (8 bits)
+#define LC_WINDOW_MAX 128U         // commands in flight (acknowledge has 
+                                   // superseded up to 0xFF)
+//-----------------------------------------------------------------------------
+// Frame as on bus: l - bytes 0..3, h - bytes 4..7 (as TDLR / TDHR of node)
+struct lc_frame {
+	uint32_t id;
+	uint32_t dlc;
+	uint32_t l;
+	uint32_t h;
+};
+//-----------------------------------------------------------------------------
+// One node (IDs of can.h are fixed: one node per CAN interface); state is
+// from state answers (CAN_ID_CTRL) and events (CAN_ID_EVENT)
+struct lc_node {
+	int fd;
+	int pid;              // simulated node (lc_spawn()), 0 - none
+	// State
+	uint32_t pos;         // focus (ADC counts)
+	uint32_t target;
+	uint32_t pole;
+	uint32_t states;      // state answers
+	uint32_t events;
+	// Commands: sent = acked + superseded + rejected + in flight
+	uint32_t seq;         // sequence ID of last command
+	uint32_t sent;
+	uint32_t acked;       // applied (CAN_EV_ACK)
+	uint32_t superseded;  // never applied (count of CAN_EV_ACK)
+	uint32_t rejected;    // CAN_EV_REJECT
+	uint32_t moves;       // CAN_EV_FOCUS | CAN_EV_POLE of last acknowledge
+	uint32_t focus_done;  // CAN_EV_FOCUS_DONE of latest command
+	uint32_t pole_done;
+	uint32_t last_done;   // sequence ID + 1 of last end of move
+	uint64_t t_sent[LC_SEQ_NUM];  // ns (lc_now())
+	uint64_t lat_sum;     // command up to acknowledge (ns)
+	uint64_t lat_max;
+	// Service answer (CAN_ID_SRV)
+	uint32_t srv;         // answers
+	struct lc_frame srv_last;
+	// Position stream (CAN_ID_STREAM), samples to callback
+	struct decode stream;
+	void (*on_samples)(struct lc_node *n, const uint16_t *v, int32_t num,
+		uint64_t t_us);
+	void *user;
+};
+//-----------------------------------------------------------------------------
+uint64_t lc_now(void);
+int32_t lc_open(struct lc_node *n, const char *ifname);
+void lc_attach(struct lc_node *n, int fd);
+int32_t lc_spawn(struct lc_node *n, const char *path, const char *opt);
+void lc_close(struct lc_node *n);
+int32_t lc_send(struct lc_node *n, const struct lc_frame *f);
+int32_t lc_cmd(struct lc_node *n, uint32_t focus, uint32_t pole);
+int32_t lc_ctrl(struct lc_node *n);
+int32_t lc_srv(struct lc_node *n, uint32_t op, uint32_t a1, uint32_t a2,
+	uint32_t a3, uint32_t h);
+void lc_feed(struct lc_node *n, const struct lc_frame *f);
+int32_t lc_recv(struct lc_node *n);
+int32_t lc_poll(struct lc_node *n, uint32_t num, int32_t timeout_ms);
+uint32_t lc_inflight(const struct lc_node *n);
+//=============================================================================
+#endif // LENSCTL_H
+//=============================================================================
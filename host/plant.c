@@ -0,0 +1,300 @@
+//=============================================================================
+/*
+* Plant for host simulator (see sim.c)
+* modules:
+ - focus motor: GPIO A pin 0 ("MC3_N" - forward), pin 1 ("MC3_P" - back),
+   GPIO B pin 12 ("EN_3"); potentiometer on ADC 1 channel 13
+ - zoom and iris motors: "MC4_x", "EN_4", "MC5_x", "EN_5" and channels of
+   board.h (driven with BOARD_AXIS_NUM 3)
+ - pole motors: GPIO B pin 4, 5 ("MC1_x"), GPIO A pin 2, 3 ("MC2_x");
+   only time of pulse is observed (no position)
+ - temperature sensor and internal reference voltage: constant + noise
+* notes:
+ - speed: first order (tau_drive under drive, tau_coast without drive),
+   exact between changes of pins (plant_advance() before change); 
+   Coulomb friction per step of integration (PLANT_STEP_MS)
+ - gear lash: load follows motor with dead band of lash (centered at 
+   start); potentiometer reads motor
+*/
+//=============================================================================
+#include <math.h>
+//-----------------------------------------------------------------------------
+#include "sim.h"
+#include "plant.h"
+#include "board.h"
+//=============================================================================
+#define PLANT_STEP_MS   0.1   // max step of integration
+#define PLANT_TEMP      1750U
+#define PLANT_VREF      1655U
+#define PLANT_ADC_MAX   4095.0
+
+#define PLANT_POLE_A       ((0x1U << 2) | (0x1U << 3))
+#define PLANT_POLE_B       ((0x1U << 4) | (0x1U << 5))
+//-----------------------------------------------------------------------------
+// Pins and channel of motor (port: index of sim_getOdr())
+struct plant_pins {
+	uint32_t port;
+	uint32_t fwd;
+	uint32_t back;
+	uint32_t en_port;
+	uint32_t en;
+	uint32_t ch;
+};
+
+static const struct plant_pins pins[PLANT_MOTORS] = {
+	{ BOARD_MC3_PORT, BOARD_BS(BOARD_MC3_N), BOARD_BS(BOARD_MC3_P),
+		BOARD_EN3_PORT, BOARD_BS(BOARD_EN3), PLANT_CH_FOCUS },
+	{ BOARD_MC4_PORT, BOARD_BS(BOARD_MC4_P), BOARD_BS(BOARD_MC4_N),
+		BOARD_EN4_PORT, BOARD_BS(BOARD_EN4), BOARD_POT4_CH },
+	{ BOARD_MC5_PORT, BOARD_BS(BOARD_MC5_P), BOARD_BS(BOARD_MC5_N),
+		BOARD_EN5_PORT, BOARD_BS(BOARD_EN5), BOARD_POT5_CH },
+};
+//=============================================================================
+static struct {
+	struct plant_param par;
+	double pos;
+	double speed;        // counts per ms
+	double load;         // behind gear lash
+	uint32_t rnd;
+} mot[PLANT_MOTORS];
+static uint32_t mot_num;
+static uint64_t t_last;
+static uint32_t rnd;     // temperature sensor, internal reference
+static uint32_t pole_on;
+static uint64_t pole_t;
+static uint32_t pulses;
+static uint64_t pulse_max;
+//=============================================================================
+// p - n motors (focus first)
+void 
+plant_init(const struct plant_param *p, uint32_t n)
+{
+	uint32_t m;
+
+	mot_num = n < PLANT_MOTORS ? n : PLANT_MOTORS;
+	for (m = 0; m < mot_num; ++m) {
+		mot[m].par = p[m];
+		mot[m].pos = p[m].pos;
+		mot[m].speed = 0;
+		mot[m].load = p[m].pos;
+		mot[m].rnd = p[m].seed;
+	}
+	t_last = 0;
+	rnd = p[0].seed ^ 0x5A5AU;
+	pole_on = 0;
+	pole_t = 0;
+	pulses = 0;
+	pulse_max = 0;
+}
+//-----------------------------------------------------------------------------
+// Drive of motor m from pins: 1 - forward, -1 - back, 0 - coast
+static int32_t 
+plant_drive(uint32_t m)
+{
+	const struct plant_pins *p = &pins[m];
+	uint32_t mc = sim_getOdr(p->port);
+
+	if (!(sim_getOdr(p->en_port) & p->en))
+		return 0;
+	if ((mc & p->fwd) && !(mc & p->back))
+		return 1;
+	if ((mc & p->back) && !(mc & p->fwd))
+		return -1;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+static void 
+plant_move(uint32_t m, double dt)
+{
+	const struct plant_param *par = &mot[m].par;
+	double k, v_end, tau, f, h2 = par->lash / 2.0;
+	int32_t u = plant_drive(m);
+
+	v_end = u * par->speed;
+	tau = u ? par->tau_drive : par->tau_coast;
+
+	while (dt > 0) {
+		double h = dt > PLANT_STEP_MS ? PLANT_STEP_MS : dt;
+
+		k = exp(-h / tau);
+		// Exact distance for first order speed
+		mot[m].pos += v_end * h + (mot[m].speed - v_end) * tau * (1.0 - k);
+		mot[m].speed = v_end + (mot[m].speed - v_end) * k;
+		// Friction: speed toward 0 (not past it)
+		f = par->friction * h;
+		if (f > fabs(mot[m].speed))
+			f = fabs(mot[m].speed);
+		if (mot[m].speed < 0)
+			f = -f;
+		mot[m].pos -= f * h / 2.0;
+		mot[m].speed -= f;
+		if (mot[m].pos < par->stop_lo) {
+			mot[m].pos = par->stop_lo;
+			mot[m].speed = 0;
+		} else if (mot[m].pos > par->stop_hi) {
+			mot[m].pos = par->stop_hi;
+			mot[m].speed = 0;
+		}
+		if (mot[m].pos - mot[m].load > h2)
+			mot[m].load = mot[m].pos - h2;
+		else if (mot[m].load - mot[m].pos > h2)
+			mot[m].load = mot[m].pos + h2;
+		dt -= h;
+	}
+}
+//-----------------------------------------------------------------------------
+void 
+plant_advance(uint64_t t)
+{
+	double dt;
+	uint32_t m;
+
+	if (t <= t_last)
+		return;
+	dt = (double)(t - t_last) / SIM_CYCLES_MS;
+	t_last = t;
+
+	for (m = 0; m < mot_num; ++m)
+		plant_move(m, dt);
+}
+//-----------------------------------------------------------------------------
+// After change of pins (time of pole pulses)
+void 
+plant_gpio(uint64_t t)
+{
+	uint32_t on = (sim_getOdr(0) & PLANT_POLE_A) ||
+		(sim_getOdr(1) & PLANT_POLE_B);
+
+	if (on && !pole_on) {
+		pole_t = t;
+	} else if (!on && pole_on) {
+		++pulses;
+		if (t - pole_t > pulse_max)
+			pulse_max = t - pole_t;
+	}
+	pole_on = on;
+}
+//=============================================================================
+// Uniform noise in [-noise, noise] of generator r
+static double 
+plant_noise(uint32_t *r, double noise)
+{
+	*r = *r * 1664525U + 1013904223U;
+	return noise * ((double)(*r >> 8) / (double)(1U << 23) - 1.0);
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+plant_adc(uint32_t ch)
+{
+	double v;
+	uint32_t m;
+
+	for (m = 0; m < mot_num && pins[m].ch != ch; ++m)
+		;
+	if (m < mot_num) {
+		plant_advance(sim_now());
+		v = mot[m].pos + plant_noise(&mot[m].rnd, mot[m].par.noise);
+	} else if (ch == PLANT_CH_TEMP) {
+		v = PLANT_TEMP + plant_noise(&rnd, mot[0].par.noise);
+	} else if (ch == PLANT_CH_VREF) {
+		v = PLANT_VREF + plant_noise(&rnd, mot[0].par.noise);
+	} else {
+		return 0;
+	}
+	v = floor(v + 0.5);
+	if (v < 0)
+		v = 0;
+	if (v > PLANT_ADC_MAX)
+		v = PLANT_ADC_MAX;
+	return (uint32_t)v;
+}
+//=============================================================================
+// All motors
+void 
+plant_setNoise(double noise)
+{
+	uint32_t m;
+
+	for (m = 0; m < mot_num; ++m)
+		mot[m].par.noise = noise;
+}
+//-----------------------------------------------------------------------------
+// Parameters of motor m (position and speed go on: pos of p is not used)
+void 
+plant_setParam(uint32_t m, const struct plant_param *p)
+{
+	if (m >= mot_num)
+		return;
+	plant_advance(sim_now());
+	mot[m].par = *p;
+	mot[m].rnd = p->seed;
+}
+//-----------------------------------------------------------------------------
+// Focus
+double 
+plant_getPos(void)
+{
+	plant_advance(sim_now());
+	return mot[0].pos;
+}
+//-----------------------------------------------------------------------------
+double 
+plant_getSpeed(void)
+{
+	plant_advance(sim_now());
+	return mot[0].speed;
+}
+//-----------------------------------------------------------------------------
+// Lens of focus (behind gear lash)
+double 
+plant_getLens(void)
+{
+	plant_advance(sim_now());
+	return mot[0].load;
+}
+//-----------------------------------------------------------------------------
+// Motor m (PLANT_MOTORS order)
+double 
+plant_getAxis(uint32_t m)
+{
+	plant_advance(sim_now());
+	return m < mot_num ? mot[m].pos : 0;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+plant_getPulses(void)
+{
+	return pulses;
+}
+//-----------------------------------------------------------------------------
+// Longest pole pulse (cycles)
+uint64_t 
+plant_getPulseMax(void)
+{
+	return pulse_max;
+}
+//=============================================================================
+// Warm reset of firmware (see sim_save()): motors go on in new process
+int32_t 
+plant_save(int fd)
+{
+	plant_advance(sim_now());
+	if (sim_pipe(fd, mot, sizeof(mot), 1U) ||
+		sim_pipe(fd, &mot_num, sizeof(mot_num), 1U) ||
+		sim_pipe(fd, &t_last, sizeof(t_last), 1U) ||
+		sim_pipe(fd, &rnd, sizeof(rnd), 1U))
+		return -1;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+int32_t 
+plant_load(int fd)
+{
+	if (sim_pipe(fd, mot, sizeof(mot), 0) ||
+		sim_pipe(fd, &mot_num, sizeof(mot_num), 0) ||
+		sim_pipe(fd, &t_last, sizeof(t_last), 0) ||
+		sim_pipe(fd, &rnd, sizeof(rnd), 0))
+		return -1;
+	return 0;
+}
+//=============================================================================
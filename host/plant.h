@@ -0,0 +1,46 @@
+//=============================================================================
+#ifndef PLANT_H
+#define PLANT_H
+//=============================================================================
+#include <stdint.h>
+//-----------------------------------------------------------------------------
+// ADC channels of plant (see focus.c)
+#define PLANT_CH_FOCUS  13U
+#define PLANT_CH_TEMP   16U
+#define PLANT_CH_VREF   18U
+//-----------------------------------------------------------------------------
+// Motors: focus, zoom, iris (axis_desc[] order, see axis.c)
+#define PLANT_MOTORS    3U
+//-----------------------------------------------------------------------------
+// Motor: DC motor with first order speed, end stops and ADC noise; gear 
+// lash between potentiometer (motor) and load (lens of focus)
+struct plant_param {
+	double pos;        // start position (ADC counts)
+	double speed;      // counts per ms at full drive
+	double tau_drive;  // ms (speed up under drive)
+	double tau_coast;  // ms (slow down without drive)
+	double stop_lo;    // end stops (ADC counts)
+	double stop_hi;
+	double noise;      // ADC noise amplitude (counts, uniform)
+	uint32_t seed;
+	double lash;       // counts (0 - none)
+	double friction;   // Coulomb: counts per ms^2 against motion (0 - none)
+};
+//-----------------------------------------------------------------------------
+void plant_init(const struct plant_param *p, uint32_t n);
+void plant_advance(uint64_t t);
+void plant_gpio(uint64_t t);
+uint32_t plant_adc(uint32_t ch);
+void plant_setNoise(double noise);
+void plant_setParam(uint32_t m, const struct plant_param *p);
+double plant_getPos(void);
+double plant_getSpeed(void);
+double plant_getLens(void);
+double plant_getAxis(uint32_t m);
+uint32_t plant_getPulses(void);
+uint64_t plant_getPulseMax(void);
+int32_t plant_save(int fd);
+int32_t plant_load(int fd);
+//=============================================================================
+#endif // PLANT_H
+//=============================================================================
@@ -0,0 +1,1663 @@
+//=============================================================================
+/*
+* Host simulator of STM32F302x8 peripherals (for bench.c)
+* modules:
+ - RCC, GPIO A/B/C/F, DMA 1 Channel 1, ADC 1, TIM 2/6/7, CAN, FLASH, DWT,
+   NVIC (priority grouping, preemption, PRIMASK), RTC backup registers
+* notes:
+ - time in cycles of HCLK; each access to peripheral costs
+   SIM_ACCESS_CYCLES, exception entry/exit SIM_ENTRY_CYCLES, code between
+   accesses costs nothing => cycles are for comparison between builds, not
+   equal to hardware
+ - peripheral macro (see stm32f302x8.h) calls sim_sync() before access:
+   1. writes of previous access are applied (compare with copy after last
+      access => write of the same value is not visible)
+   2. time goes on, events of peripherals in time order
+   3. pending interrupts are taken (preemption only at access)
+ - w1c registers written by '=' (ADC ISR, FLASH SR, CAN TSR) have marker
+   in reserved bit (SIM_MARK_x): write without marker => clear flags
+ - CAN: one bus for RX (from bench) and TX (from firmware), bit time from
+   BTR; frame length with worst case of stuff bits
+ - CAN filters: FIFO of bank from FFA1R; frame matching several banks goes
+   to bank with priority (32-bit scale, then list mode, then lower number)
+ - CAN errors (sim_canError()): failed attempt takes time of frame; TEC +8
+   on error, -1 on success; bus-off over 255, recovery after 128 x 11 bits
+   (ABOM only); REC is not modeled
+ - CAN rate of other nodes (sim_canRate()): frame at other rate than BTR
+   is not received (LEC - stuff error); TX at other rate is not checked
+ - FLASH: mapped at FLASH_BASE (mmap); erase and programming stall CPU
+   (events go on, interrupts are taken after)
+ - Stop mode (WFI with SLEEPDEEP): firmware stops peripherals before;
+   wake-up by EXTI line 8 (GPIO B pin 8 - CAN RX, falling edge) at SOF
+   of next frame + SIM_WUSTOP_CYCLES, this frame is lost; SYSCLK is HSI
+   after it (code is not slower), DWT does not count in Stop mode;
+   without frame WFI returns after SIM_STOP_STEP (still in Stop mode)
+ - TIM: ARR (ARPE) and CCR2 (OC2PE) preload, shadow is loaded at update 
+   event (not with UDIS) or UG; PSC is always preloaded
+ - ISR time (sim_getIsr()): cycles from entry of first interrupt to exit 
+   of last one (nested included once)
+ - reset: sim_init() is power-on (RCC CSR: PORRSTF, backup registers 
+   cleared); warm reset is new process of bench with sim_load() of state 
+   that survives system reset (time, flash, backup registers), other 
+   peripherals have reset values; backup registers are written with DBP 
+   (PWR) only
+*/
+//=============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+//-----------------------------------------------------------------------------
+#include "sim.h"
+#include "plant.h"
+//=============================================================================
+#define SIM_MARK_ADC_ISR   (0x1U << 31)
+#define SIM_MARK_FLASH_SR  (0x1U << 1)
+#define SIM_MARK_CAN_TSR   ((0x1U << 4) | (0x1U << 12) | (0x1U << 20))
+#define SIM_MARK_CAN_MSR   (0x1U << 31)
+#define SIM_MARK_EXTI_PR   (0x1U << 31)
+
+#define SIM_FLASH_SIZE     0x10000U
+#define SIM_ERASE_CYCLES   (20U * SIM_CYCLES_MS)
+#define SIM_PROG_CYCLES    (40U * SIM_CYCLES_US)
+
+#define SIM_STOP_STEP      SIM_CYCLES_MS
+#define SIM_WUSTOP_CYCLES  (6U * SIM_CYCLES_US)
+
+#define SIM_CAN_FIFO       3U
+#define SIM_CAN_QUEUE      SIM_LOG_SIZE
+#define SIM_IRQ_NUM        64U
+#define SIM_THREAD         16U  // execution priority of thread mode
+#define SIM_NONE           0xFFFFFFFFU
+//-----------------------------------------------------------------------------
+// Interrupts with model (see irq_pending())
+static const uint32_t sim_irq[] = {
+	DMA1_Channel1_IRQn, ADC1_IRQn, USB_HP_CAN_TX_IRQn, USB_LP_CAN_RX0_IRQn,
+	CAN_RX1_IRQn, CAN_SCE_IRQn, EXTI9_5_IRQn, EXTI15_10_IRQn, TIM6_DAC_IRQn,
+	TIM7_IRQn
+};
+#define SIM_IRQ_MODEL  (sizeof(sim_irq) / sizeof(sim_irq[0]))
+//=============================================================================
+// Interrupt handlers of firmware (weak - not all are used)
+void NMI_Handler(void) __attribute__((weak));
+void DMA1_Channel1_IRQHandler(void) __attribute__((weak));
+void ADC1_IRQHandler(void) __attribute__((weak));
+void USB_HP_CAN_TX_IRQHandler(void) __attribute__((weak));
+void USB_LP_CAN_RX0_IRQHandler(void) __attribute__((weak));
+void CAN_RX1_IRQHandler(void) __attribute__((weak));
+void CAN_SCE_IRQHandler(void) __attribute__((weak));
+void EXTI9_5_IRQHandler(void) __attribute__((weak));
+void EXTI15_10_IRQHandler(void) __attribute__((weak));
+void TIM6_DAC_IRQHandler(void) __attribute__((weak));
+void TIM7_IRQHandler(void) __attribute__((weak));
+//=============================================================================
+struct sim_tim {
+	TIM_TypeDef r;       // visible for firmware
+	TIM_TypeDef last;    // copy after last access
+	uint32_t psc;        // active prescaler (preloaded)
+	uint32_t arr;        // active ARR, CCR2 (shadow, see ARPE and OC2PE)
+	uint32_t ccr2;
+	uint32_t run;
+	uint32_t cnt0;       // CNT at t0
+	uint64_t t0;
+	uint64_t t_upd;      // next update event
+	uint64_t t_cc2;      // next compare 2 event
+	uint32_t oc2;        // OC2REF
+	uint32_t top;        // max of counter (16 or 32 bit)
+};
+//-----------------------------------------------------------------------------
+uint32_t SystemCoreClock = SIM_HCLK_HZ;
+//-----------------------------------------------------------------------------
+static uint64_t now;
+static uint32_t primask;
+static uint32_t act_pre[SIM_IRQ_NUM];  // stack of active preemption prio
+static uint32_t act_num;
+static uint64_t isr_cycles;           // in handlers (see dispatch())
+static uint32_t nvic_en[SIM_IRQ_NUM];
+static uint32_t nvic_prio[SIM_IRQ_NUM];
+static uint32_t nvic_group;
+
+static RCC_TypeDef rcc;
+static GPIO_TypeDef gpio[6], gpio_last[6];
+static DMA_TypeDef dma1;
+static DMA_Channel_TypeDef dma1_ch1, dma1_ch1_last;
+static uint32_t dma_n;        // CNDTR at enable (for circular reload)
+static ADC_TypeDef adc1, adc1_last;
+static ADC_Common_TypeDef adc1_common;
+static uint32_t adc_seq;      // conversion in sequence or SIM_NONE
+static uint64_t adc_eoc;      // end of conversion
+static uint64_t adc_trig_t;   // trigger of sequence in conversion
+static uint64_t frame_t;      // trigger of last sequence with DMA TC
+static uint32_t adc_unread;   // DR is not read (without DMA)
+static uint32_t adc_dma_stop; // DMA requests stop after overrun
+static struct sim_tim tim[8];
+static CAN_TypeDef can, can_last;
+static struct sim_frame can_fifo[2][SIM_CAN_FIFO];
+static uint32_t can_fmp[2];
+static struct sim_frame can_mb[3];    // frame in TX mailbox
+static uint64_t can_tx_t[3];         // end of TX frame
+static uint64_t can_bus;             // bus is free after
+static struct sim_frame can_q[SIM_CAN_QUEUE];  // from bench (t - request)
+static uint32_t can_q_num, can_q_head;
+static uint64_t can_rx_t;            // end of RX frame (head of queue)
+static uint32_t can_abort[3];        // ABRQ during attempt
+static uint32_t can_errN, can_arbN;  // next attempts: error, arbitration
+static uint32_t can_tec;
+static uint64_t can_boff_t;          // end of bus-off
+static uint32_t can_lec;             // last error code (ESR)
+static uint32_t can_bps;             // rate of other nodes (0 - as BTR)
+static uint32_t can_rxLost;          // frame on bus at wake-up
+static struct sim_frame rx_log[SIM_LOG_SIZE], tx_log[SIM_LOG_SIZE];
+static uint32_t rx_num, tx_num, dropped;
+static uint64_t bus_cycles;           // frames on bus (see sim_getBus())
+static USART_TypeDef usart2;
+static FLASH_TypeDef flash, flash_last;
+static uint32_t flash_key;
+static uint16_t *flash_mem;
+static uint16_t flash_copy[SIM_FLASH_SIZE / 2U];
+static PWR_TypeDef pwr;
+static RTC_TypeDef rtc, rtc_last;
+static uint32_t stop;                // in Stop mode (up to wake-up)
+static uint64_t stop_t;              // entry in Stop mode
+static uint64_t stop_cycles;         // all time in Stop mode
+static uint64_t wake_t;              // SOF of last wake-up
+static EXTI_TypeDef exti, exti_last;
+static SYSCFG_TypeDef syscfg;
+static SCB_Type scb;
+static DWT_Type dwt, dwt_last;
+static uint64_t dwt_base;
+static CoreDebug_Type coredebug;
+//=============================================================================
+static void advance(uint64_t t);
+static uint64_t next_event(void);
+static void dispatch(void);
+static void apply(void);
+static void refresh(void);
+//=============================================================================
+// Reset values of registers (only used by firmware)
+void 
+sim_init(void)
+{
+	uint32_t i;
+
+	if (!flash_mem) {
+		flash_mem = mmap((void *)(uintptr_t)FLASH_BASE, SIM_FLASH_SIZE,
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+		if (flash_mem != (void *)(uintptr_t)FLASH_BASE) {
+			fprintf(stderr, "sim: flash is not mapped at 0x%08X\n",
+				FLASH_BASE);
+			exit(2);
+		}
+		memset(flash_mem, 0xFF, SIM_FLASH_SIZE);
+	}
+	memcpy(flash_copy, flash_mem, SIM_FLASH_SIZE);
+
+	now = 0;
+	primask = 0;
+	act_num = 0;
+	isr_cycles = 0;
+	nvic_group = 0;
+	memset(nvic_en, 0, sizeof(nvic_en));
+	memset(nvic_prio, 0, sizeof(nvic_prio));
+
+	memset(&rcc, 0, sizeof(rcc));
+	rcc.CR = RCC_CR_HSION | RCC_CR_HSIRDY;
+	rcc.CSR = RCC_CSR_PORRSTF | RCC_CSR_PINRSTF;
+	memset(gpio, 0, sizeof(gpio));
+	gpio[0].MODER = 0xA8000000U;  // PA 13, 14, 15 - SWD
+	gpio[1].MODER = 0x00000280U;  // PB 3, 4 - JTAG
+	gpio[1].PUPDR = 0x00000100U;
+	gpio[1].OSPEEDR = 0x000000C0U;
+	memcpy(gpio_last, gpio, sizeof(gpio));
+
+	memset(&dma1, 0, sizeof(dma1));
+	memset(&dma1_ch1, 0, sizeof(dma1_ch1));
+	dma1_ch1_last = dma1_ch1;
+	dma_n = 0;
+
+	memset(&adc1, 0, sizeof(adc1));
+	adc1.CR = ADC_CR_ADVREGEN_1;
+	adc1_last = adc1;
+	memset(&adc1_common, 0, sizeof(adc1_common));
+	adc_seq = SIM_NONE;
+	adc_eoc = SIM_NEVER;
+	adc_unread = 0;
+	adc_dma_stop = 0;
+	adc_trig_t = 0;
+	frame_t = 0;
+
+	memset(tim, 0, sizeof(tim));
+	for (i = 0; i < 8U; ++i) {
+		tim[i].r.ARR = i == 2U ? 0xFFFFFFFFU : 0xFFFFU;
+		tim[i].last = tim[i].r;
+		tim[i].top = tim[i].r.ARR;
+		tim[i].arr = tim[i].r.ARR;
+		tim[i].t_upd = SIM_NEVER;
+		tim[i].t_cc2 = SIM_NEVER;
+	}
+
+	memset(&can, 0, sizeof(can));
+	can.MCR = CAN_MCR_SLEEP | CAN_MCR_DBF;
+	can.MSR = CAN_MSR_SLAK;
+	can.TSR = CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2;
+	can.BTR = 0x01230000U;
+	can.FMR = CAN_FMR_FINIT;
+	can_last = can;
+	can_fmp[0] = 0;
+	can_fmp[1] = 0;
+	for (i = 0; i < 3U; ++i)
+		can_tx_t[i] = SIM_NEVER;
+	can_bus = 0;
+	can_q_num = 0;
+	can_q_head = 0;
+	can_rx_t = SIM_NEVER;
+	memset(can_abort, 0, sizeof(can_abort));
+	can_errN = 0;
+	can_arbN = 0;
+	can_tec = 0;
+	can_boff_t = SIM_NEVER;
+	can_lec = 0;
+	can_bps = 0;
+	can_rxLost = 0;
+	rx_num = 0;
+	tx_num = 0;
+	dropped = 0;
+	bus_cycles = 0;
+
+	memset(&usart2, 0, sizeof(usart2));
+	usart2.ISR = USART_ISR_TXE;
+	memset(&flash, 0, sizeof(flash));
+	flash.CR = FLASH_CR_LOCK;
+	flash_last = flash;
+	flash_key = 0;
+	memset(&pwr, 0, sizeof(pwr));
+	memset(&rtc, 0, sizeof(rtc));
+	rtc_last = rtc;
+	stop = 0;
+	stop_t = 0;
+	stop_cycles = 0;
+	wake_t = SIM_NEVER;
+	memset(&exti, 0, sizeof(exti));
+	exti_last = exti;
+	memset(&syscfg, 0, sizeof(syscfg));
+	memset(&scb, 0, sizeof(scb));
+	memset(&dwt, 0, sizeof(dwt));
+	dwt_last = dwt;
+	dwt_base = 0;
+	memset(&coredebug, 0, sizeof(coredebug));
+
+	refresh();
+}
+//-----------------------------------------------------------------------------
+uint64_t 
+sim_now(void)
+{
+	return now;
+}
+//-----------------------------------------------------------------------------
+// Before each access to peripheral
+void 
+sim_sync(void)
+{
+	apply();
+	advance(now + SIM_ACCESS_CYCLES);
+	dispatch();
+}
+//-----------------------------------------------------------------------------
+// Code without access to peripheral (e.g. pass of main loop); interrupts
+// are taken in time of event
+void 
+sim_idle(uint32_t cycles)
+{
+	uint64_t end = now + cycles;
+	uint64_t t;
+
+	apply();
+	for (;;) {
+		dispatch();
+		if (now >= end)
+			break;
+		t = next_event();
+		advance(t < end ? t : end);
+	}
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+sim_getOdr(uint32_t port)
+{
+	return gpio[port].ODR;
+}
+//=============================================================================
+// Peripherals
+RCC_TypeDef *sim_rcc(void) { sim_sync(); return &rcc; }
+GPIO_TypeDef *sim_gpio(uint32_t port) { sim_sync(); return &gpio[port]; }
+DMA_TypeDef *sim_dma1(void) { sim_sync(); return &dma1; }
+DMA_Channel_TypeDef *sim_dma1_ch1(void) { sim_sync(); return &dma1_ch1; }
+ADC_TypeDef *sim_adc1(void) { sim_sync(); return &adc1; }
+ADC_Common_TypeDef *sim_adc1_common(void) { sim_sync(); return &adc1_common; }
+TIM_TypeDef *sim_tim(uint32_t n) { sim_sync(); return &tim[n].r; }
+CAN_TypeDef *sim_can(void) { sim_sync(); return &can; }
+USART_TypeDef *sim_usart2(void) { sim_sync(); return &usart2; }
+FLASH_TypeDef *sim_flash(void) { sim_sync(); return &flash; }
+PWR_TypeDef *sim_pwr(void) { sim_sync(); return &pwr; }
+RTC_TypeDef *sim_rtc(void) { sim_sync(); return &rtc; }
+EXTI_TypeDef *sim_exti(void) { sim_sync(); return &exti; }
+SYSCFG_TypeDef *sim_syscfg(void) { sim_sync(); return &syscfg; }
+SCB_Type *sim_scb(void) { sim_sync(); return &scb; }
+DWT_Type *sim_dwt(void) { sim_sync(); return &dwt; }
+CoreDebug_Type *sim_coredebug(void) { sim_sync(); return &coredebug; }
+//=============================================================================
+// Timers (up-counting; TIM 2 compare 2 toggles OC2REF for ADC 1 trigger)
+static uint32_t 
+tim_cnt(struct sim_tim *t)
+{
+	if (!t->run)
+		return t->cnt0;
+	return t->cnt0 + (uint32_t)((now - t->t0) / (t->psc + 1U));
+}
+//-----------------------------------------------------------------------------
+// New start point of counter (after write of CNT, ARR, CCR2, CEN, UG)
+static void 
+tim_rebase(struct sim_tim *t, uint32_t n, uint32_t cnt)
+{
+	uint64_t tick = t->psc + 1U;
+	uint32_t arr = t->arr;
+	uint32_t end = cnt <= arr ? arr : t->top;
+
+	t->cnt0 = cnt;
+	t->t0 = now;
+	t->t_upd = SIM_NEVER;
+	t->t_cc2 = SIM_NEVER;
+	if (!t->run)
+		return;
+	t->t_upd = now + (uint64_t)(end - cnt + 1U) * tick;
+	if (n == 2U && t->ccr2 <= arr) {
+		if (t->ccr2 > cnt)
+			t->t_cc2 = now + (uint64_t)(t->ccr2 - cnt) * tick;
+		else
+			t->t_cc2 = t->t_upd + (uint64_t)t->ccr2 * tick;
+	}
+}
+//-----------------------------------------------------------------------------
+static void adc_trigger(void);
+//-----------------------------------------------------------------------------
+static void 
+tim_event(uint32_t n)
+{
+	struct sim_tim *t = &tim[n];
+	uint32_t m, ext;
+
+	if (now == t->t_cc2) {
+		t->r.SR |= TIM_SR_CC2IF;
+		t->t_cc2 += (uint64_t)(t->arr + 1U) * (t->psc + 1U);
+		// OC2M = 011 - toggle
+		m = (t->r.CCMR1 & TIM_CCMR1_OC2M_Msk) >> TIM_CCMR1_OC2M_Pos;
+		if (m == 3U)
+			t->oc2 ^= 1U;
+		// ADC 1 external trigger EXT3 (TIM2_CC2): EXTEN edges of OC2REF
+		ext = (adc1.CFGR & ADC_CFGR_EXTEN_Msk) >> ADC_CFGR_EXTEN_Pos;
+		if (n == 2U && (t->r.CCER & TIM_CCER_CC2E) &&
+			(adc1.CFGR & ADC_CFGR_EXTSEL_Msk) >> ADC_CFGR_EXTSEL_Pos == 3U &&
+			(ext == 3U || (ext == 1U && t->oc2) || (ext == 2U && !t->oc2)))
+			adc_trigger();
+	}
+	if (now == t->t_upd) {
+		// UDIS: counter restarts, shadow registers are not loaded
+		if (!(t->r.CR1 & TIM_CR1_UDIS)) {
+			t->r.SR |= TIM_SR_UIF;
+			t->psc = t->r.PSC;
+			t->arr = t->r.ARR;
+			t->ccr2 = t->r.CCR2;
+		}
+		if (t->r.CR1 & TIM_CR1_OPM) {
+			t->r.CR1 &= ~TIM_CR1_CEN;
+			t->run = 0;
+		}
+		tim_rebase(t, n, 0);
+	}
+}
+//-----------------------------------------------------------------------------
+static void 
+tim_apply(uint32_t n)
+{
+	struct sim_tim *t = &tim[n];
+	TIM_TypeDef *r = &t->r, *l = &t->last;
+	uint32_t cnt = tim_cnt(t);
+	uint32_t arr = t->arr, ccr2 = t->ccr2;
+
+	// SR: rc_w0
+	r->SR &= l->SR;
+
+	// Without preload: shadow is written at once
+	if (!(r->CR1 & TIM_CR1_ARPE))
+		t->arr = r->ARR;
+	if (!(r->CCMR1 & TIM_CCMR1_OC2PE))
+		t->ccr2 = r->CCR2;
+
+	if ((r->CR1 ^ l->CR1) & TIM_CR1_CEN) {
+		t->run = r->CR1 & TIM_CR1_CEN;
+		tim_rebase(t, n, r->CNT != l->CNT ? r->CNT : cnt);
+	} else if (r->EGR & TIM_EGR_UG) {
+		t->psc = r->PSC;
+		t->arr = r->ARR;
+		t->ccr2 = r->CCR2;
+		if (!(r->CR1 & TIM_CR1_URS))
+			r->SR |= TIM_SR_UIF;
+		tim_rebase(t, n, 0);
+	} else if (r->CNT != l->CNT) {
+		tim_rebase(t, n, r->CNT);
+	} else if (t->arr != arr || t->ccr2 != ccr2) {
+		tim_rebase(t, n, cnt);
+	}
+	r->EGR = 0;
+}
+//=============================================================================
+// ADC 1 (regular sequence SQR1..SQR4, sampling time SMPR1/2)
+static uint32_t 
+adc_ch(uint32_t i)
+{
+	const __IO uint32_t *sqr[] = { &adc1.SQR1, &adc1.SQR2, &adc1.SQR3,
+		&adc1.SQR4 };
+	uint32_t pos = i + 1U;
+
+	return *sqr[pos / 5U] >> (6U * (pos % 5U)) & 0x1FU;
+}
+//-----------------------------------------------------------------------------
+// Conversion time (cycles of HCLK) for channel
+static uint64_t 
+adc_time(uint32_t ch)
+{
+	// Sampling time + 12.5 in half of ADC clock cycles
+	static const uint32_t smp2[] = { 3, 5, 9, 15, 39, 123, 363, 1203 };
+	uint32_t smp, div;
+
+	if (ch < 10U)
+		smp = adc1.SMPR1 >> (3U * ch) & 7U;
+	else
+		smp = adc1.SMPR2 >> (3U * (ch - 10U)) & 7U;
+	// CKMODE: 01 - HCLK, 10 - HCLK / 2, 11 - HCLK / 4 (00 - as HCLK)
+	div = (adc1_common.CCR & (ADC1_CCR_CKMODE_0 | ADC1_CCR_CKMODE_1)) >> 16;
+	div = div == 3U ? 4U : (div == 2U ? 2U : 1U);
+	return (uint64_t)(smp2[smp] + 25U) * div / 2U;
+}
+//-----------------------------------------------------------------------------
+static void 
+adc_trigger(void)
+{
+	if (!(adc1.CR & ADC_CR_ADEN) || !(adc1.CR & ADC_CR_ADSTART) ||
+		adc_seq != SIM_NONE)
+		return;
+	adc_seq = 0;
+	adc_eoc = now + adc_time(adc_ch(0));
+	adc_trig_t = now;
+}
+//-----------------------------------------------------------------------------
+static void 
+dma_request(uint32_t v)
+{
+	uint32_t msize, addr;
+
+	if (!(dma1_ch1.CCR & DMA_CCR_EN) || dma1_ch1.CNDTR == 0)
+		return;
+	msize = 1U << ((dma1_ch1.CCR & DMA_CCR_MSIZE_Msk) >> DMA_CCR_MSIZE_Pos);
+	addr = dma1_ch1.CMAR;
+	if (dma1_ch1.CCR & DMA_CCR_MINC)
+		addr += (dma_n - dma1_ch1.CNDTR) * msize;
+	if (msize == 4U)
+		*(volatile uint32_t *)(uintptr_t)addr = v;
+	else if (msize == 2U)
+		*(volatile uint16_t *)(uintptr_t)addr = (uint16_t)v;
+	else
+		*(volatile uint8_t *)(uintptr_t)addr = (uint8_t)v;
+
+	if (--dma1_ch1.CNDTR == dma_n / 2U)
+		dma1.ISR |= DMA_ISR_HTIF1 | DMA_ISR_GIF1;
+	if (dma1_ch1.CNDTR == 0) {
+		dma1.ISR |= DMA_ISR_TCIF1 | DMA_ISR_GIF1;
+		frame_t = adc_trig_t;
+		if (dma1_ch1.CCR & DMA_CCR_CIRC)
+			dma1_ch1.CNDTR = dma_n;
+	}
+}
+//-----------------------------------------------------------------------------
+static void 
+adc_event(void)
+{
+	uint32_t len = (adc1.SQR1 & ADC_SQR1_L_Msk) >> ADC_SQR1_L_Pos;
+
+	adc1.DR = plant_adc(adc_ch(adc_seq));
+	adc1.ISR |= ADC_ISR_EOC;
+	if (adc_seq == len)
+		adc1.ISR |= ADC_ISR_EOS;
+
+	if ((adc1.CFGR & ADC_CFGR_DMAEN) && !adc_dma_stop &&
+		(dma1_ch1.CCR & DMA_CCR_EN)) {
+		// DMA reads DR (clears EOC)
+		adc1.ISR &= ~ADC_ISR_EOC;
+		dma_request(adc1.DR);
+		adc_unread = 0;
+	} else if (adc_unread) {
+		adc1.ISR |= ADC_ISR_OVR;
+		adc_dma_stop = 1;
+	} else {
+		adc_unread = 1;
+	}
+
+	if (adc_seq < len) {
+		++adc_seq;
+		adc_eoc = now + adc_time(adc_ch(adc_seq));
+	} else {
+		adc_seq = SIM_NONE;
+		adc_eoc = SIM_NEVER;
+	}
+}
+//-----------------------------------------------------------------------------
+static void 
+adc_apply(void)
+{
+	ADC_TypeDef *r = &adc1, *l = &adc1_last;
+
+	// ISR: w1c by '=' (without marker)
+	if (!(r->ISR & SIM_MARK_ADC_ISR))
+		r->ISR = l->ISR & ~r->ISR;
+	r->ISR &= ~SIM_MARK_ADC_ISR;
+
+	if (r->CR & ADC_CR_ADCAL) {
+		r->CR &= ~ADC_CR_ADCAL;
+		r->CALFACT = 0x3FU;
+	}
+	if (r->CR & ADC_CR_ADDIS)
+		r->CR &= ~(ADC_CR_ADDIS | ADC_CR_ADEN);
+	if ((r->CR & ADC_CR_ADEN) && !(l->CR & ADC_CR_ADEN))
+		r->ISR |= ADC_ISR_ADRDY;
+	if (r->CR & ADC_CR_ADSTP) {
+		r->CR &= ~(ADC_CR_ADSTP | ADC_CR_ADSTART);
+		adc_seq = SIM_NONE;
+		adc_eoc = SIM_NEVER;
+	}
+	if ((r->CR & ADC_CR_ADSTART) && !(l->CR & ADC_CR_ADSTART)) {
+		adc_dma_stop = 0;
+		adc_unread = 0;
+	}
+	// Read of DR is not visible => DMA only
+}
+//=============================================================================
+// DMA 1 Channel 1
+static void 
+dma_apply(void)
+{
+	DMA_Channel_TypeDef *r = &dma1_ch1, *l = &dma1_ch1_last;
+	uint32_t f = dma1.IFCR;
+
+	// IFCR: write only (clear flags of channel)
+	if (f & DMA_IFCR_CGIF1)
+		f |= DMA_IFCR_CTCIF1 | DMA_IFCR_CHTIF1 | DMA_IFCR_CTEIF1;
+	dma1.ISR &= ~(f & 0xFU);
+	if (!(dma1.ISR & (DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1)))
+		dma1.ISR &= ~DMA_ISR_GIF1;
+	dma1.IFCR = 0;
+
+	if ((r->CCR & DMA_CCR_EN) && !(l->CCR & DMA_CCR_EN))
+		dma_n = r->CNDTR;
+}
+//=============================================================================
+// CAN (filters, FIFO 0 and 1, TX mailboxes, bus)
+// Cycles of one bit
+static uint64_t 
+can_bit(void)
+{
+	uint32_t btr = can.BTR;
+	uint32_t tq = ((btr & CAN_BTR_TS1_Msk) >> CAN_BTR_TS1_Pos) +
+		((btr & CAN_BTR_TS2_Msk) >> CAN_BTR_TS2_Pos) + 3U;
+	uint32_t brp = ((btr & CAN_BTR_BRP_Msk) >> CAN_BTR_BRP_Pos) + 1U;
+
+	return (uint64_t)tq * brp;
+}
+//-----------------------------------------------------------------------------
+// Cycles of one bit on bus (other nodes)
+static uint64_t 
+can_busBit(void)
+{
+	return can_bps ? SIM_HCLK_HZ / can_bps : can_bit();
+}
+//-----------------------------------------------------------------------------
+static uint64_t 
+can_frame(uint32_t dlc)
+{
+	// Standard frame: 47 bits + data + stuff bits (34 + data of 5 bits)
+	uint32_t bits = 47U + 8U * dlc + (34U + 8U * dlc - 1U) / 4U;
+
+	return bits * can_busBit();
+}
+//-----------------------------------------------------------------------------
+static uint32_t 
+can_normal(void)
+{
+	return !(can.MCR & (CAN_MCR_INRQ | CAN_MCR_SLEEP));
+}
+//-----------------------------------------------------------------------------
+static uint32_t 
+can_match16(uint32_t w, uint32_t fr, uint32_t list)
+{
+	uint32_t a = fr & 0xFFFFU, b = fr >> 16;
+
+	if (list)
+		return w == (a & ~0x18U) || w == (b & ~0x18U);
+	return ((w ^ a) & b) == 0;
+}
+//-----------------------------------------------------------------------------
+// Filter banks 0 ... 13: FIFO (0, 1) of bank with priority or SIM_NONE
+static uint32_t 
+can_filter(uint32_t id)
+{
+	uint32_t i, fr1, fr2, list, wide, m, rank, best = 4U, fifo = SIM_NONE;
+	uint32_t w32 = id << 21, w16 = id << 5;
+
+	for (i = 0; i < 14U; ++i) {
+		if (!(can.FA1R >> i & 1U))
+			continue;
+		fr1 = can.sFilterRegister[i].FR1;
+		fr2 = can.sFilterRegister[i].FR2;
+		list = can.FM1R >> i & 1U;
+		wide = can.FS1R >> i & 1U;
+		if (wide && list)
+			m = (fr1 & ~6U) == w32 || (fr2 & ~6U) == w32;
+		else if (wide)
+			m = ((w32 ^ fr1) & fr2 & ~1U) == 0;
+		else
+			m = can_match16(w16, fr1, list) || can_match16(w16, fr2, list);
+		// 32-bit before 16-bit, list before mask, lower bank first
+		rank = (wide ? 0 : 2U) + (list ? 0 : 1U);
+		if (m && rank < best) {
+			best = rank;
+			fifo = can.FFA1R >> i & 1U;
+		}
+	}
+	return fifo;
+}
+//-----------------------------------------------------------------------------
+// ESR from TEC, bus-off and last error code (lec: of last frame, SIM_NONE
+// - no frame); ERRI on new flag or error (enabled in IER)
+static void 
+can_esr(uint32_t lec)
+{
+	uint32_t old = can.ESR, esr = 0;
+
+	if (lec != SIM_NONE)
+		can_lec = lec;
+
+	if (can_tec >= 96U)
+		esr |= CAN_ESR_EWGF;
+	if (can_tec > 127U)
+		esr |= CAN_ESR_EPVF;
+	if (can_boff_t != SIM_NEVER)
+		esr |= CAN_ESR_BOFF;
+	esr |= (can_tec > 255U ? 255U : can_tec) << CAN_ESR_TEC_Pos |
+		can_lec << CAN_ESR_LEC_Pos;
+	can.ESR = esr;
+
+	esr &= ~old;
+	if (((esr & CAN_ESR_EWGF) && (can.IER & CAN_IER_EWGIE)) ||
+		((esr & CAN_ESR_EPVF) && (can.IER & CAN_IER_EPVIE)) ||
+		((esr & CAN_ESR_BOFF) && (can.IER & CAN_IER_BOFIE)) ||
+		(lec != SIM_NONE && lec && (can.IER & CAN_IER_LECIE)))
+		can.MSR |= CAN_MSR_ERRI;
+}
+//-----------------------------------------------------------------------------
+static void 
+can_rxNext(void)
+{
+	uint64_t start;
+
+	if (can_q_head == can_q_num) {
+		can_rx_t = SIM_NEVER;
+		return;
+	}
+	start = can_q[can_q_head].t > can_bus ? can_q[can_q_head].t : can_bus;
+	if (start < now)
+		start = now;
+	can_rx_t = start + can_frame(can_q[can_q_head].dlc);
+	can_bus = can_rx_t;
+}
+//-----------------------------------------------------------------------------
+static void 
+can_rxEvent(void)
+{
+	struct sim_frame f = can_q[can_q_head++];
+	uint32_t k;
+	__IO uint32_t *rf;
+
+	bus_cycles += can_frame(f.dlc);
+	f.t = now;
+	f.drop = 0;
+	if (!can_normal() || can_boff_t != SIM_NEVER || stop || can_rxLost) {
+		// Not clocked in Stop mode (also frame of wake-up)
+		f.drop = 1;
+		can_rxLost = 0;
+	} else if (can_busBit() != can_bit()) {
+		// Other rate (also in silent mode): stuff error
+		f.drop = 1;
+		can_esr(1U);
+	} else {
+		// Frame without error: LEC = 0 (also not passed by filters)
+		can_esr(0);
+		k = can_filter(f.id);
+		// RF1R: same bits as RF0R
+		rf = k ? &can.RF1R : &can.RF0R;
+		if (k == SIM_NONE) {
+			f.drop = 1;
+		} else if (can_fmp[k] == SIM_CAN_FIFO) {
+			// FIFO is not locked: last message is overwritten
+			*rf |= CAN_RF0R_FOVR0;
+			can_fifo[k][SIM_CAN_FIFO - 1U] = f;
+			if (k == 0)
+				++dropped;
+		} else {
+			can_fifo[k][can_fmp[k]++] = f;
+			if (can_fmp[k] == SIM_CAN_FIFO)
+				*rf |= CAN_RF0R_FULL0;
+		}
+	}
+	if (rx_num < SIM_LOG_SIZE)
+		rx_log[rx_num++] = f;
+	can_rxNext();
+}
+//-----------------------------------------------------------------------------
+// Pending requests to bus (not in initialization mode or bus-off)
+static void 
+can_txStart(void)
+{
+	uint32_t k;
+	uint64_t start;
+
+	if (!can_normal() || can_boff_t != SIM_NEVER)
+		return;
+	for (k = 0; k < 3U; ++k) {
+		if (!(can.sTxMailBox[k].TIR & CAN_TI0R_TXRQ) ||
+			can_tx_t[k] != SIM_NEVER)
+			continue;
+		can_mb[k].id = can.sTxMailBox[k].TIR >> CAN_TI0R_STID_Pos;
+		can_mb[k].dlc = can.sTxMailBox[k].TDTR & CAN_TDT0R_DLC_Msk;
+		can_mb[k].l = can.sTxMailBox[k].TDLR;
+		can_mb[k].h = can.sTxMailBox[k].TDHR;
+		can_mb[k].drop = 0;
+		start = can_bus > now ? can_bus : now;
+		can_tx_t[k] = start + can_frame(can_mb[k].dlc);
+		can_bus = can_tx_t[k];
+	}
+}
+//-----------------------------------------------------------------------------
+// Mailbox k is empty: result of request in TSR
+static void 
+can_txEnd(uint32_t k, uint32_t ok)
+{
+	can.sTxMailBox[k].TIR &= ~CAN_TI0R_TXRQ;
+	can.TSR |= (CAN_TSR_RQCP0 | (ok ? CAN_TSR_TXOK0 : 0)) << (8U * k) |
+		CAN_TSR_TME0 << k;
+	can_abort[k] = 0;
+}
+//-----------------------------------------------------------------------------
+// End of attempt: sent, arbitration lost or error (see sim_canError())
+static void 
+can_txEvent(uint32_t k)
+{
+	uint32_t fail = 0;
+
+	bus_cycles += can_frame(can_mb[k].dlc);
+	can_tx_t[k] = SIM_NEVER;
+	if (can_arbN) {
+		--can_arbN;
+		fail = CAN_TSR_ALST0;
+	} else if (can_errN) {
+		--can_errN;
+		fail = CAN_TSR_TERR0;
+		can_tec += 8U;
+		if (can_tec > 255U && (can.MCR & CAN_MCR_ABOM))
+			can_boff_t = now + 128U * 11U * can_bit();
+		can_esr(5U);  // bit dominant error
+	} else {
+		if (can_tec)
+			--can_tec;
+		can_esr(0);
+	}
+
+	if (!fail) {
+		can_txEnd(k, 1);
+		can_mb[k].t = now;
+		if (tx_num < SIM_LOG_SIZE)
+			tx_log[tx_num++] = can_mb[k];
+	} else {
+		can.TSR |= fail << (8U * k);
+		// Automatic retransmission (request stays) if not NART / ABRQ
+		if ((can.MCR & CAN_MCR_NART) || can_abort[k])
+			can_txEnd(k, 0);
+	}
+	can_txStart();
+}
+//-----------------------------------------------------------------------------
+// End of bus-off (ABOM): counters are reset
+static void 
+can_boffEvent(void)
+{
+	can_boff_t = SIM_NEVER;
+	can_tec = 0;
+	can_esr(SIM_NONE);
+	can_txStart();
+}
+//-----------------------------------------------------------------------------
+static void 
+can_apply(void)
+{
+	CAN_TypeDef *r = &can, *l = &can_last;
+	uint32_t k, abrq;
+	__IO uint32_t *rf;
+
+	// MSR: ERRI, WKUI, SLAKI - w1c by '=' (without marker)
+	if (!(r->MSR & SIM_MARK_CAN_MSR))
+		r->MSR = l->MSR & ~(r->MSR &
+			(CAN_MSR_ERRI | CAN_MSR_WKUI | CAN_MSR_SLAKI));
+	r->MSR &= ~SIM_MARK_CAN_MSR;
+
+	// ESR: only LEC is written (7 - by software)
+	if ((r->ESR ^ l->ESR) & CAN_ESR_LEC_Msk) {
+		can_lec = (r->ESR & CAN_ESR_LEC_Msk) >> CAN_ESR_LEC_Pos;
+		can_esr(SIM_NONE);
+	}
+
+	// TSR: w1c by '=' (without marker)
+	abrq = r->TSR & (CAN_TSR_ABRQ0 | CAN_TSR_ABRQ1 | CAN_TSR_ABRQ2);
+	if (!(r->TSR & SIM_MARK_CAN_TSR))
+		r->TSR = l->TSR & ~(r->TSR & 0x000F0F0FU);
+	r->TSR &= ~(SIM_MARK_CAN_TSR | abrq);
+
+	for (k = 0; k < 3U; ++k) {
+		// New request: flags of last request are cleared
+		if ((r->sTxMailBox[k].TIR & CAN_TI0R_TXRQ) &&
+			!(l->sTxMailBox[k].TIR & CAN_TI0R_TXRQ))
+			r->TSR &= ~((CAN_TSR_RQCP0 | CAN_TSR_TXOK0 |
+				CAN_TSR_ALST0 | CAN_TSR_TERR0) << (8U * k) |
+				CAN_TSR_TME0 << k);
+		// Abort: pending request at once, attempt on bus if it fails
+		if ((abrq >> (8U * k) & CAN_TSR_ABRQ0) &&
+			(r->sTxMailBox[k].TIR & CAN_TI0R_TXRQ)) {
+			if (can_tx_t[k] == SIM_NEVER)
+				can_txEnd(k, 0);
+			else
+				can_abort[k] = 1;
+		}
+	}
+	can_txStart();
+
+	// Release of message in FIFO 0, 1 (written FULL / FOVR - w1c)
+	for (k = 0; k < 2U; ++k) {
+		rf = k ? &r->RF1R : &r->RF0R;
+		if (!(*rf & CAN_RF0R_RFOM0))
+			continue;
+		*rf &= ~(*rf & (CAN_RF0R_FULL0 | CAN_RF0R_FOVR0));
+		if (can_fmp[k]) {
+			memmove(can_fifo[k], can_fifo[k] + 1,
+				(SIM_CAN_FIFO - 1U) * sizeof(can_fifo[k][0]));
+			--can_fmp[k];
+		}
+		*rf &= ~CAN_RF0R_RFOM0;
+	}
+}
+//=============================================================================
+// FLASH (FPEC): unlock, page erase, programming by half-words
+static void 
+flash_stall(uint64_t cycles)
+{
+	advance(now + cycles);
+}
+//-----------------------------------------------------------------------------
+static void 
+flash_apply(void)
+{
+	FLASH_TypeDef *r = &flash, *l = &flash_last;
+	uint32_t i, page, n = 0;
+
+	// SR: w1c by '=' (without marker)
+	if (!(r->SR & SIM_MARK_FLASH_SR))
+		r->SR = l->SR & ~r->SR;
+	r->SR &= ~SIM_MARK_FLASH_SR;
+
+	if (r->KEYR) {
+		if (r->KEYR == FLASH_KEY1) {
+			flash_key = 1;
+		} else if (r->KEYR == FLASH_KEY2 && flash_key) {
+			r->CR &= ~FLASH_CR_LOCK;
+			flash_key = 0;
+		} else {
+			flash_key = 0;
+		}
+		r->KEYR = 0;
+	}
+	// CR is write protected (only LOCK) while locked
+	if (l->CR & FLASH_CR_LOCK)
+		r->CR = l->CR | (r->CR & FLASH_CR_LOCK);
+
+	if ((r->CR & FLASH_CR_STRT) && (r->CR & FLASH_CR_PER)) {
+		page = (r->AR - FLASH_BASE) & ~(0x800U - 1U);
+		if (page < SIM_FLASH_SIZE) {
+			memset((uint8_t *)flash_mem + page, 0xFF, 0x800U);
+			memset((uint8_t *)flash_copy + page, 0xFF, 0x800U);
+		}
+		r->SR |= FLASH_SR_EOP;
+		flash_stall(SIM_ERASE_CYCLES);
+	}
+	r->CR &= ~FLASH_CR_STRT;
+
+	// Programming: compare with copy (only 1 -> 0 after erase); write
+	// without PG is not checked (compare only in programming mode)
+	if ((r->CR & FLASH_CR_PG) &&
+		memcmp(flash_mem, flash_copy, SIM_FLASH_SIZE)) {
+		for (i = 0; i < SIM_FLASH_SIZE / 2U; ++i) {
+			if (flash_mem[i] == flash_copy[i])
+				continue;
+			if (flash_copy[i] != 0xFFFFU && flash_mem[i] != 0) {
+				r->SR |= FLASH_SR_PGERR;
+				flash_mem[i] = flash_copy[i];
+			} else {
+				flash_copy[i] = flash_mem[i];
+				r->SR |= FLASH_SR_EOP;
+				++n;
+			}
+		}
+		flash_stall((uint64_t)n * SIM_PROG_CYCLES);
+	}
+}
+//=============================================================================
+static void 
+gpio_apply(void)
+{
+	uint32_t i, odr;
+
+	for (i = 0; i < 6U; ++i) {
+		odr = gpio[i].ODR;
+		odr &= ~gpio[i].BRR;
+		odr &= ~(gpio[i].BSRR >> 16);
+		odr |= gpio[i].BSRR & 0xFFFFU;
+		gpio[i].BSRR = 0;
+		gpio[i].BRR = 0;
+		if (odr != gpio_last[i].ODR) {
+			// Plant with old pins up to now
+			gpio[i].ODR = gpio_last[i].ODR;
+			plant_advance(now);
+			gpio[i].ODR = odr;
+			plant_gpio(now);
+		}
+	}
+}
+//=============================================================================
+static void 
+exti_apply(void)
+{
+	// PR: w1c by '=' (without marker)
+	if (!(exti.PR & SIM_MARK_EXTI_PR))
+		exti.PR = exti_last.PR & ~exti.PR;
+	exti.PR &= ~SIM_MARK_EXTI_PR;
+}
+//=============================================================================
+// RCC: RMVF clears reset flags; RTC: backup registers with DBP only
+static void 
+rcc_apply(void)
+{
+	if (rcc.CSR & RCC_CSR_RMVF)
+		rcc.CSR &= ~(RCC_CSR_RMVF | RCC_CSR_LPWRRSTF | RCC_CSR_WWDGRSTF | 
+			RCC_CSR_IWDGRSTF | RCC_CSR_SFTRSTF | RCC_CSR_PORRSTF | 
+			RCC_CSR_PINRSTF | RCC_CSR_OBLRSTF);
+	if (!(pwr.CR & PWR_CR_DBP))
+		rtc = rtc_last;
+}
+//=============================================================================
+// Writes of firmware after last access (copies are refreshed after)
+static void 
+apply(void)
+{
+	rcc_apply();
+	gpio_apply();
+	exti_apply();
+	dma_apply();
+	adc_apply();
+	tim_apply(2);
+	tim_apply(6);
+	tim_apply(7);
+	can_apply();
+	if (dwt.CYCCNT != dwt_last.CYCCNT)
+		dwt_base = now - dwt.CYCCNT;
+	// Last: erase and programming stall CPU (time goes on)
+	flash_apply();
+
+	refresh();
+}
+//-----------------------------------------------------------------------------
+// Values for reading and copy for next apply()
+static void 
+refresh(void)
+{
+	uint32_t i;
+
+	rcc.CR &= ~(RCC_CR_HSERDY | RCC_CR_PLLRDY | RCC_CR_HSIRDY);
+	rcc.CR |= (rcc.CR & RCC_CR_HSEON ? RCC_CR_HSERDY : 0) |
+		(rcc.CR & RCC_CR_PLLON ? RCC_CR_PLLRDY : 0) |
+		(rcc.CR & RCC_CR_HSION ? RCC_CR_HSIRDY : 0);
+	rcc.CFGR = (rcc.CFGR & ~(RCC_CFGR_SWS_0 | RCC_CFGR_SWS_1)) |
+		(rcc.CFGR & (RCC_CFGR_SW_0 | RCC_CFGR_SW_1)) << 2;
+
+	for (i = 0; i < 6U; ++i) {
+		gpio[i].IDR = gpio[i].ODR;
+		gpio_last[i] = gpio[i];
+	}
+
+	dma1_ch1_last = dma1_ch1;
+	adc1_last = adc1;
+	adc1.ISR |= SIM_MARK_ADC_ISR;
+
+	for (i = 0; i < 8U; ++i) {
+		tim[i].r.CNT = tim_cnt(&tim[i]);
+		tim[i].last = tim[i].r;
+	}
+
+	can.MSR &= ~(CAN_MSR_INAK | CAN_MSR_SLAK);
+	if (can.MCR & CAN_MCR_INRQ)
+		can.MSR |= CAN_MSR_INAK;
+	else if (can.MCR & CAN_MCR_SLEEP)
+		can.MSR |= CAN_MSR_SLAK;
+	can.RF0R = (can.RF0R & ~CAN_RF0R_FMP0_Msk) | can_fmp[0];
+	can.RF1R = (can.RF1R & ~CAN_RF1R_FMP1_Msk) | can_fmp[1];
+	for (i = 0; i < 2U; ++i) {
+		if (!can_fmp[i])
+			continue;
+		can.sFIFOMailBox[i].RIR = can_fifo[i][0].id << CAN_RI0R_STID_Pos;
+		can.sFIFOMailBox[i].RDTR = can_fifo[i][0].dlc;
+		can.sFIFOMailBox[i].RDLR = can_fifo[i][0].l;
+		can.sFIFOMailBox[i].RDHR = can_fifo[i][0].h;
+	}
+	can_last = can;
+	can.TSR |= SIM_MARK_CAN_TSR;
+	can.MSR |= SIM_MARK_CAN_MSR;
+
+	flash_last = flash;
+	flash.SR |= SIM_MARK_FLASH_SR;
+
+	exti_last = exti;
+	exti.PR |= SIM_MARK_EXTI_PR;
+
+	rtc_last = rtc;
+
+	dwt.CYCCNT = (uint32_t)(now - dwt_base);
+	dwt_last = dwt;
+}
+//=============================================================================
+// Events of peripherals up to t (in time order)
+static uint64_t 
+next_event(void)
+{
+	uint64_t t = adc_eoc;
+	uint32_t i;
+
+	for (i = 0; i < 8U; ++i) {
+		if (tim[i].t_upd < t)
+			t = tim[i].t_upd;
+		if (tim[i].t_cc2 < t)
+			t = tim[i].t_cc2;
+	}
+	for (i = 0; i < 3U; ++i)
+		if (can_tx_t[i] < t)
+			t = can_tx_t[i];
+	if (can_rx_t < t)
+		t = can_rx_t;
+	if (can_boff_t < t)
+		t = can_boff_t;
+	return t;
+}
+//-----------------------------------------------------------------------------
+static void 
+advance(uint64_t t)
+{
+	uint64_t e;
+	uint32_t i;
+
+	while ((e = next_event()) <= t) {
+		now = e;
+		for (i = 0; i < 8U; ++i)
+			if (tim[i].t_upd == now || tim[i].t_cc2 == now)
+				tim_event(i);
+		if (adc_eoc == now)
+			adc_event();
+		for (i = 0; i < 3U; ++i)
+			if (can_tx_t[i] == now)
+				can_txEvent(i);
+		if (can_rx_t == now)
+			can_rxEvent();
+		if (can_boff_t == now)
+			can_boffEvent();
+	}
+	now = t;
+	// Changes of peripherals are not writes of firmware
+	refresh();
+}
+//=============================================================================
+// NVIC: level of interrupt request from flags of peripheral
+static uint32_t 
+irq_pending(uint32_t irq)
+{
+	uint32_t ccr = dma1_ch1.CCR, isr = dma1.ISR;
+
+	switch (irq) {
+	case DMA1_Channel1_IRQn:
+		return ((isr & DMA_ISR_TCIF1) && (ccr & DMA_CCR_TCIE)) ||
+			((isr & DMA_ISR_HTIF1) && (ccr & DMA_CCR_HTIE)) ||
+			((isr & DMA_ISR_TEIF1) && (ccr & DMA_CCR_TEIE));
+	case ADC1_IRQn:
+		return (adc1.ISR & adc1.IER & 0x7FFU) != 0;
+	case USB_HP_CAN_TX_IRQn:
+		return (can.IER & CAN_IER_TMEIE) && (can.TSR &
+			(CAN_TSR_RQCP0 | CAN_TSR_RQCP1 | CAN_TSR_RQCP2));
+	case USB_LP_CAN_RX0_IRQn:
+		return ((can.IER & CAN_IER_FMPIE0) && can_fmp[0]) ||
+			((can.IER & CAN_IER_FFIE0) && (can.RF0R & CAN_RF0R_FULL0)) ||
+			((can.IER & CAN_IER_FOVIE0) && (can.RF0R & CAN_RF0R_FOVR0));
+	case CAN_RX1_IRQn:
+		return ((can.IER & CAN_IER_FMPIE1) && can_fmp[1]) ||
+			((can.IER & CAN_IER_FFIE1) && (can.RF1R & CAN_RF1R_FULL1)) ||
+			((can.IER & CAN_IER_FOVIE1) && (can.RF1R & CAN_RF1R_FOVR1));
+	case CAN_SCE_IRQn:
+		return ((can.IER & CAN_IER_ERRIE) && (can.MSR & CAN_MSR_ERRI)) ||
+			((can.IER & CAN_IER_WKUIE) && (can.MSR & CAN_MSR_WKUI));
+	case EXTI9_5_IRQn:
+		return (exti.PR & exti.IMR & 0x3E0U) != 0;
+	case EXTI15_10_IRQn:
+		return (exti.PR & exti.IMR & 0xFC00U) != 0;
+	case TIM6_DAC_IRQn:
+		return (tim[6].r.SR & TIM_SR_UIF) && (tim[6].r.DIER & TIM_DIER_UIE);
+	case TIM7_IRQn:
+		return (tim[7].r.SR & TIM_SR_UIF) && (tim[7].r.DIER & TIM_DIER_UIE);
+	default:
+		return 0;
+	}
+}
+//-----------------------------------------------------------------------------
+static void
+(*irq_handler(uint32_t irq))(void)
+{
+	switch (irq) {
+	case DMA1_Channel1_IRQn:   return DMA1_Channel1_IRQHandler;
+	case ADC1_IRQn:            return ADC1_IRQHandler;
+	case USB_HP_CAN_TX_IRQn:   return USB_HP_CAN_TX_IRQHandler;
+	case USB_LP_CAN_RX0_IRQn:  return USB_LP_CAN_RX0_IRQHandler;
+	case CAN_RX1_IRQn:         return CAN_RX1_IRQHandler;
+	case CAN_SCE_IRQn:         return CAN_SCE_IRQHandler;
+	case EXTI9_5_IRQn:         return EXTI9_5_IRQHandler;
+	case EXTI15_10_IRQn:       return EXTI15_10_IRQHandler;
+	case TIM6_DAC_IRQn:        return TIM6_DAC_IRQHandler;
+	case TIM7_IRQn:            return TIM7_IRQHandler;
+	default:                   return 0;
+	}
+}
+//-----------------------------------------------------------------------------
+// Sub-priority bits of 4 bits (PRIGROUP: group bits [7:PRIGROUP+1])
+static uint32_t 
+irq_subBits(void)
+{
+	return nvic_group > 3U ? nvic_group - 3U : 0;
+}
+//-----------------------------------------------------------------------------
+// Take pending interrupts with higher preemption priority than current
+static void 
+dispatch(void)
+{
+	uint32_t i, irq, best, pre, cur;
+	uint64_t t;
+	void (*h)(void);
+
+	for (;;) {
+		if (primask)
+			return;
+		cur = act_num ? act_pre[act_num - 1U] : SIM_THREAD;
+		best = SIM_NONE;
+		for (i = 0; i < SIM_IRQ_MODEL; ++i) {
+			irq = sim_irq[i];
+			if (!nvic_en[irq] || !irq_pending(irq))
+				continue;
+			pre = nvic_prio[irq] >> irq_subBits();
+			if (pre >= cur)
+				continue;
+			if (best == SIM_NONE || nvic_prio[irq] < nvic_prio[best])
+				best = irq;
+		}
+		if (best == SIM_NONE || !(h = irq_handler(best)))
+			return;
+
+		t = now;
+		act_pre[act_num++] = nvic_prio[best] >> irq_subBits();
+		advance(now + SIM_ENTRY_CYCLES);
+		h();
+		apply();
+		advance(now + SIM_ENTRY_CYCLES);
+		if (--act_num == 0)
+			isr_cycles += now - t;
+	}
+}
+//=============================================================================
+// Core (CMSIS) functions
+void 
+NVIC_EnableIRQ(IRQn_Type irq)
+{
+	if (irq >= 0)
+		nvic_en[irq] = 1;
+}
+//-----------------------------------------------------------------------------
+void 
+NVIC_DisableIRQ(IRQn_Type irq)
+{
+	if (irq >= 0)
+		nvic_en[irq] = 0;
+}
+//-----------------------------------------------------------------------------
+void 
+NVIC_SetPriority(IRQn_Type irq, uint32_t prio)
+{
+	if (irq >= 0)
+		nvic_prio[irq] = prio & ((1U << __NVIC_PRIO_BITS) - 1U);
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+NVIC_GetPriority(IRQn_Type irq)
+{
+	return irq >= 0 ? nvic_prio[irq] : 0;
+}
+//-----------------------------------------------------------------------------
+void 
+NVIC_SetPriorityGrouping(uint32_t group)
+{
+	nvic_group = group & 7U;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+NVIC_GetPriorityGrouping(void)
+{
+	return nvic_group;
+}
+//-----------------------------------------------------------------------------
+// As CMSIS
+uint32_t 
+NVIC_EncodePriority(uint32_t group, uint32_t pre, uint32_t sub)
+{
+	uint32_t g = group & 7U;
+	uint32_t pre_bits = 7U - g > __NVIC_PRIO_BITS ? __NVIC_PRIO_BITS : 7U - g;
+	uint32_t sub_bits = g + __NVIC_PRIO_BITS < 7U ? 0 :
+		g - 7U + __NVIC_PRIO_BITS;
+
+	return (pre & ((1U << pre_bits) - 1U)) << sub_bits |
+		(sub & ((1U << sub_bits) - 1U));
+}
+//-----------------------------------------------------------------------------
+void 
+NVIC_ClearPendingIRQ(IRQn_Type irq)
+{
+	(void)irq;
+}
+//-----------------------------------------------------------------------------
+void 
+NVIC_SystemReset(void)
+{
+	fprintf(stderr, "sim: system reset\n");
+	exit(3);
+}
+//-----------------------------------------------------------------------------
+void 
+__disable_irq(void)
+{
+	primask = 1;
+}
+//-----------------------------------------------------------------------------
+void 
+__enable_irq(void)
+{
+	primask = 0;
+	sim_sync();
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+__get_PRIMASK(void)
+{
+	return primask;
+}
+//-----------------------------------------------------------------------------
+void 
+__set_PRIMASK(uint32_t v)
+{
+	primask = v & 1U;
+	if (!primask)
+		sim_sync();
+}
+//-----------------------------------------------------------------------------
+void __DMB(void) {}
+void __DSB(void) {}
+void __ISB(void) {}
+void __NOP(void) {}
+void __nop(void) {}
+void __CLREX(void) {}
+//-----------------------------------------------------------------------------
+// EXTI line 8 from GPIO B pin 8 (CAN RX), falling edge, not masked
+static uint32_t 
+pwr_exti8(void)
+{
+	return (exti.IMR & EXTI_IMR_MR8) && (exti.FTSR & EXTI_FTSR_TR8) &&
+		(syscfg.EXTICR[2] & SYSCFG_EXTICR3_EXTI8) == SYSCFG_EXTICR3_EXTI8_PB;
+}
+//-----------------------------------------------------------------------------
+// Stop mode up to SOF of next frame (or SIM_STOP_STEP without wake-up)
+static void 
+pwr_stop(void)
+{
+	uint64_t sof = SIM_NEVER;
+
+	if (!stop) {
+		stop = 1;
+		stop_t = now;
+	}
+	if (can_rx_t != SIM_NEVER && pwr_exti8())
+		sof = can_rx_t - can_frame(can_q[can_q_head].dlc);
+	if (sof != SIM_NEVER && sof < now)
+		sof = now;
+	if (sof > now + SIM_STOP_STEP) {
+		advance(now + SIM_STOP_STEP);
+		return;
+	}
+	advance(sof);
+	exti.PR |= EXTI_PR_PR8;
+	advance(now + SIM_WUSTOP_CYCLES);
+
+	stop = 0;
+	stop_cycles += now - stop_t;
+	wake_t = sof;
+	dwt_base += now - stop_t;
+	can_rxLost = can_rx_t != SIM_NEVER;
+	// SYSCLK from HSI (HSE, PLL, CSS are off)
+	rcc.CR = (rcc.CR & ~(RCC_CR_HSEON | RCC_CR_PLLON | RCC_CR_CSSON)) |
+		RCC_CR_HSION;
+	rcc.CFGR &= ~(RCC_CFGR_SW_0 | RCC_CFGR_SW_1);
+	refresh();
+	dispatch();
+}
+//-----------------------------------------------------------------------------
+// Sleep up to next event (interrupt); Stop mode with SLEEPDEEP
+void 
+__WFI(void)
+{
+	uint64_t t;
+
+	apply();
+	if (scb.SCR & SCB_SCR_SLEEPDEEP_Msk) {
+		pwr_stop();
+		return;
+	}
+	t = next_event();
+	if (t == SIM_NEVER)
+		t = now + SIM_ACCESS_CYCLES;
+	advance(t > now ? t : now);
+	dispatch();
+}
+//-----------------------------------------------------------------------------
+void 
+__WFE(void)
+{
+	__WFI();
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+__LDREXW(volatile uint32_t *addr)
+{
+	return *addr;
+}
+//-----------------------------------------------------------------------------
+// Preemption is only at access to peripheral => store is always exclusive
+uint32_t 
+__STREXW(uint32_t value, volatile uint32_t *addr)
+{
+	*addr = value;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+__SMLAD(uint32_t x, uint32_t y, uint32_t acc)
+{
+	int32_t p0 = (int16_t)x * (int16_t)y;
+	int32_t p1 = (int16_t)(x >> 16) * (int16_t)(y >> 16);
+
+	return acc + (uint32_t)p0 + (uint32_t)p1;
+}
+//-----------------------------------------------------------------------------
+int32_t 
+__SSAT(int32_t value, uint32_t bits)
+{
+	int32_t max = (int32_t)((1U << (bits - 1U)) - 1U);
+
+	if (value > max)
+		return max;
+	if (value < -max - 1)
+		return -max - 1;
+	return value;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+__USAT(int32_t value, uint32_t bits)
+{
+	uint32_t max = (1U << bits) - 1U;
+
+	if (value < 0)
+		return 0;
+	return (uint32_t)value > max ? max : (uint32_t)value;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+__CLZ(uint32_t value)
+{
+	return value ? (uint32_t)__builtin_clz(value) : 32U;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+__RBIT(uint32_t value)
+{
+	uint32_t r = 0, i;
+
+	for (i = 0; i < 32U; ++i)
+		r |= (value >> i & 1U) << (31U - i);
+	return r;
+}
+//=============================================================================
+// Bench side
+uint32_t 
+sim_canRx(uint32_t id, uint32_t dlc, uint32_t l, uint32_t h)
+{
+	struct sim_frame *f;
+
+	if (can_q_num == SIM_CAN_QUEUE) {
+		fprintf(stderr, "sim: CAN queue is full\n");
+		exit(2);
+	}
+	f = &can_q[can_q_num];
+	f->t = now;
+	f->id = id;
+	f->dlc = dlc;
+	f->l = l;
+	f->h = h;
+	f->drop = 0;
+	if (can_q_head == can_q_num++)
+		can_rxNext();
+	return can_q_num - 1U;
+}
+//-----------------------------------------------------------------------------
+// Long run (lcnode.c): frames on bus are dropped from RX queue and RX log,
+// TX log keeps frames from tx on (indexes of sim_canRx(), sim_rx(), 
+// sim_tx() start again at 0)
+void 
+sim_canTrim(uint32_t tx)
+{
+	can_q_num -= can_q_head;
+	memmove(can_q, &can_q[can_q_head], can_q_num * sizeof(can_q[0]));
+	can_q_head = 0;
+	rx_num = 0;
+	if (tx > tx_num)
+		tx = tx_num;
+	tx_num -= tx;
+	memmove(tx_log, &tx_log[tx], tx_num * sizeof(tx_log[0]));
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+sim_rxNum(void)
+{
+	return rx_num;
+}
+//-----------------------------------------------------------------------------
+const struct sim_frame * 
+sim_rx(uint32_t i)
+{
+	return &rx_log[i];
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+sim_txNum(void)
+{
+	return tx_num;
+}
+//-----------------------------------------------------------------------------
+const struct sim_frame * 
+sim_tx(uint32_t i)
+{
+	return &tx_log[i];
+}
+//-----------------------------------------------------------------------------
+// Frames lost by FIFO 0 overrun
+uint32_t 
+sim_getDropped(void)
+{
+	return dropped;
+}
+//-----------------------------------------------------------------------------
+void 
+sim_fault(uint32_t fault)
+{
+	apply();
+	if (fault == SIM_FAULT_ADC_OVR) {
+		adc1.ISR |= ADC_ISR_OVR;
+		adc_dma_stop = 1;
+	} else if (fault == SIM_FAULT_DMA_TE) {
+		dma1.ISR |= DMA_ISR_TEIF1 | DMA_ISR_GIF1;
+		dma1_ch1.CCR &= ~DMA_CCR_EN;
+	}
+	refresh();
+}
+//-----------------------------------------------------------------------------
+// Next attempts of TX: terr - with error, alst - arbitration lost (first)
+void 
+sim_canRate(uint32_t bps)
+{
+	apply();
+	can_bps = bps;
+	refresh();
+}
+//-----------------------------------------------------------------------------
+// Time in Stop mode (cycles, current stay included)
+uint64_t 
+sim_getStop(void)
+{
+	return stop_cycles + (stop ? now - stop_t : 0);
+}
+//-----------------------------------------------------------------------------
+// SOF of frame of last wake-up (SIM_NEVER - none)
+uint64_t 
+sim_getWake(void)
+{
+	return wake_t;
+}
+//-----------------------------------------------------------------------------
+// Trigger (TIM 2) of last ADC 1 sequence with transfer complete of DMA 1
+uint64_t 
+sim_getFrame(void)
+{
+	return frame_t;
+}
+//-----------------------------------------------------------------------------
+// Cycles in interrupt handlers (entry and exit included)
+uint64_t 
+sim_getIsr(void)
+{
+	return isr_cycles;
+}
+//-----------------------------------------------------------------------------
+// Cycles of bus with frames (RX, also not received, and TX attempts; added
+// at end of frame)
+uint64_t 
+sim_getBus(void)
+{
+	return bus_cycles;
+}
+//-----------------------------------------------------------------------------
+// Cycles of one frame on bus at rate of network (as sim_getBus())
+uint64_t 
+sim_canFrame(uint32_t dlc)
+{
+	return can_frame(dlc);
+}
+//-----------------------------------------------------------------------------
+void 
+sim_canError(uint32_t terr, uint32_t alst)
+{
+	apply();
+	can_errN += terr;
+	can_arbN += alst;
+	refresh();
+}
+//=============================================================================
+// Warm reset (see notes)
+// Whole buffer through pipe (wr - 1 write, 0 read); return -1 on error or
+// end of file
+int32_t 
+sim_pipe(int fd, void *p, uint32_t n, uint32_t wr)
+{
+	uint8_t *b = p;
+	ssize_t k;
+
+	while (n) {
+		k = wr ? write(fd, b, n) : read(fd, b, n);
+		if (k <= 0)
+			return -1;
+		b += k;
+		n -= (uint32_t)k;
+	}
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// State that survives system reset: time, flash, backup registers
+int32_t 
+sim_save(int fd)
+{
+	apply();
+	if (sim_pipe(fd, &now, sizeof(now), 1U) ||
+		sim_pipe(fd, flash_mem, SIM_FLASH_SIZE, 1U) ||
+		sim_pipe(fd, &rtc, sizeof(rtc), 1U))
+		return -1;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// After sim_init() of new process: state of sim_save(), csr - reset flags
+// (RCC CSR)
+int32_t 
+sim_load(int fd, uint32_t csr)
+{
+	if (sim_pipe(fd, &now, sizeof(now), 0) ||
+		sim_pipe(fd, flash_mem, SIM_FLASH_SIZE, 0) ||
+		sim_pipe(fd, &rtc, sizeof(rtc), 0))
+		return -1;
+	memcpy(flash_copy, flash_mem, SIM_FLASH_SIZE);
+	rcc.CSR = csr;
+	dwt_base = now;
+	refresh();
+	return 0;
+}
+//=============================================================================
@@ -0,0 +1,69 @@
+//=============================================================================
+#ifndef SIM_H
+#define SIM_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+// Time of simulator in cycles of HCLK (firmware runs 16 MHz after clock.c)
+#define SIM_HCLK_HZ        16000000U
+#define SIM_CYCLES_MS      (SIM_HCLK_HZ / 1000U)
+#define SIM_CYCLES_US      (SIM_HCLK_HZ / 1000000U)
+//-----------------------------------------------------------------------------
+// Cost model (see sim.c notes)
+#define SIM_ACCESS_CYCLES  4U   // one access to peripheral
+#define SIM_ENTRY_CYCLES   12U  // exception entry (and same for exit)
+#define SIM_LOOP_CYCLES    48U  // pass of main loop without access
+//-----------------------------------------------------------------------------
+// Supply current of MCU (uA) for estimate: run at HCLK with peripherals,
+// Stop mode with regulator in low-power mode (typical values of datasheet,
+// motor drivers and CAN transceiver are not included)
+#define SIM_RUN_UA         8000U
+#define SIM_STOP_UA        20U
+//-----------------------------------------------------------------------------
+#define SIM_NEVER  0xFFFFFFFFFFFFFFFFULL
+//-----------------------------------------------------------------------------
+// Faults for sim_fault()
+#define SIM_FAULT_ADC_OVR  1U  // overrun of ADC 1 (DMA requests stop)
+#define SIM_FAULT_DMA_TE   2U  // transfer error of DMA 1 Channel 1
+//-----------------------------------------------------------------------------
+#define SIM_LOG_SIZE  8192U  // frames in each log (RX and TX)
+//-----------------------------------------------------------------------------
+// CAN frame on bus (t - end of frame)
+struct sim_frame {
+	uint64_t t;
+	uint32_t id;
+	uint32_t dlc;
+	uint32_t l;
+	uint32_t h;
+	uint32_t drop;  // RX: not stored (FIFO overrun or filter)
+};
+//-----------------------------------------------------------------------------
+void sim_init(void);
+uint64_t sim_now(void);
+void sim_sync(void);
+void sim_idle(uint32_t cycles);
+void sim_fault(uint32_t fault);
+void sim_canError(uint32_t terr, uint32_t alst);
+void sim_canRate(uint32_t bps);
+uint32_t sim_getOdr(uint32_t port);
+//-----------------------------------------------------------------------------
+uint32_t sim_canRx(uint32_t id, uint32_t dlc, uint32_t l, uint32_t h);
+void sim_canTrim(uint32_t tx);
+uint32_t sim_rxNum(void);
+const struct sim_frame *sim_rx(uint32_t i);
+uint32_t sim_txNum(void);
+const struct sim_frame *sim_tx(uint32_t i);
+uint32_t sim_getDropped(void);
+uint64_t sim_getStop(void);
+uint64_t sim_getWake(void);
+uint64_t sim_getFrame(void);
+uint64_t sim_getIsr(void);
+uint64_t sim_getBus(void);
+uint64_t sim_canFrame(uint32_t dlc);
+//-----------------------------------------------------------------------------
+int32_t sim_pipe(int fd, void *p, uint32_t n, uint32_t wr);
+int32_t sim_save(int fd);
+int32_t sim_load(int fd, uint32_t csr);
+//=============================================================================
+#endif // SIM_H
+//=============================================================================
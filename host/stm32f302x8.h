@@ -0,0 +1,1195 @@
+//=============================================================================
+/*
+* Host (Linux) replacement of device header for STM32F302x8 (see host/sim.c)
+* notes:
+ - bit definitions have values of device header
+ - each peripheral is a structure in RAM; peripheral macro (RCC, GPIOA, ...) 
+   calls simulator before each access (sim_x()), so self-clearing bits, 
+   flags, interrupts and time are handled by simulator
+ - only registers and bits used by firmware are defined
+*/
+//=============================================================================
+#ifndef STM32F302X8_H
+#define STM32F302X8_H
+//=============================================================================
+#include <stdint.h>
+//-----------------------------------------------------------------------------
+#define __IO  volatile
+#define __I   volatile const
+#define __O   volatile
+
+#define __align(x)  __attribute__((aligned(x)))
+//=============================================================================
+typedef struct {
+	__IO uint32_t CR, CFGR, CIR, APB2RSTR, APB1RSTR, AHBENR, APB2ENR, 
+		APB1ENR, BDCR, CSR, AHBRSTR, CFGR2, CFGR3;
+} RCC_TypeDef;
+
+typedef struct {
+	__IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, 
+		AFR[2], BRR;
+} GPIO_TypeDef;
+
+typedef struct {
+	__IO uint32_t ISR, IFCR;
+} DMA_TypeDef;
+
+typedef struct {
+	__IO uint32_t CCR, CNDTR, CPAR, CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct {
+	__IO uint32_t ISR, IER, CR, CFGR, SMPR1, SMPR2, TR1, TR2, TR3, SQR1, 
+		SQR2, SQR3, SQR4, DR, JSQR, OFR1, OFR2, OFR3, OFR4, JDR1, JDR2, 
+		JDR3, JDR4, AWD2CR, AWD3CR, DIFSEL, CALFACT;
+} ADC_TypeDef;
+
+typedef struct {
+	__IO uint32_t CSR, CCR, CDR;
+} ADC_Common_TypeDef;
+
+typedef struct {
+	__IO uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, 
+		PSC, ARR, RCR, CCR1, CCR2, CCR3, CCR4, BDTR, DCR, DMAR, OR;
+} TIM_TypeDef;
+
+typedef struct {
+	__IO uint32_t TIR, TDTR, TDLR, TDHR;
+} CAN_TxMailBox_TypeDef;
+
+typedef struct {
+	__IO uint32_t RIR, RDTR, RDLR, RDHR;
+} CAN_FIFOMailBox_TypeDef;
+
+typedef struct {
+	__IO uint32_t FR1, FR2;
+} CAN_FilterRegister_TypeDef;
+
+typedef struct {
+	__IO uint32_t MCR, MSR, TSR, RF0R, RF1R, IER, ESR, BTR;
+	CAN_TxMailBox_TypeDef sTxMailBox[3];
+	CAN_FIFOMailBox_TypeDef sFIFOMailBox[2];
+	__IO uint32_t FMR, FM1R, FS1R, FFA1R, FA1R;
+	CAN_FilterRegister_TypeDef sFilterRegister[28];
+} CAN_TypeDef;
+
+typedef struct {
+	__IO uint32_t CR1, CR2, CR3, BRR, GTPR, RTOR, RQR, ISR, ICR, RDR, TDR;
+} USART_TypeDef;
+
+typedef struct {
+	__IO uint32_t ACR, KEYR, OPTKEYR, SR, CR, AR, OBR, WRPR;
+} FLASH_TypeDef;
+
+typedef struct {
+	__IO uint32_t CR, CSR;
+} PWR_TypeDef;
+
+typedef struct {
+	__IO uint32_t BKP0R, BKP1R, BKP2R, BKP3R;
+} RTC_TypeDef;
+
+typedef struct {
+	__IO uint32_t IMR, EMR, RTSR, FTSR, SWIER, PR;
+} EXTI_TypeDef;
+
+typedef struct {
+	__IO uint32_t CFGR1, RCR, EXTICR[4], CFGR2;
+} SYSCFG_TypeDef;
+
+typedef struct {
+	__IO uint32_t CPUID, ICSR, VTOR, AIRCR, SCR, CCR, SHCSR, CFSR;
+} SCB_Type;
+
+typedef struct {
+	__IO uint32_t CTRL, CYCCNT;
+} DWT_Type;
+
+typedef struct {
+	__IO uint32_t DHCSR, DCRSR, DCRDR, DEMCR;
+} CoreDebug_Type;
+//-----------------------------------------------------------------------------
+typedef enum {
+	NonMaskableInt_IRQn = -14,
+	DMA1_Channel1_IRQn = 11,
+	ADC1_IRQn = 18,
+	USB_HP_CAN_TX_IRQn = 19,
+	USB_LP_CAN_RX0_IRQn = 20,
+	CAN_RX1_IRQn = 21,
+	CAN_SCE_IRQn = 22,
+	EXTI9_5_IRQn = 23,
+	EXTI15_10_IRQn = 40,
+	TIM6_DAC_IRQn = 54,
+	TIM7_IRQn = 55
+} IRQn_Type;
+
+#define __NVIC_PRIO_BITS  4U
+//=============================================================================
+// Simulator (before each access to peripheral)
+RCC_TypeDef *sim_rcc(void);
+GPIO_TypeDef *sim_gpio(uint32_t port);
+DMA_TypeDef *sim_dma1(void);
+DMA_Channel_TypeDef *sim_dma1_ch1(void);
+ADC_TypeDef *sim_adc1(void);
+ADC_Common_TypeDef *sim_adc1_common(void);
+TIM_TypeDef *sim_tim(uint32_t n);
+CAN_TypeDef *sim_can(void);
+USART_TypeDef *sim_usart2(void);
+FLASH_TypeDef *sim_flash(void);
+PWR_TypeDef *sim_pwr(void);
+RTC_TypeDef *sim_rtc(void);
+EXTI_TypeDef *sim_exti(void);
+SYSCFG_TypeDef *sim_syscfg(void);
+SCB_Type *sim_scb(void);
+DWT_Type *sim_dwt(void);
+CoreDebug_Type *sim_coredebug(void);
+
+#define RCC          (sim_rcc())
+#define GPIOA        (sim_gpio(0U))
+#define GPIOB        (sim_gpio(1U))
+#define GPIOC        (sim_gpio(2U))
+#define GPIOF        (sim_gpio(5U))
+#define DMA1         (sim_dma1())
+#define DMA1_Channel1  (sim_dma1_ch1())
+#define ADC1         (sim_adc1())
+#define ADC1_COMMON  (sim_adc1_common())
+#define TIM2         (sim_tim(2U))
+#define TIM6         (sim_tim(6U))
+#define TIM7         (sim_tim(7U))
+#define CAN          (sim_can())
+#define USART2       (sim_usart2())
+#define FLASH        (sim_flash())
+#define PWR          (sim_pwr())
+#define RTC          (sim_rtc())
+#define EXTI         (sim_exti())
+#define SYSCFG       (sim_syscfg())
+#define SCB          (sim_scb())
+#define DWT          (sim_dwt())
+#define CoreDebug    (sim_coredebug())
+//-----------------------------------------------------------------------------
+// Core (CMSIS) functions
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_SetPriority(IRQn_Type irq, uint32_t prio);
+uint32_t NVIC_GetPriority(IRQn_Type irq);
+void NVIC_SetPriorityGrouping(uint32_t group);
+uint32_t NVIC_GetPriorityGrouping(void);
+uint32_t NVIC_EncodePriority(uint32_t group, uint32_t pre, uint32_t sub);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void NVIC_SystemReset(void);
+void __disable_irq(void);
+void __enable_irq(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t primask);
+void __DMB(void);
+void __DSB(void);
+void __ISB(void);
+void __WFI(void);
+void __NOP(void);
+void __nop(void);
+void __WFE(void);
+uint32_t __LDREXW(volatile uint32_t *addr);
+uint32_t __STREXW(uint32_t value, volatile uint32_t *addr);
+void __CLREX(void);
+uint32_t __SMLAD(uint32_t x, uint32_t y, uint32_t acc);
+int32_t __SSAT(int32_t value, uint32_t bits);
+uint32_t __USAT(int32_t value, uint32_t bits);
+uint32_t __CLZ(uint32_t value);
+uint32_t __RBIT(uint32_t value);
+
+extern uint32_t SystemCoreClock;
+//=============================================================================
+#define GPIO_MODER_MODER0_Msk  (0x3U << 0)
+#define GPIO_MODER_MODER0  (0x3U << 0)
+#define GPIO_MODER_MODER0_0  (0x1U << 0)
+#define GPIO_MODER_MODER0_1  (0x2U << 0)
+#define GPIO_OSPEEDER_OSPEEDR0_Msk  (0x3U << 0)
+#define GPIO_OSPEEDER_OSPEEDR0  (0x3U << 0)
+#define GPIO_OSPEEDER_OSPEEDR0_0  (0x1U << 0)
+#define GPIO_OSPEEDER_OSPEEDR0_1  (0x2U << 0)
+#define GPIO_PUPDR_PUPDR0_Msk  (0x3U << 0)
+#define GPIO_PUPDR_PUPDR0  (0x3U << 0)
+#define GPIO_PUPDR_PUPDR0_0  (0x1U << 0)
+#define GPIO_PUPDR_PUPDR0_1  (0x2U << 0)
+#define GPIO_BSRR_BS_0  (0x1U << 0)
+#define GPIO_BSRR_BR_0  (0x1U << 16)
+#define GPIO_ODR_0  (0x1U << 0)
+#define GPIO_IDR_0  (0x1U << 0)
+#define GPIO_MODER_MODER1_Msk  (0x3U << 2)
+#define GPIO_MODER_MODER1  (0x3U << 2)
+#define GPIO_MODER_MODER1_0  (0x1U << 2)
+#define GPIO_MODER_MODER1_1  (0x2U << 2)
+#define GPIO_OSPEEDER_OSPEEDR1_Msk  (0x3U << 2)
+#define GPIO_OSPEEDER_OSPEEDR1  (0x3U << 2)
+#define GPIO_OSPEEDER_OSPEEDR1_0  (0x1U << 2)
+#define GPIO_OSPEEDER_OSPEEDR1_1  (0x2U << 2)
+#define GPIO_PUPDR_PUPDR1_Msk  (0x3U << 2)
+#define GPIO_PUPDR_PUPDR1  (0x3U << 2)
+#define GPIO_PUPDR_PUPDR1_0  (0x1U << 2)
+#define GPIO_PUPDR_PUPDR1_1  (0x2U << 2)
+#define GPIO_BSRR_BS_1  (0x1U << 1)
+#define GPIO_BSRR_BR_1  (0x1U << 17)
+#define GPIO_ODR_1  (0x1U << 1)
+#define GPIO_IDR_1  (0x1U << 1)
+#define GPIO_MODER_MODER2_Msk  (0x3U << 4)
+#define GPIO_MODER_MODER2  (0x3U << 4)
+#define GPIO_MODER_MODER2_0  (0x1U << 4)
+#define GPIO_MODER_MODER2_1  (0x2U << 4)
+#define GPIO_OSPEEDER_OSPEEDR2_Msk  (0x3U << 4)
+#define GPIO_OSPEEDER_OSPEEDR2  (0x3U << 4)
+#define GPIO_OSPEEDER_OSPEEDR2_0  (0x1U << 4)
+#define GPIO_OSPEEDER_OSPEEDR2_1  (0x2U << 4)
+#define GPIO_PUPDR_PUPDR2_Msk  (0x3U << 4)
+#define GPIO_PUPDR_PUPDR2  (0x3U << 4)
+#define GPIO_PUPDR_PUPDR2_0  (0x1U << 4)
+#define GPIO_PUPDR_PUPDR2_1  (0x2U << 4)
+#define GPIO_BSRR_BS_2  (0x1U << 2)
+#define GPIO_BSRR_BR_2  (0x1U << 18)
+#define GPIO_ODR_2  (0x1U << 2)
+#define GPIO_IDR_2  (0x1U << 2)
+#define GPIO_MODER_MODER3_Msk  (0x3U << 6)
+#define GPIO_MODER_MODER3  (0x3U << 6)
+#define GPIO_MODER_MODER3_0  (0x1U << 6)
+#define GPIO_MODER_MODER3_1  (0x2U << 6)
+#define GPIO_OSPEEDER_OSPEEDR3_Msk  (0x3U << 6)
+#define GPIO_OSPEEDER_OSPEEDR3  (0x3U << 6)
+#define GPIO_OSPEEDER_OSPEEDR3_0  (0x1U << 6)
+#define GPIO_OSPEEDER_OSPEEDR3_1  (0x2U << 6)
+#define GPIO_PUPDR_PUPDR3_Msk  (0x3U << 6)
+#define GPIO_PUPDR_PUPDR3  (0x3U << 6)
+#define GPIO_PUPDR_PUPDR3_0  (0x1U << 6)
+#define GPIO_PUPDR_PUPDR3_1  (0x2U << 6)
+#define GPIO_BSRR_BS_3  (0x1U << 3)
+#define GPIO_BSRR_BR_3  (0x1U << 19)
+#define GPIO_ODR_3  (0x1U << 3)
+#define GPIO_IDR_3  (0x1U << 3)
+#define GPIO_MODER_MODER4_Msk  (0x3U << 8)
+#define GPIO_MODER_MODER4  (0x3U << 8)
+#define GPIO_MODER_MODER4_0  (0x1U << 8)
+#define GPIO_MODER_MODER4_1  (0x2U << 8)
+#define GPIO_OSPEEDER_OSPEEDR4_Msk  (0x3U << 8)
+#define GPIO_OSPEEDER_OSPEEDR4  (0x3U << 8)
+#define GPIO_OSPEEDER_OSPEEDR4_0  (0x1U << 8)
+#define GPIO_OSPEEDER_OSPEEDR4_1  (0x2U << 8)
+#define GPIO_PUPDR_PUPDR4_Msk  (0x3U << 8)
+#define GPIO_PUPDR_PUPDR4  (0x3U << 8)
+#define GPIO_PUPDR_PUPDR4_0  (0x1U << 8)
+#define GPIO_PUPDR_PUPDR4_1  (0x2U << 8)
+#define GPIO_BSRR_BS_4  (0x1U << 4)
+#define GPIO_BSRR_BR_4  (0x1U << 20)
+#define GPIO_ODR_4  (0x1U << 4)
+#define GPIO_IDR_4  (0x1U << 4)
+#define GPIO_MODER_MODER5_Msk  (0x3U << 10)
+#define GPIO_MODER_MODER5  (0x3U << 10)
+#define GPIO_MODER_MODER5_0  (0x1U << 10)
+#define GPIO_MODER_MODER5_1  (0x2U << 10)
+#define GPIO_OSPEEDER_OSPEEDR5_Msk  (0x3U << 10)
+#define GPIO_OSPEEDER_OSPEEDR5  (0x3U << 10)
+#define GPIO_OSPEEDER_OSPEEDR5_0  (0x1U << 10)
+#define GPIO_OSPEEDER_OSPEEDR5_1  (0x2U << 10)
+#define GPIO_PUPDR_PUPDR5_Msk  (0x3U << 10)
+#define GPIO_PUPDR_PUPDR5  (0x3U << 10)
+#define GPIO_PUPDR_PUPDR5_0  (0x1U << 10)
+#define GPIO_PUPDR_PUPDR5_1  (0x2U << 10)
+#define GPIO_BSRR_BS_5  (0x1U << 5)
+#define GPIO_BSRR_BR_5  (0x1U << 21)
+#define GPIO_ODR_5  (0x1U << 5)
+#define GPIO_IDR_5  (0x1U << 5)
+#define GPIO_MODER_MODER6_Msk  (0x3U << 12)
+#define GPIO_MODER_MODER6  (0x3U << 12)
+#define GPIO_MODER_MODER6_0  (0x1U << 12)
+#define GPIO_MODER_MODER6_1  (0x2U << 12)
+#define GPIO_OSPEEDER_OSPEEDR6_Msk  (0x3U << 12)
+#define GPIO_OSPEEDER_OSPEEDR6  (0x3U << 12)
+#define GPIO_OSPEEDER_OSPEEDR6_0  (0x1U << 12)
+#define GPIO_OSPEEDER_OSPEEDR6_1  (0x2U << 12)
+#define GPIO_PUPDR_PUPDR6_Msk  (0x3U << 12)
+#define GPIO_PUPDR_PUPDR6  (0x3U << 12)
+#define GPIO_PUPDR_PUPDR6_0  (0x1U << 12)
+#define GPIO_PUPDR_PUPDR6_1  (0x2U << 12)
+#define GPIO_BSRR_BS_6  (0x1U << 6)
+#define GPIO_BSRR_BR_6  (0x1U << 22)
+#define GPIO_ODR_6  (0x1U << 6)
+#define GPIO_IDR_6  (0x1U << 6)
+#define GPIO_MODER_MODER7_Msk  (0x3U << 14)
+#define GPIO_MODER_MODER7  (0x3U << 14)
+#define GPIO_MODER_MODER7_0  (0x1U << 14)
+#define GPIO_MODER_MODER7_1  (0x2U << 14)
+#define GPIO_OSPEEDER_OSPEEDR7_Msk  (0x3U << 14)
+#define GPIO_OSPEEDER_OSPEEDR7  (0x3U << 14)
+#define GPIO_OSPEEDER_OSPEEDR7_0  (0x1U << 14)
+#define GPIO_OSPEEDER_OSPEEDR7_1  (0x2U << 14)
+#define GPIO_PUPDR_PUPDR7_Msk  (0x3U << 14)
+#define GPIO_PUPDR_PUPDR7  (0x3U << 14)
+#define GPIO_PUPDR_PUPDR7_0  (0x1U << 14)
+#define GPIO_PUPDR_PUPDR7_1  (0x2U << 14)
+#define GPIO_BSRR_BS_7  (0x1U << 7)
+#define GPIO_BSRR_BR_7  (0x1U << 23)
+#define GPIO_ODR_7  (0x1U << 7)
+#define GPIO_IDR_7  (0x1U << 7)
+#define GPIO_MODER_MODER8_Msk  (0x3U << 16)
+#define GPIO_MODER_MODER8  (0x3U << 16)
+#define GPIO_MODER_MODER8_0  (0x1U << 16)
+#define GPIO_MODER_MODER8_1  (0x2U << 16)
+#define GPIO_OSPEEDER_OSPEEDR8_Msk  (0x3U << 16)
+#define GPIO_OSPEEDER_OSPEEDR8  (0x3U << 16)
+#define GPIO_OSPEEDER_OSPEEDR8_0  (0x1U << 16)
+#define GPIO_OSPEEDER_OSPEEDR8_1  (0x2U << 16)
+#define GPIO_PUPDR_PUPDR8_Msk  (0x3U << 16)
+#define GPIO_PUPDR_PUPDR8  (0x3U << 16)
+#define GPIO_PUPDR_PUPDR8_0  (0x1U << 16)
+#define GPIO_PUPDR_PUPDR8_1  (0x2U << 16)
+#define GPIO_BSRR_BS_8  (0x1U << 8)
+#define GPIO_BSRR_BR_8  (0x1U << 24)
+#define GPIO_ODR_8  (0x1U << 8)
+#define GPIO_IDR_8  (0x1U << 8)
+#define GPIO_MODER_MODER9_Msk  (0x3U << 18)
+#define GPIO_MODER_MODER9  (0x3U << 18)
+#define GPIO_MODER_MODER9_0  (0x1U << 18)
+#define GPIO_MODER_MODER9_1  (0x2U << 18)
+#define GPIO_OSPEEDER_OSPEEDR9_Msk  (0x3U << 18)
+#define GPIO_OSPEEDER_OSPEEDR9  (0x3U << 18)
+#define GPIO_OSPEEDER_OSPEEDR9_0  (0x1U << 18)
+#define GPIO_OSPEEDER_OSPEEDR9_1  (0x2U << 18)
+#define GPIO_PUPDR_PUPDR9_Msk  (0x3U << 18)
+#define GPIO_PUPDR_PUPDR9  (0x3U << 18)
+#define GPIO_PUPDR_PUPDR9_0  (0x1U << 18)
+#define GPIO_PUPDR_PUPDR9_1  (0x2U << 18)
+#define GPIO_BSRR_BS_9  (0x1U << 9)
+#define GPIO_BSRR_BR_9  (0x1U << 25)
+#define GPIO_ODR_9  (0x1U << 9)
+#define GPIO_IDR_9  (0x1U << 9)
+#define GPIO_MODER_MODER10_Msk  (0x3U << 20)
+#define GPIO_MODER_MODER10  (0x3U << 20)
+#define GPIO_MODER_MODER10_0  (0x1U << 20)
+#define GPIO_MODER_MODER10_1  (0x2U << 20)
+#define GPIO_OSPEEDER_OSPEEDR10_Msk  (0x3U << 20)
+#define GPIO_OSPEEDER_OSPEEDR10  (0x3U << 20)
+#define GPIO_OSPEEDER_OSPEEDR10_0  (0x1U << 20)
+#define GPIO_OSPEEDER_OSPEEDR10_1  (0x2U << 20)
+#define GPIO_PUPDR_PUPDR10_Msk  (0x3U << 20)
+#define GPIO_PUPDR_PUPDR10  (0x3U << 20)
+#define GPIO_PUPDR_PUPDR10_0  (0x1U << 20)
+#define GPIO_PUPDR_PUPDR10_1  (0x2U << 20)
+#define GPIO_BSRR_BS_10  (0x1U << 10)
+#define GPIO_BSRR_BR_10  (0x1U << 26)
+#define GPIO_ODR_10  (0x1U << 10)
+#define GPIO_IDR_10  (0x1U << 10)
+#define GPIO_MODER_MODER11_Msk  (0x3U << 22)
+#define GPIO_MODER_MODER11  (0x3U << 22)
+#define GPIO_MODER_MODER11_0  (0x1U << 22)
+#define GPIO_MODER_MODER11_1  (0x2U << 22)
+#define GPIO_OSPEEDER_OSPEEDR11_Msk  (0x3U << 22)
+#define GPIO_OSPEEDER_OSPEEDR11  (0x3U << 22)
+#define GPIO_OSPEEDER_OSPEEDR11_0  (0x1U << 22)
+#define GPIO_OSPEEDER_OSPEEDR11_1  (0x2U << 22)
+#define GPIO_PUPDR_PUPDR11_Msk  (0x3U << 22)
+#define GPIO_PUPDR_PUPDR11  (0x3U << 22)
+#define GPIO_PUPDR_PUPDR11_0  (0x1U << 22)
+#define GPIO_PUPDR_PUPDR11_1  (0x2U << 22)
+#define GPIO_BSRR_BS_11  (0x1U << 11)
+#define GPIO_BSRR_BR_11  (0x1U << 27)
+#define GPIO_ODR_11  (0x1U << 11)
+#define GPIO_IDR_11  (0x1U << 11)
+#define GPIO_MODER_MODER12_Msk  (0x3U << 24)
+#define GPIO_MODER_MODER12  (0x3U << 24)
+#define GPIO_MODER_MODER12_0  (0x1U << 24)
+#define GPIO_MODER_MODER12_1  (0x2U << 24)
+#define GPIO_OSPEEDER_OSPEEDR12_Msk  (0x3U << 24)
+#define GPIO_OSPEEDER_OSPEEDR12  (0x3U << 24)
+#define GPIO_OSPEEDER_OSPEEDR12_0  (0x1U << 24)
+#define GPIO_OSPEEDER_OSPEEDR12_1  (0x2U << 24)
+#define GPIO_PUPDR_PUPDR12_Msk  (0x3U << 24)
+#define GPIO_PUPDR_PUPDR12  (0x3U << 24)
+#define GPIO_PUPDR_PUPDR12_0  (0x1U << 24)
+#define GPIO_PUPDR_PUPDR12_1  (0x2U << 24)
+#define GPIO_BSRR_BS_12  (0x1U << 12)
+#define GPIO_BSRR_BR_12  (0x1U << 28)
+#define GPIO_ODR_12  (0x1U << 12)
+#define GPIO_IDR_12  (0x1U << 12)
+#define GPIO_MODER_MODER13_Msk  (0x3U << 26)
+#define GPIO_MODER_MODER13  (0x3U << 26)
+#define GPIO_MODER_MODER13_0  (0x1U << 26)
+#define GPIO_MODER_MODER13_1  (0x2U << 26)
+#define GPIO_OSPEEDER_OSPEEDR13_Msk  (0x3U << 26)
+#define GPIO_OSPEEDER_OSPEEDR13  (0x3U << 26)
+#define GPIO_OSPEEDER_OSPEEDR13_0  (0x1U << 26)
+#define GPIO_OSPEEDER_OSPEEDR13_1  (0x2U << 26)
+#define GPIO_PUPDR_PUPDR13_Msk  (0x3U << 26)
+#define GPIO_PUPDR_PUPDR13  (0x3U << 26)
+#define GPIO_PUPDR_PUPDR13_0  (0x1U << 26)
+#define GPIO_PUPDR_PUPDR13_1  (0x2U << 26)
+#define GPIO_BSRR_BS_13  (0x1U << 13)
+#define GPIO_BSRR_BR_13  (0x1U << 29)
+#define GPIO_ODR_13  (0x1U << 13)
+#define GPIO_IDR_13  (0x1U << 13)
+#define GPIO_MODER_MODER14_Msk  (0x3U << 28)
+#define GPIO_MODER_MODER14  (0x3U << 28)
+#define GPIO_MODER_MODER14_0  (0x1U << 28)
+#define GPIO_MODER_MODER14_1  (0x2U << 28)
+#define GPIO_OSPEEDER_OSPEEDR14_Msk  (0x3U << 28)
+#define GPIO_OSPEEDER_OSPEEDR14  (0x3U << 28)
+#define GPIO_OSPEEDER_OSPEEDR14_0  (0x1U << 28)
+#define GPIO_OSPEEDER_OSPEEDR14_1  (0x2U << 28)
+#define GPIO_PUPDR_PUPDR14_Msk  (0x3U << 28)
+#define GPIO_PUPDR_PUPDR14  (0x3U << 28)
+#define GPIO_PUPDR_PUPDR14_0  (0x1U << 28)
+#define GPIO_PUPDR_PUPDR14_1  (0x2U << 28)
+#define GPIO_BSRR_BS_14  (0x1U << 14)
+#define GPIO_BSRR_BR_14  (0x1U << 30)
+#define GPIO_ODR_14  (0x1U << 14)
+#define GPIO_IDR_14  (0x1U << 14)
+#define GPIO_MODER_MODER15_Msk  (0x3U << 30)
+#define GPIO_MODER_MODER15  (0x3U << 30)
+#define GPIO_MODER_MODER15_0  (0x1U << 30)
+#define GPIO_MODER_MODER15_1  (0x2U << 30)
+#define GPIO_OSPEEDER_OSPEEDR15_Msk  (0x3U << 30)
+#define GPIO_OSPEEDER_OSPEEDR15  (0x3U << 30)
+#define GPIO_OSPEEDER_OSPEEDR15_0  (0x1U << 30)
+#define GPIO_OSPEEDER_OSPEEDR15_1  (0x2U << 30)
+#define GPIO_PUPDR_PUPDR15_Msk  (0x3U << 30)
+#define GPIO_PUPDR_PUPDR15  (0x3U << 30)
+#define GPIO_PUPDR_PUPDR15_0  (0x1U << 30)
+#define GPIO_PUPDR_PUPDR15_1  (0x2U << 30)
+#define GPIO_BSRR_BS_15  (0x1U << 15)
+#define GPIO_BSRR_BR_15  (0x1U << 31)
+#define GPIO_ODR_15  (0x1U << 15)
+#define GPIO_IDR_15  (0x1U << 15)
+#define GPIO_AFRL_AFRL0_Pos  0U
+#define GPIO_AFRL_AFRL0  (0xFU << 0)
+#define GPIO_AFRH_AFRH0_Pos  0U
+#define GPIO_AFRH_AFRH0  (0xFU << 0)
+#define GPIO_AFRL_AFRL1_Pos  4U
+#define GPIO_AFRL_AFRL1  (0xFU << 4)
+#define GPIO_AFRH_AFRH1_Pos  4U
+#define GPIO_AFRH_AFRH1  (0xFU << 4)
+#define GPIO_AFRL_AFRL2_Pos  8U
+#define GPIO_AFRL_AFRL2  (0xFU << 8)
+#define GPIO_AFRH_AFRH2_Pos  8U
+#define GPIO_AFRH_AFRH2  (0xFU << 8)
+#define GPIO_AFRL_AFRL3_Pos  12U
+#define GPIO_AFRL_AFRL3  (0xFU << 12)
+#define GPIO_AFRH_AFRH3_Pos  12U
+#define GPIO_AFRH_AFRH3  (0xFU << 12)
+#define GPIO_AFRL_AFRL4_Pos  16U
+#define GPIO_AFRL_AFRL4  (0xFU << 16)
+#define GPIO_AFRH_AFRH4_Pos  16U
+#define GPIO_AFRH_AFRH4  (0xFU << 16)
+#define GPIO_AFRL_AFRL5_Pos  20U
+#define GPIO_AFRL_AFRL5  (0xFU << 20)
+#define GPIO_AFRH_AFRH5_Pos  20U
+#define GPIO_AFRH_AFRH5  (0xFU << 20)
+#define GPIO_AFRL_AFRL6_Pos  24U
+#define GPIO_AFRL_AFRL6  (0xFU << 24)
+#define GPIO_AFRH_AFRH6_Pos  24U
+#define GPIO_AFRH_AFRH6  (0xFU << 24)
+#define GPIO_AFRL_AFRL7_Pos  28U
+#define GPIO_AFRL_AFRL7  (0xFU << 28)
+#define GPIO_AFRH_AFRH7_Pos  28U
+#define GPIO_AFRH_AFRH7  (0xFU << 28)
+//-----------------------------------------------------------------------------
+#define CAN_RF0R_FMP0_Pos  0U
+#define CAN_RF0R_FMP0_Msk  (0x3U << 0)
+#define CAN_RF0R_FMP0  CAN_RF0R_FMP0_Msk
+#define CAN_RF0R_FMP0_0  (0x1U << 0)
+#define CAN_RF0R_FMP0_1  (0x1U << 1)
+#define CAN_RF0R_FOVR0_Pos  4U
+#define CAN_RF0R_FOVR0_Msk  (0x1U << 4)
+#define CAN_RF0R_FOVR0  CAN_RF0R_FOVR0_Msk
+#define CAN_RF0R_FOVR0_0  (0x1U << 4)
+#define CAN_RF0R_FULL0_Pos  3U
+#define CAN_RF0R_FULL0_Msk  (0x1U << 3)
+#define CAN_RF0R_FULL0  CAN_RF0R_FULL0_Msk
+#define CAN_RF0R_FULL0_0  (0x1U << 3)
+#define CAN_RI0R_STID_Pos  21U
+#define CAN_RI0R_STID_Msk  (0x7FFU << 21)
+#define CAN_RI0R_STID  CAN_RI0R_STID_Msk
+#define CAN_RI0R_STID_0  (0x1U << 21)
+#define CAN_RI0R_STID_1  (0x1U << 22)
+#define CAN_RI0R_STID_2  (0x1U << 23)
+#define CAN_RI0R_STID_3  (0x1U << 24)
+#define CAN_RI0R_STID_4  (0x1U << 25)
+#define CAN_RI0R_STID_5  (0x1U << 26)
+#define CAN_RI0R_STID_6  (0x1U << 27)
+#define CAN_RI0R_STID_7  (0x1U << 28)
+#define CAN_RI0R_STID_8  (0x1U << 29)
+#define CAN_RI0R_STID_9  (0x1U << 30)
+#define CAN_RI0R_STID_10  (0x1U << 31)
+#define CAN_RI0R_EXID_Pos  3U
+#define CAN_RI0R_EXID_Msk  (0x3FFFFU << 3)
+#define CAN_RI0R_EXID  CAN_RI0R_EXID_Msk
+#define CAN_RI0R_EXID_0  (0x1U << 3)
+#define CAN_RI0R_EXID_1  (0x1U << 4)
+#define CAN_RI0R_EXID_2  (0x1U << 5)
+#define CAN_RI0R_EXID_3  (0x1U << 6)
+#define CAN_RI0R_EXID_4  (0x1U << 7)
+#define CAN_RI0R_EXID_5  (0x1U << 8)
+#define CAN_RI0R_EXID_6  (0x1U << 9)
+#define CAN_RI0R_EXID_7  (0x1U << 10)
+#define CAN_RI0R_EXID_8  (0x1U << 11)
+#define CAN_RI0R_EXID_9  (0x1U << 12)
+#define CAN_RI0R_EXID_10  (0x1U << 13)
+#define CAN_RI0R_EXID_11  (0x1U << 14)
+#define CAN_RI0R_EXID_12  (0x1U << 15)
+#define CAN_RI0R_EXID_13  (0x1U << 16)
+#define CAN_RI0R_EXID_14  (0x1U << 17)
+#define CAN_RI0R_EXID_15  (0x1U << 18)
+#define CAN_RI0R_EXID_16  (0x1U << 19)
+#define CAN_RI0R_EXID_17  (0x1U << 20)
+#define CAN_TI0R_STID_Pos  21U
+#define CAN_TI0R_STID_Msk  (0x7FFU << 21)
+#define CAN_TI0R_STID  CAN_TI0R_STID_Msk
+#define CAN_TI0R_STID_0  (0x1U << 21)
+#define CAN_TI0R_STID_1  (0x1U << 22)
+#define CAN_TI0R_STID_2  (0x1U << 23)
+#define CAN_TI0R_STID_3  (0x1U << 24)
+#define CAN_TI0R_STID_4  (0x1U << 25)
+#define CAN_TI0R_STID_5  (0x1U << 26)
+#define CAN_TI0R_STID_6  (0x1U << 27)
+#define CAN_TI0R_STID_7  (0x1U << 28)
+#define CAN_TI0R_STID_8  (0x1U << 29)
+#define CAN_TI0R_STID_9  (0x1U << 30)
+#define CAN_TI0R_STID_10  (0x1U << 31)
+#define CAN_TDT0R_DLC_Pos  0U
+#define CAN_TDT0R_DLC_Msk  (0xFU << 0)
+#define CAN_TDT0R_DLC  CAN_TDT0R_DLC_Msk
+#define CAN_TDT0R_DLC_0  (0x1U << 0)
+#define CAN_TDT0R_DLC_1  (0x1U << 1)
+#define CAN_TDT0R_DLC_2  (0x1U << 2)
+#define CAN_TDT0R_DLC_3  (0x1U << 3)
+#define CAN_RDT0R_DLC_Pos  0U
+#define CAN_RDT0R_DLC_Msk  (0xFU << 0)
+#define CAN_RDT0R_DLC  CAN_RDT0R_DLC_Msk
+#define CAN_RDT0R_DLC_0  (0x1U << 0)
+#define CAN_RDT0R_DLC_1  (0x1U << 1)
+#define CAN_RDT0R_DLC_2  (0x1U << 2)
+#define CAN_RDT0R_DLC_3  (0x1U << 3)
+#define CAN_RDT0R_FMI_Pos  8U
+#define CAN_RDT0R_FMI_Msk  (0xFFU << 8)
+#define CAN_RDT0R_FMI  CAN_RDT0R_FMI_Msk
+#define CAN_RDT0R_FMI_0  (0x1U << 8)
+#define CAN_RDT0R_FMI_1  (0x1U << 9)
+#define CAN_RDT0R_FMI_2  (0x1U << 10)
+#define CAN_RDT0R_FMI_3  (0x1U << 11)
+#define CAN_RDT0R_FMI_4  (0x1U << 12)
+#define CAN_RDT0R_FMI_5  (0x1U << 13)
+#define CAN_RDT0R_FMI_6  (0x1U << 14)
+#define CAN_RDT0R_FMI_7  (0x1U << 15)
+#define CAN_RDT0R_TIME_Pos  16U
+#define CAN_RDT0R_TIME_Msk  (0xFFFFU << 16)
+#define CAN_RDT0R_TIME  CAN_RDT0R_TIME_Msk
+#define CAN_RDT0R_TIME_0  (0x1U << 16)
+#define CAN_RDT0R_TIME_1  (0x1U << 17)
+#define CAN_RDT0R_TIME_2  (0x1U << 18)
+#define CAN_RDT0R_TIME_3  (0x1U << 19)
+#define CAN_RDT0R_TIME_4  (0x1U << 20)
+#define CAN_RDT0R_TIME_5  (0x1U << 21)
+#define CAN_RDT0R_TIME_6  (0x1U << 22)
+#define CAN_RDT0R_TIME_7  (0x1U << 23)
+#define CAN_RDT0R_TIME_8  (0x1U << 24)
+#define CAN_RDT0R_TIME_9  (0x1U << 25)
+#define CAN_RDT0R_TIME_10  (0x1U << 26)
+#define CAN_RDT0R_TIME_11  (0x1U << 27)
+#define CAN_RDT0R_TIME_12  (0x1U << 28)
+#define CAN_RDT0R_TIME_13  (0x1U << 29)
+#define CAN_RDT0R_TIME_14  (0x1U << 30)
+#define CAN_RDT0R_TIME_15  (0x1U << 31)
+#define CAN_TDT0R_TIME_Pos  16U
+#define CAN_TDT0R_TIME_Msk  (0xFFFFU << 16)
+#define CAN_TDT0R_TIME  CAN_TDT0R_TIME_Msk
+#define CAN_TDT0R_TIME_0  (0x1U << 16)
+#define CAN_TDT0R_TIME_1  (0x1U << 17)
+#define CAN_TDT0R_TIME_2  (0x1U << 18)
+#define CAN_TDT0R_TIME_3  (0x1U << 19)
+#define CAN_TDT0R_TIME_4  (0x1U << 20)
+#define CAN_TDT0R_TIME_5  (0x1U << 21)
+#define CAN_TDT0R_TIME_6  (0x1U << 22)
+#define CAN_TDT0R_TIME_7  (0x1U << 23)
+#define CAN_TDT0R_TIME_8  (0x1U << 24)
+#define CAN_TDT0R_TIME_9  (0x1U << 25)
+#define CAN_TDT0R_TIME_10  (0x1U << 26)
+#define CAN_TDT0R_TIME_11  (0x1U << 27)
+#define CAN_TDT0R_TIME_12  (0x1U << 28)
+#define CAN_TDT0R_TIME_13  (0x1U << 29)
+#define CAN_TDT0R_TIME_14  (0x1U << 30)
+#define CAN_TDT0R_TIME_15  (0x1U << 31)
+#define CAN_ESR_REC_Pos  24U
+#define CAN_ESR_REC_Msk  (0xFFU << 24)
+#define CAN_ESR_REC  CAN_ESR_REC_Msk
+#define CAN_ESR_REC_0  (0x1U << 24)
+#define CAN_ESR_REC_1  (0x1U << 25)
+#define CAN_ESR_REC_2  (0x1U << 26)
+#define CAN_ESR_REC_3  (0x1U << 27)
+#define CAN_ESR_REC_4  (0x1U << 28)
+#define CAN_ESR_REC_5  (0x1U << 29)
+#define CAN_ESR_REC_6  (0x1U << 30)
+#define CAN_ESR_REC_7  (0x1U << 31)
+#define CAN_ESR_TEC_Pos  16U
+#define CAN_ESR_TEC_Msk  (0xFFU << 16)
+#define CAN_ESR_TEC  CAN_ESR_TEC_Msk
+#define CAN_ESR_TEC_0  (0x1U << 16)
+#define CAN_ESR_TEC_1  (0x1U << 17)
+#define CAN_ESR_TEC_2  (0x1U << 18)
+#define CAN_ESR_TEC_3  (0x1U << 19)
+#define CAN_ESR_TEC_4  (0x1U << 20)
+#define CAN_ESR_TEC_5  (0x1U << 21)
+#define CAN_ESR_TEC_6  (0x1U << 22)
+#define CAN_ESR_TEC_7  (0x1U << 23)
+#define CAN_ESR_LEC_Pos  4U
+#define CAN_ESR_LEC_Msk  (0x7U << 4)
+#define CAN_ESR_LEC  CAN_ESR_LEC_Msk
+#define CAN_ESR_LEC_0  (0x1U << 4)
+#define CAN_ESR_LEC_1  (0x1U << 5)
+#define CAN_ESR_LEC_2  (0x1U << 6)
+#define CAN_BTR_SJW_Pos  24U
+#define CAN_BTR_SJW_Msk  (0x3U << 24)
+#define CAN_BTR_SJW  CAN_BTR_SJW_Msk
+#define CAN_BTR_SJW_0  (0x1U << 24)
+#define CAN_BTR_SJW_1  (0x1U << 25)
+#define CAN_BTR_TS2_Pos  20U
+#define CAN_BTR_TS2_Msk  (0x7U << 20)
+#define CAN_BTR_TS2  CAN_BTR_TS2_Msk
+#define CAN_BTR_TS2_0  (0x1U << 20)
+#define CAN_BTR_TS2_1  (0x1U << 21)
+#define CAN_BTR_TS2_2  (0x1U << 22)
+#define CAN_BTR_TS1_Pos  16U
+#define CAN_BTR_TS1_Msk  (0xFU << 16)
+#define CAN_BTR_TS1  CAN_BTR_TS1_Msk
+#define CAN_BTR_TS1_0  (0x1U << 16)
+#define CAN_BTR_TS1_1  (0x1U << 17)
+#define CAN_BTR_TS1_2  (0x1U << 18)
+#define CAN_BTR_TS1_3  (0x1U << 19)
+#define CAN_BTR_BRP_Pos  0U
+#define CAN_BTR_BRP_Msk  (0x3FFU << 0)
+#define CAN_BTR_BRP  CAN_BTR_BRP_Msk
+#define CAN_BTR_BRP_0  (0x1U << 0)
+#define CAN_BTR_BRP_1  (0x1U << 1)
+#define CAN_BTR_BRP_2  (0x1U << 2)
+#define CAN_BTR_BRP_3  (0x1U << 3)
+#define CAN_BTR_BRP_4  (0x1U << 4)
+#define CAN_BTR_BRP_5  (0x1U << 5)
+#define CAN_BTR_BRP_6  (0x1U << 6)
+#define CAN_BTR_BRP_7  (0x1U << 7)
+#define CAN_BTR_BRP_8  (0x1U << 8)
+#define CAN_BTR_BRP_9  (0x1U << 9)
+#define CAN_TSR_CODE_Pos  24U
+#define CAN_TSR_CODE_Msk  (0x3U << 24)
+#define CAN_TSR_CODE  CAN_TSR_CODE_Msk
+#define CAN_TSR_CODE_0  (0x1U << 24)
+#define CAN_TSR_CODE_1  (0x1U << 25)
+#define ADC_CR_ADVREGEN_Pos  28U
+#define ADC_CR_ADVREGEN_Msk  (0x3U << 28)
+#define ADC_CR_ADVREGEN  ADC_CR_ADVREGEN_Msk
+#define ADC_CR_ADVREGEN_0  (0x1U << 28)
+#define ADC_CR_ADVREGEN_1  (0x1U << 29)
+#define ADC_SQR1_L_Pos  0U
+#define ADC_SQR1_L_Msk  (0xFU << 0)
+#define ADC_SQR1_L  ADC_SQR1_L_Msk
+#define ADC_SQR1_L_0  (0x1U << 0)
+#define ADC_SQR1_L_1  (0x1U << 1)
+#define ADC_SQR1_L_2  (0x1U << 2)
+#define ADC_SQR1_L_3  (0x1U << 3)
+#define ADC_SQR1_SQ1_Pos  6U
+#define ADC_SQR1_SQ1_Msk  (0x1FU << 6)
+#define ADC_SQR1_SQ1  ADC_SQR1_SQ1_Msk
+#define ADC_SQR1_SQ1_0  (0x1U << 6)
+#define ADC_SQR1_SQ1_1  (0x1U << 7)
+#define ADC_SQR1_SQ1_2  (0x1U << 8)
+#define ADC_SQR1_SQ1_3  (0x1U << 9)
+#define ADC_SQR1_SQ1_4  (0x1U << 10)
+#define ADC_SQR1_SQ2_Pos  12U
+#define ADC_SQR1_SQ2_Msk  (0x1FU << 12)
+#define ADC_SQR1_SQ2  ADC_SQR1_SQ2_Msk
+#define ADC_SQR1_SQ2_0  (0x1U << 12)
+#define ADC_SQR1_SQ2_1  (0x1U << 13)
+#define ADC_SQR1_SQ2_2  (0x1U << 14)
+#define ADC_SQR1_SQ2_3  (0x1U << 15)
+#define ADC_SQR1_SQ2_4  (0x1U << 16)
+#define ADC_SQR1_SQ3_Pos  18U
+#define ADC_SQR1_SQ3_Msk  (0x1FU << 18)
+#define ADC_SQR1_SQ3  ADC_SQR1_SQ3_Msk
+#define ADC_SQR1_SQ3_0  (0x1U << 18)
+#define ADC_SQR1_SQ3_1  (0x1U << 19)
+#define ADC_SQR1_SQ3_2  (0x1U << 20)
+#define ADC_SQR1_SQ3_3  (0x1U << 21)
+#define ADC_SQR1_SQ3_4  (0x1U << 22)
+#define ADC_SQR1_SQ4_Pos  24U
+#define ADC_SQR1_SQ4_Msk  (0x1FU << 24)
+#define ADC_SQR1_SQ4  ADC_SQR1_SQ4_Msk
+#define ADC_SQR1_SQ4_0  (0x1U << 24)
+#define ADC_SQR1_SQ4_1  (0x1U << 25)
+#define ADC_SQR1_SQ4_2  (0x1U << 26)
+#define ADC_SQR1_SQ4_3  (0x1U << 27)
+#define ADC_SQR1_SQ4_4  (0x1U << 28)
+#define ADC_SQR2_SQ5_Pos  0U
+#define ADC_SQR2_SQ5_Msk  (0x1FU << 0)
+#define ADC_SQR2_SQ5  ADC_SQR2_SQ5_Msk
+#define ADC_SQR2_SQ5_0  (0x1U << 0)
+#define ADC_SQR2_SQ5_1  (0x1U << 1)
+#define ADC_SQR2_SQ5_2  (0x1U << 2)
+#define ADC_SQR2_SQ5_3  (0x1U << 3)
+#define ADC_SQR2_SQ5_4  (0x1U << 4)
+#define ADC_SQR2_SQ6_Pos  6U
+#define ADC_SQR2_SQ6_Msk  (0x1FU << 6)
+#define ADC_SQR2_SQ6  ADC_SQR2_SQ6_Msk
+#define ADC_SQR2_SQ6_0  (0x1U << 6)
+#define ADC_SQR2_SQ6_1  (0x1U << 7)
+#define ADC_SQR2_SQ6_2  (0x1U << 8)
+#define ADC_SQR2_SQ6_3  (0x1U << 9)
+#define ADC_SQR2_SQ6_4  (0x1U << 10)
+#define ADC_SQR2_SQ7_Pos  12U
+#define ADC_SQR2_SQ7_Msk  (0x1FU << 12)
+#define ADC_SQR2_SQ7  ADC_SQR2_SQ7_Msk
+#define ADC_SQR2_SQ7_0  (0x1U << 12)
+#define ADC_SQR2_SQ7_1  (0x1U << 13)
+#define ADC_SQR2_SQ7_2  (0x1U << 14)
+#define ADC_SQR2_SQ7_3  (0x1U << 15)
+#define ADC_SQR2_SQ7_4  (0x1U << 16)
+#define ADC_SQR2_SQ8_Pos  18U
+#define ADC_SQR2_SQ8_Msk  (0x1FU << 18)
+#define ADC_SQR2_SQ8  ADC_SQR2_SQ8_Msk
+#define ADC_SQR2_SQ8_0  (0x1U << 18)
+#define ADC_SQR2_SQ8_1  (0x1U << 19)
+#define ADC_SQR2_SQ8_2  (0x1U << 20)
+#define ADC_SQR2_SQ8_3  (0x1U << 21)
+#define ADC_SQR2_SQ8_4  (0x1U << 22)
+#define ADC_SQR2_SQ9_Pos  24U
+#define ADC_SQR2_SQ9_Msk  (0x1FU << 24)
+#define ADC_SQR2_SQ9  ADC_SQR2_SQ9_Msk
+#define ADC_SQR2_SQ9_0  (0x1U << 24)
+#define ADC_SQR2_SQ9_1  (0x1U << 25)
+#define ADC_SQR2_SQ9_2  (0x1U << 26)
+#define ADC_SQR2_SQ9_3  (0x1U << 27)
+#define ADC_SQR2_SQ9_4  (0x1U << 28)
+#define ADC_SMPR1_SMP1_Pos  3U
+#define ADC_SMPR1_SMP1_Msk  (0x7U << 3)
+#define ADC_SMPR1_SMP1  ADC_SMPR1_SMP1_Msk
+#define ADC_SMPR1_SMP1_0  (0x1U << 3)
+#define ADC_SMPR1_SMP1_1  (0x1U << 4)
+#define ADC_SMPR1_SMP1_2  (0x1U << 5)
+#define ADC_SMPR1_SMP2_Pos  6U
+#define ADC_SMPR1_SMP2_Msk  (0x7U << 6)
+#define ADC_SMPR1_SMP2  ADC_SMPR1_SMP2_Msk
+#define ADC_SMPR1_SMP2_0  (0x1U << 6)
+#define ADC_SMPR1_SMP2_1  (0x1U << 7)
+#define ADC_SMPR1_SMP2_2  (0x1U << 8)
+#define ADC_SMPR1_SMP3_Pos  9U
+#define ADC_SMPR1_SMP3_Msk  (0x7U << 9)
+#define ADC_SMPR1_SMP3  ADC_SMPR1_SMP3_Msk
+#define ADC_SMPR1_SMP3_0  (0x1U << 9)
+#define ADC_SMPR1_SMP3_1  (0x1U << 10)
+#define ADC_SMPR1_SMP3_2  (0x1U << 11)
+#define ADC_SMPR1_SMP4_Pos  12U
+#define ADC_SMPR1_SMP4_Msk  (0x7U << 12)
+#define ADC_SMPR1_SMP4  ADC_SMPR1_SMP4_Msk
+#define ADC_SMPR1_SMP4_0  (0x1U << 12)
+#define ADC_SMPR1_SMP4_1  (0x1U << 13)
+#define ADC_SMPR1_SMP4_2  (0x1U << 14)
+#define ADC_SMPR1_SMP5_Pos  15U
+#define ADC_SMPR1_SMP5_Msk  (0x7U << 15)
+#define ADC_SMPR1_SMP5  ADC_SMPR1_SMP5_Msk
+#define ADC_SMPR1_SMP5_0  (0x1U << 15)
+#define ADC_SMPR1_SMP5_1  (0x1U << 16)
+#define ADC_SMPR1_SMP5_2  (0x1U << 17)
+#define ADC_SMPR1_SMP6_Pos  18U
+#define ADC_SMPR1_SMP6_Msk  (0x7U << 18)
+#define ADC_SMPR1_SMP6  ADC_SMPR1_SMP6_Msk
+#define ADC_SMPR1_SMP6_0  (0x1U << 18)
+#define ADC_SMPR1_SMP6_1  (0x1U << 19)
+#define ADC_SMPR1_SMP6_2  (0x1U << 20)
+#define ADC_SMPR1_SMP7_Pos  21U
+#define ADC_SMPR1_SMP7_Msk  (0x7U << 21)
+#define ADC_SMPR1_SMP7  ADC_SMPR1_SMP7_Msk
+#define ADC_SMPR1_SMP7_0  (0x1U << 21)
+#define ADC_SMPR1_SMP7_1  (0x1U << 22)
+#define ADC_SMPR1_SMP7_2  (0x1U << 23)
+#define ADC_SMPR1_SMP8_Pos  24U
+#define ADC_SMPR1_SMP8_Msk  (0x7U << 24)
+#define ADC_SMPR1_SMP8  ADC_SMPR1_SMP8_Msk
+#define ADC_SMPR1_SMP8_0  (0x1U << 24)
+#define ADC_SMPR1_SMP8_1  (0x1U << 25)
+#define ADC_SMPR1_SMP8_2  (0x1U << 26)
+#define ADC_SMPR1_SMP9_Pos  27U
+#define ADC_SMPR1_SMP9_Msk  (0x7U << 27)
+#define ADC_SMPR1_SMP9  ADC_SMPR1_SMP9_Msk
+#define ADC_SMPR1_SMP9_0  (0x1U << 27)
+#define ADC_SMPR1_SMP9_1  (0x1U << 28)
+#define ADC_SMPR1_SMP9_2  (0x1U << 29)
+#define ADC_SMPR2_SMP10_Pos  0U
+#define ADC_SMPR2_SMP10_Msk  (0x7U << 0)
+#define ADC_SMPR2_SMP10  ADC_SMPR2_SMP10_Msk
+#define ADC_SMPR2_SMP10_0  (0x1U << 0)
+#define ADC_SMPR2_SMP10_1  (0x1U << 1)
+#define ADC_SMPR2_SMP10_2  (0x1U << 2)
+#define ADC_SMPR2_SMP11_Pos  3U
+#define ADC_SMPR2_SMP11_Msk  (0x7U << 3)
+#define ADC_SMPR2_SMP11  ADC_SMPR2_SMP11_Msk
+#define ADC_SMPR2_SMP11_0  (0x1U << 3)
+#define ADC_SMPR2_SMP11_1  (0x1U << 4)
+#define ADC_SMPR2_SMP11_2  (0x1U << 5)
+#define ADC_SMPR2_SMP12_Pos  6U
+#define ADC_SMPR2_SMP12_Msk  (0x7U << 6)
+#define ADC_SMPR2_SMP12  ADC_SMPR2_SMP12_Msk
+#define ADC_SMPR2_SMP12_0  (0x1U << 6)
+#define ADC_SMPR2_SMP12_1  (0x1U << 7)
+#define ADC_SMPR2_SMP12_2  (0x1U << 8)
+#define ADC_SMPR2_SMP13_Pos  9U
+#define ADC_SMPR2_SMP13_Msk  (0x7U << 9)
+#define ADC_SMPR2_SMP13  ADC_SMPR2_SMP13_Msk
+#define ADC_SMPR2_SMP13_0  (0x1U << 9)
+#define ADC_SMPR2_SMP13_1  (0x1U << 10)
+#define ADC_SMPR2_SMP13_2  (0x1U << 11)
+#define ADC_SMPR2_SMP14_Pos  12U
+#define ADC_SMPR2_SMP14_Msk  (0x7U << 12)
+#define ADC_SMPR2_SMP14  ADC_SMPR2_SMP14_Msk
+#define ADC_SMPR2_SMP14_0  (0x1U << 12)
+#define ADC_SMPR2_SMP14_1  (0x1U << 13)
+#define ADC_SMPR2_SMP14_2  (0x1U << 14)
+#define ADC_SMPR2_SMP15_Pos  15U
+#define ADC_SMPR2_SMP15_Msk  (0x7U << 15)
+#define ADC_SMPR2_SMP15  ADC_SMPR2_SMP15_Msk
+#define ADC_SMPR2_SMP15_0  (0x1U << 15)
+#define ADC_SMPR2_SMP15_1  (0x1U << 16)
+#define ADC_SMPR2_SMP15_2  (0x1U << 17)
+#define ADC_SMPR2_SMP16_Pos  18U
+#define ADC_SMPR2_SMP16_Msk  (0x7U << 18)
+#define ADC_SMPR2_SMP16  ADC_SMPR2_SMP16_Msk
+#define ADC_SMPR2_SMP16_0  (0x1U << 18)
+#define ADC_SMPR2_SMP16_1  (0x1U << 19)
+#define ADC_SMPR2_SMP16_2  (0x1U << 20)
+#define ADC_SMPR2_SMP17_Pos  21U
+#define ADC_SMPR2_SMP17_Msk  (0x7U << 21)
+#define ADC_SMPR2_SMP17  ADC_SMPR2_SMP17_Msk
+#define ADC_SMPR2_SMP17_0  (0x1U << 21)
+#define ADC_SMPR2_SMP17_1  (0x1U << 22)
+#define ADC_SMPR2_SMP17_2  (0x1U << 23)
+#define ADC_SMPR2_SMP18_Pos  24U
+#define ADC_SMPR2_SMP18_Msk  (0x7U << 24)
+#define ADC_SMPR2_SMP18  ADC_SMPR2_SMP18_Msk
+#define ADC_SMPR2_SMP18_0  (0x1U << 24)
+#define ADC_SMPR2_SMP18_1  (0x1U << 25)
+#define ADC_SMPR2_SMP18_2  (0x1U << 26)
+#define ADC_CALFACT_CALFACT_S_Pos  0U
+#define ADC_CALFACT_CALFACT_S_Msk  (0x7FU << 0)
+#define ADC_CALFACT_CALFACT_S  ADC_CALFACT_CALFACT_S_Msk
+#define ADC_CALFACT_CALFACT_S_0  (0x1U << 0)
+#define ADC_CALFACT_CALFACT_S_1  (0x1U << 1)
+#define ADC_CALFACT_CALFACT_S_2  (0x1U << 2)
+#define ADC_CALFACT_CALFACT_S_3  (0x1U << 3)
+#define ADC_CALFACT_CALFACT_S_4  (0x1U << 4)
+#define ADC_CALFACT_CALFACT_S_5  (0x1U << 5)
+#define ADC_CALFACT_CALFACT_S_6  (0x1U << 6)
+#define ADC_CALFACT_CALFACT_D_Pos  16U
+#define ADC_CALFACT_CALFACT_D_Msk  (0x7FU << 16)
+#define ADC_CALFACT_CALFACT_D  ADC_CALFACT_CALFACT_D_Msk
+#define ADC_CALFACT_CALFACT_D_0  (0x1U << 16)
+#define ADC_CALFACT_CALFACT_D_1  (0x1U << 17)
+#define ADC_CALFACT_CALFACT_D_2  (0x1U << 18)
+#define ADC_CALFACT_CALFACT_D_3  (0x1U << 19)
+#define ADC_CALFACT_CALFACT_D_4  (0x1U << 20)
+#define ADC_CALFACT_CALFACT_D_5  (0x1U << 21)
+#define ADC_CALFACT_CALFACT_D_6  (0x1U << 22)
+#define ADC_CFGR_EXTSEL_Pos  6U
+#define ADC_CFGR_EXTSEL_Msk  (0xFU << 6)
+#define ADC_CFGR_EXTSEL  ADC_CFGR_EXTSEL_Msk
+#define ADC_CFGR_EXTSEL_0  (0x1U << 6)
+#define ADC_CFGR_EXTSEL_1  (0x1U << 7)
+#define ADC_CFGR_EXTSEL_2  (0x1U << 8)
+#define ADC_CFGR_EXTSEL_3  (0x1U << 9)
+#define ADC_CFGR_EXTEN_Pos  10U
+#define ADC_CFGR_EXTEN_Msk  (0x3U << 10)
+#define ADC_CFGR_EXTEN  ADC_CFGR_EXTEN_Msk
+#define ADC_CFGR_EXTEN_0  (0x1U << 10)
+#define ADC_CFGR_EXTEN_1  (0x1U << 11)
+#define ADC_CFGR_RES_Pos  3U
+#define ADC_CFGR_RES_Msk  (0x3U << 3)
+#define ADC_CFGR_RES  ADC_CFGR_RES_Msk
+#define ADC_CFGR_RES_0  (0x1U << 3)
+#define ADC_CFGR_RES_1  (0x1U << 4)
+#define ADC_CFGR_AWD1CH_Pos  26U
+#define ADC_CFGR_AWD1CH_Msk  (0x1FU << 26)
+#define ADC_CFGR_AWD1CH  ADC_CFGR_AWD1CH_Msk
+#define ADC_CFGR_AWD1CH_0  (0x1U << 26)
+#define ADC_CFGR_AWD1CH_1  (0x1U << 27)
+#define ADC_CFGR_AWD1CH_2  (0x1U << 28)
+#define ADC_CFGR_AWD1CH_3  (0x1U << 29)
+#define ADC_CFGR_AWD1CH_4  (0x1U << 30)
+#define TIM_CCMR1_OC2M_Pos  12U
+#define TIM_CCMR1_OC2M_Msk  (0x7U << 12)
+#define TIM_CCMR1_OC2M  TIM_CCMR1_OC2M_Msk
+#define TIM_CCMR1_OC2M_0  (0x1U << 12)
+#define TIM_CCMR1_OC2M_1  (0x1U << 13)
+#define TIM_CCMR1_OC2M_2  (0x1U << 14)
+#define DMA_CCR_PL_Pos  12U
+#define DMA_CCR_PL_Msk  (0x3U << 12)
+#define DMA_CCR_PL  DMA_CCR_PL_Msk
+#define DMA_CCR_PL_0  (0x1U << 12)
+#define DMA_CCR_PL_1  (0x1U << 13)
+#define DMA_CCR_MSIZE_Pos  10U
+#define DMA_CCR_MSIZE_Msk  (0x3U << 10)
+#define DMA_CCR_MSIZE  DMA_CCR_MSIZE_Msk
+#define DMA_CCR_MSIZE_0  (0x1U << 10)
+#define DMA_CCR_MSIZE_1  (0x1U << 11)
+#define DMA_CCR_PSIZE_Pos  8U
+#define DMA_CCR_PSIZE_Msk  (0x3U << 8)
+#define DMA_CCR_PSIZE  DMA_CCR_PSIZE_Msk
+#define DMA_CCR_PSIZE_0  (0x1U << 8)
+#define DMA_CCR_PSIZE_1  (0x1U << 9)
+#define SCB_AIRCR_PRIGROUP_Pos  8U
+#define SCB_AIRCR_PRIGROUP_Msk  (0x7U << 8)
+#define SCB_AIRCR_PRIGROUP  SCB_AIRCR_PRIGROUP_Msk
+#define SCB_AIRCR_PRIGROUP_0  (0x1U << 8)
+#define SCB_AIRCR_PRIGROUP_1  (0x1U << 9)
+#define SCB_AIRCR_PRIGROUP_2  (0x1U << 10)
+#define SCB_ICSR_VECTACTIVE_Pos  0U
+#define SCB_ICSR_VECTACTIVE_Msk  (0x1FFU << 0)
+#define SCB_ICSR_VECTACTIVE  SCB_ICSR_VECTACTIVE_Msk
+#define SCB_ICSR_VECTACTIVE_0  (0x1U << 0)
+#define SCB_ICSR_VECTACTIVE_1  (0x1U << 1)
+#define SCB_ICSR_VECTACTIVE_2  (0x1U << 2)
+#define SCB_ICSR_VECTACTIVE_3  (0x1U << 3)
+#define SCB_ICSR_VECTACTIVE_4  (0x1U << 4)
+#define SCB_ICSR_VECTACTIVE_5  (0x1U << 5)
+#define SCB_ICSR_VECTACTIVE_6  (0x1U << 6)
+#define SCB_ICSR_VECTACTIVE_7  (0x1U << 7)
+#define SCB_ICSR_VECTACTIVE_8  (0x1U << 8)
+#define SYSCFG_EXTICR3_EXTI8_Pos  0U
+#define SYSCFG_EXTICR3_EXTI8_Msk  (0xFU << 0)
+#define SYSCFG_EXTICR3_EXTI8  SYSCFG_EXTICR3_EXTI8_Msk
+#define SYSCFG_EXTICR3_EXTI8_0  (0x1U << 0)
+#define SYSCFG_EXTICR3_EXTI8_1  (0x1U << 1)
+#define SYSCFG_EXTICR3_EXTI8_2  (0x1U << 2)
+#define SYSCFG_EXTICR3_EXTI8_3  (0x1U << 3)
+#define FLASH_ACR_LATENCY_Pos  0U
+#define FLASH_ACR_LATENCY_Msk  (0x7U << 0)
+#define FLASH_ACR_LATENCY  FLASH_ACR_LATENCY_Msk
+#define FLASH_ACR_LATENCY_0  (0x1U << 0)
+#define FLASH_ACR_LATENCY_1  (0x1U << 1)
+#define FLASH_ACR_LATENCY_2  (0x1U << 2)
+//-----------------------------------------------------------------------------
+#define RCC_AHBENR_GPIOAEN  (0x1U << 17)
+#define RCC_AHBENR_GPIOBEN  (0x1U << 18)
+#define RCC_AHBENR_GPIOCEN  (0x1U << 19)
+#define RCC_AHBENR_DMA1EN  (0x1U << 0)
+#define RCC_AHBENR_ADC1EN  (0x1U << 28)
+#define RCC_APB1ENR_TIM2EN  (0x1U << 0)
+#define RCC_APB1ENR_TIM6EN  (0x1U << 4)
+#define RCC_APB1ENR_TIM7EN  (0x1U << 5)
+#define RCC_APB1ENR_CANEN  (0x1U << 25)
+#define RCC_APB1ENR_USART2EN  (0x1U << 17)
+#define RCC_APB1ENR_PWREN  (0x1U << 28)
+#define RCC_APB2ENR_SYSCFGEN  (0x1U << 0)
+#define RCC_CR_HSEBYP  (0x1U << 18)
+#define RCC_CR_HSEON  (0x1U << 16)
+#define RCC_CR_HSERDY  (0x1U << 17)
+#define RCC_CR_PLLON  (0x1U << 24)
+#define RCC_CR_PLLRDY  (0x1U << 25)
+#define RCC_CR_CSSON  (0x1U << 19)
+#define RCC_CR_HSION  (0x1U << 0)
+#define RCC_CR_HSIRDY  (0x1U << 1)
+#define RCC_CFGR_PLLSRC  (0x1U << 16)
+#define RCC_CFGR_SW_1  (0x1U << 1)
+#define RCC_CFGR_SW_0  (0x1U << 0)
+#define RCC_CFGR_SWS_1  (0x1U << 3)
+#define RCC_CFGR_SWS_0  (0x1U << 2)
+#define RCC_CIR_CSSC  (0x1U << 23)
+#define RCC_CSR_LPWRRSTF  (0x1U << 31)
+#define RCC_CSR_WWDGRSTF  (0x1U << 30)
+#define RCC_CSR_IWDGRSTF  (0x1U << 29)
+#define RCC_CSR_SFTRSTF  (0x1U << 28)
+#define RCC_CSR_PORRSTF  (0x1U << 27)
+#define RCC_CSR_PINRSTF  (0x1U << 26)
+#define RCC_CSR_OBLRSTF  (0x1U << 25)
+#define RCC_CSR_RMVF  (0x1U << 24)
+#define DMA_CCR_EN  (0x1U << 0)
+#define DMA_CCR_TCIE  (0x1U << 1)
+#define DMA_CCR_HTIE  (0x1U << 2)
+#define DMA_CCR_TEIE  (0x1U << 3)
+#define DMA_CCR_DIR  (0x1U << 4)
+#define DMA_CCR_CIRC  (0x1U << 5)
+#define DMA_CCR_PINC  (0x1U << 6)
+#define DMA_CCR_MINC  (0x1U << 7)
+#define DMA_ISR_GIF1  (0x1U << 0)
+#define DMA_ISR_TCIF1  (0x1U << 1)
+#define DMA_ISR_HTIF1  (0x1U << 2)
+#define DMA_ISR_TEIF1  (0x1U << 3)
+#define DMA_IFCR_CGIF1  (0x1U << 0)
+#define DMA_IFCR_CTCIF1  (0x1U << 1)
+#define DMA_IFCR_CHTIF1  (0x1U << 2)
+#define DMA_IFCR_CTEIF1  (0x1U << 3)
+#define ADC_CR_ADEN  (0x1U << 0)
+#define ADC_CR_ADDIS  (0x1U << 1)
+#define ADC_CR_ADSTART  (0x1U << 2)
+#define ADC_CR_JADSTART  (0x1U << 3)
+#define ADC_CR_ADSTP  (0x1U << 4)
+#define ADC_CR_JADSTP  (0x1U << 5)
+#define ADC_CR_ADCALDIF  (0x1U << 30)
+#define ADC_CR_ADCAL  (0x1U << 31)
+#define ADC_ISR_ADRDY  (0x1U << 0)
+#define ADC_ISR_EOSMP  (0x1U << 1)
+#define ADC_ISR_EOC  (0x1U << 2)
+#define ADC_ISR_EOS  (0x1U << 3)
+#define ADC_ISR_OVR  (0x1U << 4)
+#define ADC_ISR_AWD1  (0x1U << 7)
+#define ADC_IER_ADRDYIE  (0x1U << 0)
+#define ADC_IER_EOCIE  (0x1U << 2)
+#define ADC_IER_EOSIE  (0x1U << 3)
+#define ADC_IER_OVRIE  (0x1U << 4)
+#define ADC_CFGR_DMAEN  (0x1U << 0)
+#define ADC_CFGR_DMACFG  (0x1U << 1)
+#define ADC_CFGR_ALIGN  (0x1U << 5)
+#define ADC_CFGR_OVRMOD  (0x1U << 12)
+#define ADC_CFGR_CONT  (0x1U << 13)
+#define ADC_CFGR_AUTDLY  (0x1U << 14)
+#define ADC_CFGR_AWD1SGL  (0x1U << 22)
+#define ADC_CFGR_AWD1EN  (0x1U << 23)
+#define ADC_CCR_TSEN  (0x1U << 23)
+#define ADC_CCR_VREFEN  (0x1U << 22)
+#define ADC1_CCR_CKMODE_0  (0x1U << 16)
+#define ADC1_CCR_CKMODE_1  (0x1U << 17)
+#define TIM_CR1_CEN  (0x1U << 0)
+#define TIM_CR1_UDIS  (0x1U << 1)
+#define TIM_CR1_URS  (0x1U << 2)
+#define TIM_CR1_OPM  (0x1U << 3)
+#define TIM_CR1_ARPE  (0x1U << 7)
+#define TIM_DIER_UIE  (0x1U << 0)
+#define TIM_DIER_CC2IE  (0x1U << 2)
+#define TIM_SR_UIF  (0x1U << 0)
+#define TIM_SR_CC2IF  (0x1U << 2)
+#define TIM_EGR_UG  (0x1U << 0)
+#define TIM_CCMR1_OC2PE  (0x1U << 11)
+#define TIM_CCER_CC2E  (0x1U << 4)
+#define CAN_MCR_INRQ  (0x1U << 0)
+#define CAN_MCR_SLEEP  (0x1U << 1)
+#define CAN_MCR_TXFP  (0x1U << 2)
+#define CAN_MCR_RFLM  (0x1U << 3)
+#define CAN_MCR_NART  (0x1U << 4)
+#define CAN_MCR_AWUM  (0x1U << 5)
+#define CAN_MCR_ABOM  (0x1U << 6)
+#define CAN_MCR_TTCM  (0x1U << 7)
+#define CAN_MCR_RESET  (0x1U << 15)
+#define CAN_MCR_DBF  (0x1U << 16)
+#define CAN_MSR_INAK  (0x1U << 0)
+#define CAN_MSR_SLAK  (0x1U << 1)
+#define CAN_MSR_ERRI  (0x1U << 2)
+#define CAN_MSR_WKUI  (0x1U << 3)
+#define CAN_MSR_SLAKI  (0x1U << 4)
+#define CAN_MSR_TXM  (0x1U << 8)
+#define CAN_MSR_RXM  (0x1U << 9)
+#define CAN_MSR_RX  (0x1U << 11)
+#define CAN_TSR_RQCP0  (0x1U << 0)
+#define CAN_TSR_TXOK0  (0x1U << 1)
+#define CAN_TSR_ALST0  (0x1U << 2)
+#define CAN_TSR_TERR0  (0x1U << 3)
+#define CAN_TSR_ABRQ0  (0x1U << 7)
+#define CAN_TSR_RQCP1  (0x1U << 8)
+#define CAN_TSR_TXOK1  (0x1U << 9)
+#define CAN_TSR_ALST1  (0x1U << 10)
+#define CAN_TSR_TERR1  (0x1U << 11)
+#define CAN_TSR_ABRQ1  (0x1U << 15)
+#define CAN_TSR_RQCP2  (0x1U << 16)
+#define CAN_TSR_TXOK2  (0x1U << 17)
+#define CAN_TSR_ALST2  (0x1U << 18)
+#define CAN_TSR_TERR2  (0x1U << 19)
+#define CAN_TSR_ABRQ2  (0x1U << 23)
+#define CAN_TSR_TME0  (0x1U << 26)
+#define CAN_TSR_TME1  (0x1U << 27)
+#define CAN_TSR_TME2  (0x1U << 28)
+#define CAN_RF0R_RFOM0  (0x1U << 5)
+#define CAN_RF1R_FMP1_Pos  0U
+#define CAN_RF1R_FMP1_Msk  (0x3U << 0)
+#define CAN_RF1R_FULL1  (0x1U << 3)
+#define CAN_RF1R_FOVR1  (0x1U << 4)
+#define CAN_RF1R_RFOM1  (0x1U << 5)
+#define CAN_IER_TMEIE  (0x1U << 0)
+#define CAN_IER_FMPIE0  (0x1U << 1)
+#define CAN_IER_FFIE0  (0x1U << 2)
+#define CAN_IER_FOVIE0  (0x1U << 3)
+#define CAN_IER_FMPIE1  (0x1U << 4)
+#define CAN_IER_FFIE1  (0x1U << 5)
+#define CAN_IER_FOVIE1  (0x1U << 6)
+#define CAN_IER_EWGIE  (0x1U << 8)
+#define CAN_IER_EPVIE  (0x1U << 9)
+#define CAN_IER_BOFIE  (0x1U << 10)
+#define CAN_IER_LECIE  (0x1U << 11)
+#define CAN_IER_ERRIE  (0x1U << 15)
+#define CAN_IER_WKUIE  (0x1U << 16)
+#define CAN_IER_SLKIE  (0x1U << 17)
+#define CAN_ESR_EWGF  (0x1U << 0)
+#define CAN_ESR_EPVF  (0x1U << 1)
+#define CAN_ESR_BOFF  (0x1U << 2)
+#define CAN_BTR_LBKM  (0x1U << 30)
+#define CAN_BTR_SILM  (0x1U << 31)
+#define CAN_FMR_FINIT  (0x1U << 0)
+#define CAN_FM1R_FBM0  (0x1U << 0)
+#define CAN_FM1R_FBM1  (0x1U << 1)
+#define CAN_FM1R_FBM2  (0x1U << 2)
+#define CAN_FM1R_FBM3  (0x1U << 3)
+#define CAN_FS1R_FSC0  (0x1U << 0)
+#define CAN_FS1R_FSC1  (0x1U << 1)
+#define CAN_FS1R_FSC2  (0x1U << 2)
+#define CAN_FS1R_FSC3  (0x1U << 3)
+#define CAN_FA1R_FACT0  (0x1U << 0)
+#define CAN_FA1R_FACT1  (0x1U << 1)
+#define CAN_FA1R_FACT2  (0x1U << 2)
+#define CAN_FA1R_FACT3  (0x1U << 3)
+#define CAN_FFA1R_FFA2  (0x1U << 2)
+#define CAN_TI0R_TXRQ  (0x1U << 0)
+#define CAN_RI0R_RTR  (0x1U << 1)
+#define CAN_RI0R_IDE  (0x1U << 2)
+#define USART_CR1_UE  (0x1U << 0)
+#define USART_CR1_TE  (0x1U << 3)
+#define USART_ISR_TXE  (0x1U << 7)
+#define FLASH_CR_PG  (0x1U << 0)
+#define FLASH_CR_PER  (0x1U << 1)
+#define FLASH_CR_MER  (0x1U << 2)
+#define FLASH_CR_STRT  (0x1U << 6)
+#define FLASH_CR_LOCK  (0x1U << 7)
+#define FLASH_SR_BSY  (0x1U << 0)
+#define FLASH_SR_PGERR  (0x1U << 2)
+#define FLASH_SR_WRPERR  (0x1U << 4)
+#define FLASH_SR_EOP  (0x1U << 5)
+#define PWR_CR_LPDS  (0x1U << 0)
+#define PWR_CR_PDDS  (0x1U << 1)
+#define PWR_CR_CWUF  (0x1U << 2)
+#define PWR_CR_DBP  (0x1U << 8)
+#define SCB_SCR_SLEEPDEEP_Msk  (0x1U << 2)
+#define SCB_SCR_SLEEPONEXIT_Msk  (0x1U << 1)
+#define DWT_CTRL_CYCCNTENA_Msk  (0x1U << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk  (0x1U << 24)
+#define SysTick_CTRL_ENABLE_Msk  (0x1U << 0)
+#define SysTick_CTRL_TICKINT_Msk  (0x1U << 1)
+#define SysTick_CTRL_CLKSOURCE_Msk  (0x1U << 2)
+#define SysTick_CTRL_COUNTFLAG_Msk  (0x1U << 16)
+//-----------------------------------------------------------------------------
+#define EXTI_IMR_MR8  (0x1U << 8)
+#define EXTI_EMR_MR8  (0x1U << 8)
+#define EXTI_FTSR_TR8  (0x1U << 8)
+#define EXTI_RTSR_TR8  (0x1U << 8)
+#define EXTI_PR_PR8  (0x1U << 8)
+#define SYSCFG_EXTICR3_EXTI8_PB  (0x1U)
+#define FLASH_KEY1  0x45670123U
+#define FLASH_KEY2  0xCDEF89ABU
+#define FLASH_BASE  0x08000000U
+#define SRAM_BASE  0x20000000U
+#define RCC_CFGR_SWS_Pos  2U
+#define RCC_CFGR_SWS_Msk  (0x3U << 2)
+#define RCC_CFGR_SWS  RCC_CFGR_SWS_Msk
+#define RCC_CFGR_HPRE_Pos  4U
+#define RCC_CFGR_HPRE_Msk  (0xFU << 4)
+#define RCC_CFGR_HPRE  RCC_CFGR_HPRE_Msk
+#define RCC_CFGR_PPRE1_Pos  8U
+#define RCC_CFGR_PPRE1_Msk  (0x7U << 8)
+#define RCC_CFGR_PPRE1  RCC_CFGR_PPRE1_Msk
+#define RCC_CFGR_PLLMUL_Pos  18U
+#define RCC_CFGR_PLLMUL_Msk  (0xFU << 18)
+#define RCC_CFGR_PLLMUL  RCC_CFGR_PLLMUL_Msk
+#define RCC_CFGR2_PREDIV_Pos  0U
+#define RCC_CFGR2_PREDIV_Msk  (0xFU << 0)
+#define RCC_CFGR2_PREDIV  RCC_CFGR2_PREDIV_Msk
+#define RCC_CFGR_SWS_HSI  (0x0U)
+#define RCC_CFGR_SWS_HSE  (0x4U)
+#define RCC_CFGR_SWS_PLL  (0x8U)
+//=============================================================================
+#endif // STM32F302X8_H
+//=============================================================================
@@ -0,0 +1,513 @@
+//=============================================================================
+/*
+* Monte Carlo of focus controller: firmware in simulator (see sim.c)
+* against spread of plant; pattern search of controller parameters for
+* best worst case
+* usage:
+ - tune [-n trials] [-s seed] [-j jobs] [-k spread] [-e tol] [-a approach]
+   [-g start,stop,lash,over] [-o iterations]
+   -n - trials per parameter set (default 32, up to TUNE_TRIALS_MAX), -s -
+   seed of trials (default 1), -j - trials in parallel (default: online
+   CPUs), -k - scale of spread (default 1.0, 0 - nominal plant), -e -
+   tolerance of lens for settle (counts, default TUNE_TOL_DEF), -a -
+   approach (config.focus_approach: 0 - both, FOCUS_DIR_x), -g - start
+   parameters (config.focus_band_start, focus_band_stop, focus_lash,
+   focus_over; default: firmware defaults), -o - iterations of search
+   (default 0: Monte Carlo of start parameters only)
+* notes:
+ - firmware boots once (focus and pole ready), then each trial runs in
+   own child process forked from it: all trials start from same state,
+   up to -j at once; result goes back over pipe
+ - trial i of seed: plant spread (TUNE_SPREAD_x, uniform, scaled by -k):
+   supply (speed at full drive), coast (tau_coast), friction (Coulomb),
+   gear lash, ADC noise; TUNE_MOVES moves of focus (short and long,
+   random direction), each TUNE_SEG_MS; same trials for each parameter
+   set (common random numbers) => runs are reproducible from seed
+ - parameters go to config as calibration would (not through CAN, not
+   saved); approach of -a is fixed, focus_over is searched only with
+   approach in one direction
+ - move: settle_ms - from command up to last sample (each ms) of lens out
+   of tolerance or moving; overshoot - counts of lens past target;
+   err - lens against target at end; fail - not settled at end
+ - cost of trial: worst settle_ms + TUNE_OVER_W * worst overshoot +
+   TUNE_FAIL_MS per failed move; cost of parameter set: worst trial
+   (mean breaks ties)
+ - search (-o): pattern search from start parameters: each iteration
+   tries + / - step of each parameter (in parallel), moves to best if it
+   is better, else halves steps (end at step 1); best is checked on
+   fresh trials (seed + 1) against start parameters
+* output: distributions (min, median, p90, max) of settle_ms, overshoot
+  and err, failed moves; progress of search to stderr; exit code 2 -
+  usage or failed trial
+*/
+//=============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+//-----------------------------------------------------------------------------
+#include "sim.h"
+#include "plant.h"
+#include "main.h"
+#include "can.h"
+#include "config.h"
+#include "focus.h"
+#include "pole.h"
+//=============================================================================
+#define TUNE_TRIALS_MAX  1024U
+#define TUNE_JOBS_MAX    64U
+#define TUNE_PARAMS      4U      // start, stop, lash, over
+#define TUNE_CAND_MAX    (2U * TUNE_PARAMS)
+#define TUNE_MOVES       4U
+#define TUNE_SEG_MS      800U    // time of move (long move: 600 counts)
+#define TUNE_TOL_DEF     12.0    // counts (as FOCUS_BAND_START)
+#define TUNE_OVER_W      2.0     // ms of cost per count of overshoot
+#define TUNE_FAIL_MS     1000.0  // cost of failed move
+#define TUNE_LO          400     // targets (ADC counts)
+#define TUNE_HI          3600
+// Spread at -k 1: nominal * (1 +/- x) or 0 ... x
+#define TUNE_SPREAD_SUPPLY    0.2     // speed at full drive
+#define TUNE_SPREAD_COAST     0.5     // tau_coast
+#define TUNE_SPREAD_NOISE     0.6
+#define TUNE_SPREAD_FRICTION  0.005   // counts per ms^2
+#define TUNE_SPREAD_LASH      40.0    // counts
+// Bounds of search
+#define TUNE_START_MAX   64
+#define TUNE_OVER_MAX    400
+//-----------------------------------------------------------------------------
+// Parameters (config.focus_x): band_start, band_stop, lash, over
+struct tune_gain {
+	int32_t p[TUNE_PARAMS];
+};
+
+// Trial: max of moves
+struct tune_res {
+	double settle;
+	double over;
+	double err;
+	uint32_t fails;
+};
+//-----------------------------------------------------------------------------
+// Focus as in bench.c; zoom and iris are not moved
+static const struct plant_param tune_plant[PLANT_MOTORS] = {
+	{ .pos = 1000, .speed = 1.0, .tau_drive = 20.0, .tau_coast = 3.0,
+		.stop_lo = 40.0, .stop_hi = 4050.0, .noise = 1.5, .seed = 12345U },
+	{ .pos = 800, .speed = 2.0, .tau_drive = 10.0, .tau_coast = 2.0,
+		.stop_lo = 40.0, .stop_hi = 4050.0, .noise = 1.5, .seed = 23456U },
+	{ .pos = 3000, .speed = 2.0, .tau_drive = 10.0, .tau_coast = 2.0,
+		.stop_lo = 40.0, .stop_hi = 4050.0, .noise = 1.5, .seed = 34567U },
+};
+static uint32_t tune_trials = 32U;
+static uint32_t tune_jobs;
+static double tune_spread = 1.0;
+static double tune_tol = TUNE_TOL_DEF;
+static uint32_t tune_approach = FOCUS_APPROACH_BOTH;
+static uint32_t tune_seq;
+//=============================================================================
+// Uniform in [0, 1) of generator r
+static double 
+tune_rnd(uint32_t *r)
+{
+	*r = *r * 1664525U + 1013904223U;
+	return (double)(*r >> 8) / (double)(1U << 24);
+}
+//-----------------------------------------------------------------------------
+// Uniform in [-1, 1)
+static double 
+tune_rnd2(uint32_t *r)
+{
+	return 2.0 * tune_rnd(r) - 1.0;
+}
+//-----------------------------------------------------------------------------
+// Hash of seed and trial: start of generator (LCG of near seeds correlate)
+static uint32_t 
+tune_mix(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7FEB352DU;
+	x ^= x >> 15;
+	x *= 0x846CA68BU;
+	x ^= x >> 16;
+	return x;
+}
+//-----------------------------------------------------------------------------
+// Plant and targets of trial i of seed (same for each parameter set)
+static void 
+tune_draw(uint32_t seed, uint32_t i, struct plant_param *p,
+	int32_t *target)
+{
+	uint32_t r = tune_mix(tune_mix(seed) + i);
+	double k = tune_spread;
+	int32_t pos = (int32_t)tune_plant[0].pos, d;
+	uint32_t m;
+
+	*p = tune_plant[0];
+	p->speed *= 1.0 + k * TUNE_SPREAD_SUPPLY * tune_rnd2(&r);
+	p->tau_coast *= 1.0 + k * TUNE_SPREAD_COAST * tune_rnd2(&r);
+	p->noise *= 1.0 + k * TUNE_SPREAD_NOISE * tune_rnd2(&r);
+	p->friction = k * TUNE_SPREAD_FRICTION * tune_rnd(&r);
+	p->lash = k * TUNE_SPREAD_LASH * tune_rnd(&r);
+	p->seed = r;
+	// Short (20 ... 150) and long (150 ... 600) moves
+	for (m = 0; m < TUNE_MOVES; ++m) {
+		d = m & 1U ? 150 + (int32_t)(450.0 * tune_rnd(&r)) :
+			20 + (int32_t)(130.0 * tune_rnd(&r));
+		if (tune_rnd(&r) < 0.5)
+			d = -d;
+		if (pos + d < TUNE_LO || pos + d > TUNE_HI)
+			d = -d;
+		pos += d;
+		target[m] = pos;
+	}
+}
+//-----------------------------------------------------------------------------
+static void 
+tune_cmd(uint32_t focus)
+{
+	tune_seq = (tune_seq + 1U) & 0xFFU;
+	sim_canRx(CAN_ID_CMD, 8,
+		CAN_POLE_KEEP << CAN_POLE_POS | tune_seq << CAN_SEQ_POS |
+		CAN_VER_HIRES << CAN_VER_POS,
+		focus << CAN_FOCUS_HR_POS);
+}
+//-----------------------------------------------------------------------------
+static void 
+tune_apply(const struct tune_gain *g)
+{
+	config.focus_band_start = (uint32_t)g->p[0];
+	config.focus_band_stop = (uint32_t)g->p[1];
+	config.focus_lash = (uint32_t)g->p[2];
+	config.focus_over = (uint32_t)g->p[3];
+	config.focus_approach = tune_approach;
+}
+//-----------------------------------------------------------------------------
+// In child: moves of trial i with parameters g
+static void 
+tune_trial(const struct tune_gain *g, uint32_t seed, uint32_t i,
+	struct tune_res *res)
+{
+	struct plant_param p;
+	int32_t target[TUNE_MOVES];
+	uint64_t t0, end, sample, bad;
+	double lens, over, settle;
+	uint32_t m, ok, dir;
+
+	tune_draw(seed, i, &p, target);
+	plant_setParam(0, &p);
+	tune_apply(g);
+	memset(res, 0, sizeof(*res));
+
+	for (m = 0; m < TUNE_MOVES; ++m) {
+		tune_cmd((uint32_t)target[m]);
+		t0 = sim_now();
+		end = t0 + (uint64_t)TUNE_SEG_MS * SIM_CYCLES_MS;
+		sample = t0;
+		bad = t0;
+		ok = 0;
+		dir = plant_getLens() < target[m];
+		while (sim_now() < end) {
+			main_loop();
+			sim_idle(SIM_LOOP_CYCLES);
+			if (sim_now() < sample)
+				continue;
+			sample += SIM_CYCLES_MS;
+			lens = plant_getLens();
+			ok = fabs(lens - target[m]) <= tune_tol &&
+				focus_getDir() == FOCUS_DIR_STOP &&
+				fabs(plant_getSpeed()) < 0.01;
+			if (!ok)
+				bad = sim_now();
+			over = dir ? lens - target[m] : target[m] - lens;
+			if (over > res->over)
+				res->over = over;
+		}
+		lens = fabs(plant_getLens() - target[m]);
+		if (lens > res->err)
+			res->err = lens;
+		if (!ok) {
+			++res->fails;
+			settle = TUNE_SEG_MS;
+		} else {
+			settle = (double)(bad - t0) / SIM_CYCLES_MS + 1.0;
+		}
+		if (settle > res->settle)
+			res->settle = settle;
+	}
+}
+//=============================================================================
+// Parent (booted firmware): n parameter sets x trials, up to tune_jobs
+// children at once; res[set * tune_trials + trial]
+static int32_t 
+tune_eval(const struct tune_gain *g, uint32_t n, uint32_t seed,
+	struct tune_res *res)
+{
+	pid_t pid[TUNE_JOBS_MAX], w;
+	int fd[TUNE_JOBS_MAX][2];
+	uint32_t job[TUNE_JOBS_MAX];
+	uint32_t next = 0, run = 0, total = n * tune_trials, s;
+	int st;
+
+	for (s = 0; s < tune_jobs; ++s)
+		pid[s] = 0;
+	fflush(stdout);
+	fflush(stderr);
+	while (next < total || run) {
+		for (s = 0; s < tune_jobs && next < total; ++s) {
+			if (pid[s])
+				continue;
+			if (pipe(fd[s]))
+				return -1;
+			pid[s] = fork();
+			if (pid[s] < 0)
+				return -1;
+			if (!pid[s]) {
+				struct tune_res r;
+
+				close(fd[s][0]);
+				tune_trial(&g[next / tune_trials], seed,
+					next % tune_trials, &r);
+				_exit(write(fd[s][1], &r, sizeof(r)) == sizeof(r) ? 0 : 1);
+			}
+			close(fd[s][1]);
+			job[s] = next++;
+			++run;
+		}
+		w = wait(&st);
+		for (s = 0; s < tune_jobs && pid[s] != w; ++s)
+			;
+		if (w < 0 || s == tune_jobs)
+			return -1;
+		pid[s] = 0;
+		--run;
+		if (!WIFEXITED(st) || WEXITSTATUS(st) ||
+			read(fd[s][0], &res[job[s]], sizeof(*res)) != sizeof(*res))
+			return -1;
+		close(fd[s][0]);
+	}
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Worst trial of set (mean: ties)
+static double 
+tune_cost(const struct tune_res *res, double *mean)
+{
+	double c, worst = 0;
+	uint32_t i;
+
+	*mean = 0;
+	for (i = 0; i < tune_trials; ++i) {
+		c = res[i].settle + TUNE_OVER_W * res[i].over +
+			TUNE_FAIL_MS * res[i].fails;
+		*mean += c / tune_trials;
+		if (c > worst)
+			worst = c;
+	}
+	return worst;
+}
+//-----------------------------------------------------------------------------
+static int 
+tune_cmpD(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+//-----------------------------------------------------------------------------
+// Min, median, p90, max of field at offset of trials
+static void 
+tune_dist(const char *name, const struct tune_res *res, size_t off)
+{
+	static double v[TUNE_TRIALS_MAX];
+	uint32_t i, n = tune_trials;
+
+	for (i = 0; i < n; ++i)
+		v[i] = *(const double *)((const char *)&res[i] + off);
+	qsort(v, n, sizeof(v[0]), tune_cmpD);
+	printf("%-10s %8.1f %8.1f %8.1f %8.1f\n", name, v[0], v[n / 2U],
+		v[(n * 9U) / 10U < n ? (n * 9U) / 10U : n - 1U], v[n - 1U]);
+}
+//-----------------------------------------------------------------------------
+static void 
+tune_print(const char *title, const struct tune_gain *g,
+	const struct tune_res *res)
+{
+	uint32_t i, fails = 0;
+	double mean, worst = tune_cost(res, &mean);
+
+	for (i = 0; i < tune_trials; ++i)
+		fails += res[i].fails;
+	printf("%s: start %d stop %d lash %d over %d\n", title, g->p[0],
+		g->p[1], g->p[2], g->p[3]);
+	printf("%-10s %8s %8s %8s %8s\n", "", "min", "median", "p90", "max");
+	tune_dist("settle_ms", res, offsetof(struct tune_res, settle));
+	tune_dist("overshoot", res, offsetof(struct tune_res, over));
+	tune_dist("err", res, offsetof(struct tune_res, err));
+	printf("failed %u of %u moves (%.1f %%), cost worst %.1f mean %.1f\n",
+		fails, tune_trials * TUNE_MOVES,
+		100.0 * fails / (tune_trials * TUNE_MOVES), worst, mean);
+}
+//=============================================================================
+static uint32_t 
+tune_valid(const struct tune_gain *g)
+{
+	return g->p[0] >= 2 && g->p[0] <= TUNE_START_MAX &&
+		g->p[1] >= 0 && g->p[1] < g->p[0] &&
+		g->p[2] >= 0 && g->p[2] <= (int32_t)FOCUS_LASH_MAX &&
+		g->p[3] > g->p[0] && g->p[3] <= TUNE_OVER_MAX;
+}
+//-----------------------------------------------------------------------------
+// Pattern search from g (best to g); return -1 if trial failed
+static int32_t 
+tune_search(struct tune_gain *g, uint32_t iters, uint32_t seed)
+{
+	static struct tune_res res[(TUNE_CAND_MAX + 1U) * TUNE_TRIALS_MAX];
+	struct tune_gain cand[TUNE_CAND_MAX];
+	int32_t step[TUNE_PARAMS] = { 4, 2, 8, 16 };
+	uint32_t it, p, n, c, best;
+	double cost, mean, best_c, best_m, cm;
+
+	if (tune_eval(g, 1U, seed, res))
+		return -1;
+	best_c = tune_cost(res, &best_m);
+	fprintf(stderr, "start: cost %.1f (mean %.1f)\n", best_c, best_m);
+	for (it = 0; it < iters; ++it) {
+		// 1. Candidates: + / - step of each parameter
+		n = 0;
+		for (p = 0; p < TUNE_PARAMS; ++p) {
+			if (p == 3U && tune_approach == FOCUS_APPROACH_BOTH)
+				continue;
+			cand[n] = *g;
+			cand[n].p[p] += step[p];
+			n += tune_valid(&cand[n]);
+			cand[n] = *g;
+			cand[n].p[p] -= step[p];
+			n += tune_valid(&cand[n]);
+		}
+		if (n && tune_eval(cand, n, seed, res))
+			return -1;
+		// 2. Best candidate
+		best = n;
+		for (c = 0; c < n; ++c) {
+			cost = tune_cost(&res[c * tune_trials], &mean);
+			if (cost < best_c || (cost == best_c && mean < best_m)) {
+				best = c;
+				best_c = cost;
+				best_m = mean;
+			}
+		}
+		// 3. Move to best, else smaller steps
+		if (best < n) {
+			*g = cand[best];
+		} else {
+			for (p = 0, cm = 0; p < TUNE_PARAMS; ++p) {
+				cm += step[p] > 1;
+				step[p] = step[p] > 1 ? step[p] / 2 : 1;
+			}
+		}
+		fprintf(stderr, "iteration %u: start %d stop %d lash %d over %d "
+			"cost %.1f (mean %.1f)%s\n", it + 1U, g->p[0], g->p[1],
+			g->p[2], g->p[3], best_c, best_m, best < n ? "" : ", steps / 2");
+		if (best == n && cm == 0)
+			break;
+	}
+	return 0;
+}
+//=============================================================================
+// Boot firmware up to focus and pole ready
+static int32_t 
+tune_boot(void)
+{
+	uint64_t end;
+
+	sim_init();
+	plant_init(tune_plant, PLANT_MOTORS);
+	main_init();
+	end = sim_now() + 10000U * (uint64_t)SIM_CYCLES_MS;
+	while (focus_getState() != FOCUS_STATE_OK ||
+		pole_getState() != POLE_STATE_OK) {
+		if (sim_now() >= end)
+			return -1;
+		main_loop();
+		sim_idle(SIM_LOOP_CYCLES);
+	}
+	return 0;
+}
+//-----------------------------------------------------------------------------
+int 
+main(int argc, char **argv)
+{
+	static struct tune_res res[TUNE_TRIALS_MAX];
+	struct tune_gain g = { { FOCUS_BAND_START, FOCUS_BAND_STOP, 0,
+		FOCUS_OVER_DEF } }, g0;
+	uint32_t seed = 1U, iters = 0, p;
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int c;
+
+	tune_jobs = cpus > 0 ? (uint32_t)cpus : 1U;
+	while ((c = getopt(argc, argv, "n:s:j:k:e:a:g:o:")) != -1) {
+		if (c == 'n')
+			tune_trials = (uint32_t)atoi(optarg);
+		else if (c == 's')
+			seed = (uint32_t)strtoul(optarg, NULL, 0);
+		else if (c == 'j')
+			tune_jobs = (uint32_t)atoi(optarg);
+		else if (c == 'k')
+			tune_spread = atof(optarg);
+		else if (c == 'e')
+			tune_tol = atof(optarg);
+		else if (c == 'a')
+			tune_approach = (uint32_t)atoi(optarg);
+		else if (c == 'g' && sscanf(optarg, "%d,%d,%d,%d", &g.p[0],
+			&g.p[1], &g.p[2], &g.p[3]) == 4)
+			;
+		else if (c == 'o')
+			iters = (uint32_t)atoi(optarg);
+		else
+			break;
+	}
+	if (c != -1 || !tune_trials || tune_trials > TUNE_TRIALS_MAX ||
+		!tune_jobs || tune_approach > FOCUS_DIR_BACK || !tune_valid(&g)) {
+		fprintf(stderr, "usage: %s [-n trials] [-s seed] [-j jobs] "
+			"[-k spread] [-e tol] [-a approach] [-g start,stop,lash,over] "
+			"[-o iterations]\n", argv[0]);
+		return 2;
+	}
+	if (tune_jobs > TUNE_JOBS_MAX)
+		tune_jobs = TUNE_JOBS_MAX;
+
+	if (tune_boot()) {
+		fprintf(stderr, "tune: firmware not ready\n");
+		return 2;
+	}
+	printf("%u trials x %u moves, seed %u, spread %.2f, tol %.1f, "
+		"approach %u, %u jobs\n", tune_trials, TUNE_MOVES, seed,
+		tune_spread, tune_tol, tune_approach, tune_jobs);
+	g0 = g;
+	if (iters) {
+		if (tune_search(&g, iters, seed))
+			goto fail;
+		// Fresh trials: start parameters against best
+		++seed;
+		printf("check on seed %u\n", seed);
+		if (tune_eval(&g0, 1U, seed, res))
+			goto fail;
+		tune_print("start", &g0, res);
+	}
+	if (tune_eval(&g, 1U, seed, res))
+		goto fail;
+	tune_print(iters ? "best" : "parameters", &g, res);
+	if (iters) {
+		printf("-g");
+		for (p = 0; p < TUNE_PARAMS; ++p)
+			printf("%c%d", p ? ',' : ' ', g.p[p]);
+		printf("\n");
+	}
+	return 0;
+fail:
+	fprintf(stderr, "tune: trial failed\n");
+	return 2;
+}
+//=============================================================================
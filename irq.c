@@ -0,0 +1,100 @@
+//=============================================================================
+/*
+* modules:
+ - NVIC (priority grouping)
+ - DWT (cycle counter)
+* notes:
+ - latency - cycles from the event to the entry in the handler; each 
+   handler knows own event time (see irq_add() callers), so constant part 
+   (e.g. ADC conversion time for DMA 1) is included; jitter = max - min
+ - duration - cycles from the entry to irq_add() call (end of handler)
+ - count - handlers run (irq_add() calls): main loop measures own code 
+   without preemption (see axis_cost())
+ - all values in cycles of HCLK
+*/
+//=============================================================================
+#include "main.h"
+#include "irq.h"
+//=============================================================================
+static volatile uint32_t lat_min[IRQ_SRC_NUM];
+static volatile uint32_t lat_max[IRQ_SRC_NUM];
+static volatile uint32_t dur_max[IRQ_SRC_NUM];
+static volatile uint32_t irq_count;
+//=============================================================================
+// 1. Priority grouping for all interrupts (see IRQ_GROUP)
+// 2. Enable cycle counter (DWT)
+// 3. Reset statistics
+void 
+irq_init(void)
+{
+  // 1. Priority grouping for all interrupts (see IRQ_GROUP)
+	NVIC_SetPriorityGrouping(IRQ_GROUP);
+	
+  // 2. Enable cycle counter (DWT)
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	
+  // 3. Reset statistics
+	irq_reset();
+}
+//-----------------------------------------------------------------------------
+void 
+irq_reset(void)
+{
+	uint32_t i;
+	
+	for (i = 0; i < IRQ_SRC_NUM; ++i) {
+		lat_min[i] = 0xFFFFFFFFU;
+		lat_max[i] = 0;
+		dur_max[i] = 0;
+	}
+}
+//=============================================================================
+// Call at the end of handler
+// src - IRQ_SRC_x
+// t0 - irq_cycles() at the entry in handler
+// lat - latency of the entry or IRQ_NOLAT
+void 
+irq_add(uint32_t src, uint32_t t0, uint32_t lat)
+{
+	uint32_t dur = irq_cycles() - t0;
+	
+	++irq_count;
+	if (dur > dur_max[src])
+		dur_max[src] = dur;
+	
+	if (lat == IRQ_NOLAT)
+		return;
+	if (lat < lat_min[src])
+		lat_min[src] = lat;
+	if (lat > lat_max[src])
+		lat_max[src] = lat;
+}
+//=============================================================================
+uint32_t 
+irq_getJitter(uint32_t src)
+{
+	if (lat_max[src] < lat_min[src])
+		return 0;
+	return lat_max[src] - lat_min[src];
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+irq_getLatency(uint32_t src)
+{
+	return lat_max[src];
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+irq_getDuration(uint32_t src)
+{
+	return dur_max[src];
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+irq_getCount(void)
+{
+	return irq_count;
+}
+//=============================================================================
@@ -0,0 +1,52 @@
+//=============================================================================
+#ifndef IRQ_H
+#define IRQ_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+// Priority plan: 2 bits preemption priority, 2 bits sub-priority 
+// (lower value - higher priority); motion safety (TIM 6 pole stop) preempts 
+// ADC frame processing, both preempt communications
+#define IRQ_GROUP         5U  // PRIGROUP (4 priority bits: 2 group + 2 sub)
+
+#define IRQ_TIM6_PRE      0U
+#define IRQ_TIM6_SUB      0U
+#define IRQ_DMA1_PRE      1U
+#define IRQ_DMA1_SUB      0U
+#define IRQ_ADC1_PRE      1U  // same group as DMA 1: both re-arm ADC/DMA
+#define IRQ_ADC1_SUB      1U
+#define IRQ_CAN_RX0_PRE   3U
+#define IRQ_CAN_RX0_SUB   0U
+#define IRQ_CAN_SCE_PRE   3U  // bus-off and error passive (counters only)
+#define IRQ_CAN_SCE_SUB   1U
+#define IRQ_EXTI8_PRE     3U  // wake-up from Stop mode (see power.c)
+#define IRQ_EXTI8_SUB     2U
+#define IRQ_CAN_RX1_PRE   3U  // frames of other nodes (load statistics)
+#define IRQ_CAN_RX1_SUB   3U
+
+#define IRQ_PRIO(pre, sub)  NVIC_EncodePriority(IRQ_GROUP, (pre), (sub))
+//-----------------------------------------------------------------------------
+// Sources for statistics
+#define IRQ_SRC_TIM6     0U
+#define IRQ_SRC_DMA1     1U
+#define IRQ_SRC_ADC1     2U
+#define IRQ_SRC_CAN_RX0  3U
+#define IRQ_SRC_CAN_SCE  4U
+#define IRQ_SRC_EXTI8    5U
+#define IRQ_SRC_CAN_RX1  6U
+#define IRQ_SRC_NUM      7U
+
+#define IRQ_NOLAT        0xFFFFFFFFU  // latency is not measured for source
+//-----------------------------------------------------------------------------
+#define irq_cycles()     (DWT->CYCCNT)
+//-----------------------------------------------------------------------------
+void irq_init(void);
+void irq_add(uint32_t src, uint32_t t0, uint32_t lat);
+void irq_reset(void);
+uint32_t irq_getJitter(uint32_t src);
+uint32_t irq_getLatency(uint32_t src);
+uint32_t irq_getDuration(uint32_t src);
+uint32_t irq_getCount(void);
+//=============================================================================
+#endif // IRQ_H
+//=============================================================================
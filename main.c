@@ -11,6 +11,18 @@ http://www.keil.com/support/docs/3213.htm
 #include "pole.h"
 #include "can.h"
 #include "clock.h"
+#include "trace.h"
+#include "irq.h"
+#include "cmd.h"
+#include "config.h"
+#include "preset.h"
+#include "calib.h"
+#include "power.h"
+#include "dsp.h"
+#include "axis.h"
+#include "boot.h"
+#include "stream.h"
+#include "drive.h"
 //=============================================================================
 volatile uint32_t *focus_pos;
 volatile uint32_t *temp;
@@ -18,51 +30,365 @@ volatile uint32_t *vref;
 volatile uint32_t focus_target;
 volatile uint32_t pole_target;
 //=============================================================================
-int 
-main(void)
+// Initialization of all modules (before main loop)
+void 
+main_init(void)
 {
-	uint32_t i, focus_pos_v;
-	
 	clock_change();
 	
+	irq_init();
 	debug_init();
+	config_init();
+	boot_init();
 	
 	focus_init();
+	axis_init();
 	pole_init();
+	drive_init();
 	can_init();
+	trace_init();
+	stream_init();
+	cmd_init();
+	preset_init();
+	calib_init();
+	power_init();
 	
+	// Last targets of warm boot (else position of first frame, POLE_0)
+	if (boot_getFocus() != BOOT_FOCUS_NONE)
+		focus_target = focus_clamp(boot_getFocus());
 	focus_start();
-	pole_start();
+	pole_start(boot_getPole());
 	can_start();
 	
-	for (;;) {
+	// Calibration at start (after first DMA frame; not on warm boot)
+	if (config.calib_boot && !boot_isWarm())
+		calib_start();
+}
+//-----------------------------------------------------------------------------
+// One pass of main loop
+void 
+main_loop(void)
+{
+	uint32_t focus_pos_v, arrived = 0;
+	uint32_t cmd_focus, cmd_pole, cmd_id, t0;
+	
+	// Apply latest command from CAN (both targets at once); command from 
+	// before calibration is held up to its end (calib.c)
+	if (!(focus_getState() & FOCUS_STATE_CALIB) && 
+		cmd_get(&cmd_focus, &cmd_pole, &cmd_id) == 0) {
+		if (cmd_focus != CMD_KEEP)
+			focus_target = cmd_focus;
+		if (cmd_pole != CMD_KEEP)
+			pole_target = cmd_pole;
+	}
+	
+	if (pole_getState() == POLE_STATE_OK) {
+		// Store targets for warm boot (pole is not trusted while it moves)
+		boot_poll(pole_target != pole_getPole() || pole_isMoving());
+		pole_setPole(pole_target);
+	}
+	
+	if (focus_getState() == FOCUS_STATE_OK) {
+		
+		focus_pos_v = *focus_pos & FOCUS_MASK;
 		
-		if (pole_getState() == POLE_STATE_OK) {
-			pole_setPole(pole_target);
-		}
+		t0 = axis_costStart(AXIS_FOCUS);
+		arrived = focus_control(focus_pos_v, focus_target);
+		axis_cost(AXIS_FOCUS, t0);
 		
-		if (focus_getState() == FOCUS_STATE_OK) {
-			
-			focus_pos_v = 
-				(*focus_pos & FOCUS_MASK) / FOCUS_DEVIDER;
-			
-			if (focus_pos_v > focus_target) {
-				focus_keysBack();
-			} else if (focus_pos_v < focus_target) {
-				focus_keysForward();
-			} else { 
-				focus_keysStop();
-			}
-		}
+		// Notification on arrival to preset (if requested)
+		preset_poll(arrived, focus_pos_v);
 	}
+	
+	// Controllers of other axes (zoom, iris) on same frame
+	axis_poll();
+	
+	// Rate of ADC frames: fast while any axis moves, slow when parked
+	focus_adapt(arrived);
+	
+	// Acknowledge, rejection and end of move of commands (events)
+	cmd_poll(arrived);
+	
+	// Save configuration (if requested) only when motors are stopped
+	if (focus_getDir() == FOCUS_DIR_STOP && !axis_isMoving() && 
+		!pole_isMoving() && !(focus_getState() & FOCUS_STATE_CALIB))
+		config_poll();
+	
+	// Result of calibration (after calibration)
+	calib_poll();
+	
+	// Read out flight recorder (if requested)
+	trace_poll();
+	
+	// Position streaming (if requested)
+	stream_poll();
+	
+	// Motor drivers: enabled around moves, on and drive time
+	drive_poll();
+	
+	// Bus-off recovery time, change of retransmission policy
+	can_poll();
+	
+	// Stop mode after quiet period (returns after wake-up or at once)
+	power_poll(arrived);
+}
+//=============================================================================
+int 
+main(void)
+{
+	main_init();
+	
+	for (;;)
+		main_loop();
 }
 //=============================================================================
 void 
 send_state(void)
 {
+	uint32_t pos = *focus_pos & FOCUS_MASK;
+	
+	// Legacy: step of focus and pole; high resolution: focus and target
 	can_send(CAN_ID_CTRL, 8, 
-			((*focus_pos & FOCUS_MASK) / FOCUS_DEVIDER) << 8 | 
-			pole_target,
-		0, 0);
+			focus_toStep(pos) << CAN_FOCUS_POS | 
+			pole_target << CAN_POLE_POS,
+			pos << CAN_STATE_FOCUS_HR_POS | 
+			focus_target << CAN_STATE_TARGET_HR_POS, 
+		0);
+}
+//=============================================================================
+static uint32_t 
+sat16(uint32_t v)
+{
+	return v > 0xFFFFU ? 0xFFFFU : v;
+}
+//-----------------------------------------------------------------------------
+// Service request (CAN_ID_SRV) from CAN RX interrupt
+void 
+service(uint32_t l, uint32_t h)
+{
+	uint32_t op, a1, a2, a3, n, err, l_, h_;
+	
+	op = (l & CAN_SRV_OP_MSK) >> CAN_SRV_OP_POS;
+	a1 = l >> CAN_SRV_ARG1_POS & CAN_SRV_ARG_MSK;
+	a2 = l >> CAN_SRV_ARG2_POS & CAN_SRV_ARG_MSK;
+	a3 = l >> CAN_SRV_ARG3_POS & CAN_SRV_ARG_MSK;
+	
+	switch (op) {
+	case CAN_SRV_TRACE_ARM:
+		trace_arm(a1, a2, a3);
+		break;
+	case CAN_SRV_TRACE_TRIG:
+		trace_trigger();
+		break;
+	case CAN_SRV_TRACE_READ:
+		n = trace_read();
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				trace_getState() << CAN_SRV_ARG1_POS | 
+				n << CAN_SRV_ARG2_POS, 
+			0, 0);
+		break;
+	case CAN_SRV_IRQ_STAT:
+		if (a1 >= IRQ_SRC_NUM)
+			break;
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				a1 << CAN_SRV_ARG1_POS | 
+				sat16(irq_getJitter(a1)) << CAN_SRV_ARG2_POS, 
+				sat16(irq_getLatency(a1)) | 
+				sat16(irq_getDuration(a1)) << 16, 
+			0);
+		break;
+	case CAN_SRV_IRQ_RESET:
+		irq_reset();
+		break;
+	case CAN_SRV_CMD_STAT:
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				(cmd_getReceived() & 0xFFFFU) << CAN_SRV_ARG2_POS, 
+				(cmd_getApplied() & 0xFFFFU) | 
+				(cmd_getSuperseded() & 0xFFFFU) << 16, 
+			0);
+		break;
+	case CAN_SRV_PRESET_STORE:
+		err = preset_store(a1, h & 0xFFFFU, a2, a3) ? 0xFFU : 0;
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				a1 << CAN_SRV_ARG1_POS | 
+				err << CAN_SRV_ARG2_POS, 
+			0, 0);
+		break;
+	case CAN_SRV_PRESET_RECALL:
+		err = preset_recall(a1, a2, a3) ? 0xFFU : 0;
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				a1 << CAN_SRV_ARG1_POS | 
+				err << CAN_SRV_ARG2_POS, 
+			0, 0);
+		break;
+	case CAN_SRV_PRESET_READ:
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				a1 << CAN_SRV_ARG1_POS, 
+				preset_get(a1), 
+			0);
+		break;
+	case CAN_SRV_CALIB_START:
+		err = calib_start() ? 0xFFU : 0;
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				err << CAN_SRV_ARG2_POS, 
+			0, 0);
+		break;
+	case CAN_SRV_CALIB_READ:
+		calib_get(a1, &l_, &h_);
+		can_send(CAN_ID_SRV, 8, op << CAN_SRV_OP_POS | l_, h_, 0);
+		break;
+	case CAN_SRV_CALIB_BOOT:
+		config.calib_boot = a1 ? 1U : 0;
+		config_request();
+		break;
+	case CAN_SRV_CAN_STAT:
+		can_getStat(a1, &l_, &h_);
+		can_send(CAN_ID_SRV, 8, op << CAN_SRV_OP_POS | l_, h_, 0);
+		break;
+	case CAN_SRV_CAN_RESET:
+		can_resetStat();
+		cmd_resetLatency();
+		break;
+	case CAN_SRV_CAN_LOAD:
+		can_getLoad(a1, &l_, &h_);
+		can_send(CAN_ID_SRV, 8, op << CAN_SRV_OP_POS | l_, h_, 0);
+		break;
+	case CAN_SRV_CAN_RATE:
+		err = 0;
+		if (a1 != 0xFFU)
+			err = can_setRate(a1) ? 0xFFU : 0;
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				config.can_rate << CAN_SRV_ARG1_POS | 
+				can_getRate() << CAN_SRV_ARG2_POS | 
+				err << CAN_SRV_ARG3_POS, 
+			can_getRates(), 0);
+		break;
+	case CAN_SRV_CAN_RETRY:
+		err = 0;
+		if (a1 != 0xFFU)
+			err = can_setRetry(a1, a2) ? 0xFFU : 0;
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				(config.can_retry >> CAN_RETRY_POS & CAN_RETRY_MSK) 
+					<< CAN_SRV_ARG1_POS | 
+				(config.can_retry >> CAN_RETRIES_POS & CAN_RETRY_MSK) 
+					<< CAN_SRV_ARG2_POS | 
+				err << CAN_SRV_ARG3_POS, 
+			0, 0);
+		break;
+	case CAN_SRV_POWER:
+		if (a1 != 0xFFU)
+			power_setQuiet(a1);
+		power_getStat(&l_, &h_);
+		can_send(CAN_ID_SRV, 8, op << CAN_SRV_OP_POS | l_, h_, 0);
+		break;
+	case CAN_SRV_FOCUS_RATE:
+		err = 0;
+		if (a1 != 0xFFU)
+			err = focus_setRate(a1) ? 0xFFU : 0;
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				focus_getMode() << CAN_SRV_ARG1_POS | 
+				focus_getRate() << CAN_SRV_ARG2_POS | 
+				err << CAN_SRV_ARG3_POS, 
+			focus_getFrames(), 0);
+		break;
+	case CAN_SRV_DSP_BENCH:
+		err = dsp_bench(a1, &n, &h_) ? 0xFFU : 0;
+		if (err)
+			n = h_ = 0;
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				a1 << CAN_SRV_ARG1_POS | 
+				DSP_SIMD << CAN_SRV_ARG2_POS | 
+				err << CAN_SRV_ARG3_POS, 
+				sat16(n * 16U / DSP_BENCH_N) | h_ << 16, 
+			0);
+		break;
+	case CAN_SRV_CMD_EVENT:
+		if (a1 != 0xFFU)
+			cmd_setEvent(a1);
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				config.cmd_event << CAN_SRV_ARG1_POS | 
+				(cmd_getRejected() & 0xFFFFU) << CAN_SRV_ARG2_POS, 
+			cmd_getEvents(), 0);
+		break;
+	case CAN_SRV_AXIS:
+		err = 0;
+		if (a2)
+			err = axis_setTarget(a1, h & 0xFFFFU) ? 0xFFU : 0;
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				a1 << CAN_SRV_ARG1_POS | 
+				err << CAN_SRV_ARG2_POS | 
+				axis_getDir(a1) << CAN_SRV_ARG3_POS, 
+				(a1 < AXIS_NUM ? focus_getAxis(a1) & FOCUS_MASK : 0) | 
+				sat16(axis_getCycles(a1)) << 16, 
+			0);
+		break;
+	case CAN_SRV_FOCUS_LASH:
+		err = 0;
+		if (a1 != 0xFFU)
+			err = focus_setLash(a1, a2, h & 0xFFFFU) ? 0xFFU : 0;
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				config.focus_approach << CAN_SRV_ARG1_POS | 
+				config.focus_over << CAN_SRV_ARG2_POS | 
+				err << CAN_SRV_ARG3_POS, 
+				config.focus_lash | focus_getLens() << 16, 
+			0);
+		break;
+	case CAN_SRV_BOOT:
+		boot_getStat(&l_, &h_);
+		can_send(CAN_ID_SRV, 8, op << CAN_SRV_OP_POS | l_, h_, 0);
+		break;
+	case CAN_SRV_POLE_FOCUS:
+		err = 0;
+		if (a2)
+			err = focus_setPoleOffset(a1, (int16_t)(h & 0xFFFFU)) ? 
+				0xFFU : 0;
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | 
+				a1 << CAN_SRV_ARG1_POS | 
+				err << CAN_SRV_ARG2_POS, 
+				(a1 < CONFIG_POLE_NUM ? 
+					(uint32_t)config.focus_pole[a1] & 0xFFFFU : 0) | 
+				focus_target << 16, 
+			0);
+		break;
+	case CAN_SRV_STREAM:
+		err = 0;
+		if (a1 != 0xFFU)
+			err = stream_start(a1, a2) ? 0xFFU : 0;
+		stream_getStat(&l_, &h_);
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | l_ | 
+				err << CAN_SRV_ARG3_POS, 
+			h_, 0);
+		break;
+	case CAN_SRV_DRIVE:
+		err = 0;
+		if (a2)
+			err = a1 != DRIVE_CONFIG || 
+				drive_setTime(h & 0xFFFFU, h >> 16) ? 0xFFU : 0;
+		drive_getStat(a1, &l_, &h_);
+		can_send(CAN_ID_SRV, 8, 
+				op << CAN_SRV_OP_POS | l_ | 
+				err << CAN_SRV_ARG2_POS, 
+			h_, 0);
+		break;
+	default:
+		// err op
+		break;
+	}
 }
 //=============================================================================
@@ -18,7 +18,10 @@ extern volatile uint32_t *vref;
 extern volatile uint32_t focus_target;
 extern volatile uint32_t pole_target;
 //-----------------------------------------------------------------------------
+void main_init(void);
+void main_loop(void);
 void send_state(void);
+void service(uint32_t l, uint32_t h);
 //=============================================================================
 #endif // MAIN_H
 //=============================================================================
@@ -1,68 +1,37 @@
 //=============================================================================
 /*
 * modules:
- - GPIO B (AHB): pin 4 ("MC1_P"), pin 5 ("MC1_N")
- - GPIO C (AHB): pin 14 ("EN_1")
- - GPIO A (AHB): pin 2 ("MC2_P"), pin 3 ("MC2_N")
- - GPIO B (AHB): pin 10 ("EN_2")
+ - GPIO (AHB): "MC1_P", "MC1_N", "EN_1" (motor channel 1, see board.h)
+ - GPIO (AHB): "MC2_P", "MC2_N", "EN_2" (motor channel 2, see board.h)
  - TIM 6 (APB 1)
 * notes:
  - TIM 6 prescaler from RCC: Figure 14. STM32F302x6/8 clock tree
  - look for "<RCC>" for code depend on system clock frequence value
- - GPIO B, pin 4 - using after reset => clear related bits in GPIO B
+ - MC1_P is NJTRST after reset (PB 4): see board.h
+ - start resets all poles (POLE_0, one TIM 6 period) or, on warm boot 
+   with trusted pole (see boot.c), keeps stored pole without move
+ - "EN_1", "EN_2" are driven by drive.c (enabled around moves): move 
+   starts after drive_start() of its motors (lead time)
 */
 //=============================================================================
 #include "main.h"
 #include "pole.h"
+#include "irq.h"
+#include "board.h"
+#include "boot.h"
+#include "drive.h"
 //=============================================================================
 static volatile uint32_t pole_state;
 static uint32_t pole_current;
+static volatile uint32_t pole_t0;  // cycles when TIM 6 was run
+static volatile uint32_t pole_drive;  // driven motors (bit 0 - motor 1)
 //=============================================================================
 static void 
 keys_init(void)
 {
-	// For delay
-	int32_t i;
-	
-	// Enable clock for GPIO A, B, C + delay
-	RCC->AHBENR |= RCC_AHBENR_GPIOAEN | RCC_AHBENR_GPIOBEN | 
-		RCC_AHBENR_GPIOCEN;
-	for (i = 0; i < 15; ++i);
-	
-	// Using pins: PA 2, PA 3, PB 4, PB 5, PB 10, PC 14
-	//                         ^^^^-- DANGER
-	
-	// Output mode
-	  // Clear PB4 bits
-	GPIOB->MODER &= ~GPIO_MODER_MODER4_Msk;
-	
-	GPIOA->MODER |= GPIO_MODER_MODER2_0 | GPIO_MODER_MODER3_0;
-	GPIOB->MODER |= GPIO_MODER_MODER4_0 | GPIO_MODER_MODER5_0 | 
-		GPIO_MODER_MODER10_0;
-	GPIOC->MODER |= GPIO_MODER_MODER14_0; 
-	
-	// High speed
-	  // Clear PB4 bits
-	GPIOB->OSPEEDR &= ~GPIO_OSPEEDER_OSPEEDR4_Msk;
-	
-	GPIOA->OSPEEDR |= 
-		GPIO_OSPEEDER_OSPEEDR2_0 | GPIO_OSPEEDER_OSPEEDR2_1 |
-		GPIO_OSPEEDER_OSPEEDR3_0 | GPIO_OSPEEDER_OSPEEDR3_1;
-	GPIOB->OSPEEDR |= 
-		GPIO_OSPEEDER_OSPEEDR4_0 | GPIO_OSPEEDER_OSPEEDR4_1 |
-		GPIO_OSPEEDER_OSPEEDR5_0 | GPIO_OSPEEDER_OSPEEDR5_1 |
-		GPIO_OSPEEDER_OSPEEDR10_0 | GPIO_OSPEEDER_OSPEEDR10_1;
-	GPIOC->OSPEEDR |= 
-		GPIO_OSPEEDER_OSPEEDR14_0 | GPIO_OSPEEDER_OSPEEDR14_1;
-	
-	// Pull-down
-	  // Clear PB4 bits
-	GPIOB->PUPDR &= ~GPIO_PUPDR_PUPDR4_Msk;
-	
-	GPIOA->PUPDR |= GPIO_PUPDR_PUPDR2_1 | GPIO_PUPDR_PUPDR3_1;
-	GPIOB->PUPDR |= GPIO_PUPDR_PUPDR4_1 | GPIO_PUPDR_PUPDR5_1 | 
-		GPIO_PUPDR_PUPDR10_1;
-	GPIOC->PUPDR |= GPIO_PUPDR_PUPDR14_1;
+	// Output, high speed, pull-down: MC1_x, EN_1, MC2_x, EN_2 (see 
+	// board.c; whole fields => reset state of PB 4 is cleared)
+	board_gpioInit(BOARD_GRP_POLE);
 }
 //-----------------------------------------------------------------------------
 void
@@ -98,7 +67,8 @@ tim6_init(void)
   // Enable UEV interrupt
 	TIM6->DIER |= TIM_DIER_UIE;
 	
-  // Enable interrupt from TIM 6
+  // Enable interrupt from TIM 6 (priority - see irq.h)
+	NVIC_SetPriority(TIM6_DAC_IRQn, IRQ_PRIO(IRQ_TIM6_PRE, IRQ_TIM6_SUB));
 	NVIC_EnableIRQ(TIM6_DAC_IRQn);
 }
 //-----------------------------------------------------------------------------
@@ -106,104 +76,129 @@ void
 pole_init(void)
 {
 	pole_state = POLE_STATE_NOSTART;
+	pole_drive = 0;
 	
 	keys_init();
 	tim6_init();
 }
 //=============================================================================
 void 
-pole_keysEn(void)
-{
-	// Enable EN_1
-	GPIOC->BSRR |= GPIO_BSRR_BS_14;
-	// Enable EN_2
-	GPIOB->BSRR |= GPIO_BSRR_BS_10;
-}
-//-----------------------------------------------------------------------------
-void 
-pole_keysDis(void)
-{
-	// Disable EN_1
-	GPIOC->BSRR |= GPIO_BSRR_BR_14;
-	// Disable EN_2
-	GPIOB->BSRR |= GPIO_BSRR_BR_10;
-}
-//-----------------------------------------------------------------------------
-void 
 pole_keysSetDir(int32_t m_1, int32_t m_2)
 {
 	if (m_1 == 0)
 		// Reset MC1_P, reset MC1_N
-		GPIOB->BSRR |= GPIO_BSRR_BR_4 | GPIO_BSRR_BR_5;
+		BOARD_MC_GPIO(1)->BSRR = BOARD_MC(1, 0, 0);
 	if (m_2 == 0)
 		// Reset MC2_P, reset MC2_N
-		GPIOA->BSRR |= GPIO_BSRR_BR_2 | GPIO_BSRR_BR_3;
+		BOARD_MC_GPIO(2)->BSRR = BOARD_MC(2, 0, 0);
 	
 	if (m_1 == -1)
 		// Set MC1_P, reset MC1_N
-		GPIOB->BSRR |= GPIO_BSRR_BS_4 | GPIO_BSRR_BR_5;
+		BOARD_MC_GPIO(1)->BSRR = BOARD_MC(1, 1, 0);
 	if (m_2 == 1)
 		// Set MC2_P, reset MC2_N
-		GPIOA->BSRR |= GPIO_BSRR_BS_2 | GPIO_BSRR_BR_3;
+		BOARD_MC_GPIO(2)->BSRR = BOARD_MC(2, 1, 0);
 	
 	if (m_1 == 1)
-		// Set MC1_P, reset MC1_N
-		GPIOB->BSRR |= GPIO_BSRR_BR_4 | GPIO_BSRR_BS_5;
+		// Reset MC1_P, set MC1_N
+		BOARD_MC_GPIO(1)->BSRR = BOARD_MC(1, 0, 1);
 	if (m_2 == -1)
-		// Set MC2_P, reset MC2_N
-		GPIOA->BSRR |= GPIO_BSRR_BR_2 | GPIO_BSRR_BS_3;
+		// Reset MC2_P, set MC2_N
+		BOARD_MC_GPIO(2)->BSRR = BOARD_MC(2, 0, 1);
+	
+	pole_drive = (m_1 != 0) | (m_2 != 0) << 1;
 }
 //=============================================================================
+// After drive_init(); pole - stored pole of warm boot or BOOT_POLE_NONE 
+// (reset all poles)
 void 
-pole_start(void)
+pole_start(uint32_t pole)
 {
+	if (pole != BOOT_POLE_NONE) {
+		// Set target pole == current pole == stored pole
+		pole_target = pole;
+		pole_current = pole;
+		// Keys stopped (drivers off), ready without move
+		pole_keysSetDir(0, 0);
+		pole_state &= ~POLE_STATE_NOSTART;
+		return;
+	}
+	
 	// Set target pole == current pole
 	pole_target = POLE_0;
 	// Set current pole == target pole
 	pole_current = POLE_0;
-	// Enable keys
-	pole_keysEn();
+	// Enable drivers + wait lead time (both motors)
+	while (!(drive_start(DRIVE_POLE_1) & drive_start(DRIVE_POLE_2)))
+		drive_poll();
 	// Reset all poles
 	pole_keysSetDir(-1, -1);
 	// Run TIM 6
+	pole_t0 = irq_cycles();
 	TIM6->CR1 |= TIM_CR1_CEN;
 }
+//-----------------------------------------------------------------------------
+// Before Stop mode (see power.c): pole is not moving => keys are stopped
+// (drivers: drive_sleep())
+void 
+pole_sleep(void)
+{
+	pole_keysSetDir(0, 0);
+}
 //=============================================================================
+// Main loop (each pass): move starts when drivers of its motors are enabled
+// for lead time (see drive.c)
 void 
 pole_setPole(uint32_t pole)
 {
+	int32_t m_1 = 0, m_2 = 0;
+	uint32_t ready = 1U;
+	
 	if (pole_current == pole)
 		return;
 	
-	// Disable TIM 6 (if was be run)
-	TIM6->CR1 &= ~TIM_CR1_CEN;
-	// Clear counter regiset
-	TIM6->CNT &= 0xFFFF0000U;
-	
 	if (pole_current == POLE_1 && pole == POLE_2) {
 		// 1
-		pole_keysSetDir(-1, 1);
+		m_1 = -1;
+		m_2 = 1;
 	} else if (pole_current == POLE_2 && pole == POLE_1) {
 		// 2
-		pole_keysSetDir(1, -1);
+		m_1 = 1;
+		m_2 = -1;
 	} else if (pole_current == POLE_1 && pole == POLE_0) {
 		// 3
-		pole_keysSetDir(-1, 0);
+		m_1 = -1;
 	} else if (pole_current == POLE_2 && pole == POLE_0) {
 		// 4
-		pole_keysSetDir(0, -1);
+		m_2 = -1;
 	} else if (pole_current == POLE_0 && pole == POLE_1) {
 		// 5
-		pole_keysSetDir(1, 0);
+		m_1 = 1;
 	} else if (pole_current == POLE_0 && pole == POLE_2) {
 		// 6
-		pole_keysSetDir(0, 1);
+		m_2 = 1;
 	}
 	
+	// Drivers of moved motors (both calls: each one enables its driver)
+	if (m_1)
+		ready &= drive_start(DRIVE_POLE_1);
+	if (m_2)
+		ready &= drive_start(DRIVE_POLE_2);
+	if (!ready)
+		return;
+	
+	// Disable TIM 6 (if was be run)
+	TIM6->CR1 &= ~TIM_CR1_CEN;
+	// Clear counter regiset
+	TIM6->CNT &= 0xFFFF0000U;
+	
+	pole_keysSetDir(m_1, m_2);
+	
 	// Set current pole as pole get from main loop
 	pole_current = pole;
 	
 	// Run TIM 6
+	pole_t0 = irq_cycles();
 	TIM6->CR1 |= TIM_CR1_CEN;
 }
 //=============================================================================
@@ -212,10 +207,33 @@ pole_getState(void)
 {
 	return pole_state;
 }
+//-----------------------------------------------------------------------------
+uint32_t 
+pole_getPole(void)
+{
+	return pole_current;
+}
+//-----------------------------------------------------------------------------
+// TIM 6 is run (one-pulse mode clears CEN at the end of move)
+uint32_t 
+pole_isMoving(void)
+{
+	return TIM6->CR1 & TIM_CR1_CEN;
+}
+//-----------------------------------------------------------------------------
+// Driven motors: bit 0 - motor 1, bit 1 - motor 2 (RAM only)
+uint32_t 
+pole_getDrive(void)
+{
+	return pole_drive;
+}
 //=============================================================================
 void 
 TIM6_DAC_IRQHandler(void)
 {
+	// Entry time
+	uint32_t t0 = irq_cycles();
+	
 	// Stop all pole motors
 	pole_keysSetDir(0, 0);
 	
@@ -224,5 +242,9 @@ TIM6_DAC_IRQHandler(void)
 	
 	// Clear NOSTART flag (for main loop)
 	pole_state &= ~POLE_STATE_NOSTART;
+	
+	// Latency: cycles after one-pulse period ((ARR + 1) * (PSC + 1))
+	irq_add(IRQ_SRC_TIM6, t0, 
+		t0 - pole_t0 - (TIM6->ARR + 1U) * (TIM6->PSC + 1U));
 }
 //=============================================================================
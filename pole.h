@@ -8,9 +8,13 @@
 #define POLE_STATE_NOSTART   0x10U
 //-----------------------------------------------------------------------------
 void pole_init(void);
-void pole_start(void);
+void pole_start(uint32_t pole);
+void pole_sleep(void);
 uint32_t pole_getState(void);
 void pole_setPole(uint32_t pole);
+uint32_t pole_getPole(void);
+uint32_t pole_isMoving(void);
+uint32_t pole_getDrive(void);
 //=============================================================================
 #endif // POLE_H
 //=============================================================================
@@ -0,0 +1,247 @@
+//=============================================================================
+/*
+* modules:
+ - PWR (APB 1): Stop mode, voltage regulator in low-power mode
+ - EXTI line 8 (SYSCFG: "CAN_RX", see board.h): falling edge wakes up
+* notes:
+ - Stop mode after quiet period (config.power_quiet): no CAN frame, focus 
+   stopped on target, pole not moving, no calibration, no saving of 
+   configuration, no streaming, no pending CAN TX; motors are parked 
+   (keys stopped, drivers disabled before end of hold time, see drive.c),
+   TIM 2, ADC 1 and DMA 1 are stopped (see focus_sleep())
+ - any CAN frame wakes up by SOF (EXTI line 8 is unmasked in Stop mode 
+   only); this frame is lost (CAN is not clocked), host repeats it => 
+   Stop mode is off by default (POWER_QUIET_DEF), on by CAN_SRV_POWER
+ - SYSCLK is HSI after wake-up => clock_change() before restart of modules
+ - wake-to-ready: EXTI handler entry (+ POWER_WUSTOP_US) up to first ADC 
+   frame (main loop controls focus again); cycles before clock_change() 
+   are HSI cycles
+ - DWT does not count in Stop mode: quiet period starts after wake-up
+*/
+//=============================================================================
+#include "main.h"
+#include "power.h"
+#include "irq.h"
+#include "config.h"
+#include "clock.h"
+#include "focus.h"
+#include "pole.h"
+#include "axis.h"
+#include "can.h"
+#include "board.h"
+#include "stream.h"
+#include "drive.h"
+//-----------------------------------------------------------------------------
+// EXTI line (IMR, FTSR, PR bits and EXTI9_5 interrupt) is line 8
+#if BOARD_CAN_RX != 8U
+#error "power.c: CAN_RX must be pin 8 (EXTI line 8)"
+#endif
+//=============================================================================
+static volatile uint32_t power_state;
+static volatile uint32_t power_rx;     // CAN frame after last poll
+static volatile uint32_t power_exti;   // EXTI line 8 after Stop mode
+static uint32_t power_msT;             // cycles of HCLK per ms
+static uint32_t power_t0;              // start of quiet period (cycles)
+static volatile uint32_t power_wakeT;  // EXTI handler entry (cycles)
+static uint32_t power_hsiT;            // cycles at HSI after wake-up
+static uint32_t power_wakes;
+static uint32_t power_late;            // over POWER_WAKE_MAX_US
+static uint32_t power_wakeMax;         // us
+//=============================================================================
+// 1. Enable clock for SYSCFG and PWR
+// 2. EXTI line 8 from port of CAN_RX, falling edge (masked up to Stop mode)
+// 3. Enable interrupt from EXTI lines 9..5
+void 
+power_init(void)
+{
+	// For delay
+	int32_t i;
+	
+	power_state = POWER_STATE_RUN;
+	power_rx = 0;
+	power_exti = 0;
+	power_msT = clock_getHclk() / 1000U;
+	power_t0 = irq_cycles();
+	power_wakes = 0;
+	power_late = 0;
+	power_wakeMax = 0;
+	
+  // 1. Enable clock for SYSCFG and PWR + delay
+	RCC->APB2ENR |= RCC_APB2ENR_SYSCFGEN;
+	RCC->APB1ENR |= RCC_APB1ENR_PWREN;
+	for (i = 0; i < 15; ++i);
+	
+  // 2. EXTI line 8 from port of CAN_RX, falling edge (SOF of CAN frame)
+	SYSCFG->EXTICR[2] = (SYSCFG->EXTICR[2] & ~SYSCFG_EXTICR3_EXTI8) | 
+		BOARD_CAN_PORT << SYSCFG_EXTICR3_EXTI8_Pos;
+	EXTI->FTSR |= EXTI_FTSR_TR8;
+	EXTI->IMR &= ~EXTI_IMR_MR8;
+	
+  // 3. Enable interrupt from EXTI lines 9..5 (priority - see irq.h)
+	NVIC_SetPriority(EXTI9_5_IRQn, IRQ_PRIO(IRQ_EXTI8_PRE, IRQ_EXTI8_SUB));
+	NVIC_EnableIRQ(EXTI9_5_IRQn);
+}
+//-----------------------------------------------------------------------------
+// CAN RX interrupt: quiet period starts again
+void 
+power_activity(void)
+{
+	power_rx = 1;
+}
+//=============================================================================
+// Nothing to do for main loop and interrupts (except CAN RX)
+static uint32_t 
+power_isIdle(uint32_t arrived)
+{
+	return arrived && focus_getDir() == FOCUS_DIR_STOP && 
+		!axis_isMoving() && focus_getState() == FOCUS_STATE_OK && 
+		pole_getState() == POLE_STATE_OK && !pole_isMoving() && 
+		pole_getPole() == pole_target && 
+		!config_getRequest() && !stream_isOn() && can_isIdle();
+}
+//-----------------------------------------------------------------------------
+// 1. Park motors, stop TIM 2, ADC 1, DMA 1
+// 2. Unmask EXTI line 8 (old edge is cleared)
+// 3. Stop mode on WFI: SLEEPDEEP, regulator in low-power mode
+static void 
+power_stop(void)
+{
+  // 1. Park motors, stop TIM 2, ADC 1, DMA 1
+	focus_sleep();
+	axis_sleep();
+	pole_sleep();
+	drive_sleep();
+	
+  // 2. Unmask EXTI line 8 (write 1 to clear)
+	power_exti = 0;
+	EXTI->PR = EXTI_PR_PR8;
+	EXTI->IMR |= EXTI_IMR_MR8;
+	
+  // 3. Stop mode on WFI: SLEEPDEEP, regulator in low-power mode
+	PWR->CR = (PWR->CR & ~PWR_CR_PDDS) | PWR_CR_LPDS;
+	SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+	
+	power_state = POWER_STATE_STOP;
+}
+//-----------------------------------------------------------------------------
+// After EXTI line 8 (SYSCLK is HSI)
+// 1. Sleep mode on WFI (not Stop mode)
+// 2. System clock (HSE, PLL)
+// 3. Restart focus (first frame => ready); drivers are enabled by next move
+static void 
+power_wake(void)
+{
+  // 1. Sleep mode on WFI (not Stop mode)
+	SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+	
+  // 2. System clock (HSE, PLL): cycles up to it are HSI cycles
+	clock_change();
+	power_hsiT = irq_cycles() - power_wakeT;
+	power_wakeT = irq_cycles();
+	
+  // 3. Restart focus (first frame => ready)
+	focus_wake();
+	
+	++power_wakes;
+	power_state = POWER_STATE_WAKE;
+}
+//-----------------------------------------------------------------------------
+// Wake-to-ready (us)
+static void 
+power_ready(void)
+{
+	uint32_t us = POWER_WUSTOP_US + 
+		power_hsiT / (CLOCK_HSI_HZ / 1000000U) + 
+		(irq_cycles() - power_wakeT) / (power_msT / 1000U);
+	
+	if (us > power_wakeMax)
+		power_wakeMax = us;
+	if (us > POWER_WAKE_MAX_US)
+		++power_late;
+}
+//-----------------------------------------------------------------------------
+// Main loop (last); arrived - focus is stopped on target
+// 1. RUN: quiet period => Stop mode (at once)
+// 2. STOP: WFI with disabled interrupts (EXTI after check wakes up WFI, 
+//    handler is taken after); back to main loop without wake-up
+// 3. WAKE: first ADC frame => ready, quiet period starts
+void 
+power_poll(uint32_t arrived)
+{
+	switch (power_state) {
+	case POWER_STATE_RUN:
+		if (!config.power_quiet || power_rx || !power_isIdle(arrived)) {
+			power_rx = 0;
+			power_t0 = irq_cycles();
+			break;
+		}
+		if (irq_cycles() - power_t0 < config.power_quiet * power_msT)
+			break;
+		power_stop();
+		// Stop mode at once
+		// fall through
+	case POWER_STATE_STOP:
+		__disable_irq();
+		if (!power_exti)
+			__WFI();
+		__enable_irq();
+		if (power_exti)
+			power_wake();
+		break;
+	case POWER_STATE_WAKE:
+		if (focus_getState() & FOCUS_STATE_NOSTART)
+			break;
+		power_ready();
+		power_rx = 0;
+		power_t0 = irq_cycles();
+		power_state = POWER_STATE_RUN;
+		break;
+	default:
+		break;
+	}
+}
+//=============================================================================
+uint32_t 
+power_getState(void)
+{
+	return power_state;
+}
+//-----------------------------------------------------------------------------
+// quiet - POWER_QUIET_UNIT ms (0 - never)
+void 
+power_setQuiet(uint32_t quiet)
+{
+	config.power_quiet = quiet * POWER_QUIET_UNIT;
+	config_request();
+}
+//-----------------------------------------------------------------------------
+// Answer of CAN_SRV_POWER (without opcode)
+void 
+power_getStat(uint32_t *l, uint32_t *h)
+{
+	uint32_t q = config.power_quiet / POWER_QUIET_UNIT;
+	
+	*l = (q > 0xFEU ? 0xFEU : q) << CAN_SRV_ARG1_POS | 
+		(power_wakes > 0xFFFFU ? 0xFFFFU : power_wakes) << CAN_SRV_ARG2_POS;
+	*h = (power_wakeMax > 0xFFFFU ? 0xFFFFU : power_wakeMax) | 
+		(power_late > 0xFFFFU ? 0xFFFFU : power_late) << 16;
+}
+//=============================================================================
+// Wake-up from Stop mode (SOF of CAN frame on "CAN_RX")
+void 
+EXTI9_5_IRQHandler(void)
+{
+	// Entry time (first cycles after Stop mode)
+	uint32_t t0 = irq_cycles();
+	
+	// Exclude the cause of the interrupt (write 1 to clear); line 8 is 
+	// masked up to next Stop mode (SOF of each frame)
+	EXTI->PR = EXTI_PR_PR8;
+	EXTI->IMR &= ~EXTI_IMR_MR8;
+	
+	power_wakeT = t0;
+	power_exti = 1;
+	
+	irq_add(IRQ_SRC_EXTI8, t0, IRQ_NOLAT);
+}
+//=============================================================================
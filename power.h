@@ -0,0 +1,29 @@
+//=============================================================================
+#ifndef POWER_H
+#define POWER_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+#define POWER_STATE_RUN   0U
+#define POWER_STATE_STOP  1U  // motors parked, Stop mode (see power.c)
+#define POWER_STATE_WAKE  2U  // clock restored, waiting first ADC frame
+//-----------------------------------------------------------------------------
+// Quiet period (config.power_quiet, ms; 0 - never Stop mode): Stop mode 
+// is enabled by CAN_SRV_POWER only (wake-up frame is lost)
+#define POWER_QUIET_DEF   0U
+#define POWER_QUIET_UNIT  100U    // ms in CAN_SRV_POWER argument
+// Wake-to-ready (us): t WUSTOP with regulator in low-power mode (datasheet,
+// rounded up) is added to measured time; bound - HSE start-up, PLL lock,
+// ADC 1 start (FOCUS_STUP_US) and one ADC sequence
+#define POWER_WUSTOP_US   6U
+#define POWER_WAKE_MAX_US 5000U
+//-----------------------------------------------------------------------------
+void power_init(void);
+void power_activity(void);
+void power_poll(uint32_t arrived);
+uint32_t power_getState(void);
+void power_setQuiet(uint32_t quiet);
+void power_getStat(uint32_t *l, uint32_t *h);
+//=============================================================================
+#endif // POWER_H
+//=============================================================================
@@ -0,0 +1,127 @@
+//=============================================================================
+/*
+* modules:
+ - RAM only (presets are saved in flash by config.c)
+* notes:
+ - store/recall are called from CAN RX interrupt; recall goes to main loop 
+   as usual command (cmd.c), so it is applied as one command with both 
+   targets
+ - notification is sent by main loop (thread 1) when recalled command is 
+   applied, focus is on target and pole motors are stopped; it is dropped 
+   if the command is superseded by newer one
+*/
+//=============================================================================
+#include "main.h"
+#include "preset.h"
+#include "config.h"
+#include "cmd.h"
+#include "can.h"
+#include "pole.h"
+#include "focus.h"
+//=============================================================================
+static volatile uint32_t notify_seq;   // command to wait
+static volatile uint32_t notify_slot;  // 0 - nothing to wait, slot + 1
+//=============================================================================
+void 
+preset_init(void)
+{
+	notify_slot = 0;
+}
+//=============================================================================
+// pole == PRESET_CURRENT - store current targets; return -1 if not valid
+int32_t 
+preset_store(uint32_t slot, uint32_t focus, uint32_t pole, uint32_t speed)
+{
+	if (pole == PRESET_CURRENT) {
+		focus = focus_target;
+		pole = pole_target;
+	}
+	
+	if (slot >= CONFIG_PRESET_NUM || focus > FOCUS_MASK)
+		return -1;
+	switch (pole) {
+	case POLE_0:
+	case POLE_1:
+	case POLE_2:
+		break;
+	default:
+		return -1;
+	}
+	
+	config.preset[slot] = 
+		focus << PRESET_FOCUS_POS | 
+		pole << PRESET_POLE_POS | 
+		(speed & PRESET_SPEED_MSK) << PRESET_SPEED_POS;
+	
+	// Save in flash (by main loop)
+	config_request();
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Return -1 if slot is not valid or empty
+int32_t 
+preset_recall(uint32_t slot, uint32_t flags, uint32_t id)
+{
+	uint32_t p;
+	
+	if (slot >= CONFIG_PRESET_NUM)
+		return -1;
+	p = config.preset[slot];
+	if (p == CONFIG_PRESET_EMPTY)
+		return -1;
+	
+	cmd_put(p >> PRESET_FOCUS_POS & PRESET_FOCUS_MSK, 
+		p >> PRESET_POLE_POS & PRESET_POLE_MSK, id);
+	
+	if (flags & PRESET_NOTIFY) {
+		notify_seq = cmd_getReceived();
+		notify_slot = slot + 1U;
+	} else {
+		notify_slot = 0;
+	}
+	return 0;
+}
+//-----------------------------------------------------------------------------
+uint32_t 
+preset_get(uint32_t slot)
+{
+	if (slot >= CONFIG_PRESET_NUM)
+		return CONFIG_PRESET_EMPTY;
+	return config.preset[slot];
+}
+//=============================================================================
+// Main loop (after command is applied)
+// arrived - focus is stopped on target (see focus_control())
+// pos - current focus position (ADC counts)
+void 
+preset_poll(uint32_t arrived, uint32_t pos)
+{
+	uint32_t slot = notify_slot;
+	int32_t d;
+	
+	if (!slot)
+		return;
+	
+	d = (int32_t)(cmd_getLast() - notify_seq);
+	// Not applied yet
+	if (d < 0)
+		return;
+	// Superseded
+	if (d > 0) {
+		notify_slot = 0;
+		return;
+	}
+	
+	if (!arrived || pole_isMoving() || 
+		pole_getPole() != pole_target)
+		return;
+	
+	if (can_send(CAN_ID_SRV, 8, 
+			CAN_SRV_PRESET_RECALL << CAN_SRV_OP_POS | 
+			(slot - 1U) << CAN_SRV_ARG1_POS | 
+			PRESET_NOTIFY << CAN_SRV_ARG2_POS | 
+			focus_toStep(pos) << CAN_SRV_ARG3_POS, 
+		pos, 1) == 0)
+		notify_slot = 0;
+}
+//=============================================================================
@@ -0,0 +1,28 @@
+//=============================================================================
+#ifndef PRESET_H
+#define PRESET_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+// Preset (word in config.preset[]): focus (ADC counts) [15:0], pole [23:16], 
+// speed [31:24] (reserved: keys drive focus motor at full speed only)
+#define PRESET_FOCUS_POS  0U
+#define PRESET_POLE_POS   16U
+#define PRESET_SPEED_POS  24U
+
+#define PRESET_FOCUS_MSK  0xFFFFU  // after shift
+#define PRESET_POLE_MSK   0xFFU
+#define PRESET_SPEED_MSK  0xFFU
+//-----------------------------------------------------------------------------
+#define PRESET_CURRENT    0xFFU  // pole for store: use current targets
+#define PRESET_NOTIFY     0x01U  // recall flag: notify on arrival
+//-----------------------------------------------------------------------------
+void preset_init(void);
+int32_t preset_store(uint32_t slot, uint32_t focus, uint32_t pole, 
+		uint32_t speed);
+int32_t preset_recall(uint32_t slot, uint32_t flags, uint32_t id);
+uint32_t preset_get(uint32_t slot);
+void preset_poll(uint32_t arrived, uint32_t pos);
+//=============================================================================
+#endif // PRESET_H
+//=============================================================================
@@ -0,0 +1,246 @@
+//=============================================================================
+/*
+* modules:
+ - RAM only (frames are sent by main loop, thread 1)
+* notes:
+ - stream_sample() is called from DMA 1 Channel 1 interrupt (5 Hz ... 
+   4 KHz, see FOCUS_RATE_x): tick of sample is each period of time stamp 
+   of frames (focus_getStamp()); one entry per frame with ticks since last
+   frame (repeats: slow frames are held, fast frames are decimated); one 
+   division only
+ - sample of tick is position of first frame at or after it (late by one 
+   frame period at most); no ticks while TIM 2 is stopped (Stop mode is 
+   not entered while streaming, see power.c)
+ - main loop packs samples: first one absolute (12 bits), others as deltas
+   of the smallest width that fits all of them (STREAM_BITS_MIN ... 
+   STREAM_BITS_MAX), frame is closed when next delta does not fit; one 
+   frame is pending at most, samples wait in buffer meanwhile
+ - buffer full (CAN busy): samples are lost, next entry has STREAM_GAP 
+   => frame is closed and sequence is skipped (decoder sees gap)
+ - CAN_SRV_STREAM (CAN RX interrupt) is applied by main loop: sampling 
+   stops, rest of samples is sent, then new stream starts
+*/
+//=============================================================================
+#include "main.h"
+#include "stream.h"
+#include "focus.h"
+#include "axis.h"
+#include "can.h"
+//=============================================================================
+#define STREAM_GAP      0x8000U      // entry after lost samples
+#define STREAM_REP_POS  16U          // repeats of entry
+#define STREAM_REQ      0x10000U     // request: period | axis << 8
+//-----------------------------------------------------------------------------
+static uint32_t stream_buf[STREAM_SIZE];  // sample | flags | repeats
+static volatile uint32_t stream_head;     // written by DMA 1 interrupt
+static volatile uint32_t stream_tail;
+static volatile uint32_t stream_per;      // us, 0 - no sampling
+static volatile uint32_t stream_axis;
+static uint32_t stream_next;              // time stamp of next tick (us)
+static uint32_t stream_gap;
+static volatile uint32_t stream_lost;     // samples
+static volatile uint32_t stream_req;      // from CAN RX interrupt
+static uint32_t stream_code;              // period (x STREAM_PER_US)
+static uint32_t stream_rep;               // repeats left of tail entry
+// Frame in work
+static uint32_t stream_has;               // first sample is set
+static uint32_t stream_first;
+static uint32_t stream_prev;
+static uint32_t stream_n;
+static uint32_t stream_bits;
+static int32_t stream_d[STREAM_N_MAX];
+// Frame to send
+static uint32_t stream_tx;
+static uint32_t stream_l;
+static uint32_t stream_h;
+static uint32_t stream_seq;
+static volatile uint32_t stream_frames;
+//=============================================================================
+void 
+stream_init(void)
+{
+	stream_per = 0;
+	stream_req = 0;
+	stream_code = 0;
+	stream_axis = 0;
+	stream_head = 0;
+	stream_tail = 0;
+	stream_rep = 0;
+	stream_gap = 0;
+	stream_lost = 0;
+	stream_has = 0;
+	stream_n = 0;
+	stream_bits = STREAM_BITS_MIN;
+	stream_tx = 0;
+	stream_seq = 0;
+	stream_frames = 0;
+}
+//-----------------------------------------------------------------------------
+// From CAN_SRV_STREAM: per - period (x STREAM_PER_US, 0 - off), axis - 
+// AXIS_x; applied by main loop
+int32_t 
+stream_start(uint32_t per, uint32_t axis)
+{
+	if (per > STREAM_PER_MAX || axis >= AXIS_NUM)
+		return -1;
+	stream_req = STREAM_REQ | per | axis << 8;
+	return 0;
+}
+//=============================================================================
+// DMA 1 Channel 1 interrupt (good frame): ticks up to this frame
+void 
+stream_sample(void)
+{
+	uint32_t per = stream_per, s, n;
+	
+	if (!per)
+		return;
+	s = focus_getStamp();
+	if ((int32_t)(s - stream_next) < 0)
+		return;
+	n = (s - stream_next) / per + 1U;
+	stream_next += n * per;
+	
+	if (stream_head - stream_tail >= STREAM_SIZE) {
+		stream_lost += n;
+		stream_gap = STREAM_GAP;
+		return;
+	}
+	stream_buf[stream_head & (STREAM_SIZE - 1U)] = 
+		(focus_getAxis(stream_axis) & FOCUS_MASK) | stream_gap | 
+		(n < STREAM_REP_MAX ? n : STREAM_REP_MAX) << STREAM_REP_POS;
+	stream_gap = 0;
+	++stream_head;
+}
+//=============================================================================
+// Close frame in work (to send); return 1 if frame is pending
+static uint32_t 
+stream_flush(void)
+{
+	uint32_t i, m, h = 0;
+	
+	if (!stream_has)
+		return 0;
+	m = (1U << stream_bits) - 1U;
+	for (i = 0; i < stream_n; ++i)
+		h |= ((uint32_t)stream_d[i] & m) << (i * stream_bits);
+	
+	stream_l = 
+		(stream_seq & 0xFFU) << STREAM_SEQ_POS | 
+		stream_code << STREAM_PER_POS | 
+		stream_bits << STREAM_BITS_POS | 
+		stream_n << STREAM_N_POS | 
+		stream_first << STREAM_FIRST_POS;
+	stream_h = h;
+	stream_tx = 1U;
+	++stream_seq;
+	
+	stream_has = 0;
+	stream_n = 0;
+	stream_bits = STREAM_BITS_MIN;
+	return 1U;
+}
+//-----------------------------------------------------------------------------
+// Sample to frame in work; return -1 if not added (frame is pending)
+static int32_t 
+stream_add(uint32_t s)
+{
+	int32_t d;
+	uint32_t u, b;
+	
+	if (stream_tx)
+		return -1;
+	if (!stream_has) {
+		stream_first = s;
+		stream_prev = s;
+		stream_has = 1U;
+		return 0;
+	}
+	
+	// Width of delta: sign bit + magnitude
+	d = (int32_t)s - (int32_t)stream_prev;
+	u = d < 0 ? ~(uint32_t)d : (uint32_t)d;
+	for (b = stream_bits; u >> (b - 1U); ++b);
+	
+	// Does not fit: sample starts next frame
+	if (stream_n == STREAM_N_MAX || (stream_n + 1U) * b > STREAM_DATA_BITS) {
+		stream_flush();
+		return -1;
+	}
+	stream_d[stream_n++] = d;
+	stream_bits = b;
+	stream_prev = s;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+// Main loop
+// 1. Pending frame (thread 1)
+// 2. Request: stop sampling, rest of samples goes to old stream
+// 3. Samples to frames (gap: frame is closed, sequence is skipped)
+// 4. Request: last frame of old stream, start of new one
+void 
+stream_poll(void)
+{
+	uint32_t v, req;
+	
+  // 1. Pending frame (thread 1)
+	if (stream_tx) {
+		if (can_send(CAN_ID_STREAM, 8, stream_l, stream_h, 1))
+			return;
+		stream_tx = 0;
+		++stream_frames;
+	}
+	
+  // 2. Request: stop sampling, rest of samples goes to old stream
+	if (stream_req)
+		stream_per = 0;
+	
+  // 3. Samples to frames (gap: frame is closed, sequence is skipped)
+	while (stream_tail != stream_head) {
+		v = stream_buf[stream_tail & (STREAM_SIZE - 1U)];
+		if (!stream_rep) {
+			if (v & STREAM_GAP) {
+				if (stream_flush())
+					return;
+				++stream_seq;
+			}
+			stream_rep = v >> STREAM_REP_POS;
+		}
+		for (; stream_rep; --stream_rep)
+			if (stream_add(v & FOCUS_MASK))
+				return;
+		++stream_tail;
+	}
+	
+  // 4. Request: last frame of old stream, start of new one
+	if (!stream_req || stream_flush())
+		return;
+	__disable_irq();
+	req = stream_req;
+	stream_req = 0;
+	__enable_irq();
+	stream_code = req & 0xFFU;
+	stream_axis = req >> 8 & 0xFFU;
+	stream_next = focus_getStamp() + stream_code * STREAM_PER_US;
+	stream_per = stream_code * STREAM_PER_US;
+}
+//=============================================================================
+// Streaming or frames to send (no Stop mode)
+uint32_t 
+stream_isOn(void)
+{
+	return stream_per || stream_req || stream_tx || stream_has;
+}
+//-----------------------------------------------------------------------------
+// Answer of CAN_SRV_STREAM (without opcode)
+void 
+stream_getStat(uint32_t *l, uint32_t *h)
+{
+	uint32_t lost = stream_lost;
+	
+	*l = stream_code << CAN_SRV_ARG1_POS | 
+		stream_axis << CAN_SRV_ARG2_POS;
+	*h = (stream_frames & 0xFFFFU) | 
+		(lost > 0xFFFFU ? 0xFFFFU : lost) << 16;
+}
+//=============================================================================
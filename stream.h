@@ -0,0 +1,37 @@
+//=============================================================================
+#ifndef STREAM_H
+#define STREAM_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+// Position streaming (CAN_ID_STREAM, CAN_SRV_STREAM): samples of one axis 
+// each period, delta-encoded, as many as fit in 8 bytes per frame
+#define STREAM_PER_US    250U  // unit of period (period 4 - 1 ms)
+#define STREAM_PER_MAX   15U
+#define STREAM_SIZE      64U   // samples to main loop (power of 2)
+#define STREAM_BITS_MIN  2U    // bits of delta (signed)
+#define STREAM_BITS_MAX  13U   // any difference of 12-bit samples
+#define STREAM_N_MAX     15U   // deltas in frame
+#define STREAM_REP_MAX   0xFFFFU
+//-----------------------------------------------------------------------------
+// Frame (2 words, 8 bytes):
+// word 0: first sample [31:20], deltas [19:16], bits of delta [15:12], 
+//         period (x STREAM_PER_US) [11:8], sequence of frame [7:0]
+// word 1: delta i at i x bits (two's complement), sample i + 1 = sample i 
+//         + delta i; sequence is skipped after lost samples (gap)
+#define STREAM_SEQ_POS    0U
+#define STREAM_PER_POS    8U
+#define STREAM_BITS_POS   12U
+#define STREAM_N_POS      16U
+#define STREAM_FIRST_POS  20U
+#define STREAM_DATA_BITS  32U
+//-----------------------------------------------------------------------------
+void stream_init(void);
+int32_t stream_start(uint32_t per, uint32_t axis);
+void stream_sample(void);
+void stream_poll(void);
+uint32_t stream_isOn(void);
+void stream_getStat(uint32_t *l, uint32_t *h);
+//=============================================================================
+#endif // STREAM_H
+//=============================================================================
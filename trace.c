@@ -0,0 +1,178 @@
+//=============================================================================
+/*
+* modules:
+ - RAM only (records are read out over CAN by main loop)
+* notes:
+ - trace_sample() is called from DMA 1 Channel 1 interrupt (5 Hz ... 
+   4 KHz, see FOCUS_RATE_x); keep it short: no loops and no division 
+   except position and time (ms from time stamp of frame)
+ - after trigger TRACE_POST_DEF (or "post") records are written, then 
+   buffer is frozen until trace_arm()
+ - trace_arm() is refused during read out (it would reset records being 
+   sent); trace_state is changed by interrupts (CAN RX, DMA 1): main loop 
+   clears TRACE_STATE_READ with interrupts disabled
+*/
+//=============================================================================
+#include "main.h"
+#include "trace.h"
+#include "focus.h"
+#include "pole.h"
+#include "can.h"
+#include "config.h"
+//=============================================================================
+static uint32_t trace_buf[TRACE_SIZE][2];
+static volatile uint32_t trace_state;
+static volatile uint32_t trace_head;     // records written (free running)
+static volatile uint32_t trace_post;     // records left after trigger
+static uint32_t trace_time;              // time stamp of frame (ms)
+static uint32_t trace_dec;               // decimation of DMA frames
+static uint32_t trace_dec_cnt;
+static uint32_t trace_post_len;
+static uint32_t trace_trig;
+static int32_t trace_err;                // last position - target out of
+                                         // band (side of approach)
+static uint32_t trace_target;            // previous focus_target
+static volatile uint32_t trace_rd;       // read index
+static uint32_t trace_rd_end;
+//=============================================================================
+void 
+trace_init(void)
+{
+	trace_time = 0;
+	trace_arm(TRACE_DEC_DEF, TRACE_POST_DEF, TRACE_TRIG_DEF);
+}
+//-----------------------------------------------------------------------------
+// dec - record each dec-th DMA frame (0 -> 1)
+// post - records after trigger (> TRACE_SIZE - 1 -> TRACE_SIZE - 1)
+// trig - TRACE_TRIG_x mask
+// Return -1 during read out (TRACE_STATE_READ)
+int32_t 
+trace_arm(uint32_t dec, uint32_t post, uint32_t trig)
+{
+	if (trace_state & TRACE_STATE_READ)
+		return -1;
+	
+	// Stop recording while settings are changed
+	trace_state = TRACE_STATE_FROZEN;
+	
+	trace_dec = dec ? dec : 1U;
+	trace_dec_cnt = 0;
+	trace_post_len = post < TRACE_SIZE ? post : TRACE_SIZE - 1U;
+	trace_trig = trig;
+	trace_err = 0;
+	trace_target = 0;
+	trace_head = 0;
+	trace_post = 0;
+	
+	trace_state = 0;
+	return 0;
+}
+//-----------------------------------------------------------------------------
+void 
+trace_trigger(void)
+{
+	if (trace_state & (TRACE_STATE_TRIG | TRACE_STATE_FROZEN))
+		return;
+	trace_post = trace_post_len;
+	trace_state = trace_post ? TRACE_STATE_TRIG : 
+		TRACE_STATE_TRIG | TRACE_STATE_FROZEN;
+}
+//=============================================================================
+void 
+trace_sample(void)
+{
+	uint32_t i, adc, target, flags;
+	int32_t err, err8, band;
+	
+	trace_time = focus_getStamp() / 1000U;
+	
+	if (trace_state & TRACE_STATE_FROZEN)
+		return;
+	if (++trace_dec_cnt < trace_dec)
+		return;
+	trace_dec_cnt = 0;
+	
+	adc = *focus_pos & FOCUS_MASK;
+	target = focus_target;
+	flags = focus_getState() | pole_getState();
+	err = (int32_t)adc - (int32_t)target;
+	err8 = err > 127 ? 127 : err < -128 ? -128 : err;
+	
+	i = trace_head++ & (TRACE_SIZE - 1U);
+	trace_buf[i][0] = 
+		trace_time << TRACE_TIME_POS | 
+		focus_getDir() << TRACE_DIR_POS | 
+		adc << TRACE_ADC_POS;
+	trace_buf[i][1] = 
+		flags << TRACE_FLAGS_POS | 
+		pole_getPole() << TRACE_POLE_POS | 
+		target << TRACE_TARGET_POS | 
+		((uint32_t)err8 & 0xFFU) << TRACE_ERR_POS;
+	
+	// Window after trigger
+	if (trace_state & TRACE_STATE_TRIG) {
+		if (--trace_post == 0)
+			trace_state |= TRACE_STATE_FROZEN;
+		return;
+	}
+	
+	// Trigger conditions (overshoot: error out of band on the other side 
+	// than approach for the same target)
+	if (target != trace_target)
+		trace_err = 0;
+	band = (int32_t)config.focus_band_start;
+	if (err > band || err < -band) {
+		if (trace_trig & TRACE_TRIG_OVERSHOOT && trace_err != 0 && 
+			(err ^ trace_err) < 0)
+			trace_trigger();
+		trace_err = err;
+	}
+	if (trace_trig & TRACE_TRIG_ERR && flags & FOCUS_STATE_ERR)
+		trace_trigger();
+	trace_target = target;
+}
+//=============================================================================
+// Freeze buffer and start read out (by trace_poll()); return number of 
+// records
+uint32_t 
+trace_read(void)
+{
+	uint32_t n;
+	
+	trace_state |= TRACE_STATE_FROZEN;
+	
+	n = trace_head < TRACE_SIZE ? trace_head : TRACE_SIZE;
+	trace_rd = trace_head - n;
+	trace_rd_end = trace_head;
+	
+	trace_state |= TRACE_STATE_READ;
+	return n;
+}
+//-----------------------------------------------------------------------------
+// Send one record (from oldest) per call; thread 1 - not used in interrupts
+void 
+trace_poll(void)
+{
+	uint32_t i;
+	
+	if (!(trace_state & TRACE_STATE_READ))
+		return;
+	
+	if (trace_rd == trace_rd_end) {
+		__disable_irq();
+		trace_state &= ~TRACE_STATE_READ;
+		__enable_irq();
+		return;
+	}
+	
+	i = trace_rd & (TRACE_SIZE - 1U);
+	if (can_send(CAN_ID_TRACE, 8, trace_buf[i][0], trace_buf[i][1], 1) == 0)
+		++trace_rd;
+}
+//=============================================================================
+uint32_t 
+trace_getState(void)
+{
+	return trace_state;
+}
+//=============================================================================
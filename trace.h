@@ -0,0 +1,41 @@
+//=============================================================================
+#ifndef TRACE_H
+#define TRACE_H
+//=============================================================================
+#include <stm32f302x8.h>
+//-----------------------------------------------------------------------------
+#define TRACE_STATE_TRIG    0x01U
+#define TRACE_STATE_FROZEN  0x02U
+#define TRACE_STATE_READ    0x04U
+//-----------------------------------------------------------------------------
+#define TRACE_TRIG_ERR        0x01U  // FOCUS_STATE_ERR in state flags
+#define TRACE_TRIG_OVERSHOOT  0x02U  // position crossed focus_target
+                                     // (out of start band)
+//-----------------------------------------------------------------------------
+#define TRACE_SIZE      256U  // records (power of 2)
+#define TRACE_DEC_DEF   1U    // record every DMA frame (FOCUS_RATE_x)
+#define TRACE_POST_DEF  (TRACE_SIZE / 2U)
+#define TRACE_TRIG_DEF  (TRACE_TRIG_ERR | TRACE_TRIG_OVERSHOOT)
+//-----------------------------------------------------------------------------
+// Record (2 words, one CAN frame):
+// word 0: time (ms) [31:16], key direction [13:12], raw ADC [11:0]
+// word 1: state flags [31:24], pole [23:20], focus_target [19:8], 
+//         position - focus_target [7:0] (signed, saturated)
+#define TRACE_TIME_POS    16U
+#define TRACE_DIR_POS     12U
+#define TRACE_ADC_POS     0U
+#define TRACE_FLAGS_POS   24U
+#define TRACE_POLE_POS    20U
+#define TRACE_TARGET_POS  8U
+#define TRACE_ERR_POS     0U
+//-----------------------------------------------------------------------------
+void trace_init(void);
+int32_t trace_arm(uint32_t dec, uint32_t post, uint32_t trig);
+void trace_trigger(void);
+void trace_sample(void);
+uint32_t trace_read(void);
+void trace_poll(void);
+uint32_t trace_getState(void);
+//=============================================================================
+#endif // TRACE_H
+//=============================================================================